@@ -156,6 +156,7 @@ fi
 %{_bindir}/automappingconverter
 %{_bindir}/%{name}
 %{_bindir}/terraingenerator
+%{_bindir}/tmbconverter
 %{_bindir}/tmxrasterizer
 %{_bindir}/tmxviewer
 %{_datadir}/applications/%{name}.desktop
@@ -175,6 +176,7 @@ fi
 %{_libdir}/%{name}/plugins/libcsv.so
 %{_libdir}/%{name}/plugins/libjson.so
 %{_libdir}/%{name}/plugins/liblua.so
+%{_libdir}/%{name}/plugins/libtmb.so
 
 %{_mandir}/man1/automappingconverter.1*
 %{_mandir}/man1/%{name}.1*
@@ -34,8 +34,20 @@
 #include <zlib.h>
 #endif
 
+#ifdef TILED_ZSTD_SUPPORT
+#include <zstd.h>
+#endif
+
+#ifdef TILED_LZ4_SUPPORT
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+
 #include <QByteArray>
 #include <QDebug>
+#include <QThreadStorage>
+
+#include <climits>
 
 #ifdef Z_PREFIX
 #undef compress
@@ -63,8 +75,214 @@ static void logZlibError(int error)
     }
 }
 
-QByteArray Tiled::decompress(const QByteArray &data, int expectedSize)
+bool Tiled::compressionSupported(CompressionMethod method)
+{
+    switch (method) {
+    case Gzip:
+    case Zlib:
+        return true;
+    case Zstandard:
+#ifdef TILED_ZSTD_SUPPORT
+        return true;
+#else
+        return false;
+#endif
+    case Lz4:
+#ifdef TILED_LZ4_SUPPORT
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    return false;
+}
+
+int Tiled::maximumCompressionLevel(CompressionMethod method)
+{
+    switch (method) {
+    case Gzip:
+    case Zlib:
+        return Z_BEST_COMPRESSION;
+    case Zstandard:
+#ifdef TILED_ZSTD_SUPPORT
+        return ZSTD_maxCLevel();
+#else
+        return 22;
+#endif
+    case Lz4:
+#ifdef TILED_LZ4_SUPPORT
+        return LZ4HC_CLEVEL_MAX;
+#else
+        return 12;
+#endif
+    }
+
+    return -1;
+}
+
+#ifdef TILED_ZSTD_SUPPORT
+static QByteArray decompressZstandard(const QByteArray &data, int expectedSize)
 {
+    // Prefer the size stored in the frame, when available
+    const unsigned long long contentSize = ZSTD_getFrameContentSize(data.constData(),
+                                                                   data.size());
+    if (contentSize == ZSTD_CONTENTSIZE_ERROR) {
+        qDebug() << "Incorrect Zstandard compressed data!";
+        return QByteArray();
+    }
+    if (contentSize != ZSTD_CONTENTSIZE_UNKNOWN) {
+        if (contentSize > INT_MAX) {
+            qDebug() << "Zstandard compressed data too large!";
+            return QByteArray();
+        }
+        expectedSize = int(contentSize);
+    }
+
+    QByteArray out;
+    out.resize(expectedSize);
+
+    ZSTD_DStream *stream = ZSTD_createDStream();
+    ZSTD_initDStream(stream);
+
+    ZSTD_inBuffer input = { data.constData(), size_t(data.size()), 0 };
+    ZSTD_outBuffer output = { out.data(), size_t(out.size()), 0 };
+
+    size_t ret;
+    forever {
+        if (output.pos == output.size) {
+            // More output space needed
+            out.resize(out.size() * 2 + 1);
+            output.dst = out.data();
+            output.size = size_t(out.size());
+        }
+
+        ret = ZSTD_decompressStream(stream, &output, &input);
+        if (ZSTD_isError(ret)) {
+            qDebug() << "Error while decompressing Zstandard data:"
+                     << ZSTD_getErrorName(ret);
+            ZSTD_freeDStream(stream);
+            return QByteArray();
+        }
+
+        // Done when the frame is complete, or when the data is truncated
+        if (ret == 0 || (input.pos == input.size && output.pos < output.size))
+            break;
+    }
+
+    ZSTD_freeDStream(stream);
+
+    if (ret != 0 || input.pos != input.size) {
+        qDebug() << "Incorrect Zstandard compressed data!";
+        return QByteArray();
+    }
+
+    out.resize(int(output.pos));
+    return out;
+}
+
+static QByteArray compressZstandard(const QByteArray &data, int level)
+{
+    if (level == -1)
+        level = ZSTD_CLEVEL_DEFAULT;
+
+    QByteArray out;
+    out.resize(int(ZSTD_compressBound(data.size())));
+
+    const size_t size = ZSTD_compress(out.data(), out.size(),
+                                      data.constData(), data.size(),
+                                      level);
+    if (ZSTD_isError(size)) {
+        qDebug() << "Error while compressing Zstandard data:"
+                 << ZSTD_getErrorName(size);
+        return QByteArray();
+    }
+
+    out.resize(int(size));
+    return out;
+}
+#endif // TILED_ZSTD_SUPPORT
+
+#ifdef TILED_LZ4_SUPPORT
+static QByteArray decompressLz4(const QByteArray &data, int expectedSize)
+{
+    // The LZ4 block format doesn't store the uncompressed size, so grow the
+    // output until it fits (up to the maximum LZ4 compression ratio)
+    const qint64 maximumSize = qMin<qint64>(qint64(data.size()) * 255 + 16, INT_MAX);
+    int capacity = qMax(expectedSize, 1);
+
+    QByteArray out;
+
+    forever {
+        out.resize(capacity);
+
+        const int size = LZ4_decompress_safe(data.constData(), out.data(),
+                                             data.size(), capacity);
+        if (size >= 0) {
+            out.resize(size);
+            return out;
+        }
+
+        if (capacity >= maximumSize)
+            break;
+
+        capacity = int(qMin<qint64>(qint64(capacity) * 2, maximumSize));
+    }
+
+    qDebug() << "Incorrect LZ4 compressed data!";
+    return QByteArray();
+}
+
+static QByteArray compressLz4(const QByteArray &data, int level)
+{
+    QByteArray out;
+    out.resize(LZ4_compressBound(data.size()));
+
+    // Levels above 1 use the slower high-compression mode
+    int size;
+    if (level > 1) {
+        size = LZ4_compress_HC(data.constData(), out.data(),
+                               data.size(), out.size(),
+                               level);
+    } else {
+        size = LZ4_compress_default(data.constData(), out.data(),
+                                    data.size(), out.size());
+    }
+
+    if (size <= 0 && !data.isEmpty()) {
+        qDebug() << "Error while compressing LZ4 data!";
+        return QByteArray();
+    }
+
+    out.resize(size);
+    return out;
+}
+#endif // TILED_LZ4_SUPPORT
+
+QByteArray Tiled::decompress(const QByteArray &data,
+                             int expectedSize,
+                             CompressionMethod method)
+{
+    switch (method) {
+    case Gzip:
+    case Zlib:
+        break;
+    case Zstandard:
+#ifdef TILED_ZSTD_SUPPORT
+        return decompressZstandard(data, expectedSize);
+#else
+        qDebug() << "Zstandard compression is not supported!";
+        return QByteArray();
+#endif
+    case Lz4:
+#ifdef TILED_LZ4_SUPPORT
+        return decompressLz4(data, expectedSize);
+#else
+        qDebug() << "LZ4 compression is not supported!";
+        return QByteArray();
+#endif
+    }
+
     QByteArray out;
     out.resize(expectedSize);
     z_stream strm;
@@ -120,8 +338,209 @@ QByteArray Tiled::decompress(const QByteArray &data, int expectedSize)
     return out;
 }
 
-QByteArray Tiled::compress(const QByteArray &data, CompressionMethod method)
+namespace {
+
+/**
+ * An inflate stream that is kept around, so that it only needs to be reset
+ * between uses rather than allocated each time.
+ */
+class InflateStream
+{
+public:
+    InflateStream()
+    {
+        mStream.zalloc = Z_NULL;
+        mStream.zfree = Z_NULL;
+        mStream.opaque = Z_NULL;
+        mStream.next_in = Z_NULL;
+        mStream.avail_in = 0;
+
+        mInitResult = inflateInit2(&mStream, 15 + 32);
+    }
+
+    ~InflateStream()
+    {
+        if (mInitResult == Z_OK)
+            inflateEnd(&mStream);
+    }
+
+    /**
+     * Returns the stream ready for use, or nullptr when it could not be
+     * initialized.
+     */
+    z_stream *reset()
+    {
+        if (mInitResult != Z_OK) {
+            logZlibError(mInitResult);
+            return nullptr;
+        }
+
+        inflateReset(&mStream);
+        return &mStream;
+    }
+
+private:
+    z_stream mStream;
+    int mInitResult;
+};
+
+} // anonymous namespace
+
+static QThreadStorage<InflateStream*> inflateStreams;
+
+static bool inflateInto(const QByteArray &data, char *out, int outSize)
 {
+    if (!inflateStreams.hasLocalData())
+        inflateStreams.setLocalData(new InflateStream);
+
+    z_stream *strm = inflateStreams.localData()->reset();
+    if (!strm)
+        return false;
+
+    strm->next_in = (Bytef *) data.data();
+    strm->avail_in = data.length();
+    strm->next_out = (Bytef *) out;
+    strm->avail_out = outSize;
+
+    int ret = inflate(strm, Z_FINISH);
+
+    switch (ret) {
+    case Z_STREAM_END:
+        break;
+    case Z_OK:
+    case Z_BUF_ERROR:
+        // Either the output buffer is full while there is more data, or the
+        // input was truncated
+        if (strm->avail_out == 0)
+            qDebug() << "Uncompressed data larger than expected!";
+        else
+            logZlibError(Z_DATA_ERROR);
+        return false;
+    case Z_NEED_DICT:
+    case Z_STREAM_ERROR:
+        ret = Z_DATA_ERROR;
+        // fall through
+    default:
+        logZlibError(ret);
+        return false;
+    }
+
+    if (strm->avail_out != 0) {
+        qDebug() << "Uncompressed data smaller than expected!";
+        return false;
+    }
+
+    if (strm->avail_in != 0) {
+        logZlibError(Z_DATA_ERROR);
+        return false;
+    }
+
+    return true;
+}
+
+#ifdef TILED_ZSTD_SUPPORT
+namespace {
+
+class ZstandardDecompressionContext
+{
+public:
+    ZstandardDecompressionContext() : mContext(ZSTD_createDCtx()) {}
+    ~ZstandardDecompressionContext() { ZSTD_freeDCtx(mContext); }
+
+    ZSTD_DCtx *context() const { return mContext; }
+
+private:
+    ZSTD_DCtx *mContext;
+};
+
+} // anonymous namespace
+
+static QThreadStorage<ZstandardDecompressionContext*> zstandardContexts;
+#endif // TILED_ZSTD_SUPPORT
+
+bool Tiled::decompress(const QByteArray &data,
+                       char *out,
+                       int outSize,
+                       CompressionMethod method)
+{
+    switch (method) {
+    case Gzip:
+    case Zlib:
+        return inflateInto(data, out, outSize);
+
+    case Zstandard: {
+#ifdef TILED_ZSTD_SUPPORT
+        if (!zstandardContexts.hasLocalData())
+            zstandardContexts.setLocalData(new ZstandardDecompressionContext);
+
+        const size_t size = ZSTD_decompressDCtx(zstandardContexts.localData()->context(),
+                                                out, size_t(outSize),
+                                                data.constData(), size_t(data.size()));
+        if (ZSTD_isError(size)) {
+            qDebug() << "Error while decompressing Zstandard data:"
+                     << ZSTD_getErrorName(size);
+            return false;
+        }
+        if (size != size_t(outSize)) {
+            qDebug() << "Uncompressed data smaller than expected!";
+            return false;
+        }
+        return true;
+#else
+        qDebug() << "Zstandard compression is not supported!";
+        return false;
+#endif
+    }
+
+    case Lz4: {
+#ifdef TILED_LZ4_SUPPORT
+        const int size = LZ4_decompress_safe(data.constData(), out,
+                                             data.size(), outSize);
+        if (size < 0) {
+            qDebug() << "Incorrect LZ4 compressed data, or larger than expected!";
+            return false;
+        }
+        if (size != outSize) {
+            qDebug() << "Uncompressed data smaller than expected!";
+            return false;
+        }
+        return true;
+#else
+        qDebug() << "LZ4 compression is not supported!";
+        return false;
+#endif
+    }
+    }
+
+    return false;
+}
+
+QByteArray Tiled::compress(const QByteArray &data,
+                           CompressionMethod method,
+                           int level)
+{
+    level = qBound(-1, level, maximumCompressionLevel(method));
+
+    switch (method) {
+    case Gzip:
+    case Zlib:
+        break;
+    case Zstandard:
+#ifdef TILED_ZSTD_SUPPORT
+        return compressZstandard(data, level);
+#else
+        qDebug() << "Zstandard compression is not supported!";
+        return QByteArray();
+#endif
+    case Lz4:
+#ifdef TILED_LZ4_SUPPORT
+        return compressLz4(data, level);
+#else
+        qDebug() << "LZ4 compression is not supported!";
+        return QByteArray();
+#endif
+    }
+
     QByteArray out;
     out.resize(1024);
     int err;
@@ -136,7 +555,10 @@ QByteArray Tiled::compress(const QByteArray &data, CompressionMethod method)
 
     const int windowBits = (method == Gzip) ? 15 + 16 : 15;
 
-    err = deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, windowBits,
+    if (level == -1)
+        level = Z_DEFAULT_COMPRESSION;
+
+    err = deflateInit2(&strm, level, Z_DEFLATED, windowBits,
                        8, Z_DEFAULT_STRATEGY);
     if (err != Z_OK) {
         logZlibError(err);
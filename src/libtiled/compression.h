@@ -36,34 +36,80 @@ namespace Tiled {
 
 enum CompressionMethod {
     Gzip,
-    Zlib
+    Zlib,
+    Zstandard,
+    Lz4
 };
 
 /**
- * Decompresses either zlib or gzip compressed memory. Returns a null
- * QByteArray if decompressing failed.
+ * Returns whether the given compression \a method is available. Zstandard
+ * and LZ4 compression are only available when libtiled was built with
+ * support for them.
+ */
+bool TILEDSHARED_EXPORT compressionSupported(CompressionMethod method);
+
+/**
+ * Returns the highest compression level of the given compression \a method.
+ * Higher levels passed to compress() are reduced to this level.
+ */
+int TILEDSHARED_EXPORT maximumCompressionLevel(CompressionMethod method);
+
+/**
+ * Decompresses zlib, gzip, Zstandard or LZ4 compressed memory. Returns a
+ * null QByteArray if decompressing failed.
  *
  * Needed because qUncompress does not support gzip compressed data. Also,
  * this method does not need the expected size to be prepended to the data,
  * but it can be passed as optional parameter.
  *
+ * The zlib and gzip formats are detected automatically, so for those it
+ * doesn't matter which of the two is passed as \a method.
+ *
  * @param data         the compressed data
  * @param expectedSize the expected size of the uncompressed data in bytes
+ * @param method       the compression method
  * @return the uncompressed data, or a null QByteArray if decompressing failed
  */
 QByteArray TILEDSHARED_EXPORT decompress(const QByteArray &data,
-                                         int expectedSize = 1024);
+                                         int expectedSize = 1024,
+                                         CompressionMethod method = Zlib);
+
+/**
+ * Decompresses \a data directly into the buffer pointed to by \a out, which
+ * is \a outSize bytes large. Use this overload when the size of the
+ * uncompressed data is known in advance, to avoid growing and copying the
+ * output.
+ *
+ * Decompressing fails when the data is corrupt, or when the size of the
+ * uncompressed data is not exactly \a outSize bytes.
+ *
+ * For zlib and gzip, a decompression stream is reused for each thread.
+ *
+ * @param data    the compressed data
+ * @param out     the buffer to store the uncompressed data in
+ * @param outSize the exact size of the uncompressed data in bytes
+ * @param method  the compression method
+ * @return whether the data was decompressed successfully
+ */
+bool TILEDSHARED_EXPORT decompress(const QByteArray &data,
+                                   char *out,
+                                   int outSize,
+                                   CompressionMethod method = Zlib);
 
 /**
- * Compresses the give data in either gzip or zlib format. Returns a null
- * QByteArray if compression failed.
+ * Compresses the give data in gzip, zlib, Zstandard or LZ4 format. Returns a
+ * null QByteArray if compression failed.
  *
  * Needed because qCompress does not support gzip compression.
  *
- * @param data the uncompressed data
+ * @param data   the uncompressed data
+ * @param method the compression method
+ * @param level  the compression level, or -1 for the default level of the
+ *               compression method. See maximumCompressionLevel().
  * @return the compressed data, or a null QByteArray if compression failed
  */
 QByteArray TILEDSHARED_EXPORT compress(const QByteArray &data,
-                                       CompressionMethod method = Zlib);
+                                       CompressionMethod method = Zlib,
+                                       int level = -1);
 
 } // namespace Tiled
@@ -0,0 +1,153 @@
+/*
+ * deferredimage.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "deferredimage.h"
+
+#include <QBitmap>
+#include <QCoreApplication>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+namespace Tiled {
+
+namespace {
+
+class DecodeTask : public QRunnable
+{
+public:
+    explicit DecodeTask(const QSharedPointer<DeferredImage> &image)
+        : mImage(image)
+    {}
+
+    void run() override
+    {
+        mImage->decode();
+    }
+
+private:
+    QSharedPointer<DeferredImage> mImage;
+};
+
+} // anonymous namespace
+
+DeferredImage::DeferredImage(const ImageReference &reference)
+    : mReference(reference)
+    , mDecoded(false)
+{
+}
+
+/**
+ * Constructs a deferred image for an image that was already decoded, which
+ * allows postponing the creation of its pixmap until it is first needed.
+ */
+DeferredImage::DeferredImage(const ImageReference &reference,
+                             const QImage &decodedImage)
+    : mReference(reference)
+    , mDecoded(true)
+    , mImage(decodedImage)
+{
+}
+
+/**
+ * Decodes the image, unless that has already happened. May be called from
+ * any thread.
+ *
+ * Returns whether the image could be decoded.
+ */
+bool DeferredImage::decode()
+{
+    QMutexLocker locker(&mMutex);
+
+    if (!mDecoded) {
+        mImage = mReference.create();
+        mDecoded = true;
+    }
+
+    return !mImage.isNull() || !mPixmap.isNull();
+}
+
+/**
+ * Returns the image as a pixmap, decoding it first when needed. The
+ * transparent color of the image reference, if any, is masked out.
+ *
+ * Returns a null pixmap when the image could not be decoded, which callers
+ * need to report as a loading error.
+ *
+ * Since it creates a pixmap, this function may only be called from the GUI
+ * thread.
+ */
+QPixmap DeferredImage::pixmap()
+{
+    decode();
+
+    QMutexLocker locker(&mMutex);
+
+    if (!mImage.isNull()) {
+        mPixmap = QPixmap::fromImage(mImage);
+
+        const QColor &transparent = mReference.transparentColor;
+        if (transparent.isValid()) {
+            const QImage mask = mImage.createMaskFromColor(transparent.rgb());
+            mPixmap.setMask(QBitmap::fromImage(mask));
+        }
+
+        // The pixmap holds the image data from now on
+        mImage = QImage();
+    }
+
+    return mPixmap;
+}
+
+/**
+ * Starts decoding \a image on the global thread pool. Does nothing when it
+ * has already been decoded.
+ */
+void DeferredImage::decodeInBackground(const QSharedPointer<DeferredImage> &image)
+{
+    {
+        QMutexLocker locker(&image->mMutex);
+        if (image->mDecoded)
+            return;
+    }
+
+    QThreadPool::globalInstance()->start(new DecodeTask(image));
+}
+
+/**
+ * Returns whether pixmaps may be created on the calling thread, which is
+ * only the case for the GUI thread. Elsewhere, for example while a map is
+ * read in the background, images are kept in a DeferredImage instead.
+ */
+bool DeferredImage::canCreatePixmaps()
+{
+    const QCoreApplication *app = QCoreApplication::instance();
+    return app && QThread::currentThread() == app->thread();
+}
+
+} // namespace Tiled
@@ -0,0 +1,73 @@
+/*
+ * deferredimage.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "imagereference.h"
+#include "tiled_global.h"
+
+#include <QImage>
+#include <QMutex>
+#include <QPixmap>
+#include <QSharedPointer>
+
+namespace Tiled {
+
+/**
+ * An image that is only decoded when it is first needed.
+ *
+ * The image is decoded at most once. Decoding may be started on the global
+ * thread pool using decodeInBackground(), in which case pixmap() waits for
+ * it to finish instead of decoding the image again.
+ */
+class TILEDSHARED_EXPORT DeferredImage
+{
+public:
+    explicit DeferredImage(const ImageReference &reference);
+    DeferredImage(const ImageReference &reference, const QImage &decodedImage);
+
+    const ImageReference &reference() const { return mReference; }
+
+    bool decode();
+    QPixmap pixmap();
+
+    static void decodeInBackground(const QSharedPointer<DeferredImage> &image);
+
+    static bool canCreatePixmaps();
+
+private:
+    const ImageReference mReference;
+
+    QMutex mMutex;
+    bool mDecoded;
+    QImage mImage;
+
+    QPixmap mPixmap;
+};
+
+} // namespace Tiled
@@ -0,0 +1,238 @@
+/*
+ * floodfill.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "floodfill.h"
+
+#include "tilelayer.h"
+
+#include <QQueue>
+
+#include <algorithm>
+
+using namespace Tiled;
+
+/**
+ * Computes the area covered by filling from \a fillOrigin, which is in map
+ * coordinates. The \a orientation, \a staggerAxis and \a staggerIndex
+ * determine which cells are adjacent to each other.
+ */
+FloodFill FloodFill::compute(const TileLayer *layer,
+                             const QPoint &fillOrigin,
+                             Map::Orientation orientation,
+                             Map::StaggerAxis staggerAxis,
+                             Map::StaggerIndex staggerIndex)
+{
+    FloodFill fill;
+
+    QRect bounds = layer->map()->infinite() ? layer->bounds() : layer->rect();
+
+    // Silently quit if parameters are unsatisfactory
+    if (!bounds.contains(fillOrigin))
+        return fill;
+
+    fill.mBounds = bounds;
+    fill.mFilled.resize(bounds.width() * bounds.height());
+
+    bounds.translate(-layer->position());
+    const QPoint origin = fillOrigin - layer->position();
+
+    // Cache cell that we will match other cells against
+    const Cell matchCell = layer->cellAt(origin);
+
+    const int startX = bounds.left();
+    const int startY = bounds.top();
+    const int endX = bounds.right() + 1;
+    const int endY = bounds.bottom() + 1;
+    const int layerWidth = endX - startX;
+
+    const int indexOffset = -(startX + startY * layerWidth);
+
+    const bool isStaggered = orientation == Map::Hexagonal || orientation == Map::Staggered;
+
+    // Create a queue to hold cells that need filling
+    QQueue<QPoint> fillPositions;
+    fillPositions.enqueue(origin);
+
+    // Create a bitmap that will store which cells have been processed
+    // This is faster than checking if a given cell is in the region/list
+    QBitArray processedCells(bounds.width() * bounds.height());
+    processedCells.setBit(indexOffset + origin.y() * layerWidth + origin.x());
+
+    // Loop through queued positions and fill them, while at the same time
+    // checking adjacent positions to see if they should be added
+    while (!fillPositions.isEmpty()) {
+        const QPoint currentPoint = fillPositions.dequeue();
+        const int startOfLine = indexOffset + currentPoint.y() * layerWidth;
+
+        // Skip positions that were already filled as part of another run
+        if (fill.mFilled.testBit(startOfLine + currentPoint.x()))
+            continue;
+
+        // Seek as far left as we can
+        int left = currentPoint.x();
+        while (left > startX && layer->cellAt(left - 1, currentPoint.y()) == matchCell) {
+            --left;
+            processedCells.setBit(startOfLine + left);
+        }
+
+        // Seek as far right as we can
+        int right = currentPoint.x();
+        while (right + 1 < endX && layer->cellAt(right + 1, currentPoint.y()) == matchCell) {
+            ++right;
+            processedCells.setBit(startOfLine + right);
+        }
+
+        // Add cells between left and right to the fill
+        fill.mFilled.fill(true, startOfLine + left, startOfLine + right + 1);
+        fill.mSpans.append(Span { currentPoint.y() + layer->y(),
+                                  left + layer->x(),
+                                  right + layer->x() });
+
+        bool leftColumnIsStaggered = false;
+        bool rightColumnIsStaggered = false;
+
+        // For hexagonal maps with a staggered Y-axis, we may need to extend the search range
+        if (isStaggered) {
+            if (staggerAxis == Map::StaggerY) {
+                bool rowIsStaggered = ((layer->y() + currentPoint.y()) & 1) ^ staggerIndex;
+                if (rowIsStaggered)
+                    right = qMin(right + 1, endX - 1);
+                else
+                    left = qMax(left - 1, startX);
+            } else {
+                leftColumnIsStaggered = ((layer->x() + left) & 1) ^ staggerIndex;
+                rightColumnIsStaggered = ((layer->x() + right) & 1) ^ staggerIndex;
+            }
+        }
+
+        // Loop between left and right and check if cells above or below need
+        // to be added to the queue.
+        auto findFillPositions = [&](int left, int right, int y) {
+            bool adjacentCellAdded = false;
+
+            for (int x = left; x <= right; ++x) {
+                const int index = indexOffset + y * layerWidth + x;
+
+                if (!processedCells.testBit(index) && layer->cellAt(x, y) == matchCell) {
+                    // Do not add the cell to the queue if an adjacent cell was added.
+                    if (!adjacentCellAdded) {
+                        fillPositions.enqueue(QPoint(x, y));
+                        adjacentCellAdded = true;
+                    }
+                } else {
+                    adjacentCellAdded = false;
+                }
+
+                processedCells.setBit(index);
+            }
+        };
+
+        if (currentPoint.y() > startY) {
+            int _left = left;
+            int _right = right;
+
+            if (isStaggered && staggerAxis == Map::StaggerX) {
+                if (!leftColumnIsStaggered)
+                    _left = qMax(left - 1, startX);
+                if (!rightColumnIsStaggered)
+                    _right = qMin(right + 1, endX - 1);
+            }
+
+            findFillPositions(_left, _right, currentPoint.y() - 1);
+        }
+
+        if (currentPoint.y() + 1 < endY) {
+            int _left = left;
+            int _right = right;
+
+            if (isStaggered && staggerAxis == Map::StaggerX) {
+                if (leftColumnIsStaggered)
+                    _left = qMax(left - 1, startX);
+                if (rightColumnIsStaggered)
+                    _right = qMin(right + 1, endX - 1);
+            }
+
+            findFillPositions(_left, _right, currentPoint.y() + 1);
+        }
+    }
+
+    std::sort(fill.mSpans.begin(), fill.mSpans.end(),
+              [] (const Span &a, const Span &b) {
+        return a.y < b.y || (a.y == b.y && a.left < b.left);
+    });
+
+    return fill;
+}
+
+/**
+ * Returns the area as a QRegion. Consecutive rows with the same runs are
+ * combined into a single band of rectangles.
+ */
+QRegion FloodFill::toRegion() const
+{
+    QVector<QRect> rects;
+    int bandStart = 0;      // index of the first rect of the last band
+    int previousRow = 0;    // index of the first span of the previous row
+
+    for (int i = 0; i < mSpans.size(); ) {
+        const int y = mSpans.at(i).y;
+
+        int rowEnd = i + 1;
+        while (rowEnd < mSpans.size() && mSpans.at(rowEnd).y == y)
+            ++rowEnd;
+
+        // Check whether this row has the same runs as the previous one
+        bool sameAsPrevious = i > 0
+                && mSpans.at(previousRow).y == y - 1
+                && rects.size() - bandStart == rowEnd - i;
+
+        for (int j = i; sameAsPrevious && j < rowEnd; ++j) {
+            const QRect &rect = rects.at(bandStart + j - i);
+            sameAsPrevious = rect.left() == mSpans.at(j).left &&
+                    rect.right() == mSpans.at(j).right;
+        }
+
+        if (sameAsPrevious) {
+            for (int j = bandStart; j < rects.size(); ++j)
+                rects[j].setBottom(y);
+        } else {
+            bandStart = rects.size();
+            for (int j = i; j < rowEnd; ++j) {
+                const Span &span = mSpans.at(j);
+                rects.append(QRect(QPoint(span.left, y), QPoint(span.right, y)));
+            }
+        }
+
+        previousRow = i;
+        i = rowEnd;
+    }
+
+    QRegion region;
+    region.setRects(rects.constData(), rects.size());
+    return region;
+}
@@ -0,0 +1,99 @@
+/*
+ * floodfill.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "map.h"
+
+#include <QBitArray>
+#include <QPoint>
+#include <QRect>
+#include <QRegion>
+#include <QVector>
+
+namespace Tiled {
+
+class TileLayer;
+
+/**
+ * The area covered by a flood fill: all cells of the same type as the cell
+ * at the fill origin that are connected to it.
+ *
+ * The area is stored as horizontal runs of cells, along with a bitmap that
+ * allows quickly checking whether a cell is part of it. It is only converted
+ * to a QRegion when needed, since building a QRegion one run at a time gets
+ * slow for fragmented areas.
+ */
+class TILEDSHARED_EXPORT FloodFill
+{
+public:
+    /**
+     * A run of cells on row \a y, from \a left to \a right inclusive.
+     */
+    struct Span
+    {
+        int y;
+        int left;
+        int right;
+    };
+
+    FloodFill() {}
+
+    static FloodFill compute(const TileLayer *layer,
+                             const QPoint &fillOrigin,
+                             Map::Orientation orientation,
+                             Map::StaggerAxis staggerAxis,
+                             Map::StaggerIndex staggerIndex);
+
+    bool isEmpty() const { return mSpans.isEmpty(); }
+    bool contains(const QPoint &point) const;
+
+    /**
+     * Returns the runs of cells making up the area, in map coordinates.
+     * They are sorted by row and then by column.
+     */
+    const QVector<Span> &spans() const { return mSpans; }
+
+    QRegion toRegion() const;
+
+private:
+    QRect mBounds;
+    QBitArray mFilled;
+    QVector<Span> mSpans;
+};
+
+inline bool FloodFill::contains(const QPoint &point) const
+{
+    if (!mBounds.contains(point))
+        return false;
+
+    const QPoint p = point - mBounds.topLeft();
+    return mFilled.testBit(p.y() * mBounds.width() + p.x());
+}
+
+} // namespace Tiled
@@ -29,10 +29,13 @@
 #include "gidmapper.h"
 
 #include "compression.h"
+#include "parallel.h"
 #include "tile.h"
 #include "tiled.h"
 #include "tileset.h"
 
+#include <limits>
+
 using namespace Tiled;
 
 // Bits on the far end of the 32-bit global tile ID are used for tile flags
@@ -42,6 +45,9 @@ const int FlippedAntiDiagonallyFlag = 0x20000000;
 
 const int RotatedHexagonal120Flag   = 0x10000000;
 
+// The largest size of a QByteArray, leaving room for its header
+static const qint64 MaxByteArraySize = std::numeric_limits<int>::max() - 32;
+
 /**
  * Default constructor. Use \l insert to initialize the gid mapper
  * incrementally.
@@ -118,18 +124,12 @@ unsigned GidMapper::cellToGid(const Cell &cell) const
     if (cell.isEmpty())
         return 0;
 
-    const Tileset *tileset = cell.tileset();
-
     // Find the first GID for the tileset
-    QMap<unsigned, Tileset*>::const_iterator i = mFirstGidToTileset.begin();
-    QMap<unsigned, Tileset*>::const_iterator i_end = mFirstGidToTileset.end();
-    while (i != i_end && i.value() != tileset)
-        ++i;
-
-    if (i == i_end) // tileset not found
+    const auto i = mTilesetToFirstGid.find(cell.tileset());
+    if (i == mTilesetToFirstGid.end()) // tileset not found
         return 0;
 
-    unsigned gid = i.key() + cell.tileId();
+    unsigned gid = i.value() + cell.tileId();
     if (cell.flippedHorizontally())
         gid |= FlippedHorizontallyFlag;
     if (cell.flippedVertically())
@@ -142,38 +142,122 @@ unsigned GidMapper::cellToGid(const Cell &cell) const
     return gid;
 }
 
+/**
+ * Stores the global tile IDs of the cells of \a tileLayer within \a bounds
+ * in \a gids, in row-major order. Large areas are processed in parallel.
+ */
+void GidMapper::cellsToGids(const TileLayer &tileLayer,
+                            const QRect &bounds,
+                            unsigned *gids) const
+{
+    const int MinimumCellsPerBand = 16384;
+
+    const int width = bounds.width();
+    const int height = bounds.height();
+    const qint64 cellCount = qint64(width) * height;
+    const int bands = static_cast<int>(qBound<qint64>(1, cellCount / MinimumCellsPerBand, height));
+
+    parallelFor(bands, [&] (int band) {
+        const int top = bounds.top() + static_cast<int>(qint64(height) * band / bands);
+        const int bottom = bounds.top() + static_cast<int>(qint64(height) * (band + 1) / bands);
+
+        CellReader reader(&tileLayer);
+        unsigned *gid = gids + qint64(top - bounds.top()) * width;
+
+        for (int y = top; y < bottom; ++y)
+            for (int x = bounds.left(); x <= bounds.right(); ++x)
+                *gid++ = cellToGid(reader.cellAt(x, y));
+    });
+}
+
+/**
+ * Writes the decimal representation of \a value to \a out, returning the
+ * position after the last written character.
+ */
+static char *writeNumber(char *out, unsigned value)
+{
+    char digits[10];
+    int count = 0;
+
+    do {
+        digits[count++] = char('0' + value % 10);
+        value /= 10;
+    } while (value);
+
+    while (count)
+        *out++ = digits[--count];
+
+    return out;
+}
+
 /**
  * Encodes the tile layer data of the given \a tileLayer in the given
- * \a format. This function should only be used for base64 encoding, with or
- * without compression.
+ * \a format. This function should only be used for CSV and base64 encoding,
+ * with or without compression.
+ *
+ * For CSV, the global tile IDs are separated by commas and each row ends
+ * with a newline. For compressed formats, the \a compressionLevel is
+ * passed on to compress().
+ *
+ * Returns a null byte array when the encoded data would not fit in a
+ * QByteArray.
+ *
+ * This function is thread-safe.
  */
 QByteArray GidMapper::encodeLayerData(const TileLayer &tileLayer,
                                       Map::LayerDataFormat format,
-                                      QRect bounds) const
+                                      QRect bounds,
+                                      int compressionLevel) const
 {
     Q_ASSERT(format != Map::XML);
-    Q_ASSERT(format != Map::CSV);
 
     if (bounds.isEmpty())
         bounds = QRect(0, 0, tileLayer.width(), tileLayer.height());
 
-    QByteArray tileData;
-    tileData.reserve(bounds.width() * bounds.height() * 4);
-
-    for (int y = bounds.top(); y <= bounds.bottom(); ++y) {
-        for (int x = bounds.left(); x <= bounds.right(); ++x) {
-            const unsigned gid = cellToGid(tileLayer.cellAt(x, y));
-            tileData.append((char) (gid));
-            tileData.append((char) (gid >> 8));
-            tileData.append((char) (gid >> 16));
-            tileData.append((char) (gid >> 24));
+    const qint64 count = qint64(bounds.width()) * bounds.height();
+
+    // The base64 encoding of the binary data is 4/3 of its size
+    const qint64 encodedSize = format == Map::CSV ? count * 11 + bounds.height()
+                                                  : (count * 4 + 2) / 3 * 4;
+    if (encodedSize > MaxByteArraySize)
+        return QByteArray();
+
+    QVector<unsigned> gids(int(count));
+    cellsToGids(tileLayer, bounds, gids.data());
+
+    if (format == Map::CSV) {
+        // At most 10 digits and a comma for each tile, and a newline for
+        // each row
+        QByteArray text(int(encodedSize), Qt::Uninitialized);
+        char *out = text.data();
+        const unsigned *gid = gids.constData();
+        const unsigned *lastGid = gid + count - 1;
+
+        for (int y = 0; y < bounds.height(); ++y) {
+            for (int x = 0; x < bounds.width(); ++x) {
+                out = writeNumber(out, *gid);
+                if (gid++ != lastGid)
+                    *out++ = ',';
+            }
+            *out++ = '\n';
         }
+
+        text.truncate(int(out - text.constData()));
+        return text;
+    }
+
+    QByteArray tileData(int(count * 4), Qt::Uninitialized);
+    uchar *data = reinterpret_cast<uchar*>(tileData.data());
+
+    for (const unsigned gid : gids) {
+        *data++ = uchar(gid);
+        *data++ = uchar(gid >> 8);
+        *data++ = uchar(gid >> 16);
+        *data++ = uchar(gid >> 24);
     }
 
-    if (format == Map::Base64Gzip)
-        tileData = compress(tileData, Gzip);
-    else if (format == Map::Base64Zlib)
-        tileData = compress(tileData, Zlib);
+    if (isCompressed(format))
+        tileData = compress(tileData, compressionMethod(format), compressionLevel);
 
     return tileData.toBase64();
 }
@@ -190,13 +274,24 @@ GidMapper::DecodeError GidMapper::decodeLayerData(TileLayer &tileLayer,
         bounds = QRect(0, 0, tileLayer.width(), tileLayer.height());
 
     QByteArray decodedData = QByteArray::fromBase64(layerData);
-    const int size = (bounds.width() * bounds.height()) * 4;
+    const qint64 size64 = qint64(bounds.width()) * bounds.height() * 4;
+    if (size64 > MaxByteArraySize)
+        return CorruptLayerData;
 
-    if (format == Map::Base64Gzip || format == Map::Base64Zlib)
-        decodedData = decompress(decodedData, size);
+    const int size = int(size64);
 
-    if (size != decodedData.length())
+    if (isCompressed(format)) {
+        // Decompress straight into a buffer of the expected size
+        QByteArray compressedData;
+        compressedData.swap(decodedData);
+        decodedData.resize(size);
+
+        if (!decompress(compressedData, decodedData.data(), size,
+                        compressionMethod(format)))
+            return CorruptLayerData;
+    } else if (size != decodedData.length()) {
         return CorruptLayerData;
+    }
 
     const unsigned char *data = reinterpret_cast<const unsigned char*>(decodedData.constData());
     int x = bounds.x();
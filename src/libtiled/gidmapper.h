@@ -31,6 +31,7 @@
 #include "map.h"
 #include "tilelayer.h"
 
+#include <QHash>
 #include <QMap>
 
 namespace Tiled {
@@ -50,10 +51,14 @@ public:
 
     Cell gidToCell(unsigned gid, bool &ok) const;
     unsigned cellToGid(const Cell &cell) const;
+    void cellsToGids(const TileLayer &tileLayer,
+                     const QRect &bounds,
+                     unsigned *gids) const;
 
     QByteArray encodeLayerData(const TileLayer &tileLayer,
                                Map::LayerDataFormat format,
-                               QRect bounds = QRect()) const;
+                               QRect bounds = QRect(),
+                               int compressionLevel = -1) const;
 
     enum DecodeError {
         NoError = 0,
@@ -71,6 +76,7 @@ public:
 
 private:
     QMap<unsigned, Tileset*> mFirstGidToTileset;
+    QHash<Tileset*, unsigned> mTilesetToFirstGid;
 
     mutable unsigned mInvalidTile;
 };
@@ -82,6 +88,12 @@ private:
 inline void GidMapper::insert(unsigned firstGid, Tileset *tileset)
 {
     mFirstGidToTileset.insert(firstGid, tileset);
+
+    auto it = mTilesetToFirstGid.find(tileset);
+    if (it == mTilesetToFirstGid.end())
+        mTilesetToFirstGid.insert(tileset, firstGid);
+    else if (firstGid < it.value())
+        it.value() = firstGid;
 }
 
 /**
@@ -90,6 +102,7 @@ inline void GidMapper::insert(unsigned firstGid, Tileset *tileset)
 inline void GidMapper::clear()
 {
     mFirstGidToTileset.clear();
+    mTilesetToFirstGid.clear();
 }
 
 /**
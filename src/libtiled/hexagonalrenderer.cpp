@@ -308,6 +308,7 @@ void HexagonalRenderer::drawTileLayer(QPainter *painter,
         startTile.rx()--;
 
     CellRenderer renderer(painter, CellRenderer::HexagonalCells);
+    CellReader reader(layer);
 
     const int endX = map()->infinite() ? layer->bounds().right() - layer->x() + 1 : layer->width();
     const int endY = map()->infinite() ? layer->bounds().bottom() - layer->y() + 1 : layer->height();
@@ -328,7 +329,7 @@ void HexagonalRenderer::drawTileLayer(QPainter *painter,
             QPoint rowPos = startPos;
 
             for (; rowPos.x() < rect.right() && rowTile.x() < endX; rowTile.rx() += 2) {
-                const Cell &cell = layer->cellAt(rowTile);
+                const Cell cell = reader.cellAt(rowTile);
 
                 if (!cell.isEmpty()) {
                     Tile *tile = cell.tile();
@@ -373,7 +374,7 @@ void HexagonalRenderer::drawTileLayer(QPainter *painter,
                 rowPos.rx() += p.columnWidth;
 
             for (; rowPos.x() < rect.right() && rowTile.x() < endX; rowTile.rx()++) {
-                const Cell &cell = layer->cellAt(rowTile);
+                const Cell cell = reader.cellAt(rowTile);
 
                 if (!cell.isEmpty()) {
                     Tile *tile = cell.tile();
@@ -28,6 +28,7 @@
  */
 
 #include "imagelayer.h"
+#include "deferredimage.h"
 #include "map.h"
 
 #include <QBitmap>
@@ -43,19 +44,44 @@ ImageLayer::~ImageLayer()
 {
 }
 
+const QPixmap &ImageLayer::image() const
+{
+    if (mDeferredImage) {
+        Q_ASSERT(DeferredImage::canCreatePixmaps());
+        mImage = mDeferredImage->pixmap();
+        mDeferredImage.reset();
+    }
+    return mImage;
+}
+
+void ImageLayer::setImage(const QPixmap &image)
+{
+    mImage = image;
+    mDeferredImage.reset();
+}
+
 void ImageLayer::resetImage()
 {
     mImage = QPixmap();
+    mDeferredImage.reset();
     mImageSource.clear();
 }
 
 bool ImageLayer::loadFromImage(const QImage &image, const QUrl &source)
 {
     mImageSource = source;
+    mImage = QPixmap();
+    mDeferredImage.reset();
 
-    if (image.isNull()) {
-        mImage = QPixmap();
+    if (image.isNull())
         return false;
+
+    if (!DeferredImage::canCreatePixmaps()) {
+        ImageReference reference;
+        reference.source = source;
+        reference.transparentColor = mTransparentColor;
+        mDeferredImage = QSharedPointer<DeferredImage>::create(reference, image);
+        return true;
     }
 
     mImage = QPixmap::fromImage(image);
@@ -81,7 +107,7 @@ bool ImageLayer::loadFromImage(const QImage &image, const QString &source)
 
 bool ImageLayer::isEmpty() const
 {
-    return mImage.isNull();
+    return mImage.isNull() && !mDeferredImage;
 }
 
 ImageLayer *ImageLayer::clone() const
@@ -96,6 +122,7 @@ ImageLayer *ImageLayer::initializeClone(ImageLayer *clone) const
     clone->mImageSource = mImageSource;
     clone->mTransparentColor = mTransparentColor;
     clone->mImage = mImage;
+    clone->mDeferredImage = mDeferredImage;
 
     return clone;
 }
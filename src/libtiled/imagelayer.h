@@ -35,11 +35,14 @@
 
 #include <QColor>
 #include <QPixmap>
+#include <QSharedPointer>
 
 class QImage;
 
 namespace Tiled {
 
+class DeferredImage;
+
 /**
  * An image on a map.
  */
@@ -86,14 +89,16 @@ public:
     const QUrl &imageSource() const { return mImageSource; }
 
     /**
-      * Returns the image of this layer.
+      * Returns the image of this layer. When the image is deferred, it is
+      * decoded by the first call, which may therefore only happen on the GUI
+      * thread (see DeferredImage::canCreatePixmaps()).
       */
-    const QPixmap &image() const { return mImage; }
+    const QPixmap &image() const;
 
     /**
       * Sets the image of this layer.
       */
-    void setImage(const QPixmap &image) { mImage = image; }
+    void setImage(const QPixmap &image);
 
     /**
      * Resets layer image.
@@ -105,6 +110,9 @@ public:
      * image. The \a fileName becomes the new imageSource, regardless of
      * whether the image could be loaded.
      *
+     * When called off the GUI thread, the pixmap is only created once the
+     * image is first requested.
+     *
      * @param image    the image to load the layer from
      * @param source   the URL of the image, which will be remembered
      *                 as the image source of this layer.
@@ -129,7 +137,8 @@ protected:
 private:
     QUrl mImageSource;
     QColor mTransparentColor;
-    QPixmap mImage;
+    mutable QPixmap mImage;
+    mutable QSharedPointer<DeferredImage> mDeferredImage;
 };
 
 
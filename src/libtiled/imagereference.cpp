@@ -20,8 +20,40 @@
 
 #include "imagereference.h"
 
+#include <QAtomicInt>
+#include <QBuffer>
+#include <QImageReader>
+
 namespace Tiled {
 
+// Atomic since it is read by the threads that read maps in the background
+static QAtomicInt sImageLoadingMode(LoadImagesOnDemand);
+
+/**
+ * Returns when the images referenced by tilesets are decoded. By default,
+ * this happens when they are first needed.
+ */
+ImageLoadingMode imageLoadingMode()
+{
+    return ImageLoadingMode(sImageLoadingMode.loadAcquire());
+}
+
+/**
+ * Sets when the images referenced by tilesets are decoded. This affects all
+ * tilesets read after the call, regardless of the map format.
+ *
+ * Tools that never draw anything can use SkipImages to avoid reading more
+ * than the header of each image.
+ *
+ * This is a process-wide setting, meant to be set once at startup before
+ * any maps or tilesets are read. Reads that are in progress on other threads
+ * while the mode is changed may use either mode.
+ */
+void setImageLoadingMode(ImageLoadingMode mode)
+{
+    sImageLoadingMode.storeRelease(mode);
+}
+
 bool ImageReference::hasImage() const
 {
     return !source.isEmpty() || !data.isEmpty();
@@ -37,4 +69,33 @@ QImage ImageReference::create() const
     return QImage();
 }
 
+/**
+ * Returns the size of the referenced image, or an invalid size when the
+ * image can't be read. For most image formats, this only reads the header
+ * of the image.
+ */
+QSize ImageReference::readSize() const
+{
+    QBuffer buffer;
+    QImageReader reader;
+
+    if (source.isLocalFile()) {
+        reader.setFileName(source.toLocalFile());
+    } else if (!data.isEmpty()) {
+        buffer.setData(data);
+        reader.setDevice(&buffer);
+        reader.setFormat(format);
+    } else {
+        return QSize();
+    }
+
+    QSize size = reader.size();
+
+    // Some formats need to be decoded to know their size
+    if (!size.isValid())
+        size = reader.read().size();
+
+    return size;
+}
+
 } // namespace Tiled
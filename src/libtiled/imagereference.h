@@ -28,6 +28,18 @@
 
 namespace Tiled {
 
+/**
+ * Determines when the images referenced by tilesets are decoded.
+ */
+enum ImageLoadingMode {
+    LoadImagesImmediately,  ///< Decode the images while reading the tileset
+    LoadImagesOnDemand,     ///< Decode the images when they are first needed
+    SkipImages              ///< Only read the image sizes (except for embedded images)
+};
+
+TILEDSHARED_EXPORT ImageLoadingMode imageLoadingMode();
+TILEDSHARED_EXPORT void setImageLoadingMode(ImageLoadingMode mode);
+
 class ImageReference
 {
 public:
@@ -42,6 +54,7 @@ public:
 
     bool hasImage() const;
     QImage create() const;
+    QSize readSize() const;
 };
 
 } // namespace Tiled
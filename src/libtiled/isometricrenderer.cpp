@@ -261,6 +261,7 @@ void IsometricRenderer::drawTileLayer(QPainter *painter,
     bool shifted = inUpperHalf ^ inLeftHalf;
 
     CellRenderer renderer(painter);
+    CellReader reader(layer);
 
     for (int y = startPos.y() * 2; y - tileHeight * 2 < rect.bottom() * 2;
          y += tileHeight)
@@ -268,7 +269,7 @@ void IsometricRenderer::drawTileLayer(QPainter *painter,
         QPoint columnItr = rowItr;
 
         for (int x = startPos.x(); x < rect.right(); x += tileWidth) {
-            const Cell &cell = layer->cellAt(columnItr);
+            const Cell cell = reader.cellAt(columnItr);
             if (!cell.isEmpty()) {
                 Tile *tile = cell.tile();
                 QSize size = tile ? tile->size() : map()->tileSize();
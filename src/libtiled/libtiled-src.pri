@@ -1,7 +1,9 @@
 INCLUDEPATH += $$PWD
 
 SOURCES += $$PWD/compression.cpp \
+    $$PWD/deferredimage.cpp \
     $$PWD/filesystemwatcher.cpp \
+    $$PWD/floodfill.cpp \
     $$PWD/gidmapper.cpp \
     $$PWD/grouplayer.cpp \
     $$PWD/hex.cpp \
@@ -19,6 +21,7 @@ SOURCES += $$PWD/compression.cpp \
     $$PWD/objectgroup.cpp \
     $$PWD/objecttemplate.cpp \
     $$PWD/orthogonalrenderer.cpp \
+    $$PWD/parallel.cpp \
     $$PWD/plugin.cpp \
     $$PWD/pluginmanager.cpp \
     $$PWD/properties.cpp \
@@ -32,13 +35,16 @@ SOURCES += $$PWD/compression.cpp \
     $$PWD/tileanimationdriver.cpp \
     $$PWD/tiled.cpp \
     $$PWD/tilelayer.cpp \
+    $$PWD/tilelayerdelta.cpp \
     $$PWD/tileset.cpp \
     $$PWD/tilesetformat.cpp \
     $$PWD/tilesetmanager.cpp \
     $$PWD/varianttomapconverter.cpp \
     $$PWD/wangset.cpp
 HEADERS += $$PWD/compression.h \
+    $$PWD/deferredimage.h \
     $$PWD/filesystemwatcher.h \
+    $$PWD/floodfill.h \
     $$PWD/gidmapper.h \
     $$PWD/grouplayer.h \
     $$PWD/hex.h \
@@ -59,6 +65,7 @@ HEADERS += $$PWD/compression.h \
     $$PWD/objectgroup.h \
     $$PWD/objecttemplate.h \
     $$PWD/orthogonalrenderer.h \
+    $$PWD/parallel.h \
     $$PWD/plugin.h \
     $$PWD/pluginmanager.h \
     $$PWD/properties.h \
@@ -74,6 +81,7 @@ HEADERS += $$PWD/compression.h \
     $$PWD/tiled.h \
     $$PWD/tiled_global.h \
     $$PWD/tilelayer.h \
+    $$PWD/tilelayerdelta.h \
     $$PWD/tileset.h \
     $$PWD/tilesetformat.h \
     $$PWD/tilesetmanager.h \
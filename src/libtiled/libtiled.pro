@@ -17,6 +17,17 @@ win32 {
 } else {
     # On other platforms it is necessary to link to zlib explicitly
     LIBS += -lz
+
+    # Zstandard and LZ4 compression of tile layer data are optional
+    CONFIG += link_pkgconfig
+    packagesExist(libzstd) {
+        PKGCONFIG += libzstd
+        DEFINES += TILED_ZSTD_SUPPORT
+    }
+    packagesExist(liblz4) {
+        PKGCONFIG += liblz4
+        DEFINES += TILED_LZ4_SUPPORT
+    }
 }
 
 DEFINES += QT_NO_CAST_FROM_ASCII \
@@ -56,6 +56,7 @@ Map::Map(Orientation orientation,
     mStaggerIndex(StaggerOdd),
     mDrawMarginsDirty(true),
     mLayerDataFormat(Base64Zlib),
+    mCompressionLevel(-1),
     mNextObjectId(1)
 {
 }
@@ -77,6 +78,7 @@ Map::Map(const Map &map):
     mDrawMarginsDirty(map.mDrawMarginsDirty),
     mTilesets(map.mTilesets),
     mLayerDataFormat(map.mLayerDataFormat),
+    mCompressionLevel(map.mCompressionLevel),
     mNextObjectId(1)
 {
     for (const Layer *layer : map.mLayers) {
@@ -438,3 +440,49 @@ Map::RenderOrder Tiled::renderOrderFromString(const QString &string)
     }
     return renderOrder;
 }
+
+/**
+ * Returns whether the given layer data \a format uses compression.
+ */
+bool Tiled::isCompressed(Map::LayerDataFormat format)
+{
+    switch (format) {
+    case Map::Base64Gzip:
+    case Map::Base64Zlib:
+    case Map::Base64Zstd:
+    case Map::Base64Lz4:
+        return true;
+    case Map::XML:
+    case Map::Base64:
+    case Map::CSV:
+        break;
+    }
+    return false;
+}
+
+/**
+ * Returns the compression method used by the given layer data \a format.
+ * Only meaningful when isCompressed() returns true for this format.
+ */
+CompressionMethod Tiled::compressionMethod(Map::LayerDataFormat format)
+{
+    switch (format) {
+    case Map::Base64Gzip:
+        return Gzip;
+    case Map::Base64Zstd:
+        return Zstandard;
+    case Map::Base64Lz4:
+        return Lz4;
+    default:
+        return Zlib;
+    }
+}
+
+/**
+ * Returns whether the given layer data \a format can be used. Formats
+ * relying on optional compression libraries may not be available.
+ */
+bool Tiled::layerDataFormatSupported(Map::LayerDataFormat format)
+{
+    return !isCompressed(format) || compressionSupported(compressionMethod(format));
+}
@@ -30,6 +30,7 @@
 
 #pragma once
 
+#include "compression.h"
 #include "layer.h"
 #include "object.h"
 #include "tileset.h"
@@ -78,7 +79,9 @@ public:
         Base64     = 1,
         Base64Gzip = 2,
         Base64Zlib = 3,
-        CSV        = 4
+        CSV        = 4,
+        Base64Zstd = 5,
+        Base64Lz4  = 6
     };
 
     /**
@@ -387,6 +390,15 @@ public:
     void setLayerDataFormat(LayerDataFormat format)
     { mLayerDataFormat = format; }
 
+    /**
+     * Returns the compression level used for compressed layer data, or -1
+     * to use the default level of the compression method.
+     */
+    int compressionLevel() const
+    { return mCompressionLevel; }
+    void setCompressionLevel(int compressionLevel)
+    { mCompressionLevel = compressionLevel; }
+
     void setNextObjectId(int nextId);
     int nextObjectId() const;
     int takeNextObjectId();
@@ -416,6 +428,7 @@ private:
     QVector<SharedTileset> mTilesets;
     QList<TemplateGroup*> mTemplateGroups;
     LayerDataFormat mLayerDataFormat;
+    int mCompressionLevel;
     int mNextObjectId;
 };
 
@@ -512,6 +525,10 @@ TILEDSHARED_EXPORT Map::Orientation orientationFromString(const QString &);
 TILEDSHARED_EXPORT QString renderOrderToString(Map::RenderOrder renderOrder);
 TILEDSHARED_EXPORT Map::RenderOrder renderOrderFromString(const QString &);
 
+TILEDSHARED_EXPORT bool isCompressed(Map::LayerDataFormat format);
+TILEDSHARED_EXPORT CompressionMethod compressionMethod(Map::LayerDataFormat format);
+TILEDSHARED_EXPORT bool layerDataFormatSupported(Map::LayerDataFormat format);
+
 } // namespace Tiled
 
 Q_DECLARE_METATYPE(Tiled::Map::Orientation)
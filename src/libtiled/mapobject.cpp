@@ -196,8 +196,8 @@ void MapObject::setMapObjectProperty(Property property, const QVariant &value)
     case TextAlignmentProperty: mTextData.alignment = value.value<Qt::Alignment>(); break;
     case TextWordWrapProperty:  mTextData.wordWrap = value.toBool(); break;
     case TextColorProperty:     mTextData.color = value.value<QColor>(); break;
-    case SizeProperty:          mSize = value.toSizeF(); break;
-    case RotationProperty:      mRotation = value.toReal(); break;
+    case SizeProperty:          setSize(value.toSizeF()); break;
+    case RotationProperty:      setRotation(value.toReal()); break;
     case CellProperty:          Q_ASSERT(false); break;
     case ShapeProperty:         Q_ASSERT(false); break;
     }
@@ -311,6 +311,16 @@ TemplateGroup *MapObject::templateGroup() const
     return templateRef().templateGroup;
 }
 
+/**
+ * Lets the object group know that the position, size or shape of this object
+ * changed, so that it can update its spatial index.
+ */
+void MapObject::geometryChanged()
+{
+    if (mObjectGroup)
+        mObjectGroup->objectGeometryChanged(this);
+}
+
 void MapObject::flipRectObject(const QTransform &flipTransform)
 {
     QPointF oldBottomLeftPoint = QPointF(cos(qDegreesToRadians(rotation() + 90)) * height() + x(),
@@ -213,6 +213,8 @@ public:
     TemplateGroup *templateGroup() const;
 
 private:
+    void geometryChanged();
+
     void flipRectObject(const QTransform &flipTransform);
     void flipPolygonObject(const QTransform &flipTransform);
     void flipTileObject(const QTransform &flipTransform);
@@ -289,7 +291,10 @@ inline const QPointF &MapObject::position() const
  * Sets the position of this object.
  */
 inline void MapObject::setPosition(const QPointF &pos)
-{ mPos = pos; }
+{
+    mPos = pos;
+    geometryChanged();
+}
 
 /**
  * Returns the x position of this object.
@@ -301,7 +306,10 @@ inline qreal MapObject::x() const
  * Sets the x position of this object.
  */
 inline void MapObject::setX(qreal x)
-{ mPos.setX(x); }
+{
+    mPos.setX(x);
+    geometryChanged();
+}
 
 /**
  * Returns the y position of this object.
@@ -313,7 +321,10 @@ inline qreal MapObject::y() const
  * Sets the x position of this object.
  */
 inline void MapObject::setY(qreal y)
-{ mPos.setY(y); }
+{
+    mPos.setY(y);
+    geometryChanged();
+}
 
 /**
  * Returns the size of this object.
@@ -325,7 +336,10 @@ inline const QSizeF &MapObject::size() const
  * Sets the size of this object.
  */
 inline void MapObject::setSize(const QSizeF &size)
-{ mSize = size; }
+{
+    mSize = size;
+    geometryChanged();
+}
 
 inline void MapObject::setSize(qreal width, qreal height)
 { setSize(QSizeF(width, height)); }
@@ -340,7 +354,10 @@ inline qreal MapObject::width() const
  * Sets the width of this object.
  */
 inline void MapObject::setWidth(qreal width)
-{ mSize.setWidth(width); }
+{
+    mSize.setWidth(width);
+    geometryChanged();
+}
 
 /**
  * Returns the height of this object.
@@ -352,7 +369,10 @@ inline qreal MapObject::height() const
  * Sets the height of this object.
  */
 inline void MapObject::setHeight(qreal height)
-{ mSize.setHeight(height); }
+{
+    mSize.setHeight(height);
+    geometryChanged();
+}
 
 /**
  * Sets the position and size of this object.
@@ -361,6 +381,7 @@ inline void MapObject::setBounds(const QRectF &bounds)
 {
     mPos = bounds.topLeft();
     mSize = bounds.size();
+    geometryChanged();
 }
 
 /**
@@ -383,7 +404,10 @@ inline const QPolygonF &MapObject::polygon() const
  * \sa setShape()
  */
 inline void MapObject::setPolygon(const QPolygonF &polygon)
-{ mPolygon = polygon; }
+{
+    mPolygon = polygon;
+    geometryChanged();
+}
 
 /**
  * Returns the shape of the object.
@@ -395,7 +419,10 @@ inline MapObject::Shape MapObject::shape() const
  * Sets the shape of the object.
  */
 inline void MapObject::setShape(MapObject::Shape shape)
-{ mShape = shape; }
+{
+    mShape = shape;
+    geometryChanged();
+}
 
 /**
  * Returns true if this is a Polygon or a Polyline.
@@ -425,7 +452,10 @@ inline const Cell &MapObject::cell() const
  * \warning The object shape is ignored for tile objects!
  */
 inline void MapObject::setCell(const Cell &cell)
-{ mCell = cell; }
+{
+    mCell = cell;
+    geometryChanged();
+}
 
 inline const TemplateRef &MapObject::templateRef() const
 { return mTemplateRef; }
@@ -456,7 +486,10 @@ inline qreal MapObject::rotation() const
  * Sets the rotation of the object in degrees clockwise.
  */
 inline void MapObject::setRotation(qreal rotation)
-{ mRotation = rotation; }
+{
+    mRotation = rotation;
+    geometryChanged();
+}
 
 inline bool MapObject::isVisible() const
 { return mVisible; }
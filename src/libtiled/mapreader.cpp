@@ -36,6 +36,7 @@
 #include "imagelayer.h"
 #include "objectgroup.h"
 #include "objecttemplate.h"
+#include "parallel.h"
 #include "map.h"
 #include "mapobject.h"
 #include "templatemanager.h"
@@ -59,6 +60,21 @@ using namespace Tiled::Internal;
 namespace Tiled {
 namespace Internal {
 
+/**
+ * The encoded data of a chunk of a tile layer (or of the whole layer, for
+ * finite maps). The data is collected while reading the XML, so that it can
+ * be decoded in parallel afterwards.
+ */
+struct EncodedChunk
+{
+    QRect bounds;
+    QByteArray data;                    // base64 data
+    QString text;                       // CSV data
+
+    QSharedPointer<TileLayer> decoded;  // set when decoding succeeded
+    QString error;                      // set when decoding failed
+};
+
 class MapReaderPrivate
 {
     Q_DECLARE_TR_FUNCTIONS(MapReader)
@@ -102,14 +118,15 @@ private:
     void readTileLayerRect(TileLayer &tileLayer,
                            Map::LayerDataFormat layerDataFormat,
                            QStringRef encoding,
-                           QRect bounds);
-    void decodeBinaryLayerData(TileLayer &tileLayer,
-                               const QByteArray &data,
-                               Map::LayerDataFormat format,
-                               QRect bounds);
-    void decodeCSVLayerData(TileLayer &tileLayer,
-                            QStringRef text,
-                            QRect bounds);
+                           QRect bounds,
+                           QVector<EncodedChunk> &encodedChunks);
+    void decodeLayerData(TileLayer &tileLayer,
+                         Map::LayerDataFormat format,
+                         QVector<EncodedChunk> &encodedChunks);
+    static void decodeChunk(EncodedChunk &chunk,
+                            const GidMapper &gidMapper,
+                            Map::LayerDataFormat format,
+                            const QString &layerName);
 
     /**
      * Returns the cell for the given global tile ID. Errors are raised with
@@ -281,6 +298,12 @@ Map *MapReaderPrivate::readMap()
     mMap->setHexSideLength(hexSideLength);
     mMap->setStaggerAxis(staggerAxis);
     mMap->setStaggerIndex(staggerIndex);
+
+    bool compressionLevelOk;
+    const int compressionLevel =
+            atts.value(QLatin1String("compressionlevel")).toInt(&compressionLevelOk);
+    if (compressionLevelOk)
+        mMap->setCompressionLevel(compressionLevel);
     mMap->setRenderOrder(renderOrder);
     if (nextObjectId)
         mMap->setNextObjectId(nextObjectId);
@@ -457,13 +480,10 @@ void MapReaderPrivate::readTilesetTile(Tileset &tileset)
         } else if (xml.name() == QLatin1String("image")) {
             ImageReference imageReference = readImage();
             if (imageReference.hasImage()) {
-                QImage image = imageReference.create();
-                if (image.isNull()) {
+                if (!tileset.setTileImage(tile, imageReference)) {
                     if (imageReference.source.isEmpty())
                         xml.raiseError(tr("Error reading embedded image for tile %1").arg(id));
                 }
-                tileset.setTileImage(tile, QPixmap::fromImage(image),
-                                     imageReference.source);
             }
         } else if (xml.name() == QLatin1String("objectgroup")) {
             tile->setObjectGroup(readObjectGroup());
@@ -811,11 +831,21 @@ void MapReaderPrivate::readTileLayerData(TileLayer &tileLayer)
             layerDataFormat = Map::Base64Gzip;
         } else if (compression == QLatin1String("zlib")) {
             layerDataFormat = Map::Base64Zlib;
+        } else if (compression == QLatin1String("zstd")) {
+            layerDataFormat = Map::Base64Zstd;
+        } else if (compression == QLatin1String("lz4")) {
+            layerDataFormat = Map::Base64Lz4;
         } else {
             xml.raiseError(tr("Compression method '%1' not supported")
                            .arg(compression.toString()));
             return;
         }
+
+        if (!layerDataFormatSupported(layerDataFormat)) {
+            xml.raiseError(tr("Compression method '%1' not supported")
+                           .arg(compression.toString()));
+            return;
+        }
     } else {
         xml.raiseError(tr("Unknown encoding: %1").arg(encoding.toString()));
         return;
@@ -823,6 +853,8 @@ void MapReaderPrivate::readTileLayerData(TileLayer &tileLayer)
 
     mMap->setLayerDataFormat(layerDataFormat);
 
+    QVector<EncodedChunk> encodedChunks;
+
     if (mMap->infinite()) {
         while (xml.readNext() != QXmlStreamReader::Invalid) {
             if (xml.isEndElement()) {
@@ -835,19 +867,26 @@ void MapReaderPrivate::readTileLayerData(TileLayer &tileLayer)
                     int width = atts.value(QLatin1String("width")).toInt();
                     int height = atts.value(QLatin1String("height")).toInt();
 
-                    readTileLayerRect(tileLayer, layerDataFormat, encoding, QRect(x, y, width, height));
+                    readTileLayerRect(tileLayer, layerDataFormat, encoding,
+                                      QRect(x, y, width, height), encodedChunks);
                 }
             }
         }
     } else {
-        readTileLayerRect(tileLayer, layerDataFormat, encoding, QRect(0, 0, tileLayer.width(), tileLayer.height()));
+        readTileLayerRect(tileLayer, layerDataFormat, encoding,
+                          QRect(0, 0, tileLayer.width(), tileLayer.height()),
+                          encodedChunks);
     }
+
+    if (!xml.hasError())
+        decodeLayerData(tileLayer, layerDataFormat, encodedChunks);
 }
 
 void MapReaderPrivate::readTileLayerRect(TileLayer &tileLayer,
                                          Map::LayerDataFormat layerDataFormat,
                                          QStringRef encoding,
-                                         QRect bounds)
+                                         QRect bounds,
+                                         QVector<EncodedChunk> &encodedChunks)
 {
     int x = bounds.x();
     int y = bounds.y();
@@ -877,74 +916,135 @@ void MapReaderPrivate::readTileLayerRect(TileLayer &tileLayer,
                 readUnknownElement();
             }
         } else if (xml.isCharacters() && !xml.isWhitespace()) {
-            if (encoding == QLatin1String("base64")) {
-                decodeBinaryLayerData(tileLayer,
-                                      xml.text().toLatin1(),
-                                      layerDataFormat,
-                                      bounds);
-            } else if (encoding == QLatin1String("csv")) {
-                decodeCSVLayerData(tileLayer, xml.text(), bounds);
-            }
+            EncodedChunk chunk;
+            chunk.bounds = bounds;
+
+            if (encoding == QLatin1String("base64"))
+                chunk.data = xml.text().toLatin1();
+            else if (encoding == QLatin1String("csv"))
+                chunk.text = xml.text().toString();
+            else
+                continue;
+
+            encodedChunks.append(chunk);
         }
     }
 }
 
-void MapReaderPrivate::decodeBinaryLayerData(TileLayer &tileLayer,
-                                             const QByteArray &data,
-                                             Map::LayerDataFormat format,
-                                             QRect bounds)
+/**
+ * Decodes the collected chunks and assembles them into the \a tileLayer.
+ *
+ * Decompressing and mapping the gids of the chunks is done in parallel on
+ * the global thread pool, since for large infinite maps this dominates the
+ * loading time.
+ *
+ * The chunks are decoded in batches, to limit the memory used by decoded
+ * chunks that have not been assembled into the layer yet.
+ */
+void MapReaderPrivate::decodeLayerData(TileLayer &tileLayer,
+                                       Map::LayerDataFormat format,
+                                       QVector<EncodedChunk> &encodedChunks)
 {
-    GidMapper::DecodeError error;
+    const int BatchSize = 1024;
 
-    error = mGidMapper.decodeLayerData(tileLayer, data, format, bounds);
+    const QString layerName = tileLayer.name();
+    EncodedChunk *chunks = encodedChunks.data();
 
-    switch (error) {
-    case GidMapper::CorruptLayerData:
-        xml.raiseError(tr("Corrupt layer data for layer '%1'").arg(tileLayer.name()));
-        return;
-    case GidMapper::TileButNoTilesets:
-        xml.raiseError(tr("Tile used but no tilesets specified"));
-        return;
-    case GidMapper::InvalidTile:
-        xml.raiseError(tr("Invalid tile: %1").arg(mGidMapper.invalidTile()));
-        return;
-    case GidMapper::NoError:
-        break;
+    for (int batchStart = 0; batchStart < encodedChunks.size(); batchStart += BatchSize) {
+        const int batchEnd = qMin(batchStart + BatchSize, encodedChunks.size());
+
+        parallelFor(batchEnd - batchStart, [&] (int index) {
+            // Using a copy, since the gid mapper records the invalid tile
+            const GidMapper gidMapper = mGidMapper;
+            decodeChunk(chunks[batchStart + index], gidMapper, format, layerName);
+        });
+
+        for (int i = batchStart; i < batchEnd; ++i) {
+            EncodedChunk &chunk = chunks[i];
+
+            if (!chunk.error.isEmpty()) {
+                xml.raiseError(chunk.error);
+                return;
+            }
+
+            const QRect &bounds = chunk.bounds;
+            tileLayer.setCells(bounds.x(), bounds.y(), chunk.decoded.data());
+            chunk.decoded.reset();
+        }
     }
 }
 
-void MapReaderPrivate::decodeCSVLayerData(TileLayer &tileLayer,
-                                          QStringRef text,
-                                          QRect bounds)
+/**
+ * Decodes the given \a chunk into a new tile layer of the size of the chunk.
+ * This function is thread-safe, provided each call gets its own
+ * \a gidMapper.
+ */
+void MapReaderPrivate::decodeChunk(EncodedChunk &chunk,
+                                   const GidMapper &gidMapper,
+                                   Map::LayerDataFormat format,
+                                   const QString &layerName)
 {
-    QString trimText = text.trimmed().toString();
-    QStringList tiles = trimText.split(QLatin1Char(','));
+    const QRect &bounds = chunk.bounds;
+    QSharedPointer<TileLayer> decoded(new TileLayer(QString(), 0, 0,
+                                                    bounds.width(),
+                                                    bounds.height()));
 
-    int lengthCheck = bounds.width() * bounds.height();
+    if (format == Map::CSV) {
+        chunk.text = chunk.text.trimmed();
+        const QVector<QStringRef> tiles = chunk.text.splitRef(QLatin1Char(','));
 
-    if (tiles.length() != lengthCheck) {
-        xml.raiseError(tr("Corrupt layer data for layer '%1'")
-                       .arg(tileLayer.name()));
-        return;
-    }
+        if (tiles.length() != bounds.width() * bounds.height()) {
+            chunk.error = tr("Corrupt layer data for layer '%1'").arg(layerName);
+            return;
+        }
 
-    int currentTile = 0;
+        int currentTile = 0;
 
-    for (int y = bounds.top(); y <= bounds.bottom(); y++) {
-        for (int x = bounds.left(); x <= bounds.right(); x++) {
-            bool conversionOk;
-            const unsigned gid = tiles.at(currentTile++).toUInt(&conversionOk);
+        for (int y = 0; y < bounds.height(); y++) {
+            for (int x = 0; x < bounds.width(); x++) {
+                bool conversionOk;
+                const unsigned gid = tiles.at(currentTile++).toUInt(&conversionOk);
 
-            if (!conversionOk) {
-                xml.raiseError(
-                        tr("Unable to parse tile at (%1,%2) on layer '%3'")
-                               .arg(x + 1).arg(y + 1).arg(tileLayer.name()));
-                return;
-            }
+                if (!conversionOk) {
+                    chunk.error = tr("Unable to parse tile at (%1,%2) on layer '%3'")
+                            .arg(bounds.x() + x + 1).arg(bounds.y() + y + 1).arg(layerName);
+                    return;
+                }
+
+                bool ok;
+                const Cell cell = gidMapper.gidToCell(gid, ok);
+                if (!ok) {
+                    if (gidMapper.isEmpty())
+                        chunk.error = tr("Tile used but no tilesets specified");
+                    else
+                        chunk.error = tr("Invalid tile: %1").arg(gid);
+                    return;
+                }
 
-            tileLayer.setCell(x, y, cellForGid(gid));
+                decoded->setCell(x, y, cell);
+            }
+        }
+    } else {
+        switch (gidMapper.decodeLayerData(*decoded, chunk.data, format)) {
+        case GidMapper::CorruptLayerData:
+            chunk.error = tr("Corrupt layer data for layer '%1'").arg(layerName);
+            return;
+        case GidMapper::TileButNoTilesets:
+            chunk.error = tr("Tile used but no tilesets specified");
+            return;
+        case GidMapper::InvalidTile:
+            chunk.error = tr("Invalid tile: %1").arg(gidMapper.invalidTile());
+            return;
+        case GidMapper::NoError:
+            break;
         }
     }
+
+    // Free the encoded data early, since all chunks are kept until the
+    // whole layer has been decoded
+    chunk.data.clear();
+    chunk.text.clear();
+    chunk.decoded = decoded;
 }
 
 Cell MapReaderPrivate::cellForGid(unsigned gid)
@@ -49,6 +49,9 @@ class MapReaderPrivate;
  *
  * Can be subclassed when special handling of external images and tilesets is
  * needed.
+ *
+ * Tileset images are decoded according to the imageLoadingMode(), which also
+ * applies to the other map formats.
  */
 class TILEDSHARED_EXPORT MapReader
 {
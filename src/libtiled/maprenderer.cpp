@@ -132,9 +132,34 @@ static bool hasOpenGLEngine(const QPainter *painter)
             type == QPaintEngine::OpenGL2);
 }
 
+/**
+ * Returns the rectangle of \a image to draw for a tile covering \a imageRect.
+ *
+ * When smooth pixmap transformation is enabled, scaled drawing samples
+ * pixels just outside of the source rectangle. For a tile that is part of a
+ * larger image, those pixels belong to neighbouring tiles. Insetting the
+ * source rectangle by half a pixel keeps the filter within the tile.
+ */
+QRectF CellRenderer::sourceRect(const QPainter *painter,
+                                const QPixmap &image,
+                                const QRect &imageRect)
+{
+    QRectF source(imageRect);
+
+    if (imageRect == image.rect() ||
+            !painter->testRenderHint(QPainter::SmoothPixmapTransform))
+        return source;
+
+    if (source.width() > 1)
+        source.adjust(0.5, 0, -0.5, 0);
+    if (source.height() > 1)
+        source.adjust(0, 0.5, 0, -0.5);
+
+    return source;
+}
+
 CellRenderer::CellRenderer(QPainter *painter, const CellType cellType)
     : mPainter(painter)
-    , mTile(nullptr)
     , mIsOpenGL(hasOpenGLEngine(painter))
     , mCellType(cellType)
 {
@@ -144,8 +169,10 @@ CellRenderer::CellRenderer(QPainter *painter, const CellType cellType)
  * Renders a \a cell with the given \a origin at \a pos, taking into account
  * the flipping and tile offset.
  *
- * For performance reasons, the actual drawing is delayed until a different
- * kind of tile has to be drawn. For this reason it is necessary to call
+ * For performance reasons, the actual drawing is delayed until a tile from a
+ * different image has to be drawn. Since the tiles of an image-based tileset
+ * share the tileset image, usually a whole layer can be drawn with a single
+ * call. For this reason it is necessary to call
  * flush when finished doing drawCell calls. This function is also called by
  * the destructor so usually an explicit call is not needed.
  */
@@ -156,7 +183,7 @@ void CellRenderer::render(const Cell &cell, const QPointF &pos, const QSizeF &si
     if (tile)
         tile = tile->currentFrameTile();
 
-    if (!tile || tile->image().isNull()) {
+    if (!tile || tile->atlasImage().isNull()) {
         QRectF target { pos - QPointF(0, size.height()), size };
         if (origin == BottomCenter)
             target.moveLeft(target.left() - size.width() / 2);
@@ -164,15 +191,18 @@ void CellRenderer::render(const Cell &cell, const QPointF &pos, const QSizeF &si
         return;
     }
 
-    if (mTile != tile)
-        flush();
-
-    const QPixmap &image = tile->image();
-    const QSizeF imageSize = image.size();
-    if (imageSize.isEmpty())
+    const QPixmap &image = tile->atlasImage();
+    const QRect &imageRect = tile->imageRect();
+    if (imageRect.isEmpty())
         return;
 
-    const QSizeF scale(size.width() / imageSize.width(), size.height() / imageSize.height());
+    const QRectF source = sourceRect(mPainter, image, imageRect);
+
+    if (!mFragments.isEmpty() && mPixmap.cacheKey() != image.cacheKey())
+        flush();
+
+    const QSizeF scale(size.width() / imageRect.width(), size.height() / imageRect.height());
+    const QSizeF sourceScale(size.width() / source.width(), size.height() / source.height());
     const QPoint offset = tile->offset();
     const QPointF sizeHalf = QPointF(size.width() / 2, size.height() / 2);
 
@@ -182,10 +212,10 @@ void CellRenderer::render(const Cell &cell, const QPointF &pos, const QSizeF &si
     QPainter::PixmapFragment fragment;
     fragment.x = pos.x() + (offset.x() * scale.width()) + sizeHalf.x();
     fragment.y = pos.y() + (offset.y() * scale.height()) + sizeHalf.y() - size.height();
-    fragment.sourceLeft = 0;
-    fragment.sourceTop = 0;
-    fragment.width = imageSize.width();
-    fragment.height = imageSize.height();
+    fragment.sourceLeft = source.x();
+    fragment.sourceTop = source.y();
+    fragment.width = source.width();
+    fragment.height = source.height();
     fragment.scaleX = flippedHorizontally ? -1 : 1;
     fragment.scaleY = flippedVertically ? -1 : 1;
     fragment.rotation = 0;
@@ -216,11 +246,11 @@ void CellRenderer::render(const Cell &cell, const QPointF &pos, const QSizeF &si
             fragment.x += halfDiff;
     }
     
-    fragment.scaleX = scale.width() * (flippedHorizontally ? -1 : 1);
-    fragment.scaleY = scale.height() * (flippedVertically ? -1 : 1);
+    fragment.scaleX = sourceScale.width() * (flippedHorizontally ? -1 : 1);
+    fragment.scaleY = sourceScale.height() * (flippedVertically ? -1 : 1);
 
     if (mIsOpenGL || (fragment.scaleX > 0 && fragment.scaleY > 0)) {
-        mTile = tile;
+        mPixmap = image;
         mFragments.append(fragment);
         return;
     }
@@ -238,7 +268,6 @@ void CellRenderer::render(const Cell &cell, const QPointF &pos, const QSizeF &si
 
     const QRectF target(fragment.width * -0.5, fragment.height * -0.5,
                         fragment.width, fragment.height);
-    const QRectF source(0, 0, fragment.width, fragment.height);
 
     mPainter->setTransform(transform);
     mPainter->drawPixmap(target, image, source);
@@ -250,13 +279,13 @@ void CellRenderer::render(const Cell &cell, const QPointF &pos, const QSizeF &si
  */
 void CellRenderer::flush()
 {
-    if (!mTile)
+    if (mFragments.isEmpty())
         return;
 
     mPainter->drawPixmapFragments(mFragments.constData(),
                                   mFragments.size(),
-                                  mTile->image());
+                                  mPixmap);
 
-    mTile = nullptr;
+    mPixmap = QPixmap();
     mFragments.resize(0);
 }
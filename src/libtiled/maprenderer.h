@@ -274,9 +274,13 @@ public:
     void render(const Cell &cell, const QPointF &pos, const QSizeF &size, Origin origin);
     void flush();
 
+    static QRectF sourceRect(const QPainter *painter,
+                             const QPixmap &image,
+                             const QRect &imageRect);
+
 private:
     QPainter * const mPainter;
-    const Tile *mTile;
+    QPixmap mPixmap;
     QVector<QPainter::PixmapFragment> mFragments;
     const bool mIsOpenGL;
     const CellType mCellType;
@@ -63,6 +63,10 @@ QVariant MapToVariantConverter::toVariant(const Map &map, const QDir &mapDir)
     mapVariant[QLatin1String("infinite")] = map.infinite();
     mapVariant[QLatin1String("nextobjectid")] = map.nextObjectId();
 
+    mCompressionLevel = map.compressionLevel();
+    if (mCompressionLevel != -1)
+        mapVariant[QLatin1String("compressionlevel")] = mCompressionLevel;
+
     addProperties(mapVariant, map.properties());
 
     if (map.orientation() == Map::Hexagonal) {
@@ -112,8 +116,13 @@ QVariant MapToVariantConverter::toVariant(const Map &map, const QDir &mapDir)
     }
     mapVariant[QLatin1String("templategroups")] = templateGroupVariants;
 
-    mapVariant[QLatin1String("layers")] = toVariant(map.layers(),
-                                                    map.layerDataFormat());
+    // Writers are expected to check whether the format is supported, since
+    // the conversion itself can't fail
+    Map::LayerDataFormat format = map.layerDataFormat();
+    if (!layerDataFormatSupported(format))
+        format = Map::Base64Zlib;
+
+    mapVariant[QLatin1String("layers")] = toVariant(map.layers(), format);
 
     return mapVariant;
 }
@@ -394,25 +403,37 @@ QVariant MapToVariantConverter::toVariant(const TileLayer &tileLayer,
             endY = bounds.bottom();
         }
 
+        // Map the cells in parallel, before building the list
+        const QRect rect(QPoint(startX, startY), QPoint(endX, endY));
+        QVector<unsigned> gids(rect.width() * rect.height());
+        mGidMapper.cellsToGids(tileLayer, rect, gids.data());
+
         QVariantList tileVariants;
-        for (int y = startY; y <= endY; ++y)
-            for (int x = startX; x <= endX; ++x)
-                tileVariants << mGidMapper.cellToGid(tileLayer.cellAt(x, y));
+        tileVariants.reserve(gids.size());
+        for (const unsigned gid : gids)
+            tileVariants.append(gid);
 
         tileLayerVariant[QLatin1String("data")] = tileVariants;
         break;
     }
     case Map::Base64:
     case Map::Base64Zlib:
-    case Map::Base64Gzip: {
+    case Map::Base64Gzip:
+    case Map::Base64Zstd:
+    case Map::Base64Lz4: {
         tileLayerVariant[QLatin1String("encoding")] = QLatin1String("base64");
 
         if (format == Map::Base64Zlib)
             tileLayerVariant[QLatin1String("compression")] = QLatin1String("zlib");
         else if (format == Map::Base64Gzip)
             tileLayerVariant[QLatin1String("compression")] = QLatin1String("gzip");
+        else if (format == Map::Base64Zstd)
+            tileLayerVariant[QLatin1String("compression")] = QLatin1String("zstd");
+        else if (format == Map::Base64Lz4)
+            tileLayerVariant[QLatin1String("compression")] = QLatin1String("lz4");
 
-        QByteArray layerData = mGidMapper.encodeLayerData(tileLayer, format);
+        QByteArray layerData = mGidMapper.encodeLayerData(tileLayer, format,
+                                                          QRect(), mCompressionLevel);
         tileLayerVariant[QLatin1String("data")] = layerData;
         break;
     }
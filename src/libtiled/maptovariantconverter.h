@@ -39,7 +39,9 @@ struct TextData;
 class TILEDSHARED_EXPORT MapToVariantConverter
 {
 public:
-    MapToVariantConverter() {}
+    MapToVariantConverter()
+        : mCompressionLevel(-1)
+    {}
 
     /**
      * Converts the given \s map to a QVariant. The \a mapDir is used to
@@ -77,6 +79,7 @@ private:
     QDir mMapDir;
     GidMapper mGidMapper;
     TidMapper mTidMapper;
+    int mCompressionLevel;
 };
 
 } // namespace Tiled
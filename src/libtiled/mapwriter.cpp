@@ -37,6 +37,7 @@
 #include "mapobject.h"
 #include "imagelayer.h"
 #include "objectgroup.h"
+#include "parallel.h"
 #include "templategroup.h"
 #include "tidmapper.h"
 #include "savefile.h"
@@ -85,6 +86,7 @@ public:
 
     QString mError;
     Map::LayerDataFormat mLayerDataFormat;
+    int mCompressionLevel;
     bool mDtdEnabled;
 
 private:
@@ -96,6 +98,7 @@ private:
     void writeLayers(QXmlStreamWriter &w, const QList<Layer *> &layers);
     void writeTileLayer(QXmlStreamWriter &w, const TileLayer &tileLayer);
     void writeTileLayerData(QXmlStreamWriter &w, const TileLayer &tileLayer, QRect bounds);
+    void writeEncodedLayerData(QXmlStreamWriter &w, const QByteArray &data);
     void writeLayerAttributes(QXmlStreamWriter &w, const Layer &layer);
     void writeObjectGroup(QXmlStreamWriter &w, const ObjectGroup &objectGroup);
     void writeObject(QXmlStreamWriter &w, const MapObject &mapObject);
@@ -118,6 +121,7 @@ private:
 
 MapWriterPrivate::MapWriterPrivate()
     : mLayerDataFormat(Map::Base64Zlib)
+    , mCompressionLevel(-1)
     , mDtdEnabled(false)
     , mUseAbsolutePaths(false)
 {
@@ -154,6 +158,14 @@ void MapWriterPrivate::writeMap(const Map *map, QIODevice *device,
     mMapDir = QDir(path);
     mUseAbsolutePaths = path.isEmpty();
     mLayerDataFormat = map->layerDataFormat();
+    mCompressionLevel = map->compressionLevel();
+
+    // Writing to a file fails before getting here, see MapWriter::writeMap
+    if (!layerDataFormatSupported(mLayerDataFormat)) {
+        mError = tr("The tile layer format of this map is not supported by "
+                    "this build, falling back to zlib compression.");
+        mLayerDataFormat = Map::Base64Zlib;
+    }
 
     AutoFormattingWriter writer(device);
     writer.writeStartDocument();
@@ -265,6 +277,11 @@ void MapWriterPrivate::writeMap(QXmlStreamWriter &w, const Map &map)
                          colorToString(map.backgroundColor()));
     }
 
+    if (map.compressionLevel() != -1) {
+        w.writeAttribute(QLatin1String("compressionlevel"),
+                         QString::number(map.compressionLevel()));
+    }
+
     w.writeAttribute(QLatin1String("nextobjectid"),
                      QString::number(map.nextObjectId()));
 
@@ -623,7 +640,9 @@ void MapWriterPrivate::writeTileLayer(QXmlStreamWriter &w,
 
     if (mLayerDataFormat == Map::Base64
             || mLayerDataFormat == Map::Base64Gzip
-            || mLayerDataFormat == Map::Base64Zlib) {
+            || mLayerDataFormat == Map::Base64Zlib
+            || mLayerDataFormat == Map::Base64Zstd
+            || mLayerDataFormat == Map::Base64Lz4) {
 
         encoding = QLatin1String("base64");
 
@@ -631,6 +650,10 @@ void MapWriterPrivate::writeTileLayer(QXmlStreamWriter &w,
             compression = QLatin1String("gzip");
         else if (mLayerDataFormat == Map::Base64Zlib)
             compression = QLatin1String("zlib");
+        else if (mLayerDataFormat == Map::Base64Zstd)
+            compression = QLatin1String("zstd");
+        else if (mLayerDataFormat == Map::Base64Lz4)
+            compression = QLatin1String("lz4");
 
     } else if (mLayerDataFormat == Map::CSV)
         encoding = QLatin1String("csv");
@@ -641,7 +664,10 @@ void MapWriterPrivate::writeTileLayer(QXmlStreamWriter &w,
     if (!compression.isEmpty())
         w.writeAttribute(QLatin1String("compression"), compression);
 
-    if (tileLayer.map()->infinite()) {
+    const bool infinite = tileLayer.map()->infinite();
+    QVector<QRect> chunkRects;
+
+    if (infinite) {
         QRect bounds = tileLayer.bounds().translated(-tileLayer.position());
         int startX = bounds.left();
         int startY = bounds.top();
@@ -659,17 +685,8 @@ void MapWriterPrivate::writeTileLayer(QXmlStreamWriter &w,
 
         for (int y = startY; y < endY; ++y) {
             for (int x = startX; x < endX; ++x) {
-                if (tileLayer.findChunk(chunkStartX, chunkStartY)) {
-                    w.writeStartElement(QLatin1String("chunk"));
-                    w.writeAttribute(QLatin1String("x"), QString::number(chunkStartX));
-                    w.writeAttribute(QLatin1String("y"), QString::number(chunkStartY));
-                    w.writeAttribute(QLatin1String("width"), QString::number(CHUNK_SIZE));
-                    w.writeAttribute(QLatin1String("height"), QString::number(CHUNK_SIZE));
-
-                    writeTileLayerData(w, tileLayer, QRect(chunkStartX, chunkStartY, CHUNK_SIZE, CHUNK_SIZE));
-
-                    w.writeEndElement(); // </chunk>
-                }
+                if (tileLayer.findChunk(chunkStartX, chunkStartY))
+                    chunkRects.append(QRect(chunkStartX, chunkStartY, CHUNK_SIZE, CHUNK_SIZE));
 
                 chunkStartX += CHUNK_SIZE;
             }
@@ -678,48 +695,94 @@ void MapWriterPrivate::writeTileLayer(QXmlStreamWriter &w,
             chunkStartY += CHUNK_SIZE;
         }
     } else {
-        writeTileLayerData(w, tileLayer, QRect(0, 0, tileLayer.width(), tileLayer.height()));
+        chunkRects.append(QRect(0, 0, tileLayer.width(), tileLayer.height()));
+    }
+
+    // Encoding is done in parallel ahead of writing the XML, in batches to
+    // limit the memory used by the encoded data
+    const int BatchSize = 1024;
+    QVector<QByteArray> encodedChunks;
+
+    for (int batchStart = 0; batchStart < chunkRects.size(); batchStart += BatchSize) {
+        const int batchEnd = qMin(batchStart + BatchSize, chunkRects.size());
+
+        if (mLayerDataFormat != Map::XML) {
+            encodedChunks.resize(batchEnd - batchStart);
+            QByteArray *encoded = encodedChunks.data();
+            const QRect *rects = chunkRects.constData() + batchStart;
+
+            parallelFor(batchEnd - batchStart, [&] (int index) {
+                encoded[index] = mGidMapper.encodeLayerData(tileLayer,
+                                                            mLayerDataFormat,
+                                                            rects[index],
+                                                            mCompressionLevel);
+            });
+
+            for (int i = 0; i < batchEnd - batchStart; ++i) {
+                if (encoded[i].isNull()) {
+                    mError = tr("The tile layer \"%1\" is too large to be "
+                                "written in this format.").arg(tileLayer.name());
+                    break;
+                }
+            }
+        }
+
+        for (int i = batchStart; i < batchEnd; ++i) {
+            const QRect &rect = chunkRects.at(i);
+
+            if (infinite) {
+                w.writeStartElement(QLatin1String("chunk"));
+                w.writeAttribute(QLatin1String("x"), QString::number(rect.x()));
+                w.writeAttribute(QLatin1String("y"), QString::number(rect.y()));
+                w.writeAttribute(QLatin1String("width"), QString::number(rect.width()));
+                w.writeAttribute(QLatin1String("height"), QString::number(rect.height()));
+            }
+
+            if (mLayerDataFormat == Map::XML)
+                writeTileLayerData(w, tileLayer, rect);
+            else
+                writeEncodedLayerData(w, encodedChunks.at(i - batchStart));
+
+            if (infinite)
+                w.writeEndElement(); // </chunk>
+        }
     }
 
     w.writeEndElement(); // </data>
     w.writeEndElement(); // </layer>
 }
 
+/**
+ * Writes the tile layer data within \a bounds as <tile> elements.
+ */
 void MapWriterPrivate::writeTileLayerData(QXmlStreamWriter &w,
                                           const TileLayer &tileLayer,
                                           QRect bounds)
 {
-    if (mLayerDataFormat == Map::XML) {
-        for (int y = bounds.top(); y <= bounds.bottom(); y++) {
-            for (int x = bounds.left(); x <= bounds.right(); x++) {
-                const unsigned gid = mGidMapper.cellToGid(tileLayer.cellAt(x, y));
-                w.writeStartElement(QLatin1String("tile"));
-                w.writeAttribute(QLatin1String("gid"), QString::number(gid));
-                w.writeEndElement();
-            }
-        }
-    } else if (mLayerDataFormat == Map::CSV) {
-        QString chunkData;
-
-        for (int y = bounds.top(); y <= bounds.bottom(); y++) {
-            for (int x = bounds.left(); x <= bounds.right(); x++) {
-                const unsigned gid = mGidMapper.cellToGid(tileLayer.cellAt(x, y));
-                chunkData.append(QString::number(gid));
-                if (x != bounds.right() || y != bounds.bottom())
-                    chunkData.append(QLatin1String(","));
-            }
-            chunkData.append(QLatin1String("\n"));
+    CellReader reader(&tileLayer);
+
+    for (int y = bounds.top(); y <= bounds.bottom(); y++) {
+        for (int x = bounds.left(); x <= bounds.right(); x++) {
+            const unsigned gid = mGidMapper.cellToGid(reader.cellAt(x, y));
+            w.writeStartElement(QLatin1String("tile"));
+            w.writeAttribute(QLatin1String("gid"), QString::number(gid));
+            w.writeEndElement();
         }
+    }
+}
 
+/**
+ * Writes tile layer data that was encoded as CSV or base64.
+ */
+void MapWriterPrivate::writeEncodedLayerData(QXmlStreamWriter &w,
+                                             const QByteArray &data)
+{
+    if (mLayerDataFormat == Map::CSV) {
         w.writeCharacters(QLatin1String("\n"));
-        w.writeCharacters(chunkData);
+        w.writeCharacters(QString::fromLatin1(data));
     } else {
-        QByteArray chunkData = mGidMapper.encodeLayerData(tileLayer,
-                                                          mLayerDataFormat,
-                                                          bounds);
-
         w.writeCharacters(QLatin1String("\n   "));
-        w.writeCharacters(QString::fromLatin1(chunkData));
+        w.writeCharacters(QString::fromLatin1(data));
         w.writeCharacters(QLatin1String("\n  "));
     }
 }
@@ -1029,12 +1092,25 @@ void MapWriter::writeMap(const Map *map, QIODevice *device,
 
 bool MapWriter::writeMap(const Map *map, const QString &fileName)
 {
+    d->mError.clear();
+
+    if (!layerDataFormatSupported(map->layerDataFormat())) {
+        d->mError = QCoreApplication::translate("MapReader",
+                                                "The tile layer format of this map is "
+                                                "not supported by this build.");
+        return false;
+    }
+
     SaveFile file(fileName);
     if (!d->openFile(&file))
         return false;
 
     writeMap(map, file.device(), QFileInfo(fileName).absolutePath());
 
+    // Leaves the existing file alone when a layer could not be encoded
+    if (!d->mError.isEmpty())
+        return false;
+
     if (file.error() != QFileDevice::NoError) {
         d->mError = file.errorString();
         return false;
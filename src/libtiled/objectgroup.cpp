@@ -34,11 +34,355 @@
 #include "map.h"
 #include "mapobject.h"
 #include "tile.h"
+#include "tilelayer.h"
 
+#include <QHash>
+#include <QSet>
+#include <QTransform>
+#include <QVector>
+#include <QtMath>
+
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 using namespace Tiled;
 
+// Size of the cells of the spatial index, in pixels
+static const qreal CellSize = 256;
+
+// Objects covering more cells than this are not stored in the cells
+static const int MaxCellsPerObject = 64;
+
+// Objects further away from the origin than this are not stored in the cells
+static const qreal MaxCellCoordinate = 1e9;
+
+// Unlike QRectF::united, does not ignore empty rects
+static QRectF unite(const QRectF &a, const QRectF &b)
+{
+    return QRectF(QPointF(std::min(a.left(), b.left()), std::min(a.top(), b.top())),
+                  QPointF(std::max(a.right(), b.right()), std::max(a.bottom(), b.bottom())));
+}
+
+/**
+ * Returns the area covered by the given \a object, both with and without its
+ * rotation applied.
+ */
+static QRectF objectBounds(const MapObject *object)
+{
+    QRectF bounds = object->bounds().normalized();
+
+    if (object->isTileObject()) {
+        // Tile objects are aligned to the bottom-left, or to the bottom on
+        // isometric maps. Cover both, as well as the tile itself.
+        const QSizeF size = bounds.size();
+        bounds = QRectF(object->x() - size.width() / 2,
+                        object->y() - size.height(),
+                        size.width() * 1.5,
+                        size.height());
+        bounds = unite(bounds, object->boundsUseTile().normalized());
+    } else if (!object->polygon().isEmpty()) {
+        const QRectF polygonBounds = object->polygon().boundingRect();
+        bounds = unite(bounds, polygonBounds.translated(object->position()));
+    }
+
+    if (object->rotation() != 0) {
+        const QPointF &pos = object->position();
+        QTransform transform;
+        transform.translate(pos.x(), pos.y());
+        transform.rotate(object->rotation());
+        transform.translate(-pos.x(), -pos.y());
+        bounds = unite(bounds, transform.mapRect(bounds));
+    }
+
+    return bounds;
+}
+
+// Unlike QRectF::intersects, also returns true for touching and empty rects
+static bool overlaps(const QRectF &a, const QRectF &b)
+{
+    return a.left() <= b.right() && b.left() <= a.right() &&
+            a.top() <= b.bottom() && b.top() <= a.bottom();
+}
+
+static qreal distance(const QRectF &rect, const QPointF &pos)
+{
+    const qreal dx = std::max({ rect.left() - pos.x(), qreal(0), pos.x() - rect.right() });
+    const qreal dy = std::max({ rect.top() - pos.y(), qreal(0), pos.y() - rect.bottom() });
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+static int cellCoordinate(qreal pixelCoordinate)
+{
+    return qFloor(pixelCoordinate / CellSize);
+}
+
+/**
+ * A grid of cells, each storing the objects overlapping it, for looking up
+ * objects by area. Objects that are too large for the grid are kept in a
+ * separate list.
+ *
+ * Changed objects are only marked as dirty and moved to their new cells on
+ * the next query.
+ */
+class ObjectGroup::SpatialIndex
+{
+public:
+    explicit SpatialIndex(const QList<MapObject*> &objects);
+
+    void insert(MapObject *object);
+    void remove(MapObject *object);
+    void markDirty(MapObject *object) { mDirtyObjects.insert(object); }
+    void invalidateOrder() { mOrder.clear(); }
+
+    void update(const QList<MapObject*> &objects);
+
+    QList<MapObject*> objectsIn(const QRectF &rect) const;
+    MapObject *nearestObject(const QPointF &pos) const;
+
+private:
+    void insertIntoCells(MapObject *object, const QRectF &bounds);
+    void removeFromCells(MapObject *object, const QRectF &bounds);
+
+    QHash<MapObject*, QRectF> mBounds;
+    QHash<QPoint, QVector<MapObject*>> mCells;
+    QSet<MapObject*> mLargeObjects;
+    QSet<MapObject*> mDirtyObjects;
+    QHash<MapObject*, int> mOrder;      // Index of each object in the group
+    QRect mCellBounds;                  // Area covered by the cells so far
+};
+
+ObjectGroup::SpatialIndex::SpatialIndex(const QList<MapObject*> &objects)
+{
+    mBounds.reserve(objects.size());
+    for (MapObject *object : objects)
+        insert(object);
+}
+
+void ObjectGroup::SpatialIndex::insert(MapObject *object)
+{
+    const QRectF bounds = objectBounds(object);
+    mBounds.insert(object, bounds);
+    insertIntoCells(object, bounds);
+    invalidateOrder();
+}
+
+void ObjectGroup::SpatialIndex::remove(MapObject *object)
+{
+    auto it = mBounds.find(object);
+    if (it == mBounds.end())
+        return;
+
+    removeFromCells(object, it.value());
+    mBounds.erase(it);
+    mDirtyObjects.remove(object);
+    invalidateOrder();
+}
+
+/**
+ * Moves the dirty objects to their new cells and makes sure the order of the
+ * given \a objects, which are the objects of the group, is known.
+ */
+void ObjectGroup::SpatialIndex::update(const QList<MapObject*> &objects)
+{
+    const QSet<MapObject*> dirtyObjects = mDirtyObjects;
+    mDirtyObjects.clear();
+
+    for (MapObject *object : dirtyObjects) {
+        auto it = mBounds.find(object);
+        if (it == mBounds.end())
+            continue;
+
+        const QRectF bounds = objectBounds(object);
+        if (it.value() == bounds)
+            continue;
+
+        removeFromCells(object, it.value());
+        it.value() = bounds;
+        insertIntoCells(object, bounds);
+    }
+
+    if (mOrder.isEmpty() && !objects.isEmpty()) {
+        mOrder.reserve(objects.size());
+        for (int i = 0; i < objects.size(); ++i)
+            mOrder.insert(objects.at(i), i);
+    }
+}
+
+/**
+ * Determines the \a cells covered by the given \a rect. Returns false when
+ * the rect lies too far away from the origin to be converted to cells.
+ */
+static bool cellsCovering(const QRectF &rect, QRect &cells)
+{
+    const QRectF limits(-MaxCellCoordinate, -MaxCellCoordinate,
+                        2 * MaxCellCoordinate, 2 * MaxCellCoordinate);
+    if (!limits.contains(rect.topLeft()) || !limits.contains(rect.bottomRight()))
+        return false;
+
+    cells = QRect(QPoint(cellCoordinate(rect.left()), cellCoordinate(rect.top())),
+                  QPoint(cellCoordinate(rect.right()), cellCoordinate(rect.bottom())));
+    return true;
+}
+
+/**
+ * Returns whether an object with the given \a bounds is stored in the
+ * \a cells, rather than in the list of large objects.
+ */
+static bool isStoredInCells(const QRectF &bounds, QRect &cells)
+{
+    return cellsCovering(bounds, cells) &&
+            qint64(cells.width()) * cells.height() <= MaxCellsPerObject;
+}
+
+void ObjectGroup::SpatialIndex::insertIntoCells(MapObject *object, const QRectF &bounds)
+{
+    QRect cells;
+    if (!isStoredInCells(bounds, cells)) {
+        mLargeObjects.insert(object);
+        return;
+    }
+
+    for (int y = cells.top(); y <= cells.bottom(); ++y)
+        for (int x = cells.left(); x <= cells.right(); ++x)
+            mCells[QPoint(x, y)].append(object);
+
+    mCellBounds |= cells;
+}
+
+void ObjectGroup::SpatialIndex::removeFromCells(MapObject *object, const QRectF &bounds)
+{
+    QRect cells;
+    if (!isStoredInCells(bounds, cells)) {
+        mLargeObjects.remove(object);
+        return;
+    }
+
+    for (int y = cells.top(); y <= cells.bottom(); ++y) {
+        for (int x = cells.left(); x <= cells.right(); ++x) {
+            auto it = mCells.find(QPoint(x, y));
+            Q_ASSERT(it != mCells.end());
+
+            it.value().removeOne(object);
+            if (it.value().isEmpty())
+                mCells.erase(it);
+        }
+    }
+}
+
+QList<MapObject*> ObjectGroup::SpatialIndex::objectsIn(const QRectF &rect) const
+{
+    QVector<MapObject*> candidates;
+
+    auto addCandidates = [&] (const QVector<MapObject*> &objects) {
+        for (MapObject *object : objects)
+            if (overlaps(mBounds.value(object), rect))
+                candidates.append(object);
+    };
+
+    QRect cells;
+    if (cellsCovering(rect, cells) &&
+            qint64(cells.width()) * cells.height() <= mCells.size()) {
+        const QRect area = cells.intersected(mCellBounds);
+        for (int y = area.top(); y <= area.bottom(); ++y) {
+            for (int x = area.left(); x <= area.right(); ++x) {
+                auto it = mCells.find(QPoint(x, y));
+                if (it != mCells.end())
+                    addCandidates(it.value());
+            }
+        }
+    } else {
+        // Checking all objects is faster than looking at each cell
+        for (auto it = mCells.begin(), end = mCells.end(); it != end; ++it)
+            addCandidates(it.value());
+    }
+
+    for (MapObject *object : mLargeObjects)
+        if (overlaps(mBounds.value(object), rect))
+            candidates.append(object);
+
+    // Objects covering multiple cells are found more than once
+    std::sort(candidates.begin(), candidates.end(), [this] (MapObject *a, MapObject *b) {
+        return mOrder.value(a) < mOrder.value(b);
+    });
+    candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                     candidates.end());
+
+    QList<MapObject*> objects;
+    objects.reserve(candidates.size());
+    for (MapObject *object : candidates)
+        objects.append(object);
+    return objects;
+}
+
+MapObject *ObjectGroup::SpatialIndex::nearestObject(const QPointF &pos) const
+{
+    MapObject *nearest = nullptr;
+    qreal nearestDistance = std::numeric_limits<qreal>::max();
+
+    auto consider = [&] (MapObject *object) {
+        const qreal d = distance(mBounds.value(object), pos);
+        if (d < nearestDistance || (d == nearestDistance &&
+                                    mOrder.value(object) < mOrder.value(nearest))) {
+            nearest = object;
+            nearestDistance = d;
+        }
+    };
+
+    for (MapObject *object : mLargeObjects)
+        consider(object);
+
+    if (mCells.isEmpty())
+        return nearest;
+
+    // Look at rings of cells around the position, until the cells are
+    // further away than the nearest object found so far
+    const QPointF clampedPos(qBound(-MaxCellCoordinate, pos.x(), MaxCellCoordinate),
+                             qBound(-MaxCellCoordinate, pos.y(), MaxCellCoordinate));
+    const QPoint center(cellCoordinate(clampedPos.x()), cellCoordinate(clampedPos.y()));
+
+    const int firstRing = std::max({ mCellBounds.left() - center.x(),
+                                     center.x() - mCellBounds.right(),
+                                     mCellBounds.top() - center.y(),
+                                     center.y() - mCellBounds.bottom(),
+                                     0 });
+    const int lastRing = std::max({ center.x() - mCellBounds.left(),
+                                    mCellBounds.right() - center.x(),
+                                    center.y() - mCellBounds.top(),
+                                    mCellBounds.bottom() - center.y() });
+
+    auto considerCell = [&] (int x, int y) {
+        auto it = mCells.find(QPoint(x, y));
+        if (it != mCells.end())
+            for (MapObject *object : it.value())
+                consider(object);
+    };
+
+    for (int ring = firstRing; ring <= lastRing; ++ring) {
+        if (nearest && (ring - 1) * CellSize > nearestDistance)
+            break;
+
+        const QRect ringRect(center.x() - ring, center.y() - ring,
+                             ring * 2 + 1, ring * 2 + 1);
+        const QRect area = ringRect.intersected(mCellBounds);
+
+        for (int y = area.top(); y <= area.bottom(); ++y) {
+            if (y == ringRect.top() || y == ringRect.bottom()) {
+                for (int x = area.left(); x <= area.right(); ++x)
+                    considerCell(x, y);
+            } else {
+                if (area.left() == ringRect.left())
+                    considerCell(area.left(), y);
+                if (area.right() == ringRect.right())
+                    considerCell(area.right(), y);
+            }
+        }
+    }
+
+    return nearest;
+}
+
+
 ObjectGroup::ObjectGroup()
     : ObjectGroup(QString(), 0, 0)
 {
@@ -61,6 +405,8 @@ void ObjectGroup::addObject(MapObject *object)
     object->setObjectGroup(this);
     if (mMap && object->id() == 0)
         object->setId(mMap->takeNextObjectId());
+    if (mSpatialIndex)
+        mSpatialIndex->insert(object);
 }
 
 void ObjectGroup::insertObject(int index, MapObject *object)
@@ -69,6 +415,8 @@ void ObjectGroup::insertObject(int index, MapObject *object)
     object->setObjectGroup(this);
     if (mMap && object->id() == 0)
         object->setId(mMap->takeNextObjectId());
+    if (mSpatialIndex)
+        mSpatialIndex->insert(object);
 }
 
 int ObjectGroup::removeObject(MapObject *object)
@@ -76,8 +424,7 @@ int ObjectGroup::removeObject(MapObject *object)
     const int index = mObjects.indexOf(object);
     Q_ASSERT(index != -1);
 
-    mObjects.removeAt(index);
-    object->setObjectGroup(nullptr);
+    removeObjectAt(index);
     return index;
 }
 
@@ -85,6 +432,8 @@ void ObjectGroup::removeObjectAt(int index)
 {
     MapObject *object = mObjects.takeAt(index);
     object->setObjectGroup(nullptr);
+    if (mSpatialIndex)
+        mSpatialIndex->remove(object);
 }
 
 void ObjectGroup::moveObjects(int from, int to, int count)
@@ -107,6 +456,9 @@ void ObjectGroup::moveObjects(int from, int to, int count)
 
     for (int i = 0; i < count; ++i)
         mObjects.insert(to + i, movingObjects.at(i));
+
+    if (mSpatialIndex)
+        mSpatialIndex->invalidateOrder();
 }
 
 QRectF ObjectGroup::objectsBoundingRect() const
@@ -117,6 +469,46 @@ QRectF ObjectGroup::objectsBoundingRect() const
     return boundingRect;
 }
 
+QList<MapObject*> ObjectGroup::objectsIn(const QRectF &rect) const
+{
+    return spatialIndex().objectsIn(rect);
+}
+
+QList<MapObject*> ObjectGroup::objectsAt(const QPointF &pos) const
+{
+    return spatialIndex().objectsIn(QRectF(pos, QSizeF(0, 0)));
+}
+
+MapObject *ObjectGroup::nearestObject(const QPointF &pos) const
+{
+    return spatialIndex().nearestObject(pos);
+}
+
+void ObjectGroup::objectGeometryChanged(MapObject *object)
+{
+    if (mSpatialIndex)
+        mSpatialIndex->markDirty(object);
+}
+
+void ObjectGroup::tileSizesChanged(const Tileset *tileset)
+{
+    if (!mSpatialIndex)
+        return;
+
+    for (MapObject *object : mObjects)
+        if (object->cell().tileset() == tileset)
+            mSpatialIndex->markDirty(object);
+}
+
+ObjectGroup::SpatialIndex &ObjectGroup::spatialIndex() const
+{
+    if (!mSpatialIndex)
+        mSpatialIndex.reset(new SpatialIndex(mObjects));
+
+    mSpatialIndex->update(mObjects);
+    return *mSpatialIndex;
+}
+
 bool ObjectGroup::isEmpty() const
 {
     return mObjects.isEmpty();
@@ -37,6 +37,7 @@
 #include <QColor>
 #include <QList>
 #include <QMetaType>
+#include <QScopedPointer>
 
 namespace Tiled {
 
@@ -133,6 +134,56 @@ public:
      */
     QRectF objectsBoundingRect() const;
 
+    /**
+     * Returns the objects whose bounds intersect or touch the given \a rect,
+     * in the order in which they are stored in this group.
+     *
+     * The bounds of an object cover its polygon or tile, both with and
+     * without its rotation applied. For tile objects they are slightly
+     * larger than the tile, since their alignment depends on the map
+     * orientation. Callers needing an exact shape should check the returned
+     * objects further. The \a rect is in pixel coordinates, like the object
+     * positions.
+     *
+     * The objects are looked up in a spatial index, which is created on the
+     * first query and kept up to date as objects are added, removed or
+     * changed. Changes to the size of tile images need to be reported
+     * through tileSizesChanged(). Because of this, it is not safe to query
+     * an object group from multiple threads at the same time.
+     */
+    QList<MapObject*> objectsIn(const QRectF &rect) const;
+
+    /**
+     * Returns the objects whose bounds contain the given \a pos, in the
+     * order in which they are stored in this group.
+     *
+     * \sa objectsIn()
+     */
+    QList<MapObject*> objectsAt(const QPointF &pos) const;
+
+    /**
+     * Returns the object whose bounds are closest to the given \a pos, or
+     * nullptr when this group has no objects. When several objects are at
+     * the same distance, the first one in this group is returned.
+     *
+     * \sa objectsIn()
+     */
+    MapObject *nearestObject(const QPointF &pos) const;
+
+    /**
+     * Notifies the object group that the position, size or shape of the
+     * given \a object changed. Should only be called from the MapObject
+     * class.
+     */
+    void objectGeometryChanged(MapObject *object);
+
+    /**
+     * Notifies the object group that the size of the tiles in the given
+     * \a tileset may have changed, which affects the bounds of the tile
+     * objects showing them.
+     */
+    void tileSizesChanged(const Tileset *tileset);
+
     /**
      * Returns whether this object group contains any objects.
      */
@@ -191,9 +242,14 @@ protected:
     ObjectGroup *initializeClone(ObjectGroup *clone) const;
 
 private:
+    class SpatialIndex;
+
+    SpatialIndex &spatialIndex() const;
+
     QList<MapObject*> mObjects;
     QColor mColor;
     DrawOrder mDrawOrder;
+    mutable QScopedPointer<SpatialIndex> mSpatialIndex;
 };
 
 
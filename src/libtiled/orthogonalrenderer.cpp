@@ -307,9 +307,11 @@ void OrthogonalRenderer::drawTileLayer(QPainter *painter,
     endX += incX;
     endY += incY;
 
+    CellReader reader(layer);
+
     for (int y = startY; y != endY; y += incY) {
         for (int x = startX; x != endX; x += incX) {
-            const Cell &cell = layer->cellAt(x, y);
+            const Cell cell = reader.cellAt(x, y);
             if (cell.isEmpty())
                 continue;
 
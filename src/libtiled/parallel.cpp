@@ -0,0 +1,107 @@
+/*
+ * parallel.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "parallel.h"
+
+#include <QAtomicInt>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+
+namespace Tiled {
+
+namespace {
+
+/**
+ * Runs a function on the thread pool and signals the given semaphore when
+ * it is done.
+ */
+class Task : public QRunnable
+{
+public:
+    Task(const std::function<void()> &work, QSemaphore *done)
+        : mWork(work)
+        , mDone(done)
+    {}
+
+    void run() override
+    {
+        mWork();
+        mDone->release();
+    }
+
+private:
+    std::function<void()> mWork;
+    QSemaphore *mDone;
+};
+
+} // anonymous namespace
+
+/**
+ * Calls \a function for each index from 0 to \a count - 1, spread over the
+ * global thread pool. Returns when all calls have finished.
+ *
+ * The calling thread takes part in the work, and additional tasks are only
+ * started when the thread pool has a thread available. This means it is
+ * safe to call this function from the thread pool, including from within
+ * another parallelFor.
+ */
+void parallelFor(int count, const std::function<void (int index)> &function)
+{
+    if (count <= 0)
+        return;
+
+    QAtomicInt next(0);
+
+    auto work = [&] {
+        int index;
+        while ((index = next.fetchAndAddRelaxed(1)) < count)
+            function(index);
+    };
+
+    QThreadPool *threadPool = QThreadPool::globalInstance();
+    const int maxTasks = qMin(count, threadPool->maxThreadCount()) - 1;
+
+    QSemaphore done;
+    int started = 0;
+
+    for (int i = 0; i < maxTasks; ++i) {
+        Task *task = new Task(work, &done);
+        if (!threadPool->tryStart(task)) {
+            delete task;
+            break;
+        }
+        ++started;
+    }
+
+    work();
+    done.acquire(started);
+}
+
+} // namespace Tiled
@@ -22,6 +22,8 @@
 #include "templatemanager.h"
 #include "templategroupformat.h"
 
+#include <QThread>
+
 using namespace Tiled;
 
 TemplateManager::TemplateManager(QObject *parent)
@@ -55,8 +57,20 @@ TemplateGroup *TemplateManager::findTemplateGroup(const QString &fileName)
     return nullptr;
 }
 
+/**
+ * Loads the template group with the given \a fileName, unless it was loaded
+ * before.
+ *
+ * Template groups add references to their tilesets, which is only possible
+ * from the thread this manager lives in. When called from another thread,
+ * as happens when a map is read in the background, nothing is loaded and
+ * the caller is expected to try again from the right thread.
+ */
 TemplateGroup *TemplateManager::loadTemplateGroup(const QString &fileName, QString *error)
 {
+    if (QThread::currentThread() != thread())
+        return nullptr;
+
     TemplateGroup *templateGroup = findTemplateGroup(fileName);
 
     if (!templateGroup) {
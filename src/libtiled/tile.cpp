@@ -28,6 +28,7 @@
 
 #include "tile.h"
 
+#include "deferredimage.h"
 #include "objectgroup.h"
 #include "tileset.h"
 
@@ -50,6 +51,7 @@ Tile::Tile(const QPixmap &image, int id, Tileset *tileset):
     mId(id),
     mTileset(tileset),
     mImage(image),
+    mImageRect(image.rect()),
     mImageStatus(image.isNull() ? LoadingError : LoadingReady),
     mTerrain(-1),
     mProbability(1.f),
@@ -71,6 +73,78 @@ QSharedPointer<Tileset> Tile::sharedTileset() const
     return mTileset->sharedPointer();
 }
 
+/**
+ * Returns the image of this tile.
+ *
+ * When the tile is part of a larger image (see atlasImage()), this returns
+ * a copy of its part. The copy is not kept, so code that draws many tiles
+ * should use atlasImage() and imageRect() instead.
+ *
+ * When the image is deferred, it is decoded by the first call, which may
+ * therefore only happen on the GUI thread (see
+ * DeferredImage::canCreatePixmaps()).
+ */
+QPixmap Tile::image() const
+{
+    if (mDeferredImage)
+        loadDeferredImage();
+
+    if (mImageRect == mImage.rect())
+        return mImage;
+
+    return mImage.copy(mImageRect);
+}
+
+/**
+ * Sets the image of this tile to the \a imageRect part of \a atlasImage.
+ * The source image may be shared between many tiles.
+ */
+void Tile::setImage(const QPixmap &atlasImage, const QRect &imageRect)
+{
+    mImage = atlasImage;
+    mDeferredImage.reset();
+    mImageRect = imageRect;
+    mImageStatus = atlasImage.isNull() ? LoadingError : LoadingReady;
+}
+
+/**
+ * Sets the image of this tile to the \a imageRect part of \a atlasImage,
+ * which is only decoded once the image of this tile is first requested.
+ *
+ * When \a atlasImage is null, the tile gets its size but no image. This is
+ * used when images are skipped entirely (see ImageLoadingMode).
+ */
+void Tile::setDeferredImage(const QSharedPointer<DeferredImage> &atlasImage,
+                            const QRect &imageRect)
+{
+    mImage = QPixmap();
+    mDeferredImage = atlasImage;
+    mImageRect = imageRect;
+    mImageStatus = LoadingReady;
+}
+
+/**
+ * Replaces the deferred image with the decoded pixmap. Since all tiles from
+ * the same atlas share the DeferredImage, they also end up sharing the
+ * pixmap.
+ *
+ * When the image turns out not to be decodable, the image status of the tile
+ * (and of an image-based tileset) is changed to LoadingError.
+ */
+void Tile::loadDeferredImage() const
+{
+    Q_ASSERT(DeferredImage::canCreatePixmaps());
+
+    mImage = mDeferredImage->pixmap();
+    mDeferredImage.reset();
+
+    if (mImage.isNull()) {
+        mImageStatus = LoadingError;
+        if (!mTileset->isCollection())
+            mTileset->setImageStatus(LoadingError);
+    }
+}
+
 /**
  * Returns the tile to render when taking into account tile animations.
  *
@@ -152,6 +226,7 @@ void Tile::setFrames(const QVector<Frame> &frames)
 {
     resetAnimation();
     mFrames = frames;
+    mTileset->markFramesChanged();
 }
 
 /**
@@ -204,6 +279,9 @@ Tile *Tile::clone(Tileset *tileset) const
     Tile *c = new Tile(mImage, mId, tileset);
     c->setProperties(properties());
 
+    c->mDeferredImage = mDeferredImage;
+    c->mImageRect = mImageRect;
+    c->mImageStatus = mImageStatus;
     c->mImageSource = mImageSource;
     c->mTerrain = mTerrain;
     c->mProbability = mProbability;
@@ -38,6 +38,7 @@
 
 namespace Tiled {
 
+class DeferredImage;
 class ObjectGroup;
 class Terrain;
 class Tileset;
@@ -103,9 +104,15 @@ public:
     Tileset *tileset() const;
     QSharedPointer<Tileset> sharedTileset() const;
 
-    const QPixmap &image() const;
+    QPixmap image() const;
     void setImage(const QPixmap &image);
 
+    const QPixmap &atlasImage() const;
+    const QRect &imageRect() const;
+    void setImage(const QPixmap &atlasImage, const QRect &imageRect);
+    void setDeferredImage(const QSharedPointer<DeferredImage> &atlasImage,
+                          const QRect &imageRect);
+
     const Tile *currentFrameTile() const;
 
     const QUrl &imageSource() const;
@@ -148,11 +155,15 @@ public:
     Tile *clone(Tileset *tileset) const;
 
 private:
+    void loadDeferredImage() const;
+
     int mId;
     Tileset *mTileset;
-    QPixmap mImage;
+    mutable QPixmap mImage;
+    mutable QSharedPointer<DeferredImage> mDeferredImage;
+    QRect mImageRect;
     QUrl mImageSource;
-    LoadingStatus mImageStatus;
+    mutable LoadingStatus mImageStatus;
     QString mType;
     unsigned mTerrain;
     float mProbability;
@@ -182,20 +193,39 @@ inline Tileset *Tile::tileset() const
 }
 
 /**
- * Returns the image of this tile.
+ * Sets the image of this tile.
  */
-inline const QPixmap &Tile::image() const
+inline void Tile::setImage(const QPixmap &image)
 {
+    setImage(image, image.rect());
+}
+
+/**
+ * Returns the image this tile is taken from. For tiles that are part of an
+ * image-based tileset, this is the tileset image shared by all its tiles and
+ * only imageRect() of it belongs to this tile.
+ *
+ * Renderers should prefer drawing imageRect() from this image over using
+ * image(), since it allows drawing many tiles in a single call.
+ *
+ * When the image is deferred, it is decoded by the first call, which may
+ * therefore only happen on the GUI thread (see
+ * DeferredImage::canCreatePixmaps()). Tileset::loadDeferredImages() can be
+ * used to load all images up front.
+ */
+inline const QPixmap &Tile::atlasImage() const
+{
+    if (mDeferredImage)
+        loadDeferredImage();
     return mImage;
 }
 
 /**
- * Sets the image of this tile.
+ * Returns the part of atlasImage() that makes up this tile.
  */
-inline void Tile::setImage(const QPixmap &image)
+inline const QRect &Tile::imageRect() const
 {
-    mImage = image;
-    mImageStatus = image.isNull() ? LoadingError : LoadingReady;
+    return mImageRect;
 }
 
 /**
@@ -218,7 +248,7 @@ inline void Tile::setImageSource(const QUrl &imageSource)
  */
 inline int Tile::width() const
 {
-    return mImage.width();
+    return mImageRect.width();
 }
 
 /**
@@ -226,7 +256,7 @@ inline int Tile::width() const
  */
 inline int Tile::height() const
 {
-    return mImage.height();
+    return mImageRect.height();
 }
 
 /**
@@ -234,7 +264,7 @@ inline int Tile::height() const
  */
 inline QSize Tile::size() const
 {
-    return mImage.size();
+    return mImageRect.size();
 }
 
 /**
@@ -32,8 +32,54 @@
 #include "tile.h"
 #include "hex.h"
 
+#include <algorithm>
+
 using namespace Tiled;
 
+TilesetTable::TilesetTable()
+{
+    mTilesets.append(nullptr);
+    mIndexes.insert(nullptr, 0);
+}
+
+QSharedPointer<TilesetTable> TilesetTable::withTileset(Tileset *tileset) const
+{
+    Q_ASSERT(!isFull());
+    Q_ASSERT(indexOf(tileset) == -1);
+
+    auto table = QSharedPointer<TilesetTable>::create(*this);
+    table->mIndexes.insert(tileset, table->mTilesets.size());
+    table->mTilesets.append(tileset);
+    return table;
+}
+
+bool Chunk::pack(const Cell &cell, const TilesetTable &tilesets, quint32 &packed)
+{
+    const int storedTileId = cell.tileId() + 1;
+    if (storedTileId < 0 || static_cast<quint32>(storedTileId) > TileIdMask)
+        return false;
+
+    const int tilesetIndex = tilesets.indexOf(cell.tileset());
+    if (tilesetIndex == -1)
+        return false;
+
+    packed = static_cast<quint32>(storedTileId) |
+            (static_cast<quint32>(tilesetIndex) << TilesetIndexShift);
+
+    if (cell.flippedHorizontally())
+        packed |= FlippedHorizontally;
+    if (cell.flippedVertically())
+        packed |= FlippedVertically;
+    if (cell.flippedAntiDiagonally())
+        packed |= FlippedAntiDiag;
+    if (cell.rotatedHexagonal120())
+        packed |= RotatedHex120;
+    if (cell.checked())
+        packed |= Checked;
+
+    return true;
+}
+
 QRegion Chunk::region(std::function<bool (const Cell &)> condition) const
 {
     QRegion region;
@@ -60,11 +106,30 @@ void Chunk::setCell(int x, int y, const Cell &cell)
 {
     int index = x + y * CHUNK_SIZE;
 
+    if (isCompact()) {
+        quint32 packed;
+        if (pack(cell, *mTilesets, packed)) {
+            mPacked[index] = packed;
+            return;
+        }
+
+        // The cell doesn't fit, so this chunk needs to store full cells
+        makeFull();
+    }
+
     mGrid[index] = cell;
 }
 
 bool Chunk::isEmpty() const
 {
+    if (isCompact()) {
+        for (quint32 packed : mPacked)
+            if (packed & TilesetIndexMask)
+                return false;
+
+        return true;
+    }
+
     for (int y = 0; y < CHUNK_SIZE; ++y) {
         for (int x = 0; x < CHUNK_SIZE; ++x) {
             if (!cellAt(x, y).isEmpty())
@@ -77,6 +142,14 @@ bool Chunk::isEmpty() const
 
 bool Chunk::hasCell(std::function<bool (const Cell &)> condition) const
 {
+    if (isCompact()) {
+        for (quint32 packed : mPacked)
+            if (condition(unpack(packed, *mTilesets)))
+                return true;
+
+        return false;
+    }
+
     for (const Cell &cell : mGrid)
         if (condition(cell))
             return true;
@@ -86,6 +159,18 @@ bool Chunk::hasCell(std::function<bool (const Cell &)> condition) const
 
 void Chunk::removeReferencesToTileset(Tileset *tileset)
 {
+    if (isCompact()) {
+        const int tilesetIndex = mTilesets->indexOf(tileset);
+        if (tilesetIndex == -1)
+            return;
+
+        for (quint32 &packed : mPacked) {
+            if (static_cast<int>((packed & TilesetIndexMask) >> TilesetIndexShift) == tilesetIndex)
+                packed = 0;
+        }
+        return;
+    }
+
     for (int i = 0, i_end = mGrid.size(); i < i_end; ++i) {
         if (mGrid.at(i).tileset() == tileset)
             mGrid.replace(i, Cell());
@@ -94,17 +179,77 @@ void Chunk::removeReferencesToTileset(Tileset *tileset)
 
 void Chunk::replaceReferencesToTileset(Tileset *oldTileset, Tileset *newTileset)
 {
+    if (isCompact()) {
+        const int oldIndex = mTilesets->indexOf(oldTileset);
+        const int newIndex = mTilesets->indexOf(newTileset);
+
+        if (oldIndex == -1)
+            return;
+
+        if (newIndex == -1) {
+            makeFull();
+        } else {
+            for (quint32 &packed : mPacked) {
+                if (static_cast<int>((packed & TilesetIndexMask) >> TilesetIndexShift) == oldIndex) {
+                    packed &= ~TilesetIndexMask;
+                    packed |= static_cast<quint32>(newIndex) << TilesetIndexShift;
+                }
+            }
+            return;
+        }
+    }
+
     for (Cell &cell : mGrid) {
         if (cell.tileset() == oldTileset)
             cell.setTile(newTileset, cell.tileId());
     }
 }
 
+bool Chunk::makeCompact(const QSharedPointer<TilesetTable> &tilesets)
+{
+    if (isCompact())
+        return true;
+
+    QVector<quint32> packedCells(CHUNK_SIZE * CHUNK_SIZE);
+    for (int i = 0; i < mGrid.size(); ++i)
+        if (!pack(mGrid.at(i), *tilesets, packedCells[i]))
+            return false;
+
+    mPacked.swap(packedCells);
+    mGrid.clear();
+    mGrid.squeeze();
+    mTilesets = tilesets;
+    return true;
+}
+
+void Chunk::setTilesetTable(const QSharedPointer<TilesetTable> &tilesets)
+{
+    if (isCompact())
+        mTilesets = tilesets;
+}
+
+void Chunk::makeFull()
+{
+    if (!isCompact())
+        return;
+
+    QVector<Cell> cells(CHUNK_SIZE * CHUNK_SIZE);
+    for (int i = 0; i < mPacked.size(); ++i)
+        cells[i] = unpack(mPacked.at(i), *mTilesets);
+
+    mGrid.swap(cells);
+    mPacked.clear();
+    mPacked.squeeze();
+    mTilesets.clear();
+}
+
 TileLayer::TileLayer(const QString &name, int x, int y, int width, int height)
     : Layer(TileLayerType, name, x, y)
     , mWidth(width)
     , mHeight(height)
+    , mSparseChunks(false)
     , mUsedTilesetsDirty(false)
+    , mAnimatedCellsDirty(true)
 {
     Q_ASSERT(width >= 0);
     Q_ASSERT(height >= 0);
@@ -192,9 +337,201 @@ void Tiled::TileLayer::setCell(int x, int y, const Cell &cell)
         }
     }
 
+    if (!mAnimatedCellsDirty) {
+        Tile *tile = cell.tile();
+        if (tile && tile->isAnimated())
+            mAnimatedCells.insert(QPoint(x, y), tile);
+        else
+            mAnimatedCells.remove(QPoint(x, y));
+
+        // Watch any newly used tileset for changes to its animations
+        if (tile) {
+            Tileset *tileset = tile->tileset();
+            if (!mAnimatedCellsFramesVersions.contains(tileset))
+                mAnimatedCellsFramesVersions.insert(tileset, { tileset->sharedPointer(),
+                                                               tileset->framesVersion() });
+        }
+    }
+
+    if (_chunk.isCompact() && mTilesetTable->indexOf(cell.tileset()) == -1)
+        addToTilesetTable(cell.tileset());
+
     _chunk.setCell(x & CHUNK_MASK, y & CHUNK_MASK, cell);
 }
 
+/**
+ * Returns the chunk containing the cell at the given coordinates, creating
+ * it when necessary.
+ */
+Chunk &TileLayer::chunk(int x, int y)
+{
+    detachChunks();
+
+    if (const Chunk *existing = findChunk(x, y))
+        return *const_cast<Chunk*>(existing);
+
+    const QPoint coordinates = chunkCoordinates(x, y);
+    auto it = mChunks.insert(coordinates, isCompact() ? Chunk(mTilesetTable) : Chunk());
+    growChunkGrid(coordinates, &it.value());
+    return it.value();
+}
+
+/**
+ * Makes sure the chunks are not shared with another layer, so that they can
+ * be changed. Since detaching copies the chunks, the chunk grid is rebuilt
+ * in that case.
+ */
+void TileLayer::detachChunks()
+{
+    if (mChunks.isDetached())
+        return;
+
+    mChunks.detach();
+    rebuildChunkGrid();
+}
+
+/**
+ * Returns whether a dense chunk grid covering \a chunkRect is reasonable
+ * given the number of chunks in this layer.
+ */
+bool TileLayer::fitsChunkGrid(const QRect &chunkRect) const
+{
+    const qint64 area = qint64(chunkRect.width()) * chunkRect.height();
+    return area <= qMax<qint64>(4096, qint64(mChunks.size()) * 16);
+}
+
+void TileLayer::rebuildChunkGrid()
+{
+    QRect chunkRect;
+
+    const QHash<QPoint, Chunk> &chunks = mChunks;
+    for (auto it = chunks.begin(), end = chunks.end(); it != end; ++it)
+        chunkRect |= QRect(it.key(), QSize(1, 1));
+
+    mSparseChunks = !fitsChunkGrid(chunkRect);
+    mChunkGridRect = mSparseChunks ? QRect() : chunkRect;
+    mChunkGrid.fill(nullptr, mChunkGridRect.width() * mChunkGridRect.height());
+
+    if (mSparseChunks)
+        return;
+
+    // The chunks are not changed here, but the grid is used to look up the
+    // chunks for modification as well.
+    for (auto it = chunks.begin(), end = chunks.end(); it != end; ++it) {
+        const int gridX = it.key().x() - mChunkGridRect.x();
+        const int gridY = it.key().y() - mChunkGridRect.y();
+        mChunkGrid[gridX + gridY * mChunkGridRect.width()] = const_cast<Chunk*>(&it.value());
+    }
+}
+
+/**
+ * Makes sure the chunk grid includes the recently added \a chunk at the
+ * given chunk coordinates.
+ */
+void TileLayer::growChunkGrid(const QPoint &chunkCoordinates, Chunk *chunk)
+{
+    if (mSparseChunks)
+        return;
+
+    if (mChunkGridRect.contains(chunkCoordinates)) {
+        const int gridX = chunkCoordinates.x() - mChunkGridRect.x();
+        const int gridY = chunkCoordinates.y() - mChunkGridRect.y();
+        mChunkGrid[gridX + gridY * mChunkGridRect.width()] = chunk;
+        return;
+    }
+
+    // Grow geometrically in the direction of the new chunk, to avoid
+    // rebuilding the grid for each chunk added while a layer is filled.
+    QRect grown = mChunkGridRect | QRect(chunkCoordinates, QSize(1, 1));
+    if (!mChunkGridRect.isEmpty()) {
+        const int marginX = mChunkGridRect.width() / 2;
+        const int marginY = mChunkGridRect.height() / 2;
+        if (chunkCoordinates.x() < mChunkGridRect.left())
+            grown.setLeft(qMin(grown.left(), mChunkGridRect.left() - marginX));
+        if (chunkCoordinates.x() > mChunkGridRect.right())
+            grown.setRight(qMax(grown.right(), mChunkGridRect.right() + marginX));
+        if (chunkCoordinates.y() < mChunkGridRect.top())
+            grown.setTop(qMin(grown.top(), mChunkGridRect.top() - marginY));
+        if (chunkCoordinates.y() > mChunkGridRect.bottom())
+            grown.setBottom(qMax(grown.bottom(), mChunkGridRect.bottom() + marginY));
+
+        if (!fitsChunkGrid(grown))
+            grown = mChunkGridRect | QRect(chunkCoordinates, QSize(1, 1));
+    }
+
+    if (!fitsChunkGrid(grown)) {
+        mSparseChunks = true;
+        mChunkGrid.clear();
+        mChunkGridRect = QRect();
+        return;
+    }
+
+    QVector<Chunk*> grid(grown.width() * grown.height(), nullptr);
+    const int offsetX = mChunkGridRect.x() - grown.x();
+    const int offsetY = mChunkGridRect.y() - grown.y();
+    for (int y = 0; y < mChunkGridRect.height(); ++y) {
+        std::copy_n(mChunkGrid.constData() + y * mChunkGridRect.width(),
+                    mChunkGridRect.width(),
+                    grid.data() + offsetX + (y + offsetY) * grown.width());
+    }
+
+    mChunkGrid.swap(grid);
+    mChunkGridRect = grown;
+
+    const int gridX = chunkCoordinates.x() - mChunkGridRect.x();
+    const int gridY = chunkCoordinates.y() - mChunkGridRect.y();
+    mChunkGrid[gridX + gridY * mChunkGridRect.width()] = chunk;
+}
+
+void TileLayer::setCompact(bool compact)
+{
+    if (compact == isCompact())
+        return;
+
+    detachChunks();
+
+    if (compact) {
+        auto table = QSharedPointer<TilesetTable>::create();
+        for (const SharedTileset &tileset : usedTilesets()) {
+            if (table->isFull())
+                break;
+            table = table->withTileset(tileset.data());
+        }
+
+        mTilesetTable = table;
+        for (Chunk &chunk : mChunks)
+            chunk.makeCompact(mTilesetTable);
+    } else {
+        expandChunks();
+        mTilesetTable.clear();
+    }
+}
+
+/**
+ * Replaces the tileset table of this compact layer with one that includes
+ * \a tileset. Does nothing when the table is full, in which case cells
+ * referring to \a tileset are stored in full.
+ */
+void TileLayer::addToTilesetTable(Tileset *tileset)
+{
+    if (mTilesetTable->isFull())
+        return;
+
+    detachChunks();
+
+    mTilesetTable = mTilesetTable->withTileset(tileset);
+    for (Chunk &chunk : mChunks)
+        chunk.setTilesetTable(mTilesetTable);
+}
+
+void TileLayer::expandChunks()
+{
+    detachChunks();
+
+    for (Chunk &chunk : mChunks)
+        chunk.makeFull();
+}
+
 TileLayer *TileLayer::copy(const QRegion &region) const
 {
     const QRect areaBounds = region.boundingRect();
@@ -274,6 +611,7 @@ void TileLayer::erase(const QRegion &area)
 void TileLayer::flip(FlipDirection direction)
 {
     QScopedPointer<TileLayer> newLayer(new TileLayer(QString(), 0, 0, mWidth, mHeight));
+    newLayer->mTilesetTable = mTilesetTable;
 
     Q_ASSERT(direction == FlipHorizontally || direction == FlipVertically);
 
@@ -302,11 +640,15 @@ void TileLayer::flip(FlipDirection direction)
     }
 
     mChunks = newLayer->mChunks;
+    mTilesetTable = newLayer->mTilesetTable;
+    mAnimatedCellsDirty = true;
+    rebuildChunkGrid();
 }
 
 void TileLayer::flipHexagonal(FlipDirection direction)
 {
     QScopedPointer<TileLayer> newLayer(new TileLayer(QString(), 0, 0, mWidth, mHeight));
+    newLayer->mTilesetTable = mTilesetTable;
 
     Q_ASSERT(direction == FlipHorizontally || direction == FlipVertically);
 
@@ -351,6 +693,9 @@ void TileLayer::flipHexagonal(FlipDirection direction)
     }
 
     mChunks = newLayer->mChunks;
+    mTilesetTable = newLayer->mTilesetTable;
+    mAnimatedCellsDirty = true;
+    rebuildChunkGrid();
 }
 
 void TileLayer::rotate(RotateDirection direction)
@@ -364,6 +709,7 @@ void TileLayer::rotate(RotateDirection direction)
     int newWidth = mHeight;
     int newHeight = mWidth;
     QScopedPointer<TileLayer> newLayer(new TileLayer(QString(), 0, 0, newWidth, newHeight));
+    newLayer->mTilesetTable = mTilesetTable;
 
     QHashIterator<QPoint, Chunk> it(mChunks);
     while (it.hasNext()) {
@@ -400,6 +746,9 @@ void TileLayer::rotate(RotateDirection direction)
     mWidth = newWidth;
     mHeight = newHeight;
     mChunks = newLayer->mChunks;
+    mTilesetTable = newLayer->mTilesetTable;
+    mAnimatedCellsDirty = true;
+    rebuildChunkGrid();
 }
 
 void TileLayer::rotateHexagonal(RotateDirection direction, Map *map)
@@ -420,6 +769,7 @@ void TileLayer::rotateHexagonal(RotateDirection direction, Map *map)
     int newWidth = topRight.toStaggered(staggerIndex, staggerAxis).x() * 2 + 2;
     int newHeight = bottomRight.toStaggered(staggerIndex, staggerAxis).y() * 2 + 2;
     QScopedPointer<TileLayer> newLayer(new TileLayer(QString(), 0, 0, newWidth, newHeight));
+    newLayer->mTilesetTable = mTilesetTable;
 
     Hex newCenter(newWidth / 2, newHeight / 2, staggerIndex, staggerAxis);
 
@@ -488,6 +838,9 @@ void TileLayer::rotateHexagonal(RotateDirection direction, Map *map)
     mWidth = newWidth;
     mHeight = newHeight;
     mChunks = newLayer->mChunks;
+    mTilesetTable = newLayer->mTilesetTable;
+    mAnimatedCellsDirty = true;
+    rebuildChunkGrid();
 
     QRect filledRect = region().boundingRect();
 
@@ -509,13 +862,14 @@ QSet<SharedTileset> TileLayer::usedTilesets() const
         QSet<SharedTileset> tilesets;
 
         for (const Chunk &chunk : mChunks) {
-            for (const Cell &cell : chunk)
-                if (const Tile *tile = cell.tile())
-                    tilesets.insert(tile->sharedTileset());
-
-            mUsedTilesets.swap(tilesets);
-            mUsedTilesetsDirty = false;
+            for (int y = 0; y < CHUNK_SIZE; ++y)
+                for (int x = 0; x < CHUNK_SIZE; ++x)
+                    if (const Tile *tile = chunk.cellAt(x, y).tile())
+                        tilesets.insert(tile->sharedTileset());
         }
+
+        mUsedTilesets.swap(tilesets);
+        mUsedTilesetsDirty = false;
     }
 
     return mUsedTilesets;
@@ -531,6 +885,71 @@ bool TileLayer::hasCell(std::function<bool (const Cell &)> condition) const
     return false;
 }
 
+/**
+ * Returns whether the animation frames of any of the tilesets used by this
+ * layer changed since the animated cells were indexed.
+ */
+bool TileLayer::animatedCellsOutdated() const
+{
+    if (mAnimatedCellsDirty)
+        return true;
+
+    for (auto it = mAnimatedCellsFramesVersions.constBegin(),
+         end = mAnimatedCellsFramesVersions.constEnd(); it != end; ++it) {
+        const SharedTileset tileset = it.value().tileset.toStrongRef();
+        if (!tileset || tileset->framesVersion() != it.value().framesVersion)
+            return true;
+    }
+
+    return false;
+}
+
+const QHash<QPoint, Tile *> &TileLayer::animatedCells() const
+{
+    if (animatedCellsOutdated()) {
+        mAnimatedCells.clear();
+        mAnimatedCellsFramesVersions.clear();
+
+        // Only the cells from tilesets with animated tiles need a closer look
+        QVector<const Tileset*> animatedTilesets;
+        for (const SharedTileset &tileset : usedTilesets()) {
+            mAnimatedCellsFramesVersions.insert(tileset.data(), { tileset,
+                                                                 tileset->framesVersion() });
+
+            for (const Tile *tile : tileset->tiles()) {
+                if (tile->isAnimated()) {
+                    animatedTilesets.append(tileset.data());
+                    break;
+                }
+            }
+        }
+
+        if (!animatedTilesets.isEmpty()) {
+            QHashIterator<QPoint, Chunk> it(mChunks);
+            while (it.hasNext()) {
+                it.next();
+                const QPoint chunkStart = it.key() * CHUNK_SIZE;
+
+                for (int y = 0; y < CHUNK_SIZE; ++y) {
+                    for (int x = 0; x < CHUNK_SIZE; ++x) {
+                        const Cell cell = it.value().cellAt(x, y);
+                        if (!animatedTilesets.contains(cell.tileset()))
+                            continue;
+
+                        Tile *tile = cell.tile();
+                        if (tile && tile->isAnimated())
+                            mAnimatedCells.insert(chunkStart + QPoint(x, y), tile);
+                    }
+                }
+            }
+        }
+
+        mAnimatedCellsDirty = false;
+    }
+
+    return mAnimatedCells;
+}
+
 bool TileLayer::referencesTileset(const Tileset *tileset) const
 {
     return usedTilesets().contains(tileset->sharedPointer());
@@ -538,20 +957,32 @@ bool TileLayer::referencesTileset(const Tileset *tileset) const
 
 void TileLayer::removeReferencesToTileset(Tileset *tileset)
 {
+    detachChunks();
+
     for (Chunk &chunk : mChunks)
         chunk.removeReferencesToTileset(tileset);
 
     mUsedTilesets.remove(tileset->sharedPointer());
+    mAnimatedCellsDirty = true;
 }
 
 void TileLayer::replaceReferencesToTileset(Tileset *oldTileset,
                                            Tileset *newTileset)
 {
+    if (isCompact() && mTilesetTable->indexOf(oldTileset) != -1 &&
+            mTilesetTable->indexOf(newTileset) == -1) {
+        addToTilesetTable(newTileset);
+    }
+
+    detachChunks();
+
     for (Chunk &chunk : mChunks)
         chunk.replaceReferencesToTileset(oldTileset, newTileset);
 
     if (mUsedTilesets.remove(oldTileset->sharedPointer()))
         mUsedTilesets.insert(newTileset->sharedPointer());
+
+    mAnimatedCellsDirty = true;
 }
 
 void TileLayer::resize(const QSize &size, const QPoint &offset)
@@ -560,6 +991,7 @@ void TileLayer::resize(const QSize &size, const QPoint &offset)
         return;
 
     QScopedPointer<TileLayer> newLayer(new TileLayer(QString(), 0, 0, size.width(), size.height()));
+    newLayer->mTilesetTable = mTilesetTable;
 
     // Copy over the preserved part
     QRect area = mBounds.translated(offset).intersected(newLayer->rect());
@@ -568,6 +1000,9 @@ void TileLayer::resize(const QSize &size, const QPoint &offset)
             newLayer->setCell(x, y, cellAt(x - offset.x(), y - offset.y()));
 
     mChunks = newLayer->mChunks;
+    mTilesetTable = newLayer->mTilesetTable;
+    mAnimatedCellsDirty = true;
+    rebuildChunkGrid();
     mBounds = newLayer->mBounds;
     setSize(size);
 }
@@ -609,6 +1044,9 @@ void TileLayer::offsetTiles(const QPoint &offset,
     }
 
     mChunks = newLayer->mChunks;
+    mTilesetTable = newLayer->mTilesetTable;
+    mAnimatedCellsDirty = true;
+    rebuildChunkGrid();
     mBounds = newLayer->mBounds;
 }
 
@@ -640,12 +1078,15 @@ QRegion TileLayer::computeDiffRegion(const TileLayer *other) const
 
     const QRect r = bounds().united(other->bounds()).translated(-position());
 
+    CellReader reader(this);
+    CellReader otherReader(other);
+
     for (int y = r.top(); y <= r.bottom(); ++y) {
         for (int x = r.left(); x <= r.right(); ++x) {
-            if (cellAt(x, y) != other->cellAt(x - dx, y - dy)) {
+            if (reader.cellAt(x, y) != otherReader.cellAt(x - dx, y - dy)) {
                 const int rangeStart = x;
                 while (x <= r.right() &&
-                       cellAt(x, y) != other->cellAt(x - dx, y - dy)) {
+                       reader.cellAt(x, y) != otherReader.cellAt(x - dx, y - dy)) {
                     ++x;
                 }
                 const int rangeEnd = x;
@@ -680,8 +1121,15 @@ TileLayer *TileLayer::initializeClone(TileLayer *clone) const
 {
     Layer::initializeClone(clone);
     clone->mChunks = mChunks;
+    clone->mChunkGrid = mChunkGrid;
+    clone->mChunkGridRect = mChunkGridRect;
+    clone->mSparseChunks = mSparseChunks;
+    clone->mTilesetTable = mTilesetTable;
     clone->mBounds = mBounds;
     clone->mUsedTilesets = mUsedTilesets;
     clone->mUsedTilesetsDirty = mUsedTilesetsDirty;
+    clone->mAnimatedCells = mAnimatedCells;
+    clone->mAnimatedCellsFramesVersions = mAnimatedCellsFramesVersions;
+    clone->mAnimatedCellsDirty = mAnimatedCellsDirty;
     return clone;
 }
@@ -150,21 +150,79 @@ inline bool Cell::refersTile(const Tile *tile) const
     return _tileset == tile->tileset() && _tileId == tile->id();
 }
 
+inline uint qHash(const Cell &cell, uint seed = 0) Q_DECL_NOTHROW
+{
+    const uint flags = (cell.flippedHorizontally() << 0) |
+                       (cell.flippedVertically() << 1) |
+                       (cell.flippedAntiDiagonally() << 2) |
+                       (cell.rotatedHexagonal120() << 3) |
+                       (cell.checked() << 4);
+
+    return qHash(cell.tileset(), seed) ^ qHash(cell.tileId(), seed) ^ (flags << 27);
+}
+
+
+/**
+ * The tilesets referenced by the compact chunks of a tile layer. Compact
+ * chunks refer to a tileset by its index in this table. Index 0 always refers
+ * to no tileset.
+ *
+ * A table is never changed once it is in use. When a layer needs to refer to
+ * another tileset, it replaces its table with an extended copy. This way the
+ * table can be shared between copies of a layer.
+ */
+class TILEDSHARED_EXPORT TilesetTable
+{
+public:
+    enum { MaxTilesets = 1024 };
+
+    TilesetTable();
+
+    /**
+     * Returns the index of the given \a tileset, or -1 when it is not in
+     * this table.
+     */
+    int indexOf(const Tileset *tileset) const { return mIndexes.value(tileset, -1); }
+
+    Tileset *tilesetAt(int index) const { return mTilesets.at(index); }
+
+    bool isFull() const { return mTilesets.size() == MaxTilesets; }
+
+    /**
+     * Returns a copy of this table with the given \a tileset added. The
+     * indexes of the tilesets already in this table are preserved.
+     */
+    QSharedPointer<TilesetTable> withTileset(Tileset *tileset) const;
+
+private:
+    QVector<Tileset*> mTilesets;
+    QHash<const Tileset*, int> mIndexes;
+};
 
 /**
  * A Chunk is a grid of cells of size CHUNK_SIZExCHUNK_SIZE.
+ *
+ * A chunk is either stored as an array of cells, or in compact form as an
+ * array of 32-bit values, each packing the index of the tileset in a
+ * TilesetTable, the tile id and the flags of a cell. A compact chunk falls
+ * back to storing cells when it is given a cell that doesn't fit.
  */
-class Chunk
+class TILEDSHARED_EXPORT Chunk
 {
 public:
     Chunk() :
         mGrid(CHUNK_SIZE * CHUNK_SIZE)
     {}
 
+    explicit Chunk(const QSharedPointer<TilesetTable> &tilesets) :
+        mPacked(CHUNK_SIZE * CHUNK_SIZE, 0u),
+        mTilesets(tilesets)
+    {}
+
     QRegion region(std::function<bool (const Cell &)> condition) const;
 
-    const Cell &cellAt(int x, int y) const;
-    const Cell &cellAt(const QPoint &point) const;
+    Cell cellAt(int x, int y) const;
+    Cell cellAt(const QPoint &point) const;
 
     void setCell(int x, int y, const Cell &cell);
 
@@ -176,21 +234,70 @@ public:
 
     void replaceReferencesToTileset(Tileset *oldTileset, Tileset *newTileset);
 
-    QVector<Cell>::iterator begin() { return mGrid.begin(); }
-    QVector<Cell>::iterator end() { return mGrid.end(); }
-    QVector<Cell>::const_iterator begin() const { return mGrid.begin(); }
-    QVector<Cell>::const_iterator end() const { return mGrid.end(); }
+    bool isCompact() const { return !mTilesets.isNull(); }
+
+    /**
+     * Converts this chunk to compact storage using the given table. Returns
+     * false and leaves the chunk unchanged when any of its cells doesn't fit.
+     */
+    bool makeCompact(const QSharedPointer<TilesetTable> &tilesets);
+
+    /**
+     * Converts this chunk to storing cells.
+     */
+    void makeFull();
+
+    /**
+     * Makes a compact chunk refer to \a tilesets, which needs to be an
+     * extension of its current table.
+     */
+    void setTilesetTable(const QSharedPointer<TilesetTable> &tilesets);
 
 private:
+    static bool pack(const Cell &cell, const TilesetTable &tilesets, quint32 &packed);
+    static Cell unpack(quint32 packed, const TilesetTable &tilesets);
+
+    // Layout of the packed cells
+    static const quint32 TileIdMask          = 0x0001FFFF;  // tile id + 1
+    static const int TilesetIndexShift       = 17;
+    static const quint32 TilesetIndexMask    = 0x07FE0000;
+    static const quint32 FlippedHorizontally = 0x80000000;
+    static const quint32 FlippedVertically   = 0x40000000;
+    static const quint32 FlippedAntiDiag     = 0x20000000;
+    static const quint32 RotatedHex120       = 0x10000000;
+    static const quint32 Checked             = 0x08000000;
+    static const quint32 FlagsMask           = 0xF8000000;
+
     QVector<Cell> mGrid;
+    QVector<quint32> mPacked;
+    QSharedPointer<TilesetTable> mTilesets;
 };
 
-inline const Cell &Chunk::cellAt(int x, int y) const
+inline Cell Chunk::unpack(quint32 packed, const TilesetTable &tilesets)
+{
+    Cell cell;
+    cell.setTile(tilesets.tilesetAt((packed & TilesetIndexMask) >> TilesetIndexShift),
+                 static_cast<int>(packed & TileIdMask) - 1);
+
+    if (packed & FlagsMask) {
+        cell.setFlippedHorizontally(packed & FlippedHorizontally);
+        cell.setFlippedVertically(packed & FlippedVertically);
+        cell.setFlippedAntiDiagonally(packed & FlippedAntiDiag);
+        cell.setRotatedHexagonal120(packed & RotatedHex120);
+        cell.setChecked(packed & Checked);
+    }
+
+    return cell;
+}
+
+inline Cell Chunk::cellAt(int x, int y) const
 {
+    if (isCompact())
+        return unpack(mPacked.at(x + y * CHUNK_SIZE), *mTilesets);
     return mGrid.at(x + y * CHUNK_SIZE);
 }
 
-inline const Cell &Chunk::cellAt(const QPoint &point) const
+inline Cell Chunk::cellAt(const QPoint &point) const
 {
     return cellAt(point.x(), point.y());
 }
@@ -205,71 +312,20 @@ inline const Cell &Chunk::cellAt(const QPoint &point) const
 class TILEDSHARED_EXPORT TileLayer : public Layer
 {
 public:
-    class iterator
-    {
-    public:
-        iterator(QHash<QPoint, Chunk>::iterator it, QHash<QPoint, Chunk>::iterator end)
-            : mChunkPointer(it)
-            , mChunkEndPointer(end)
-        {
-            if (it != end)
-                mCellPointer = it.value().begin();
-        }
-
-        iterator operator++(int)
-        {
-            iterator it = *this;
-            advance();
-            return it;
-        }
-
-        iterator &operator++()
-        {
-            advance();
-            return *this;
-        }
-
-        Cell &operator*() { return *mCellPointer; }
-
-        QVector<Cell>::iterator operator->() const { return mCellPointer; }
-
-        friend bool operator==(const iterator& lhs, const iterator& rhs)
-        {
-            if (lhs.mChunkPointer == lhs.mChunkEndPointer || rhs.mChunkPointer == rhs.mChunkEndPointer)
-                return lhs.mChunkPointer == rhs.mChunkPointer;
-            else
-                return lhs.mCellPointer == rhs.mCellPointer;
-        }
-
-        friend bool operator!=(const iterator& lhs, const iterator& rhs)
-        {
-            if (lhs.mChunkPointer == lhs.mChunkEndPointer || rhs.mChunkPointer == rhs.mChunkEndPointer)
-                return lhs.mChunkPointer != rhs.mChunkPointer;
-            else
-                return lhs.mCellPointer != rhs.mCellPointer;
-        }
-
-        Cell &value() const { return *mCellPointer; }
-
-        QPoint key() const;
-
-    private:
-        void advance();
-
-        QHash<QPoint, Chunk>::iterator mChunkPointer;
-        QHash<QPoint, Chunk>::iterator mChunkEndPointer;
-        QVector<Cell>::iterator mCellPointer;
-    };
-
+    /**
+     * Iterates over all cells of the layer's chunks. Since chunks may be
+     * stored in compact form, the iterator holds a copy of the current cell.
+     */
     class const_iterator
     {
     public:
         const_iterator(QHash<QPoint, Chunk>::const_iterator it, QHash<QPoint, Chunk>::const_iterator end)
             : mChunkPointer(it)
             , mChunkEndPointer(end)
+            , mCellIndex(0)
         {
             if (it != end)
-                mCellPointer = it.value().begin();
+                mCell = it.value().cellAt(0, 0);
         }
 
         const_iterator operator++(int)
@@ -285,27 +341,21 @@ public:
             return *this;
         }
 
-        const Cell &operator*() { return *mCellPointer; }
+        const Cell &operator*() const { return mCell; }
 
-        QVector<Cell>::const_iterator operator->() const { return mCellPointer; }
+        const Cell *operator->() const { return &mCell; }
 
         friend bool operator==(const const_iterator& lhs, const const_iterator& rhs)
         {
-            if (lhs.mChunkPointer == lhs.mChunkEndPointer || rhs.mChunkPointer == rhs.mChunkEndPointer)
-                return lhs.mChunkPointer == rhs.mChunkPointer;
-            else
-                return lhs.mCellPointer == rhs.mCellPointer;
+            return lhs.mChunkPointer == rhs.mChunkPointer && lhs.mCellIndex == rhs.mCellIndex;
         }
 
         friend bool operator!=(const const_iterator& lhs, const const_iterator& rhs)
         {
-            if (lhs.mChunkPointer == lhs.mChunkEndPointer || rhs.mChunkPointer == rhs.mChunkEndPointer)
-                return lhs.mChunkPointer != rhs.mChunkPointer;
-            else
-                return lhs.mCellPointer != rhs.mCellPointer;
+            return !(lhs == rhs);
         }
 
-        const Cell &value() const { return *mCellPointer; }
+        const Cell &value() const { return mCell; }
 
         QPoint key() const;
 
@@ -314,7 +364,8 @@ public:
 
         QHash<QPoint, Chunk>::const_iterator mChunkPointer;
         QHash<QPoint, Chunk>::const_iterator mChunkEndPointer;
-        QVector<Cell>::const_iterator mCellPointer;
+        int mCellIndex;
+        Cell mCell;
     };
 
     /**
@@ -351,10 +402,31 @@ public:
     bool contains(int x, int y) const;
     bool contains(const QPoint &point) const;
 
+    /**
+     * Returns the chunk containing the cell at the given coordinates,
+     * creating it when necessary.
+     */
     Chunk &chunk(int x, int y);
 
+    /**
+     * Returns the chunk containing the cell at the given coordinates, or
+     * nullptr when there is no such chunk.
+     */
     const Chunk *findChunk(int x, int y) const;
 
+    /**
+     * Calls \a function for each horizontal span of cells within \a rect
+     * that lies within a single chunk, in row-major order. The function is
+     * called with the chunk (or nullptr when it doesn't exist, in which case
+     * all cells of the span are empty), the coordinates of the first cell of
+     * the span and the length of the span.
+     *
+     * This allows going over an area while looking up each chunk only once
+     * per row.
+     */
+    template<typename Function>
+    void forEachSpan(const QRect &rect, Function function) const;
+
     /**
      * Calculates the region of cells in this tile layer for which the given
      * \a condition returns true.
@@ -367,11 +439,29 @@ public:
      */
     QRegion region() const;
 
-    const Cell &cellAt(int x, int y) const;
-    const Cell &cellAt(const QPoint &point) const;
+    Cell cellAt(int x, int y) const;
+    Cell cellAt(const QPoint &point) const;
 
     void setCell(int x, int y, const Cell &cell);
 
+    /**
+     * Returns whether this layer uses compact storage for its cells.
+     */
+    bool isCompact() const { return !mTilesetTable.isNull(); }
+
+    /**
+     * Sets whether this layer uses compact storage for its cells. In compact
+     * storage, each cell takes 4 bytes instead of 16, by referring to its
+     * tileset through a per-layer table.
+     *
+     * Cells that can't be stored in compact form (because of a very large
+     * tile id, or when more than TilesetTable::MaxTilesets tilesets are
+     * referenced) are still stored in full, per chunk.
+     *
+     * In Tiled, compact storage is used when enabled in the preferences.
+     */
+    void setCompact(bool compact);
+
     /**
      * Returns a copy of the area specified by the given \a region. The
      * caller is responsible for the returned tile layer.
@@ -445,6 +535,14 @@ public:
      */
     bool hasCell(std::function<bool (const Cell &)> condition) const;
 
+    /**
+     * Returns the animated tiles on this layer by the position of their cell.
+     * The index is built on first use and from then on kept up to date by
+     * setCell(). It is rebuilt when the animation frames change in any of the
+     * tilesets used by this layer.
+     */
+    const QHash<QPoint, Tile*> &animatedCells() const;
+
     /**
      * Returns whether this tile layer is referencing the given tileset.
      */
@@ -495,8 +593,10 @@ public:
 
     TileLayer *clone() const override;
 
-    iterator begin() { return iterator(mChunks.begin(), mChunks.end()); }
-    iterator end() { return iterator(mChunks.end(), mChunks.end()); }
+    /**
+     * Iterating over a tile layer is read-only, since the cells of compact
+     * chunks can't be referred to. Use setCell() to change cells.
+     */
     const_iterator begin() const { return const_iterator(mChunks.begin(), mChunks.end()); }
     const_iterator end() const { return const_iterator(mChunks.end(), mChunks.end()); }
 
@@ -504,54 +604,73 @@ protected:
     TileLayer *initializeClone(TileLayer *clone) const;
 
 private:
+    static QPoint chunkCoordinates(int x, int y);
+
+    void expandChunks();
+    void detachChunks();
+    void addToTilesetTable(Tileset *tileset);
+    bool animatedCellsOutdated() const;
+    void rebuildChunkGrid();
+    void growChunkGrid(const QPoint &chunkCoordinates, Chunk *chunk);
+    bool fitsChunkGrid(const QRect &chunkRect) const;
+
     int mWidth;
     int mHeight;
     Cell mEmptyCell;
     QHash<QPoint, Chunk> mChunks;
+    QSharedPointer<TilesetTable> mTilesetTable;
+
+    /*
+     * A dense directory of the chunks in mChunks, covering mChunkGridRect
+     * (in chunk coordinates). It avoids a hash lookup for each cell access
+     * and is grown geometrically as chunks are added. When the chunks are
+     * spread out too far for a dense directory to make sense, mSparseChunks
+     * is set and lookups fall back to mChunks.
+     *
+     * The pointers refer to the chunks in mChunks, which may be shared with
+     * a copy of this layer. Any change is therefore preceded by a call to
+     * detachChunks().
+     */
+    QVector<Chunk*> mChunkGrid;
+    QRect mChunkGridRect;
+    bool mSparseChunks;
+
     QRect mBounds;
     mutable QSet<SharedTileset> mUsedTilesets;
     mutable bool mUsedTilesetsDirty;
-};
-
-inline QPoint TileLayer::iterator::key() const
-{
-    QPoint chunkStart = mChunkPointer.key();
 
-    int index = mCellPointer - mChunkPointer.value().begin();
-    chunkStart += QPoint(index & CHUNK_MASK, index / CHUNK_SIZE);
-
-    return chunkStart;
-}
+    /**
+     * The frames version of a tileset at the time the animated cells were
+     * indexed. The tileset is referenced weakly, so that watching it doesn't
+     * keep it alive.
+     */
+    struct WatchedTileset
+    {
+        QWeakPointer<Tileset> tileset;
+        unsigned framesVersion;
+    };
 
-inline void TileLayer::iterator::advance()
-{
-    if (mChunkPointer != mChunkEndPointer) {
-        if (++mCellPointer == mChunkPointer.value().end()) {
-            mChunkPointer++;
-            if (mChunkPointer != mChunkEndPointer)
-                mCellPointer = mChunkPointer.value().begin();
-        }
-    }
-}
+    mutable QHash<QPoint, Tile*> mAnimatedCells;
+    mutable QHash<const Tileset*, WatchedTileset> mAnimatedCellsFramesVersions;
+    mutable bool mAnimatedCellsDirty;
+};
 
 inline QPoint TileLayer::const_iterator::key() const
 {
-    QPoint chunkStart = mChunkPointer.key();
-
-    int index = mCellPointer - mChunkPointer.value().begin();
-    chunkStart += QPoint(index & CHUNK_MASK, index / CHUNK_SIZE);
-
-    return chunkStart;
+    return QPoint(mChunkPointer.key().x() * CHUNK_SIZE + (mCellIndex & CHUNK_MASK),
+                  mChunkPointer.key().y() * CHUNK_SIZE + mCellIndex / CHUNK_SIZE);
 }
 
 inline void TileLayer::const_iterator::advance()
 {
     if (mChunkPointer != mChunkEndPointer) {
-        if (++mCellPointer == mChunkPointer.value().end()) {
+        if (++mCellIndex == CHUNK_SIZE * CHUNK_SIZE) {
+            mCellIndex = 0;
             mChunkPointer++;
-            if (mChunkPointer != mChunkEndPointer)
-                mCellPointer = mChunkPointer.value().begin();
         }
+        if (mChunkPointer != mChunkEndPointer)
+            mCell = mChunkPointer.value().cellAt(mCellIndex & CHUNK_MASK,
+                                                 mCellIndex / CHUNK_SIZE);
     }
 }
 
@@ -574,19 +693,41 @@ inline bool TileLayer::contains(const QPoint &point) const
     return contains(point.x(), point.y());
 }
 
-inline Chunk& TileLayer::chunk(int x, int y)
+inline QPoint TileLayer::chunkCoordinates(int x, int y)
 {
-    QPoint chunkCoordinates(x < 0 ? (x + 1) / CHUNK_SIZE - 1 : x / CHUNK_SIZE,
-                            y < 0 ? (y + 1) / CHUNK_SIZE - 1 : y / CHUNK_SIZE);
-    return mChunks[chunkCoordinates];
+    return QPoint(x < 0 ? (x + 1) / CHUNK_SIZE - 1 : x / CHUNK_SIZE,
+                  y < 0 ? (y + 1) / CHUNK_SIZE - 1 : y / CHUNK_SIZE);
 }
 
 inline const Chunk* TileLayer::findChunk(int x, int y) const
 {
-    QPoint chunkCoordinates(x < 0 ? (x + 1) / CHUNK_SIZE - 1 : x / CHUNK_SIZE,
-                            y < 0 ? (y + 1) / CHUNK_SIZE - 1 : y / CHUNK_SIZE);
-    auto it = mChunks.find(chunkCoordinates);
-    return it != mChunks.end() ? &it.value() : nullptr;
+    const QPoint coordinates = chunkCoordinates(x, y);
+
+    if (mSparseChunks) {
+        auto it = mChunks.find(coordinates);
+        return it != mChunks.end() ? &it.value() : nullptr;
+    }
+
+    const int gridX = coordinates.x() - mChunkGridRect.x();
+    const int gridY = coordinates.y() - mChunkGridRect.y();
+
+    if (gridX < 0 || gridY < 0 ||
+            gridX >= mChunkGridRect.width() || gridY >= mChunkGridRect.height())
+        return nullptr;
+
+    return mChunkGrid.at(gridX + gridY * mChunkGridRect.width());
+}
+
+template<typename Function>
+inline void TileLayer::forEachSpan(const QRect &rect, Function function) const
+{
+    for (int y = rect.top(); y <= rect.bottom(); ++y) {
+        for (int x = rect.left(); x <= rect.right(); ) {
+            const int spanEnd = qMin(x | CHUNK_MASK, rect.right());
+            function(findChunk(x, y), x, y, spanEnd - x + 1);
+            x = spanEnd + 1;
+        }
+    }
 }
 
 inline QRegion TileLayer::region() const
@@ -595,10 +736,10 @@ inline QRegion TileLayer::region() const
 }
 
 /**
- * Returns a read-only reference to the cell at the given coordinates. The
- * coordinates have to be within this layer.
+ * Returns the cell at the given coordinates. The coordinates have to be
+ * within this layer.
  */
-inline const Cell &TileLayer::cellAt(int x, int y) const
+inline Cell TileLayer::cellAt(int x, int y) const
 {
     if (const Chunk *chunk = findChunk(x, y))
         return chunk->cellAt(x & CHUNK_MASK, y & CHUNK_MASK);
@@ -606,11 +747,51 @@ inline const Cell &TileLayer::cellAt(int x, int y) const
         return mEmptyCell;
 }
 
-inline const Cell &TileLayer::cellAt(const QPoint &point) const
+inline Cell TileLayer::cellAt(const QPoint &point) const
 {
     return cellAt(point.x(), point.y());
 }
 
+/**
+ * Reads the cells of a tile layer, remembering the chunk of the last cell
+ * that was read. Reading neighbouring cells, like when going along a row,
+ * then mostly doesn't need another chunk lookup.
+ *
+ * The layer must not be changed while a CellReader is used on it.
+ */
+class CellReader
+{
+public:
+    explicit CellReader(const TileLayer *layer)
+        : mLayer(layer)
+        , mChunk(nullptr)
+        , mChunkX(1)    // never the start of a chunk, forcing a lookup
+        , mChunkY(1)
+    {}
+
+    Cell cellAt(int x, int y)
+    {
+        const int chunkX = x & ~CHUNK_MASK;
+        const int chunkY = y & ~CHUNK_MASK;
+
+        if (chunkX != mChunkX || chunkY != mChunkY) {
+            mChunk = mLayer->findChunk(x, y);
+            mChunkX = chunkX;
+            mChunkY = chunkY;
+        }
+
+        return mChunk ? mChunk->cellAt(x & CHUNK_MASK, y & CHUNK_MASK) : Cell();
+    }
+
+    Cell cellAt(const QPoint &point) { return cellAt(point.x(), point.y()); }
+
+private:
+    const TileLayer *mLayer;
+    const Chunk *mChunk;
+    int mChunkX;
+    int mChunkY;
+};
+
 typedef QSharedPointer<TileLayer> SharedTileLayer;
 
 } // namespace Tiled
@@ -0,0 +1,368 @@
+/*
+ * tilelayerdelta.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "tilelayerdelta.h"
+
+#include <QDataStream>
+#include <QSet>
+
+#include <algorithm>
+
+using namespace Tiled;
+
+static QPoint chunkCoordinates(int x, int y)
+{
+    return QPoint(x < 0 ? (x + 1) / CHUNK_SIZE - 1 : x / CHUNK_SIZE,
+                  y < 0 ? (y + 1) / CHUNK_SIZE - 1 : y / CHUNK_SIZE);
+}
+
+/**
+ * Writes the given \a cell, referring to its tileset by its index in
+ * \a tilesetIndexes, or -1 when the cell is empty.
+ */
+static void writeCell(QDataStream &stream, const Cell &cell,
+                      const QHash<Tileset*, qint32> &tilesetIndexes)
+{
+    const quint8 flags = (cell.flippedHorizontally() << 0) |
+                         (cell.flippedVertically() << 1) |
+                         (cell.flippedAntiDiagonally() << 2) |
+                         (cell.rotatedHexagonal120() << 3) |
+                         (cell.checked() << 4);
+
+    stream << tilesetIndexes.value(cell.tileset(), -1)
+           << qint32(cell.tileId())
+           << flags;
+}
+
+static Cell readCell(QDataStream &stream, const QVector<SharedTileset> &tilesets)
+{
+    qint32 tilesetIndex;
+    qint32 tileId;
+    quint8 flags;
+    stream >> tilesetIndex >> tileId >> flags;
+
+    Cell cell;
+    if (tilesetIndex >= 0)
+        cell.setTile(tilesets.at(tilesetIndex).data(), tileId);
+    cell.setFlippedHorizontally(flags & (1 << 0));
+    cell.setFlippedVertically(flags & (1 << 1));
+    cell.setFlippedAntiDiagonally(flags & (1 << 2));
+    cell.setRotatedHexagonal120(flags & (1 << 3));
+    cell.setChecked(flags & (1 << 4));
+    return cell;
+}
+
+/**
+ * Records the changes made by painting \a source at \a x, \a y on \a target,
+ * limited to \a region, which is in map coordinates. Cells that would not
+ * change are left out.
+ */
+TileLayerDelta TileLayerDelta::record(const TileLayer *target,
+                                      int x, int y,
+                                      const TileLayer *source,
+                                      const QRegion &region)
+{
+    TileLayerDelta delta;
+    QSet<Tileset*> tilesets;
+
+    const QRegion area = region & QRect(x, y, source->width(), source->height());
+
+    for (const QRect &rect : area.rects()) {
+        for (int cellY = rect.top(); cellY <= rect.bottom(); ++cellY) {
+            for (int cellX = rect.left(); cellX <= rect.right(); ) {
+                const int spanEnd = qMin(cellX | CHUNK_MASK, rect.right());
+                QVector<Run> *runs = nullptr;
+
+                for (; cellX <= spanEnd; ++cellX) {
+                    const Cell oldCell = target->cellAt(cellX - target->x(),
+                                                        cellY - target->y());
+                    const Cell newCell = source->cellAt(cellX - x, cellY - y);
+                    if (oldCell == newCell)
+                        continue;
+
+                    if (!runs)
+                        runs = &delta.mChunks[chunkCoordinates(cellX, cellY)];
+
+                    if (Tileset *tileset = oldCell.tileset())
+                        tilesets.insert(tileset);
+                    if (Tileset *tileset = newCell.tileset())
+                        tilesets.insert(tileset);
+
+                    appendCell(*runs, cellX & CHUNK_MASK, cellY & CHUNK_MASK,
+                               oldCell, newCell);
+                    delta.mBounds |= QRect(cellX, cellY, 1, 1);
+                }
+            }
+        }
+    }
+
+    // The rectangles of a band are visited one after the other, so the runs
+    // need to be put in row order
+    for (QVector<Run> &runs : delta.mChunks) {
+        std::sort(runs.begin(), runs.end(), [] (const Run &a, const Run &b) {
+            return a.y < b.y || (a.y == b.y && a.x < b.x);
+        });
+        delta.mRunCount += runs.size();
+    }
+
+    for (Tileset *tileset : tilesets)
+        delta.addTileset(tileset);
+
+    return delta;
+}
+
+/**
+ * Returns the changed cells as a region in map coordinates.
+ */
+QRegion TileLayerDelta::region() const
+{
+    Q_ASSERT(!isCompressed());
+
+    struct Span
+    {
+        int y;
+        int left;
+        int right;
+    };
+
+    QVector<Span> spans;
+    for (auto it = mChunks.cbegin(), end = mChunks.cend(); it != end; ++it) {
+        const QPoint origin = it.key() * CHUNK_SIZE;
+        for (const Run &run : it.value()) {
+            const int left = origin.x() + run.x;
+            spans.append(Span { origin.y() + run.y, left, left + run.length - 1 });
+        }
+    }
+
+    std::sort(spans.begin(), spans.end(), [] (const Span &a, const Span &b) {
+        return a.y < b.y || (a.y == b.y && a.left < b.left);
+    });
+
+    // Join touching spans, since QRegion::setRects expects them to be merged
+    QVector<QRect> rects;
+    for (const Span &span : spans) {
+        if (!rects.isEmpty()) {
+            QRect &last = rects.last();
+            if (last.top() == span.y && last.right() + 1 == span.left) {
+                last.setRight(span.right);
+                continue;
+            }
+        }
+        rects.append(QRect(QPoint(span.left, span.y), QPoint(span.right, span.y)));
+    }
+
+    QRegion region;
+    region.setRects(rects.constData(), rects.size());
+    return region;
+}
+
+/**
+ * Creates a layer covering the bounds of this delta, containing the given
+ * \a side of the changed cells. Only the chunks with changes are allocated.
+ */
+TileLayer *TileLayerDelta::createLayer(Side side) const
+{
+    Q_ASSERT(!isCompressed());
+
+    TileLayer *layer = new TileLayer(QString(),
+                                     mBounds.x(), mBounds.y(),
+                                     mBounds.width(), mBounds.height());
+
+    for (auto it = mChunks.cbegin(), end = mChunks.cend(); it != end; ++it) {
+        const QPoint origin = it.key() * CHUNK_SIZE - mBounds.topLeft();
+        for (const Run &run : it.value()) {
+            const Cell &cell = side == OldCells ? run.oldCell : run.newCell;
+            for (int i = 0; i < run.length; ++i)
+                layer->setCell(origin.x() + run.x + i, origin.y() + run.y, cell);
+        }
+    }
+
+    return layer;
+}
+
+/**
+ * Merges the changes of a \a later delta into this one. Where both deltas
+ * changed a cell, the old cell is kept from this delta and the new cell is
+ * taken from the later one.
+ *
+ * Chunks only changed by the later delta are copied as is, so the cost
+ * depends on the number of cells it changed rather than on the size of this
+ * delta.
+ */
+void TileLayerDelta::merge(const TileLayerDelta &later)
+{
+    Q_ASSERT(!isCompressed() && !later.isCompressed());
+
+    for (auto it = later.mChunks.cbegin(), end = later.mChunks.cend(); it != end; ++it) {
+        auto existing = mChunks.find(it.key());
+        if (existing == mChunks.end()) {
+            mChunks.insert(it.key(), it.value());
+            mRunCount += it.value().size();
+            continue;
+        }
+
+        // Both deltas changed this chunk, so combine them cell by cell
+        Cell oldCells[CHUNK_SIZE * CHUNK_SIZE];
+        Cell newCells[CHUNK_SIZE * CHUNK_SIZE];
+        bool changed[CHUNK_SIZE * CHUNK_SIZE] = {};
+
+        for (const Run &run : *existing) {
+            for (int i = run.y * CHUNK_SIZE + run.x, end = i + run.length; i < end; ++i) {
+                oldCells[i] = run.oldCell;
+                newCells[i] = run.newCell;
+                changed[i] = true;
+            }
+        }
+
+        for (const Run &run : it.value()) {
+            for (int i = run.y * CHUNK_SIZE + run.x, end = i + run.length; i < end; ++i) {
+                if (!changed[i])
+                    oldCells[i] = run.oldCell;
+                newCells[i] = run.newCell;
+                changed[i] = true;
+            }
+        }
+
+        QVector<Run> runs;
+        for (int i = 0; i < CHUNK_SIZE * CHUNK_SIZE; ++i) {
+            // Cells painted back to what they were are no longer a change
+            if (changed[i] && !(oldCells[i] == newCells[i]))
+                appendCell(runs, i % CHUNK_SIZE, i / CHUNK_SIZE, oldCells[i], newCells[i]);
+        }
+
+        mRunCount += runs.size() - existing->size();
+
+        if (runs.isEmpty())
+            mChunks.erase(existing);
+        else
+            *existing = runs;
+    }
+
+    for (const SharedTileset &tileset : later.mTilesets)
+        addTileset(tileset.data());
+
+    mBounds |= later.mBounds;
+}
+
+/**
+ * Returns the approximate number of bytes used by this delta. It is computed
+ * from counters, so it is cheap to call after each merge.
+ */
+qint64 TileLayerDelta::memoryUsage() const
+{
+    return sizeof(TileLayerDelta)
+            + mChunks.size() * qint64(sizeof(QPoint) + sizeof(QVector<Run>))
+            + mRunCount * qint64(sizeof(Run))
+            + mTilesets.size() * qint64(sizeof(SharedTileset))
+            + mCompressed.size();
+}
+
+/**
+ * Compresses the changes, freeing the memory used by the runs.
+ */
+void TileLayerDelta::compress()
+{
+    if (isCompressed() || mChunks.isEmpty())
+        return;
+
+    QHash<Tileset*, qint32> tilesetIndexes;
+    for (int i = 0; i < mTilesets.size(); ++i)
+        tilesetIndexes.insert(mTilesets.at(i).data(), i);
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+
+    for (auto it = mChunks.cbegin(), end = mChunks.cend(); it != end; ++it) {
+        const QVector<Run> &runs = it.value();
+        stream << it.key() << qint32(runs.size());
+
+        for (const Run &run : runs) {
+            stream << run.x << run.y << run.length;
+            writeCell(stream, run.oldCell, tilesetIndexes);
+            writeCell(stream, run.newCell, tilesetIndexes);
+        }
+    }
+
+    mCompressed = qCompress(data);
+    mChunks = QHash<QPoint, QVector<Run>>();
+    mRunCount = 0;
+}
+
+void TileLayerDelta::decompress()
+{
+    if (!isCompressed())
+        return;
+
+    const QByteArray data = qUncompress(mCompressed);
+    QDataStream stream(data);
+
+    while (!stream.atEnd()) {
+        QPoint chunkCoordinates;
+        qint32 count;
+        stream >> chunkCoordinates >> count;
+
+        QVector<Run> runs(count);
+        for (Run &run : runs) {
+            stream >> run.x >> run.y >> run.length;
+            run.oldCell = readCell(stream, mTilesets);
+            run.newCell = readCell(stream, mTilesets);
+        }
+        mChunks.insert(chunkCoordinates, runs);
+        mRunCount += count;
+    }
+
+    mCompressed = QByteArray();
+}
+
+/**
+ * Adds a changed cell at \a x, \a y within a chunk, extending the last run
+ * when the cell directly follows it and changed the same way.
+ */
+void TileLayerDelta::appendCell(QVector<Run> &runs, int x, int y,
+                                const Cell &oldCell, const Cell &newCell)
+{
+    if (!runs.isEmpty()) {
+        Run &last = runs.last();
+        if (last.y == y && last.x + last.length == x &&
+                last.oldCell == oldCell && last.newCell == newCell) {
+            ++last.length;
+            return;
+        }
+    }
+
+    runs.append(Run { quint8(x), quint8(y), 1, oldCell, newCell });
+}
+
+void TileLayerDelta::addTileset(Tileset *tileset)
+{
+    for (const SharedTileset &existing : mTilesets)
+        if (existing.data() == tileset)
+            return;
+
+    mTilesets.append(tileset->sharedPointer());
+}
@@ -0,0 +1,116 @@
+/*
+ * tilelayerdelta.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "tilelayer.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QPoint>
+#include <QRect>
+#include <QRegion>
+#include <QVector>
+
+namespace Tiled {
+
+/**
+ * The changes made by painting on a tile layer. For each changed cell, both
+ * the cell it had before and the cell painted on it are stored.
+ *
+ * The changes are grouped by chunk. Within a chunk they are stored as
+ * horizontal runs of cells that changed in the same way, so the memory used
+ * depends on the number of changed cells rather than on the rectangle
+ * around them.
+ *
+ * The tilesets of the stored cells are referenced, so that they stay alive
+ * as long as the delta does.
+ *
+ * A delta can be compressed while it is not being used. It needs to be
+ * decompressed before anything other than its bounds is accessed.
+ */
+class TILEDSHARED_EXPORT TileLayerDelta
+{
+public:
+    enum Side {
+        OldCells,
+        NewCells
+    };
+
+    TileLayerDelta() : mRunCount(0) {}
+
+    static TileLayerDelta record(const TileLayer *target,
+                                 int x, int y,
+                                 const TileLayer *source,
+                                 const QRegion &region);
+
+    bool isEmpty() const { return mBounds.isEmpty(); }
+
+    /**
+     * Returns a rectangle containing all changed cells, in map coordinates.
+     */
+    const QRect &bounds() const { return mBounds; }
+
+    QRegion region() const;
+    TileLayer *createLayer(Side side) const;
+
+    void merge(const TileLayerDelta &later);
+
+    qint64 memoryUsage() const;
+
+    bool isCompressed() const { return !mCompressed.isEmpty(); }
+    void compress();
+    void decompress();
+
+private:
+    /**
+     * A run of \a length cells starting at \a x, \a y within a chunk, which
+     * all changed from \a oldCell to \a newCell.
+     */
+    struct Run
+    {
+        quint8 x;
+        quint8 y;
+        quint8 length;
+        Cell oldCell;
+        Cell newCell;
+    };
+
+    static void appendCell(QVector<Run> &runs, int x, int y,
+                           const Cell &oldCell, const Cell &newCell);
+
+    void addTileset(Tileset *tileset);
+
+    QHash<QPoint, QVector<Run>> mChunks;
+    QVector<SharedTileset> mTilesets;
+    QRect mBounds;
+    int mRunCount;
+    QByteArray mCompressed;
+};
+
+} // namespace Tiled
@@ -29,12 +29,14 @@
 
 #include "tileset.h"
 
+#include "deferredimage.h"
 #include "terrain.h"
 #include "tile.h"
 #include "tilesetformat.h"
 #include "wangset.h"
 
 #include <QBitmap>
+#include <QSet>
 
 using namespace Tiled;
 
@@ -54,6 +56,7 @@ Tileset::Tileset(QString name, int tileWidth, int tileHeight,
     mNextTileId(0),
     mMaximumTerrainDistance(0),
     mTerrainDistancesDirty(false),
+    mFramesVersion(0),
     mStatus(LoadingReady)
 {
     Q_ASSERT(tileSpacing >= 0);
@@ -179,54 +182,79 @@ bool Tileset::loadFromImage(const QImage &image, const QUrl &source)
         return false;
     }
 
+    // All tiles share a single pixmap, which allows renderers to draw many
+    // tiles of this tileset with a single call.
+    QPixmap pixmap = QPixmap::fromImage(image);
+    const QColor &transparent = mImageReference.transparentColor;
+
+    if (transparent.isValid()) {
+        const QImage mask = image.createMaskFromColor(transparent.rgb());
+        pixmap.setMask(QBitmap::fromImage(mask));
+    }
+
+    setTileImages(image.size(), [&] (Tile *tile, const QRect &imageRect) {
+        tile->setImage(pixmap, imageRect);
+    });
+
+    return true;
+}
+
+/**
+ * Cuts an image of the given \a imageSize into tiles, calling \a setImage
+ * for each tile with the part of the image it should use. Tiles are created
+ * as needed.
+ */
+void Tileset::setTileImages(const QSize &imageSize,
+                            const std::function<void (Tile *, const QRect &)> &setImage)
+{
     const QSize tileSize = this->tileSize();
     const int margin = this->margin();
     const int spacing = this->tileSpacing();
 
     Q_ASSERT(tileSize.width() > 0 && tileSize.height() > 0);
 
-    const int stopWidth = image.width() - tileSize.width();
-    const int stopHeight = image.height() - tileSize.height();
+    const int stopWidth = imageSize.width() - tileSize.width();
+    const int stopHeight = imageSize.height() - tileSize.height();
 
     int tileNum = 0;
 
     for (int y = margin; y <= stopHeight; y += tileSize.height() + spacing) {
         for (int x = margin; x <= stopWidth; x += tileSize.width() + spacing) {
-            const QImage tileImage = image.copy(x, y, tileSize.width(), tileSize.height());
-            QPixmap tilePixmap = QPixmap::fromImage(tileImage);
-            const QColor &transparent = mImageReference.transparentColor;
-
-            if (transparent.isValid()) {
-                const QImage mask = tileImage.createMaskFromColor(transparent.rgb());
-                tilePixmap.setMask(QBitmap::fromImage(mask));
-            }
+            const QRect imageRect(QPoint(x, y), tileSize);
 
             auto it = mTiles.find(tileNum);
-            if (it != mTiles.end())
-                it.value()->setImage(tilePixmap);
-            else
-                mTiles.insert(tileNum, new Tile(tilePixmap, tileNum, this));
+            if (it != mTiles.end()) {
+                setImage(it.value(), imageRect);
+            } else {
+                Tile *tile = new Tile(tileNum, this);
+                setImage(tile, imageRect);
+                mTiles.insert(tileNum, tile);
+            }
 
             ++tileNum;
         }
     }
 
     // Blank out any remaining tiles to avoid confusion (todo: could be more clear)
+    // The pixmap is only created when needed, since this may be called
+    // while a map is read in the background.
+    QSharedPointer<DeferredImage> blankImage;
     for (Tile *tile : mTiles) {
         if (tile->id() >= tileNum) {
-            QPixmap tilePixmap = QPixmap(tileSize);
-            tilePixmap.fill();
-            tile->setImage(tilePixmap);
+            if (!blankImage) {
+                QImage image(tileSize, QImage::Format_ARGB32_Premultiplied);
+                image.fill(Qt::white);
+                blankImage = QSharedPointer<DeferredImage>::create(ImageReference(), image);
+            }
+            tile->setDeferredImage(blankImage, QRect(QPoint(), tileSize));
         }
     }
 
     mNextTileId = std::max(mNextTileId, tileNum);
 
-    mImageReference.size = image.size();
+    mImageReference.size = imageSize;
     mColumnCount = columnCountForWidth(mImageReference.size.width());
     mImageReference.status = LoadingReady;
-
-    return true;
 }
 
 /**
@@ -243,12 +271,100 @@ bool Tileset::loadFromImage(const QImage &image, const QString &source)
 /**
  * Tries to load the image this tileset is referring to.
  *
+ * Unless the imageLoadingMode() is LoadImagesImmediately, only the size of
+ * the image is read and the tiles are given a DeferredImage, which is
+ * decoded once the image of any of the tiles is first requested.
+ *
+ * When called off the GUI thread, the tiles always get a DeferredImage, since
+ * pixmaps can't be created there. With LoadImagesImmediately the image is
+ * still decoded right away.
+ *
  * @return <code>true</code> if loading was successful, otherwise
  *         returns <code>false</code>
  */
 bool Tileset::loadImage()
 {
-    return loadFromImage(mImageReference.create(), mImageReference.source);
+    const ImageLoadingMode mode = imageLoadingMode();
+    if (mode == LoadImagesImmediately && DeferredImage::canCreatePixmaps())
+        return loadFromImage(mImageReference.create(), mImageReference.source);
+
+    const QSize imageSize = mImageReference.readSize();
+    if (!imageSize.isValid()) {
+        mImageReference.status = LoadingError;
+        return false;
+    }
+
+    // Embedded images are kept even when skipping images, since they would
+    // otherwise be lost when the tileset is written out again
+    QSharedPointer<DeferredImage> image;
+    if (mode != SkipImages || !mImageReference.data.isEmpty())
+        image = QSharedPointer<DeferredImage>::create(mImageReference);
+
+    if (mode == LoadImagesImmediately && !image->decode()) {
+        mImageReference.status = LoadingError;
+        return false;
+    }
+
+    setTileImages(imageSize, [&] (Tile *tile, const QRect &imageRect) {
+        tile->setDeferredImage(image, imageRect);
+    });
+
+    return true;
+}
+
+/**
+ * Decodes any deferred images of this tileset on the calling thread. No
+ * pixmaps are created, so this may be used from a worker thread that is the
+ * only one using this tileset.
+ *
+ * Returns whether all images could be decoded. The tiles of images that
+ * could not be decoded only get the LoadingError status once their images
+ * are loaded, see loadDeferredImages().
+ */
+bool Tileset::decodeImages()
+{
+    QSet<DeferredImage*> decoded;
+    bool success = true;
+
+    for (Tile *tile : mTiles) {
+        const QSharedPointer<DeferredImage> &image = tile->mDeferredImage;
+        if (image && !decoded.contains(image.data())) {
+            decoded.insert(image.data());
+            if (!image->decode())
+                success = false;
+        }
+    }
+
+    return success;
+}
+
+/**
+ * Starts decoding any deferred images of this tileset on the global thread
+ * pool, so that they are likely ready by the time they are first needed.
+ */
+void Tileset::decodeImagesInBackground()
+{
+    QSet<DeferredImage*> started;
+
+    for (Tile *tile : mTiles) {
+        const QSharedPointer<DeferredImage> &image = tile->mDeferredImage;
+        if (image && !started.contains(image.data())) {
+            started.insert(image.data());
+            DeferredImage::decodeInBackground(image);
+        }
+    }
+}
+
+/**
+ * Makes sure the images of all tiles are loaded, waiting for any deferred
+ * images to be decoded. Needs to be called on the GUI thread before the tile
+ * images are used from other threads.
+ */
+void Tileset::loadDeferredImages()
+{
+    for (Tile *tile : mTiles)
+        if (tile->mDeferredImage)
+            tile->loadDeferredImage();
 }
 
 /**
@@ -627,12 +743,74 @@ void Tileset::setTileImage(Tile *tile,
     Q_ASSERT(isCollection());
     Q_ASSERT(mTiles.value(tile->id()) == tile);
 
-    const QSize previousImageSize = tile->image().size();
-    const QSize newImageSize = image.size();
+    const QSize previousImageSize = tile->size();
 
     tile->setImage(image);
     tile->setImageSource(source);
 
+    tileImageSizeChanged(previousImageSize, image.size());
+}
+
+/**
+ * Sets the image referenced by \a reference as the image of \a tile. Unless
+ * the imageLoadingMode() is LoadImagesImmediately, only the size of the image
+ * is read and decoding it is deferred until it is first needed. Off the GUI
+ * thread, creating the pixmap is always deferred.
+ *
+ * Like the other overload, this is only expected to be used for image
+ * collection tilesets.
+ *
+ * @return <code>true</code> if the image could be read, otherwise
+ *         returns <code>false</code>
+ */
+bool Tileset::setTileImage(Tile *tile, const ImageReference &reference)
+{
+    const ImageLoadingMode mode = imageLoadingMode();
+    if (mode == LoadImagesImmediately && DeferredImage::canCreatePixmaps()) {
+        const QImage image = reference.create();
+        setTileImage(tile, QPixmap::fromImage(image), reference.source);
+        return !image.isNull();
+    }
+
+    Q_ASSERT(isCollection());
+    Q_ASSERT(mTiles.value(tile->id()) == tile);
+
+    const QSize imageSize = reference.readSize();
+    if (!imageSize.isValid()) {
+        setTileImage(tile, QPixmap(), reference.source);
+        return false;
+    }
+
+    QSharedPointer<DeferredImage> image;
+    if (mode != SkipImages || !reference.data.isEmpty()) {
+        // The transparent color is not applied to the images of collection
+        // tiles, same as when they are loaded immediately
+        ImageReference imageReference = reference;
+        imageReference.transparentColor = QColor();
+        image = QSharedPointer<DeferredImage>::create(imageReference);
+    }
+
+    if (mode == LoadImagesImmediately && !image->decode()) {
+        setTileImage(tile, QPixmap(), reference.source);
+        return false;
+    }
+
+    const QSize previousImageSize = tile->size();
+
+    tile->setDeferredImage(image, QRect(QPoint(), imageSize));
+    tile->setImageSource(reference.source);
+
+    tileImageSizeChanged(previousImageSize, imageSize);
+    return true;
+}
+
+/**
+ * Makes sure the tile width and tile height properties of this tileset
+ * reflect the maximum tile size after a tile image changed size.
+ */
+void Tileset::tileImageSizeChanged(const QSize &previousImageSize,
+                                   const QSize &newImageSize)
+{
     if (previousImageSize != newImageSize) {
         // Update our max. tile size
         if (previousImageSize.height() == mTileHeight ||
@@ -692,6 +870,10 @@ void Tileset::swap(Tileset &other)
         terrain->mTileset = &other;
     for (auto wangSet : other.mWangSets)
         wangSet->setTileset(&other);
+
+    // The tiles were exchanged, so any index of animated tiles is outdated
+    markFramesChanged();
+    other.markFramesChanged();
 }
 
 SharedTileset Tileset::clone() const
@@ -41,6 +41,8 @@
 #include <QString>
 #include <QVector>
 
+#include <functional>
+
 class QImage;
 
 namespace Tiled {
@@ -166,6 +168,9 @@ public:
     bool loadFromImage(const QImage &image, const QString &source);
     bool loadFromImage(const QString &fileName);
     bool loadImage();
+    bool decodeImages();
+    void decodeImagesInBackground();
+    void loadDeferredImages();
 
     SharedTileset findSimilarTileset(const QVector<SharedTileset> &tilesets) const;
 
@@ -207,9 +212,13 @@ public:
     void setTileImage(Tile *tile,
                       const QPixmap &image,
                       const QUrl &source = QUrl());
+    bool setTileImage(Tile *tile, const ImageReference &reference);
 
     void markTerrainDistancesDirty();
 
+    unsigned framesVersion() const;
+    void markFramesChanged();
+
     SharedTileset sharedPointer() const;
 
     void setStatus(LoadingStatus status);
@@ -239,6 +248,10 @@ public:
     static Orientation orientationFromString(const QString &);
 
 private:
+    void setTileImages(const QSize &imageSize,
+                       const std::function<void (Tile *tile, const QRect &imageRect)> &setImage);
+    void tileImageSizeChanged(const QSize &previousImageSize,
+                              const QSize &newImageSize);
     void updateTileSize();
     void recalculateTerrainDistances();
 
@@ -261,6 +274,7 @@ private:
     QList<WangSet*> mWangSets;
     int mMaximumTerrainDistance;
     bool mTerrainDistancesDirty;
+    unsigned mFramesVersion;
     LoadingStatus mStatus;
     QColor mBackgroundColor;
     QPointer<TilesetFormat> mFormat;
@@ -615,6 +629,24 @@ inline void Tileset::markTerrainDistancesDirty()
     mTerrainDistancesDirty = true;
 }
 
+/**
+ * Returns a number that changes whenever the animation frames of any tile in
+ * this tileset are set. Allows indexes of animated tiles to know when they
+ * are outdated.
+ */
+inline unsigned Tileset::framesVersion() const
+{
+    return mFramesVersion;
+}
+
+/**
+ * Used by the Tile class when its animation frames change.
+ */
+inline void Tileset::markFramesChanged()
+{
+    ++mFramesVersion;
+}
+
 inline SharedTileset Tileset::sharedPointer() const
 {
     return SharedTileset(mWeakPointer);
@@ -32,18 +32,28 @@
 
 namespace Tiled {
 
+SharedTileset TilesetFormat::readWithError(const QString &fileName, QString *error)
+{
+    // The mutex is recursive in case the format reads other tilesets
+    QMutexLocker locker(&mReadMutex);
+
+    SharedTileset tileset = read(fileName);
+
+    if (error) {
+        if (!tileset)
+            *error = errorString();
+        else
+            *error = QString();
+    }
+
+    return tileset;
+}
+
 SharedTileset readTileset(const QString &fileName, QString *error)
 {
     // Try the first registered tileset format that claims to support the file
     if (TilesetFormat *format = findSupportingFormat(fileName)) {
-        SharedTileset tileset = format->read(fileName);
-
-        if (error) {
-            if (!tileset)
-                *error = format->errorString();
-            else
-                *error = QString();
-        }
+        SharedTileset tileset = format->readWithError(fileName, error);
 
         if (tileset)
             tileset->setFormat(format);
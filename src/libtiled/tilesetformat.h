@@ -31,6 +31,8 @@
 #include "mapformat.h"
 #include "tileset.h"
 
+#include <QMutex>
+
 namespace Tiled {
 
 /**
@@ -45,6 +47,7 @@ class TILEDSHARED_EXPORT TilesetFormat : public FileFormat
 public:
     explicit TilesetFormat(QObject *parent = nullptr)
         : FileFormat(parent)
+        , mReadMutex(QMutex::Recursive)
     {}
 
     /**
@@ -53,6 +56,16 @@ public:
      */
     virtual SharedTileset read(const QString &fileName) = 0;
 
+    /**
+     * Reads the tileset like read(), but assigns any error to \a error
+     * instead of storing it in the format. This makes it safe to call from
+     * several threads at once.
+     *
+     * The default implementation serializes the calls to read(). Formats
+     * that can read several tilesets at the same time should override it.
+     */
+    virtual SharedTileset readWithError(const QString &fileName, QString *error);
+
     /**
      * Writes the given \a tileset based on the suggested \a fileName.
      *
@@ -64,6 +77,9 @@ public:
      *         occurred. The error can be retrieved by errorString().
      */
     virtual bool write(const Tileset &tileset, const QString &fileName) = 0;
+
+private:
+    QMutex mReadMutex;
 };
 
 /**
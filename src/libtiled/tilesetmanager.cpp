@@ -34,12 +34,30 @@
 #include "tile.h"
 #include "tilesetformat.h"
 
+#include <QDir>
+#include <QFileInfo>
 #include <QImage>
+#include <QThread>
 
 namespace Tiled {
 
 TilesetManager *TilesetManager::mInstance;
 
+/**
+ * Returns the path by which tilesets are indexed. Symbolic links are
+ * resolved when the file exists, so that different ways of referring to the
+ * same file find the same tileset.
+ */
+static QString canonicalPath(const QString &fileName)
+{
+    const QFileInfo fileInfo(fileName);
+    const QString canonicalFilePath = fileInfo.canonicalFilePath();
+    if (!canonicalFilePath.isEmpty())
+        return canonicalFilePath;
+
+    return QDir::cleanPath(fileInfo.absoluteFilePath());
+}
+
 /**
  * Constructor. Only used by the tileset manager itself.
  */
@@ -95,9 +113,17 @@ void TilesetManager::deleteInstance()
  *
  * When an error occurs during loading it is assigned to the optional \a error
  * parameter.
+ *
+ * When called from another thread than the one this manager lives in, as
+ * happens when a map is read in the background, the loaded tilesets are not
+ * looked at and the tileset is always read. It is up to the caller to replace
+ * it with an already loaded instance afterwards.
  */
 SharedTileset TilesetManager::loadTileset(const QString &fileName, QString *error)
 {
+    if (QThread::currentThread() != thread())
+        return readTileset(fileName, error);
+
     SharedTileset tileset = findTileset(fileName);
     if (!tileset)
         tileset = readTileset(fileName, error);
@@ -106,20 +132,81 @@ SharedTileset TilesetManager::loadTileset(const QString &fileName, QString *erro
 }
 
 /**
- * Searches for a tileset matching the given file name.
+ * Searches for a referenced tileset matching the given file name.
  * @return a tileset matching the given file name, or 0 if none exists
  */
 SharedTileset TilesetManager::findTileset(const QString &fileName) const
 {
-    QMapIterator<SharedTileset, int> it(mTilesets);
+    if (fileName.isEmpty())
+        return SharedTileset();
 
-    while (it.hasNext()) {
-        const SharedTileset &tileset = it.next().key();
-        if (tileset->fileName() == fileName)
-            return tileset;
+    auto findIndexed = [this] (const QString &path) -> SharedTileset {
+        auto it = mTilesetsByPath.constFind(path);
+        for (; it != mTilesetsByPath.constEnd() && it.key() == path; ++it) {
+            Tileset *tileset = it.value();
+
+            // Skip tilesets that were renamed without updating the index
+            if (tileset->fileName() == mIndexedPaths.value(tileset).fileName)
+                return tileset->sharedPointer();
+        }
+        return SharedTileset();
+    };
+
+    SharedTileset tileset = findIndexed(fileName);
+    if (!tileset)
+        tileset = findIndexed(canonicalPath(fileName));
+
+    return tileset;
+}
+
+/**
+ * Loads the tilesets with the given \a fileNames, for example all the
+ * external tilesets used by a map, or shared by a batch of maps.
+ *
+ * Tilesets that are already loaded are reused, and each file is only read
+ * once even when it is referred to by several file names. The returned list
+ * has an entry for each file name, which is null when the tileset failed to
+ * load. In that case the error is stored at the same index in the optional
+ * \a errors list.
+ *
+ * The tilesets are not referenced. Adding references to them makes sure
+ * they are found by findTileset() while loading maps that use them.
+ */
+QVector<SharedTileset> TilesetManager::loadTilesets(const QStringList &fileNames,
+                                                    QStringList *errors)
+{
+    QVector<SharedTileset> tilesets;
+    tilesets.reserve(fileNames.size());
+
+    if (errors)
+        errors->clear();
+
+    QHash<QString, int> indexOfPath;
+
+    for (const QString &fileName : fileNames) {
+        SharedTileset tileset;
+        QString error;
+
+        if (!fileName.isEmpty()) {
+            const QString path = canonicalPath(fileName);
+            const int index = indexOfPath.value(path, -1);
+
+            if (index != -1) {
+                tileset = tilesets.at(index);
+                if (errors)
+                    error = errors->at(index);
+            } else {
+                tileset = loadTileset(fileName, &error);
+                indexOfPath.insert(path, tilesets.size());
+            }
+        }
+
+        tilesets.append(tileset);
+        if (errors)
+            errors->append(error);
     }
 
-    return SharedTileset();
+    return tilesets;
 }
 
 /**
@@ -132,6 +219,7 @@ void TilesetManager::addReference(const SharedTileset &tileset)
         mTilesets[tileset]++;
     } else {
         mTilesets.insert(tileset, 1);
+        addToIndex(tileset.data());
         if (tileset->imageSource().isLocalFile())
             mWatcher->addPath(tileset->imageSource().toLocalFile());
     }
@@ -148,6 +236,7 @@ void TilesetManager::removeReference(const SharedTileset &tileset)
 
     if (mTilesets.value(tileset) == 0) {
         mTilesets.remove(tileset);
+        removeFromIndex(tileset.data());
         if (tileset->imageSource().isLocalFile())
             mWatcher->removePath(tileset->imageSource().toLocalFile());
     }
@@ -235,6 +324,47 @@ void TilesetManager::tilesetImageSourceChanged(const Tileset &tileset,
         mWatcher->addPath(tileset.imageSource().toLocalFile());
 }
 
+/**
+ * Updates the index used by findTileset() after the file name of the given
+ * \a tileset was changed.
+ */
+void TilesetManager::tilesetFileNameChanged(const Tileset &tileset)
+{
+    if (!mTilesets.contains(tileset.sharedPointer()))
+        return;
+
+    Tileset *t = const_cast<Tileset*>(&tileset);
+    removeFromIndex(t);
+    addToIndex(t);
+}
+
+void TilesetManager::addToIndex(Tileset *tileset)
+{
+    if (tileset->fileName().isEmpty())
+        return;
+
+    IndexedPaths paths;
+    paths.fileName = tileset->fileName();
+    paths.canonicalPath = canonicalPath(paths.fileName);
+
+    mTilesetsByPath.insert(paths.canonicalPath, tileset);
+    if (paths.fileName != paths.canonicalPath)
+        mTilesetsByPath.insert(paths.fileName, tileset);
+
+    mIndexedPaths.insert(tileset, paths);
+}
+
+void TilesetManager::removeFromIndex(Tileset *tileset)
+{
+    auto it = mIndexedPaths.find(tileset);
+    if (it == mIndexedPaths.end())
+        return;
+
+    mTilesetsByPath.remove(it.value().canonicalPath, tileset);
+    mTilesetsByPath.remove(it.value().fileName, tileset);
+    mIndexedPaths.erase(it);
+}
+
 void TilesetManager::fileChanged(const QString &path)
 {
     if (!mReloadTilesetsOnChange)
@@ -278,13 +408,16 @@ void TilesetManager::resetTileAnimations()
 
     while (it.hasNext()) {
         const SharedTileset &tileset = it.next().key();
-        bool imageChanged = false;
+        QVector<Tile*> changedTiles;
 
         for (Tile *tile : tileset->tiles())
-            imageChanged |= tile->resetAnimation();
+            if (tile->resetAnimation())
+                changedTiles.append(tile);
 
-        if (imageChanged)
+        if (!changedTiles.isEmpty()) {
             emit repaintTileset(tileset.data());
+            emit repaintTiles(tileset.data(), changedTiles);
+        }
     }
 }
 
@@ -297,13 +430,16 @@ void TilesetManager::advanceTileAnimations(int ms)
 
     while (it.hasNext()) {
         const SharedTileset &tileset = it.next().key();
-        bool imageChanged = false;
+        QVector<Tile*> changedTiles;
 
         for (Tile *tile : tileset->tiles())
-            imageChanged |= tile->advanceAnimation(ms);
+            if (tile->advanceAnimation(ms))
+                changedTiles.append(tile);
 
-        if (imageChanged)
+        if (!changedTiles.isEmpty()) {
             emit repaintTileset(tileset.data());
+            emit repaintTiles(tileset.data(), changedTiles);
+        }
     }
 }
 
@@ -32,11 +32,14 @@
 #include "tileset.h"
 
 #include <QObject>
+#include <QHash>
 #include <QList>
 #include <QMap>
 #include <QString>
+#include <QStringList>
 #include <QSet>
 #include <QTimer>
+#include <QVector>
 
 namespace Tiled {
 
@@ -59,6 +62,9 @@ public:
     SharedTileset loadTileset(const QString &fileName, QString *error = nullptr);
     SharedTileset findTileset(const QString &fileName) const;
 
+    QVector<SharedTileset> loadTilesets(const QStringList &fileNames,
+                                        QStringList *errors = nullptr);
+
     void addReference(const SharedTileset &tileset);
     void removeReference(const SharedTileset &tileset);
 
@@ -76,6 +82,7 @@ public:
 
     void tilesetImageSourceChanged(const Tileset &tileset,
                                    const QUrl &oldImageSource);
+    void tilesetFileNameChanged(const Tileset &tileset);
 
 signals:
     /**
@@ -89,6 +96,12 @@ signals:
      */
     void repaintTileset(Tileset *tileset);
 
+    /**
+     * Emitted along with repaintTileset(), with the \a tiles of the given
+     * \a tileset whose images have changed.
+     */
+    void repaintTiles(Tileset *tileset, const QVector<Tile*> &tiles);
+
 private slots:
     void fileChanged(const QString &path);
     void fileChangedTimeout();
@@ -101,12 +114,32 @@ private:
     TilesetManager();
     ~TilesetManager();
 
+    void addToIndex(Tileset *tileset);
+    void removeFromIndex(Tileset *tileset);
+
     static TilesetManager *mInstance;
 
     /**
      * Stores the tilesets and maps them to the number of references.
      */
     QMap<SharedTileset, int> mTilesets;
+
+    struct IndexedPaths
+    {
+        QString fileName;
+        QString canonicalPath;
+    };
+
+    /**
+     * Maps the canonical paths of the external tilesets, as well as their
+     * file names, to the tilesets. This way findTileset() doesn't need to
+     * resolve any path when a tileset is referred to by the same file name.
+     * The paths each tileset was indexed by are kept, since its file name may
+     * change while it is referenced.
+     */
+    QMultiHash<QString, Tileset*> mTilesetsByPath;
+    QHash<Tileset*, IndexedPaths> mIndexedPaths;
+
     FileSystemWatcher *mWatcher;
     TileAnimationDriver *mAnimationDriver;
     QSet<QString> mChangedFiles;
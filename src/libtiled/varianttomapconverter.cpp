@@ -86,6 +86,10 @@ Map *VariantToMapConverter::toMap(const QVariant &variant,
     if (nextObjectId)
         map->setNextObjectId(nextObjectId);
 
+    const QVariant compressionLevel = variantMap.value(QLatin1String("compressionlevel"));
+    if (compressionLevel.isValid())
+        map->setCompressionLevel(compressionLevel.toInt());
+
     mMap = map.data();
     map->setProperties(extractProperties(variantMap));
 
@@ -295,8 +299,9 @@ SharedTileset VariantToMapConverter::toTileset(const QVariant &variant)
 
         imageVariant = tileVar[QLatin1String("image")];
         if (!imageVariant.isNull()) {
-            const QUrl imagePath = toUrl(imageVariant.toString(), mMapDir);
-            tileset->setTileImage(tile, QPixmap(imagePath.toLocalFile()), imagePath);
+            ImageReference imageReference;
+            imageReference.source = toUrl(imageVariant.toString(), mMapDir);
+            tileset->setTileImage(tile, imageReference);
         }
 
         QVariantMap objectGroupVariant = tileVar[QLatin1String("objectgroup")].toMap();
@@ -443,10 +448,19 @@ TileLayer *VariantToMapConverter::toTileLayer(const QVariantMap &variantMap)
             layerDataFormat = Map::Base64Gzip;
         } else if (compression == QLatin1String("zlib")) {
             layerDataFormat = Map::Base64Zlib;
+        } else if (compression == QLatin1String("zstd")) {
+            layerDataFormat = Map::Base64Zstd;
+        } else if (compression == QLatin1String("lz4")) {
+            layerDataFormat = Map::Base64Lz4;
         } else {
             mError = tr("Compression method '%1' not supported").arg(compression);
             return nullptr;
         }
+
+        if (!layerDataFormatSupported(layerDataFormat)) {
+            mError = tr("Compression method '%1' not supported").arg(compression);
+            return nullptr;
+        }
     } else {
         mError = tr("Unknown encoding: %1").arg(encoding);
         return nullptr;
@@ -490,7 +504,9 @@ TileLayer *VariantToMapConverter::toTileLayer(const QVariantMap &variantMap)
 
     case Map::Base64:
     case Map::Base64Zlib:
-    case Map::Base64Gzip: {
+    case Map::Base64Gzip:
+    case Map::Base64Zstd:
+    case Map::Base64Lz4: {
         const QByteArray data = dataVariant.toByteArray();
         GidMapper::DecodeError error = mGidMapper.decodeLayerData(*tileLayer,
                                                                   data,
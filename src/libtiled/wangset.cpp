@@ -31,6 +31,9 @@
 #include <QStack>
 #include <QtMath>
 
+#include <algorithm>
+#include <iterator>
+
 using namespace Tiled;
 
 unsigned cellToTileInfo(const Cell &cell)
@@ -552,6 +555,97 @@ void WangSet::addWangTile(const WangTile &wangTile)
 
     mWangIdToWangTile.insert(wangTile.wangId(), wangTile);
     mTileInfoToWangId.insert(wangTileToTileInfo(wangTile), wangTile.wangId());
+
+    addToSpotIndex(wangTile);
+}
+
+/**
+ * Adds \a wangTile to the index used to find the tiles matching a wangId
+ * with wildcards.
+ */
+void WangSet::addToSpotIndex(const WangTile &wangTile)
+{
+    const int index = mIndexedWangTiles.size();
+
+    if (index % 64 == 0)
+        for (QVector<quint64> &bits : mSpotColorBits)
+            bits.append(0);
+
+    mIndexedWangTiles.append(wangTile);
+    mTileInfoToIndex.insert(wangTileToTileInfo(wangTile), index);
+    setSpotIndexBits(wangTile.wangId(), index, true);
+}
+
+/**
+ * Removes \a wangTile from the index. The last indexed tile takes its place,
+ * so that the tiles stay packed.
+ */
+void WangSet::removeFromSpotIndex(const WangTile &wangTile)
+{
+    const auto it = mTileInfoToIndex.find(wangTileToTileInfo(wangTile));
+    if (it == mTileInfoToIndex.end())
+        return;
+
+    const int index = it.value();
+    const int last = mIndexedWangTiles.size() - 1;
+    mTileInfoToIndex.erase(it);
+
+    setSpotIndexBits(mIndexedWangTiles.at(index).wangId(), index, false);
+
+    if (index != last) {
+        const WangTile &lastWangTile = mIndexedWangTiles.at(last);
+        setSpotIndexBits(lastWangTile.wangId(), last, false);
+        setSpotIndexBits(lastWangTile.wangId(), index, true);
+        mTileInfoToIndex.insert(wangTileToTileInfo(lastWangTile), index);
+        mIndexedWangTiles[index] = lastWangTile;
+    }
+
+    mIndexedWangTiles.removeLast();
+
+    if (last % 64 == 0)
+        for (QVector<quint64> &bits : mSpotColorBits)
+            bits.removeLast();
+}
+
+void WangSet::setSpotIndexBits(WangId wangId, int index, bool value)
+{
+    const quint64 mask = quint64(1) << (index % 64);
+
+    for (int spot = 0; spot < 8; ++spot) {
+        quint64 &word = mSpotColorBits[spot * 16 + wangId.indexColor(spot)][index / 64];
+        if (value)
+            word |= mask;
+        else
+            word &= ~mask;
+    }
+}
+
+/**
+ * Returns a bit for each of the indexed tiles, telling whether it matches
+ * \a wangId. Like WangId::variations, the 0 spots are only wildcards when
+ * there is more than one edge or corner color respectively. The color counts
+ * are looked at here, so the index does not change when they do.
+ */
+QVector<quint64> WangSet::matchingSpotIndexBits(WangId wangId) const
+{
+    const int tileCount = mIndexedWangTiles.size();
+    QVector<quint64> bits((tileCount + 63) / 64, ~quint64(0));
+
+    if (tileCount % 64)
+        bits.last() = (quint64(1) << (tileCount % 64)) - 1;
+
+    for (int spot = 0; spot < 8; ++spot) {
+        const int color = wangId.indexColor(spot);
+        const int colorCount = (spot & 1) ? cornerColorCount() : edgeColorCount();
+        if (color == 0 && colorCount > 1)
+            continue;
+
+        const QVector<quint64> &spotBits = mSpotColorBits[spot * 16 + color];
+        for (int word = 0; word < bits.size(); ++word)
+            bits[word] &= spotBits.at(word);
+    }
+
+    return bits;
 }
 
 void WangSet::removeWangTile(const WangTile &wangTile)
@@ -563,6 +657,8 @@ void WangSet::removeWangTile(const WangTile &wangTile)
 
     mWangIdToWangTile.remove(wangId, w);
 
+    removeFromSpotIndex(w);
+
     if (wangId
             && !mWangIdToWangTile.contains(wangId)
             && (edgeColorCount() <= 1 || !wangId.hasEdgeWildCards())
@@ -593,14 +689,15 @@ QList<WangTile> WangSet::findMatchingWangTiles(WangId wangId) const
     if (wangId == 0)
         return mWangIdToWangTile.values();
 
+    const QVector<quint64> bits = matchingSpotIndexBits(wangId);
+
     QList<WangTile> list;
 
-    for (WangId id : wangId.variations(edgeColorCount(), cornerColorCount())) {
-        auto i = mWangIdToWangTile.find(id);
-        while (i != mWangIdToWangTile.end() && i.key() == id) {
-            list.append(i.value());
-            ++i;
-        }
+    for (int word = 0; word < bits.size(); ++word) {
+        int bit = 0;
+        for (quint64 b = bits.at(word); b; b >>= 1, ++bit)
+            if (b & 1)
+                list.append(mIndexedWangTiles.at(word * 64 + bit));
     }
 
     return list;
@@ -728,12 +825,8 @@ bool WangSet::wildWangIdIsUsed(WangId wangId) const
     if (!wangId)
         return true;
 
-    for (WangId id : wangId.variations(edgeColorCount(), cornerColorCount())) {
-        if (wangIdIsUsed(id))
-            return true;
-    }
-
-    return false;
+    const QVector<quint64> bits = matchingSpotIndexBits(wangId);
+    return std::any_of(bits.begin(), bits.end(), [] (quint64 b) { return b != 0; });
 }
 
 bool WangSet::isComplete() const
@@ -778,6 +871,10 @@ WangSet *WangSet::clone(Tileset *tileset) const
 
     c->mWangIdToWangTile = mWangIdToWangTile;
     c->mTileInfoToWangId = mTileInfoToWangId;
+    c->mIndexedWangTiles = mIndexedWangTiles;
+    c->mTileInfoToIndex = mTileInfoToIndex;
+    std::copy(std::begin(mSpotColorBits), std::end(mSpotColorBits),
+              std::begin(c->mSpotColorBits));
 
     return c;
 }
@@ -431,6 +431,11 @@ public:
 private:
     void removeWangTile(const WangTile &wangTile);
 
+    void addToSpotIndex(const WangTile &wangTile);
+    void removeFromSpotIndex(const WangTile &wangTile);
+    void setSpotIndexBits(WangId wangId, int index, bool value);
+    QVector<quint64> matchingSpotIndexBits(WangId wangId) const;
+
     void insertEdgeWangColor(QSharedPointer<WangColor> wangColor);
     void insertCornerWangColor(QSharedPointer<WangColor> wangColor);
 
@@ -445,6 +450,14 @@ private:
     unsigned mUniqueFullWangIdCount;
     QMultiHash<WangId, WangTile> mWangIdToWangTile;
 
+    //For each of the 8 spots of a wangId and each color, a bit for each of
+    //the mIndexedWangTiles telling whether it has that color in that spot.
+    //Allows finding the tiles matching a wangId with wildcards without going
+    //over all its variations.
+    QVector<WangTile> mIndexedWangTiles;
+    QHash<unsigned, int> mTileInfoToIndex;
+    QVector<quint64> mSpotColorBits[8 * 16];
+
     //Tile info being the tileId, with the last three bits (32, 31, 30)
     //being info on flip (horizontal, vertical, and antidiagonal)
     QHash<unsigned, WangId> mTileInfoToWangId;
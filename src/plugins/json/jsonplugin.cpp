@@ -21,6 +21,7 @@
 
 #include "jsonplugin.h"
 
+#include "map.h"
 #include "maptovariantconverter.h"
 #include "varianttomapconverter.h"
 #include "savefile.h"
@@ -89,6 +90,11 @@ Tiled::Map *JsonMapFormat::read(const QString &fileName)
 
 bool JsonMapFormat::write(const Tiled::Map *map, const QString &fileName)
 {
+    if (!Tiled::layerDataFormatSupported(map->layerDataFormat())) {
+        mError = tr("The tile layer format of this map is not supported by this build.");
+        return false;
+    }
+
     Tiled::SaveFile file(fileName);
 
     if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
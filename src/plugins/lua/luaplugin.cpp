@@ -49,11 +49,17 @@ using namespace Tiled;
 namespace Lua {
 
 LuaPlugin::LuaPlugin()
+    : mCompressionLevel(-1)
 {
 }
 
 bool LuaPlugin::write(const Map *map, const QString &fileName)
 {
+    if (!layerDataFormatSupported(map->layerDataFormat())) {
+        mError = tr("The tile layer format of this map is not supported by this build.");
+        return false;
+    }
+
     SaveFile file(fileName);
 
     if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
@@ -158,6 +164,7 @@ void LuaPlugin::writeMap(LuaTableWriter &writer, const Map *map)
     }
     writer.writeEndTable();
 
+    mCompressionLevel = map->compressionLevel();
     writeLayers(writer, map->layers(), map->layerDataFormat());
 
     writer.writeEndTable();
@@ -388,15 +395,23 @@ void LuaPlugin::writeTileLayer(LuaTableWriter &writer,
 
     case Map::Base64:
     case Map::Base64Zlib:
-    case Map::Base64Gzip: {
+    case Map::Base64Gzip:
+    case Map::Base64Zstd:
+    case Map::Base64Lz4: {
         writer.writeKeyAndValue("encoding", "base64");
 
         if (format == Map::Base64Zlib)
             writer.writeKeyAndValue("compression", "zlib");
         else if (format == Map::Base64Gzip)
             writer.writeKeyAndValue("compression", "gzip");
-
-        QByteArray layerData = mGidMapper.encodeLayerData(*tileLayer, format);
+        else if (format == Map::Base64Zstd)
+            writer.writeKeyAndValue("compression", "zstd");
+        else if (format == Map::Base64Lz4)
+            writer.writeKeyAndValue("compression", "lz4");
+
+        QByteArray layerData = mGidMapper.encodeLayerData(*tileLayer, format,
+                                                          QRect(),
+                                                          mCompressionLevel);
         writer.writeKeyAndValue("data", layerData);
         break;
     }
@@ -79,6 +79,7 @@ private:
     QString mError;
     QDir mMapDir;     // The directory in which the map is being saved
     Tiled::GidMapper mGidMapper;
+    int mCompressionLevel;
 };
 
 } // namespace Lua
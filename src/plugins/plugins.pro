@@ -9,6 +9,7 @@ SUBDIRS = csv \
           replicaisland \
           tbin \
           tengine \
+          tmb \
           tmw
 
 include(python/find_python.pri)
@@ -53,7 +53,7 @@ cls_object.add_method('setProperty', None,
 
 cls_tile = tiled.add_class('Tile', cls_object)
 cls_tile.add_method('id', 'int', [])
-cls_tile.add_method('image', retval('const QPixmap&'), [])
+cls_tile.add_method('image', retval('QPixmap'), [])
 cls_tile.add_method('setImage', None, [('const QPixmap&','image')])
 cls_tile.add_method('width', 'int', [])
 cls_tile.add_method('height', 'int', [])
@@ -0,0 +1,13 @@
+include(../plugin.pri)
+
+DEFINES += TMB_LIBRARY
+
+SOURCES += tmbplugin.cpp \
+    tmbreader.cpp \
+    tmbwriter.cpp
+
+HEADERS += tmb_global.h \
+    tmbformat.h \
+    tmbplugin.h \
+    tmbreader.h \
+    tmbwriter.h
@@ -0,0 +1,267 @@
+/*
+ * tmbformat.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "tiled.h"
+
+#include <QByteArray>
+#include <QtEndian>
+
+#include <cstring>
+
+namespace Tmb {
+
+/**
+ * TMB is a versioned binary map format. It is designed to be read straight
+ * from a memory mapped file: all data is stored in tables of fixed size
+ * records, so that nothing needs to be parsed and tile layer chunks can be
+ * decoded on demand. All values are stored in little-endian byte order.
+ *
+ * A file starts with a header:
+ *
+ *   char[4]   magic ("TMB\0")
+ *   uint32    format version
+ *   uint32    number of sections
+ *   uint32    reserved
+ *
+ * It is followed by the section table, which stores for each section:
+ *
+ *   uint64    offset of the section from the start of the file
+ *   uint32    number of records
+ *   uint32    size of a record in bytes
+ *
+ * Records may be larger than the sizes listed below, so that fields can be
+ * added at the end of a record without breaking older readers. Sections
+ * unknown to a reader are ignored.
+ *
+ * Strings are referred to by their index in the string table, where index 0
+ * is always the empty string. Properties are referred to by the index of the
+ * first property and the number of properties.
+ */
+
+const char Magic[4] = { 'T', 'M', 'B', '\0' };
+const quint32 FormatVersion = 1;
+const int HeaderSize = 16;
+const int SectionEntrySize = 16;
+const int SectionAlignment = 16;
+
+enum Section {
+    /// uint32 orientation, render order, width, height, tile width,
+    /// tile height, hex side length, stagger axis, stagger index, MapFlags,
+    /// background color (ARGB), next object id, layer data format;
+    /// int32 compression level; uint32 first property, property count
+    MapSection,
+
+    /// uint32 offset in the string data, size in bytes
+    StringSection,
+
+    /// UTF-8 encoded string data, one byte per record
+    StringDataSection,
+
+    /// uint32 name, type name and value strings
+    PropertySection,
+
+    /// uint32 first gid, source string, offset in the blob section and size
+    /// in bytes of the TSX data of an embedded tileset
+    TilesetSection,
+
+    /// uint32 first tid, source string
+    TemplateGroupSection,
+
+    /// uint32 LayerType, LayerFlags, name string; int32 x, y, width,
+    /// height; float opacity; double offset x, offset y; uint32 first
+    /// property, property count, color (ARGB), draw order, image source
+    /// string, first chunk or object, number of chunks, objects or child
+    /// layers, reserved
+    ///
+    /// Layers are stored depth-first, with the child layers of a group
+    /// layer directly following the group layer.
+    LayerSection,
+
+    /// uint32 id, ObjectFlags, name string, type string, gid, tid, shape,
+    /// changed properties; double x, y, width, height, rotation; uint32
+    /// first property, property count, first point, point count, text
+    /// index + 1 (0 when the object has no text), reserved
+    ObjectSection,
+
+    /// double x, y
+    PointSection,
+
+    /// uint32 text string, font family string; int32 pixel size; uint32
+    /// TextFlags, color (ARGB), alignment
+    TextSection,
+
+    /// int32 x, y of the top-left cell of the chunk
+    ChunkSection,
+
+    /// CHUNK_SIZE * CHUNK_SIZE uint32 gids in row-major order, one record
+    /// for each record in the chunk section
+    ChunkDataSection,
+
+    /// Arbitrary data, one byte per record
+    BlobSection,
+
+    SectionCount
+};
+
+enum LayerType {
+    TileLayerType = 1,
+    ObjectGroupType,
+    ImageLayerType,
+    GroupLayerType
+};
+
+enum MapFlags {
+    MapInfinite                 = 0x1,
+    MapHasBackgroundColor       = 0x2
+};
+
+enum LayerFlags {
+    LayerVisible                = 0x1,
+    LayerLocked                 = 0x2,
+    LayerHasColor               = 0x4
+};
+
+enum ObjectFlags {
+    ObjectVisible               = 0x1
+};
+
+enum TextFlags {
+    TextBold                    = 0x1,
+    TextItalic                  = 0x2,
+    TextUnderline               = 0x4,
+    TextStrikeOut               = 0x8,
+    TextKerning                 = 0x10,
+    TextWordWrap                = 0x20
+};
+
+const int ChunkCellCount = Tiled::CHUNK_SIZE * Tiled::CHUNK_SIZE;
+
+/**
+ * Returns the minimum size of the records in the given \a section.
+ */
+inline quint32 recordSize(Section section)
+{
+    switch (section) {
+    case MapSection:            return 64;
+    case StringSection:         return 8;
+    case StringDataSection:     return 1;
+    case PropertySection:       return 12;
+    case TilesetSection:        return 16;
+    case TemplateGroupSection:  return 8;
+    case LayerSection:          return 80;
+    case ObjectSection:         return 96;
+    case PointSection:          return 16;
+    case TextSection:           return 24;
+    case ChunkSection:          return 8;
+    case ChunkDataSection:      return ChunkCellCount * 4;
+    case BlobSection:           return 1;
+    case SectionCount:          break;
+    }
+    return 0;
+}
+
+/**
+ * Reads consecutive little-endian values from a record.
+ */
+class RecordReader
+{
+public:
+    explicit RecordReader(const uchar *data)
+        : mData(data)
+    {}
+
+    quint32 u32()
+    {
+        const quint32 value = qFromLittleEndian<quint32>(mData);
+        mData += 4;
+        return value;
+    }
+
+    qint32 i32()
+    {
+        return static_cast<qint32>(u32());
+    }
+
+    float f32()
+    {
+        const quint32 bits = u32();
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    double f64()
+    {
+        const quint64 bits = qFromLittleEndian<quint64>(mData);
+        mData += 8;
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+private:
+    const uchar *mData;
+};
+
+/**
+ * Appends little-endian values to a section.
+ */
+class RecordWriter
+{
+public:
+    explicit RecordWriter(QByteArray &data)
+        : mData(data)
+    {}
+
+    void u32(quint32 value)
+    {
+        uchar bytes[4];
+        qToLittleEndian(value, bytes);
+        mData.append(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+    }
+
+    void i32(qint32 value)
+    {
+        u32(static_cast<quint32>(value));
+    }
+
+    void f32(float value)
+    {
+        quint32 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        u32(bits);
+    }
+
+    void f64(double value)
+    {
+        quint64 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        uchar bytes[8];
+        qToLittleEndian(bits, bytes);
+        mData.append(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+    }
+
+private:
+    QByteArray &mData;
+};
+
+} // namespace Tmb
@@ -0,0 +1,82 @@
+/*
+ * TMB Tiled Plugin
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tmbplugin.h"
+
+#include "tmbreader.h"
+#include "tmbwriter.h"
+
+namespace Tmb {
+
+void TmbPlugin::initialize()
+{
+    addObject(new TmbMapFormat(this));
+}
+
+
+TmbMapFormat::TmbMapFormat(QObject *parent)
+    : Tiled::MapFormat(parent)
+{}
+
+Tiled::Map *TmbMapFormat::read(const QString &fileName)
+{
+    TmbReader reader;
+    Tiled::Map *map = reader.readMap(fileName);
+
+    if (!map)
+        mError = reader.errorString();
+
+    return map;
+}
+
+bool TmbMapFormat::supportsFile(const QString &fileName) const
+{
+    return fileName.endsWith(QLatin1String(".tmb"), Qt::CaseInsensitive) &&
+            TmbReader::isTmbFile(fileName);
+}
+
+bool TmbMapFormat::write(const Tiled::Map *map, const QString &fileName)
+{
+    TmbWriter writer;
+
+    if (!writer.writeMap(map, fileName)) {
+        mError = writer.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+QString TmbMapFormat::nameFilter() const
+{
+    return tr("Tiled binary map files (*.tmb)");
+}
+
+QString TmbMapFormat::shortName() const
+{
+    return QLatin1String("tmb");
+}
+
+QString TmbMapFormat::errorString() const
+{
+    return mError;
+}
+
+} // namespace Tmb
@@ -0,0 +1,661 @@
+/*
+ * tmbreader.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tmbreader.h"
+
+#include "grouplayer.h"
+#include "imagelayer.h"
+#include "map.h"
+#include "mapobject.h"
+#include "mapreader.h"
+#include "objectgroup.h"
+#include "parallel.h"
+#include "templategroup.h"
+#include "templatemanager.h"
+#include "tilelayer.h"
+#include "tileset.h"
+#include "tilesetmanager.h"
+
+#include <QBuffer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QScopedPointer>
+
+using namespace Tiled;
+
+namespace Tmb {
+
+TmbReader::TmbReader()
+    : mData(nullptr)
+    , mSize(0)
+{
+}
+
+Map *TmbReader::readMap(const QString &fileName, const QRect &region)
+{
+    mError.clear();
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        mError = tr("Could not open file for reading.");
+        return nullptr;
+    }
+
+    // Map the file when possible, so that only the data that is actually
+    // read needs to be loaded
+    QByteArray contents;
+    mSize = file.size();
+    mData = file.map(0, mSize);
+    if (!mData) {
+        contents = file.readAll();
+        mData = reinterpret_cast<const uchar*>(contents.constData());
+        mSize = contents.size();
+    }
+
+    mDir = QFileInfo(fileName).dir();
+    mRegion = region;
+
+    Map *map = readMap();
+
+    mData = nullptr;
+    mSize = 0;
+    mGidMapper.clear();
+    mTidMapper.clear();
+
+    return map;
+}
+
+bool TmbReader::isTmbFile(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    const QByteArray magic = file.read(sizeof(Magic));
+    return magic == QByteArray::fromRawData(Magic, sizeof(Magic));
+}
+
+Map *TmbReader::readMap()
+{
+    if (!readHeader())
+        return nullptr;
+
+    if (mSections[MapSection].count < 1) {
+        setCorrupt();
+        return nullptr;
+    }
+
+    RecordReader r(record(MapSection, 0));
+    const quint32 orientation = r.u32();
+    const quint32 renderOrder = r.u32();
+    const int width = r.i32();
+    const int height = r.i32();
+    const int tileWidth = r.i32();
+    const int tileHeight = r.i32();
+    const int hexSideLength = r.i32();
+    const quint32 staggerAxis = r.u32();
+    const quint32 staggerIndex = r.u32();
+    const quint32 flags = r.u32();
+    const QRgb backgroundColor = r.u32();
+    const int nextObjectId = r.i32();
+    const quint32 layerDataFormat = r.u32();
+    const int compressionLevel = r.i32();
+    const quint32 firstProperty = r.u32();
+    const quint32 propertyCount = r.u32();
+
+    if (orientation == Map::Unknown || orientation > quint32(Map::Hexagonal)) {
+        mError = tr("Unsupported map orientation: %1").arg(orientation);
+        return nullptr;
+    }
+
+    if (width < 0 || height < 0 || tileWidth < 0 || tileHeight < 0) {
+        setCorrupt();
+        return nullptr;
+    }
+
+    QScopedPointer<Map> map(new Map(static_cast<Map::Orientation>(orientation),
+                                    width, height, tileWidth, tileHeight,
+                                    flags & MapInfinite));
+
+    map->setRenderOrder(static_cast<Map::RenderOrder>(renderOrder & 3));
+    map->setHexSideLength(hexSideLength);
+    map->setStaggerAxis(static_cast<Map::StaggerAxis>(staggerAxis & 1));
+    map->setStaggerIndex(static_cast<Map::StaggerIndex>(staggerIndex & 1));
+    if (flags & MapHasBackgroundColor)
+        map->setBackgroundColor(QColor::fromRgba(backgroundColor));
+    if (nextObjectId)
+        map->setNextObjectId(nextObjectId);
+    if (layerDataFormat <= quint32(Map::Base64Lz4))
+        map->setLayerDataFormat(static_cast<Map::LayerDataFormat>(layerDataFormat));
+    map->setCompressionLevel(compressionLevel);
+    map->setProperties(readProperties(firstProperty, propertyCount));
+
+    readTilesets(*map);
+    readTemplateGroups(*map);
+
+    quint32 index = 0;
+    while (mError.isEmpty() && index < mSections[LayerSection].count) {
+        if (Layer *layer = readLayer(index))
+            map->addLayer(layer);
+    }
+
+    if (!mError.isEmpty())
+        return nullptr;
+
+    return map.take();
+}
+
+bool TmbReader::readHeader()
+{
+    if (mSize < HeaderSize || std::memcmp(mData, Magic, sizeof(Magic)) != 0) {
+        mError = tr("Not a TMB map file.");
+        return false;
+    }
+
+    RecordReader header(mData + sizeof(Magic));
+    const quint32 version = header.u32();
+    const quint32 sectionCount = header.u32();
+
+    if (version > FormatVersion) {
+        mError = tr("Unsupported TMB format version: %1").arg(version);
+        return false;
+    }
+
+    if (quint64(mSize) < HeaderSize + quint64(sectionCount) * SectionEntrySize) {
+        setCorrupt();
+        return false;
+    }
+
+    RecordReader entry(mData + HeaderSize);
+
+    for (int i = 0; i < SectionCount; ++i) {
+        SectionData &section = mSections[i];
+        section.data = nullptr;
+        section.count = 0;
+        section.recordSize = recordSize(static_cast<Section>(i));
+
+        // Sections missing from older files are treated as empty
+        if (quint32(i) >= sectionCount)
+            continue;
+
+        const quint64 offsetLow = entry.u32();
+        const quint64 offsetHigh = entry.u32();
+        const quint64 offset = offsetLow | (offsetHigh << 32);
+        const quint32 count = entry.u32();
+        const quint32 size = entry.u32();
+
+        if (count == 0)
+            continue;
+
+        // Byte sections need to be contiguous
+        const bool byteSection = i == StringDataSection || i == BlobSection;
+
+        if (size < section.recordSize || (byteSection && size != 1) ||
+                offset > quint64(mSize) ||
+                quint64(count) * size > quint64(mSize) - offset) {
+            setCorrupt();
+            return false;
+        }
+
+        section.data = mData + offset;
+        section.count = count;
+        section.recordSize = size;
+    }
+
+    if (mSections[ChunkDataSection].count < mSections[ChunkSection].count) {
+        setCorrupt();
+        return false;
+    }
+
+    return true;
+}
+
+void TmbReader::readTilesets(Map &map)
+{
+    for (quint32 i = 0; i < mSections[TilesetSection].count; ++i) {
+        RecordReader r(record(TilesetSection, i));
+        const unsigned firstGid = r.u32();
+        const quint32 source = r.u32();
+        const quint32 blobOffset = r.u32();
+        const quint32 blobSize = r.u32();
+
+        SharedTileset tileset;
+
+        if (source) {
+            const QString absoluteSource = QDir::cleanPath(mDir.filePath(string(source)));
+
+            QString error;
+            tileset = TilesetManager::instance()->loadTileset(absoluteSource, &error);
+
+            if (!tileset) {
+                // Insert a placeholder to allow the map to load
+                tileset = Tileset::create(QFileInfo(absoluteSource).completeBaseName(), 32, 32);
+                tileset->setFileName(absoluteSource);
+                tileset->setStatus(LoadingError);
+            }
+        } else {
+            if (!checkRange(BlobSection, blobOffset, blobSize))
+                return;
+
+            QByteArray data = QByteArray::fromRawData(
+                        reinterpret_cast<const char*>(record(BlobSection, blobOffset)),
+                        blobSize);
+            QBuffer buffer(&data);
+            buffer.open(QIODevice::ReadOnly);
+
+            MapReader reader;
+            tileset = reader.readTileset(&buffer, mDir.path());
+
+            if (!tileset) {
+                mError = tr("Error reading embedded tileset: %1").arg(reader.errorString());
+                return;
+            }
+
+            if (!tileset->isCollection())
+                tileset->loadImage();
+        }
+
+        if (firstGid == 0) {
+            setCorrupt();
+            return;
+        }
+
+        map.addTileset(tileset);
+        mGidMapper.insert(firstGid, tileset.data());
+    }
+}
+
+void TmbReader::readTemplateGroups(Map &map)
+{
+    for (quint32 i = 0; i < mSections[TemplateGroupSection].count; ++i) {
+        RecordReader r(record(TemplateGroupSection, i));
+        const unsigned firstTid = r.u32();
+        const QString source = string(r.u32());
+        const QString absoluteSource = QDir::cleanPath(mDir.filePath(source));
+
+        QString error;
+        TemplateGroup *templateGroup =
+                TemplateManager::instance()->loadTemplateGroup(absoluteSource, &error);
+
+        if (!templateGroup) { // Couldn't open the file
+            templateGroup = new TemplateGroup();
+            templateGroup->setFileName(absoluteSource);
+            templateGroup->setLoaded(false);
+        }
+
+        map.addTemplateGroup(templateGroup);
+        mTidMapper.insert(firstTid, templateGroup);
+    }
+}
+
+/**
+ * Reads the layer at \a index, which is advanced past the layer and its
+ * child layers.
+ */
+Layer *TmbReader::readLayer(quint32 &index)
+{
+    if (index >= mSections[LayerSection].count) {
+        setCorrupt();
+        return nullptr;
+    }
+
+    RecordReader r(record(LayerSection, index++));
+    const quint32 type = r.u32();
+    const quint32 flags = r.u32();
+    const QString name = string(r.u32());
+    const int x = r.i32();
+    const int y = r.i32();
+    const int width = r.i32();
+    const int height = r.i32();
+    const float opacity = r.f32();
+    const double offsetX = r.f64();
+    const double offsetY = r.f64();
+    const quint32 firstProperty = r.u32();
+    const quint32 propertyCount = r.u32();
+    const QRgb color = r.u32();
+    const quint32 drawOrder = r.u32();
+    const quint32 imageSource = r.u32();
+    const quint32 first = r.u32();
+    const quint32 count = r.u32();
+
+    if (width < 0 || height < 0) {
+        setCorrupt();
+        return nullptr;
+    }
+
+    QScopedPointer<Layer> layer;
+
+    switch (type) {
+    case TileLayerType: {
+        TileLayer *tileLayer = new TileLayer(name, x, y, width, height);
+        layer.reset(tileLayer);
+        readTileLayerChunks(*tileLayer, first, count);
+        break;
+    }
+    case ObjectGroupType: {
+        ObjectGroup *objectGroup = new ObjectGroup(name, x, y);
+        layer.reset(objectGroup);
+        if (flags & LayerHasColor)
+            objectGroup->setColor(QColor::fromRgba(color));
+        if (drawOrder == quint32(ObjectGroup::IndexOrder))
+            objectGroup->setDrawOrder(ObjectGroup::IndexOrder);
+        readObjects(*objectGroup, first, count);
+        break;
+    }
+    case ImageLayerType: {
+        ImageLayer *imageLayer = new ImageLayer(name, x, y);
+        layer.reset(imageLayer);
+        if (flags & LayerHasColor)
+            imageLayer->setTransparentColor(QColor::fromRgba(color));
+
+        const QString source = string(imageSource);
+        if (!source.isEmpty()) {
+            const QUrl sourceUrl = toUrl(source, mDir);
+            imageLayer->loadFromImage(QImage(sourceUrl.toLocalFile()), sourceUrl);
+        }
+        break;
+    }
+    case GroupLayerType: {
+        GroupLayer *groupLayer = new GroupLayer(name, x, y);
+        layer.reset(groupLayer);
+        for (quint32 i = 0; i < count && mError.isEmpty(); ++i)
+            if (Layer *childLayer = readLayer(index))
+                groupLayer->addLayer(childLayer);
+        break;
+    }
+    default:
+        mError = tr("Unknown layer type: %1").arg(type);
+        return nullptr;
+    }
+
+    layer->setOpacity(opacity);
+    layer->setVisible(flags & LayerVisible);
+    layer->setLocked(flags & LayerLocked);
+    layer->setOffset(QPointF(offsetX, offsetY));
+    layer->setProperties(readProperties(firstProperty, propertyCount));
+
+    return layer.take();
+}
+
+/**
+ * Decodes the chunks of a tile layer straight from the chunk data section.
+ * Only the chunks intersecting the requested region are decoded.
+ */
+void TmbReader::readTileLayerChunks(TileLayer &tileLayer,
+                                    quint32 firstChunk,
+                                    quint32 chunkCount)
+{
+    if (!checkRange(ChunkSection, firstChunk, chunkCount))
+        return;
+
+    QVector<quint32> chunks;
+    QVector<QPoint> positions;
+
+    for (quint32 i = firstChunk; i < firstChunk + chunkCount; ++i) {
+        RecordReader r(record(ChunkSection, i));
+        const int x = r.i32();
+        const int y = r.i32();
+
+        if ((x & CHUNK_MASK) || (y & CHUNK_MASK)) {
+            setCorrupt();
+            return;
+        }
+
+        if (!mRegion.isEmpty() && !mRegion.intersects(QRect(x, y, CHUNK_SIZE, CHUNK_SIZE)))
+            continue;
+
+        chunks.append(i);
+        positions.append(QPoint(x, y));
+    }
+
+    // Gids are converted to cells in parallel, in batches to limit the
+    // memory used by the converted cells
+    const int BatchSize = 1024;
+    QVector<Cell> cells(BatchSize * ChunkCellCount);
+    QVector<qint64> invalidGids(BatchSize);
+
+    for (int batchStart = 0; batchStart < chunks.size(); batchStart += BatchSize) {
+        const int batchSize = qMin(BatchSize, chunks.size() - batchStart);
+        const quint32 *chunkIndexes = chunks.constData() + batchStart;
+        Cell *cellData = cells.data();
+        qint64 *invalidGidData = invalidGids.data();
+
+        parallelFor(batchSize, [&] (int index) {
+            const uchar *data = record(ChunkDataSection, chunkIndexes[index]);
+            Cell *out = cellData + index * ChunkCellCount;
+            qint64 invalidGid = -1;
+
+            for (int i = 0; i < ChunkCellCount; ++i) {
+                const unsigned gid = qFromLittleEndian<quint32>(data + i * 4);
+                bool ok;
+                out[i] = mGidMapper.gidToCell(gid, ok);
+                if (!ok && invalidGid == -1)
+                    invalidGid = gid;
+            }
+
+            invalidGidData[index] = invalidGid;
+        });
+
+        for (int index = 0; index < batchSize; ++index) {
+            if (invalidGidData[index] != -1) {
+                if (mGidMapper.isEmpty())
+                    mError = tr("Tile used but no tilesets specified");
+                else
+                    mError = tr("Invalid tile: %1").arg(invalidGidData[index]);
+                return;
+            }
+
+            const QPoint &position = positions.at(batchStart + index);
+            const Cell *chunkCells = cellData + index * ChunkCellCount;
+
+            for (int i = 0; i < ChunkCellCount; ++i) {
+                const Cell &cell = chunkCells[i];
+                if (!cell.isEmpty())
+                    tileLayer.setCell(position.x() + (i & CHUNK_MASK),
+                                      position.y() + i / CHUNK_SIZE,
+                                      cell);
+            }
+        }
+    }
+}
+
+void TmbReader::readObjects(ObjectGroup &objectGroup,
+                            quint32 firstObject,
+                            quint32 objectCount)
+{
+    if (!checkRange(ObjectSection, firstObject, objectCount))
+        return;
+
+    for (quint32 i = firstObject; i < firstObject + objectCount; ++i) {
+        MapObject *object = readObject(i);
+        if (!object)
+            return;
+        objectGroup.addObject(object);
+    }
+}
+
+/**
+ * Reads the object at \a index. Returns null and sets the error when the
+ * object refers to an invalid template or tile.
+ */
+MapObject *TmbReader::readObject(quint32 index)
+{
+    RecordReader r(record(ObjectSection, index));
+    const int id = r.i32();
+    const quint32 flags = r.u32();
+    const QString name = string(r.u32());
+    const QString type = string(r.u32());
+    const unsigned gid = r.u32();
+    const unsigned tid = r.u32();
+    const quint32 shape = r.u32();
+    const quint32 changedProperties = r.u32();
+    const qreal x = r.f64();
+    const qreal y = r.f64();
+    const qreal width = r.f64();
+    const qreal height = r.f64();
+    const qreal rotation = r.f64();
+    const quint32 firstProperty = r.u32();
+    const quint32 propertyCount = r.u32();
+    const quint32 firstPoint = r.u32();
+    const quint32 pointCount = r.u32();
+    const quint32 text = r.u32();
+
+    QScopedPointer<MapObject> object(new MapObject(name, type, QPointF(x, y), QSizeF(width, height)));
+    object->setId(id);
+    object->setRotation(rotation);
+    object->setVisible(flags & ObjectVisible);
+
+    if (tid) { // This object is a template instance
+        bool ok;
+        const TemplateRef templateRef = mTidMapper.tidToTemplateRef(tid, ok);
+        if (!ok) {
+            mError = tr("Invalid template: %1").arg(tid);
+            return nullptr;
+        }
+        object->setTemplateRef(templateRef);
+    }
+
+    if (gid) {
+        bool ok;
+        object->setCell(mGidMapper.gidToCell(gid, ok));
+        if (!ok) {
+            mError = tr("Invalid tile: %1").arg(gid);
+            return nullptr;
+        }
+    }
+
+    if (shape <= quint32(MapObject::Text))
+        object->setShape(static_cast<MapObject::Shape>(shape));
+
+    if (pointCount > 0 && checkRange(PointSection, firstPoint, pointCount)) {
+        QPolygonF polygon;
+        polygon.reserve(pointCount);
+
+        for (quint32 i = firstPoint; i < firstPoint + pointCount; ++i) {
+            RecordReader pointReader(record(PointSection, i));
+            const qreal pointX = pointReader.f64();
+            const qreal pointY = pointReader.f64();
+            polygon.append(QPointF(pointX, pointY));
+        }
+
+        object->setPolygon(polygon);
+    }
+
+    if (text > 0 && checkRange(TextSection, text - 1, 1)) {
+        RecordReader textReader(record(TextSection, text - 1));
+
+        TextData textData;
+        textData.text = string(textReader.u32());
+        textData.font = QFont(string(textReader.u32()));
+
+        const int pixelSize = textReader.i32();
+        const quint32 textFlags = textReader.u32();
+        const QRgb color = textReader.u32();
+        const quint32 alignment = textReader.u32();
+
+        if (pixelSize > 0)
+            textData.font.setPixelSize(pixelSize);
+        textData.font.setBold(textFlags & TextBold);
+        textData.font.setItalic(textFlags & TextItalic);
+        textData.font.setUnderline(textFlags & TextUnderline);
+        textData.font.setStrikeOut(textFlags & TextStrikeOut);
+        textData.font.setKerning(textFlags & TextKerning);
+        textData.wordWrap = textFlags & TextWordWrap;
+        textData.color = QColor::fromRgba(color);
+        textData.alignment = Qt::Alignment(QFlag(int(alignment)));
+
+        object->setTextData(textData);
+    }
+
+    object->setProperties(readProperties(firstProperty, propertyCount));
+    object->setChangedProperties(MapObject::ChangedProperties(QFlag(int(changedProperties))));
+    object->syncWithTemplate();
+
+    return object.take();
+}
+
+Properties TmbReader::readProperties(quint32 firstProperty,
+                                     quint32 propertyCount)
+{
+    Properties properties;
+
+    if (!checkRange(PropertySection, firstProperty, propertyCount))
+        return properties;
+
+    for (quint32 i = firstProperty; i < firstProperty + propertyCount; ++i) {
+        RecordReader r(record(PropertySection, i));
+        const QString name = string(r.u32());
+        const QString typeName = string(r.u32());
+        const QString value = string(r.u32());
+
+        properties.insert(name, fromExportValue(value, nameToType(typeName), mDir));
+    }
+
+    return properties;
+}
+
+/**
+ * Returns the string at \a index in the string table.
+ */
+QString TmbReader::string(quint32 index)
+{
+    if (index == 0)
+        return QString();
+
+    if (index >= mSections[StringSection].count) {
+        setCorrupt();
+        return QString();
+    }
+
+    RecordReader r(record(StringSection, index));
+    const quint32 offset = r.u32();
+    const quint32 size = r.u32();
+
+    if (size == 0)
+        return QString();
+    if (!checkRange(StringDataSection, offset, size))
+        return QString();
+
+    return QString::fromUtf8(reinterpret_cast<const char*>(record(StringDataSection, offset)),
+                             size);
+}
+
+/**
+ * Checks whether the records [first, first + count) exist in the given
+ * \a section. Marks the file as corrupt when they don't.
+ */
+bool TmbReader::checkRange(Section section, quint32 first, quint32 count)
+{
+    const quint32 sectionCount = mSections[section].count;
+    if (first > sectionCount || count > sectionCount - first) {
+        setCorrupt();
+        return false;
+    }
+    return true;
+}
+
+void TmbReader::setCorrupt()
+{
+    if (mError.isEmpty())
+        mError = tr("The file is corrupt.");
+}
+
+} // namespace Tmb
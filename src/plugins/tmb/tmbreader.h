@@ -0,0 +1,122 @@
+/*
+ * tmbreader.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "tmb_global.h"
+#include "tmbformat.h"
+
+#include "gidmapper.h"
+#include "properties.h"
+#include "tidmapper.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QRect>
+
+namespace Tiled {
+class Layer;
+class Map;
+class MapObject;
+class ObjectGroup;
+class TileLayer;
+}
+
+namespace Tmb {
+
+/**
+ * Reads maps in the TMB format. The file is memory mapped while it is
+ * being read, so that only the parts that are used are loaded into memory.
+ *
+ * The tile layer chunks are decoded while reading the map, since tile
+ * layers have no way to decode their cells on demand. To load only part of
+ * a large map, pass a region to readMap().
+ */
+class TMBSHARED_EXPORT TmbReader
+{
+    Q_DECLARE_TR_FUNCTIONS(TmbReader)
+
+public:
+    TmbReader();
+
+    /**
+     * Reads a TMB map from the given \a fileName.
+     *
+     * When a \a region is given, only the tile layer chunks that intersect
+     * this region are decoded, and the rest of the tile layer data is not
+     * touched. The region is in tile coordinates local to each layer.
+     *
+     * Returns 0 and sets errorString() when reading failed.
+     *
+     * The caller takes ownership over the newly created map.
+     */
+    Tiled::Map *readMap(const QString &fileName,
+                        const QRect &region = QRect());
+
+    QString errorString() const { return mError; }
+
+    /**
+     * Returns whether the given file starts with the TMB magic.
+     */
+    static bool isTmbFile(const QString &fileName);
+
+private:
+    struct SectionData {
+        const uchar *data;
+        quint32 count;
+        quint32 recordSize;
+    };
+
+    Tiled::Map *readMap();
+    bool readHeader();
+    void readTilesets(Tiled::Map &map);
+    void readTemplateGroups(Tiled::Map &map);
+    Tiled::Layer *readLayer(quint32 &index);
+    void readTileLayerChunks(Tiled::TileLayer &tileLayer,
+                             quint32 firstChunk, quint32 chunkCount);
+    void readObjects(Tiled::ObjectGroup &objectGroup,
+                     quint32 firstObject, quint32 objectCount);
+    Tiled::MapObject *readObject(quint32 index);
+    Tiled::Properties readProperties(quint32 firstProperty,
+                                     quint32 propertyCount);
+
+    QString string(quint32 index);
+    const uchar *record(Section section, quint32 index) const;
+    bool checkRange(Section section, quint32 first, quint32 count);
+    void setCorrupt();
+
+    QString mError;
+    QDir mDir;
+    QRect mRegion;
+    const uchar *mData;
+    qint64 mSize;
+    SectionData mSections[SectionCount];
+    Tiled::GidMapper mGidMapper;
+    Tiled::TidMapper mTidMapper;
+};
+
+inline const uchar *TmbReader::record(Section section, quint32 index) const
+{
+    const SectionData &data = mSections[section];
+    Q_ASSERT(index < data.count);
+    return data.data + quint64(index) * data.recordSize;
+}
+
+} // namespace Tmb
@@ -0,0 +1,477 @@
+/*
+ * tmbwriter.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tmbwriter.h"
+
+#include "grouplayer.h"
+#include "imagelayer.h"
+#include "map.h"
+#include "mapobject.h"
+#include "mapwriter.h"
+#include "objectgroup.h"
+#include "parallel.h"
+#include "savefile.h"
+#include "templategroup.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QBuffer>
+#include <QFileInfo>
+
+using namespace Tiled;
+
+namespace Tmb {
+
+TmbWriter::TmbWriter()
+{
+}
+
+bool TmbWriter::writeMap(const Map *map, const QString &fileName)
+{
+    SaveFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly)) {
+        mError = tr("Could not open file for writing.");
+        return false;
+    }
+
+    writeMap(map, file.device(), QFileInfo(fileName).absolutePath());
+
+    if (file.error() != QFileDevice::NoError) {
+        mError = tr("Error while writing file:\n%1").arg(file.errorString());
+        return false;
+    }
+
+    if (!file.commit()) {
+        mError = file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+void TmbWriter::writeMap(const Map *map, QIODevice *device,
+                         const QString &path)
+{
+    mError.clear();
+    mDir = QDir(path);
+    mGidMapper.clear();
+    mTidMapper.clear();
+    mStringIndexes.clear();
+    for (QByteArray &section : mSections)
+        section.clear();
+
+    string(QString());  // index 0 is the empty string
+
+    unsigned firstGid = 1;
+    for (const SharedTileset &tileset : map->tilesets()) {
+        writeTileset(*tileset, firstGid);
+        mGidMapper.insert(firstGid, tileset.data());
+        firstGid += tileset->nextTileId();
+    }
+
+    unsigned firstTid = 1;
+    for (TemplateGroup *templateGroup : map->templateGroups()) {
+        RecordWriter record(mSections[TemplateGroupSection]);
+        record.u32(firstTid);
+        record.u32(string(mDir.relativeFilePath(templateGroup->fileName())));
+        mTidMapper.insert(firstTid, templateGroup);
+
+        // Reserve enough space to load a template group that is not loaded
+        // once it is fixed, like the TMX writer does
+        if (templateGroup->loaded())
+            firstTid += templateGroup->nextTemplateId();
+        else
+            firstTid += templateGroup->maxId() + 1;
+    }
+
+    for (const Layer *layer : map->layers())
+        writeLayer(*layer);
+
+    writeMapRecord(*map);
+
+    // Write the header, followed by the section table and the sections
+    QByteArray header;
+    header.append(Magic, sizeof(Magic));
+
+    RecordWriter headerWriter(header);
+    headerWriter.u32(FormatVersion);
+    headerWriter.u32(SectionCount);
+    headerWriter.u32(0);
+
+    auto align = [] (quint64 offset) {
+        return (offset + SectionAlignment - 1) & ~quint64(SectionAlignment - 1);
+    };
+
+    quint64 offset = align(HeaderSize + SectionCount * SectionEntrySize);
+    for (int i = 0; i < SectionCount; ++i) {
+        const Section section = static_cast<Section>(i);
+        headerWriter.u32(quint32(offset));
+        headerWriter.u32(quint32(offset >> 32));
+        headerWriter.u32(recordCount(section));
+        headerWriter.u32(recordSize(section));
+        offset = align(offset + mSections[i].size());
+    }
+
+    device->write(header);
+
+    qint64 written = header.size();
+    for (const QByteArray &section : mSections) {
+        const qint64 padding = align(written) - written;
+        device->write(QByteArray(int(padding), '\0'));
+        device->write(section);
+        written += padding + section.size();
+    }
+
+    mStringIndexes.clear();
+    for (QByteArray &section : mSections)
+        section.clear();
+}
+
+void TmbWriter::writeMapRecord(const Map &map)
+{
+    quint32 flags = 0;
+    if (map.infinite())
+        flags |= MapInfinite;
+    if (map.backgroundColor().isValid())
+        flags |= MapHasBackgroundColor;
+
+    RecordWriter record(mSections[MapSection]);
+    record.u32(map.orientation());
+    record.u32(map.renderOrder());
+    record.u32(map.width());
+    record.u32(map.height());
+    record.u32(map.tileWidth());
+    record.u32(map.tileHeight());
+    record.u32(map.hexSideLength());
+    record.u32(map.staggerAxis());
+    record.u32(map.staggerIndex());
+    record.u32(flags);
+    record.u32(map.backgroundColor().rgba());
+    record.u32(map.nextObjectId());
+    record.u32(map.layerDataFormat());
+    record.i32(map.compressionLevel());
+    writeProperties(map.properties(), record);
+}
+
+/**
+ * External tilesets are referred to by file name. Embedded tilesets are
+ * stored as TSX data, since they are small compared to the layer data and
+ * this way all tileset features are supported.
+ */
+void TmbWriter::writeTileset(const Tileset &tileset, unsigned firstGid)
+{
+    quint32 source = 0;
+    quint32 blobOffset = 0;
+    quint32 blobSize = 0;
+
+    if (!tileset.fileName().isEmpty()) {
+        source = string(mDir.relativeFilePath(tileset.fileName()));
+    } else {
+        QByteArray &blobs = mSections[BlobSection];
+
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+
+        MapWriter writer;
+        writer.setDtdEnabled(false);
+        writer.writeTileset(tileset, &buffer, mDir.path());
+
+        blobOffset = blobs.size();
+        blobSize = buffer.data().size();
+        blobs.append(buffer.data());
+    }
+
+    RecordWriter record(mSections[TilesetSection]);
+    record.u32(firstGid);
+    record.u32(source);
+    record.u32(blobOffset);
+    record.u32(blobSize);
+}
+
+void TmbWriter::writeLayer(const Layer &layer)
+{
+    quint32 type = 0;
+    quint32 flags = 0;
+    int width = 0;
+    int height = 0;
+    QColor color;
+    quint32 drawOrder = 0;
+    quint32 imageSource = 0;
+    quint32 first = 0;
+    quint32 count = 0;
+
+    if (layer.isVisible())
+        flags |= LayerVisible;
+    if (layer.isLocked())
+        flags |= LayerLocked;
+
+    switch (layer.layerType()) {
+    case Layer::TileLayerType: {
+        const TileLayer &tileLayer = static_cast<const TileLayer&>(layer);
+        type = TileLayerType;
+        width = tileLayer.width();
+        height = tileLayer.height();
+        writeTileLayerChunks(tileLayer, first, count);
+        break;
+    }
+    case Layer::ObjectGroupType: {
+        const ObjectGroup &objectGroup = static_cast<const ObjectGroup&>(layer);
+        type = ObjectGroupType;
+        color = objectGroup.color();
+        drawOrder = objectGroup.drawOrder();
+        writeObjects(objectGroup, first, count);
+        break;
+    }
+    case Layer::ImageLayerType: {
+        const ImageLayer &imageLayer = static_cast<const ImageLayer&>(layer);
+        type = ImageLayerType;
+        color = imageLayer.transparentColor();
+        imageSource = string(toFileReference(imageLayer.imageSource(), mDir));
+        break;
+    }
+    case Layer::GroupLayerType:
+        type = GroupLayerType;
+        count = static_cast<const GroupLayer&>(layer).layerCount();
+        break;
+    }
+
+    if (color.isValid())
+        flags |= LayerHasColor;
+
+    const QPointF offset = layer.offset();
+
+    RecordWriter record(mSections[LayerSection]);
+    record.u32(type);
+    record.u32(flags);
+    record.u32(string(layer.name()));
+    record.i32(layer.x());
+    record.i32(layer.y());
+    record.i32(width);
+    record.i32(height);
+    record.f32(layer.opacity());
+    record.f64(offset.x());
+    record.f64(offset.y());
+    writeProperties(layer.properties(), record);
+    record.u32(color.rgba());
+    record.u32(drawOrder);
+    record.u32(imageSource);
+    record.u32(first);
+    record.u32(count);
+    record.u32(0);
+
+    // Child layers directly follow their group layer
+    if (layer.isGroupLayer())
+        for (const Layer *childLayer : static_cast<const GroupLayer&>(layer).layers())
+            writeLayer(*childLayer);
+}
+
+void TmbWriter::writeTileLayerChunks(const TileLayer &tileLayer,
+                                     quint32 &firstChunk,
+                                     quint32 &chunkCount)
+{
+    const QRect bounds = tileLayer.bounds().translated(-tileLayer.position());
+
+    QVector<QPoint> chunks;
+
+    for (int y = bounds.top() & ~CHUNK_MASK; y <= bounds.bottom(); y += CHUNK_SIZE)
+        for (int x = bounds.left() & ~CHUNK_MASK; x <= bounds.right(); x += CHUNK_SIZE)
+            if (tileLayer.findChunk(x, y))
+                chunks.append(QPoint(x, y));
+
+    firstChunk = recordCount(ChunkSection);
+    chunkCount = chunks.size();
+
+    RecordWriter record(mSections[ChunkSection]);
+    for (const QPoint &chunk : chunks) {
+        record.i32(chunk.x());
+        record.i32(chunk.y());
+    }
+
+    // Converting cells to gids is done in parallel, directly into the
+    // chunk data section
+    QByteArray &chunkData = mSections[ChunkDataSection];
+    const int chunkDataSize = recordSize(ChunkDataSection);
+    const int start = chunkData.size();
+    chunkData.resize(start + chunks.size() * chunkDataSize);
+
+    uchar *data = reinterpret_cast<uchar*>(chunkData.data() + start);
+    const QPoint *chunkPositions = chunks.constData();
+
+    parallelFor(chunks.size(), [&] (int index) {
+        const QPoint &position = chunkPositions[index];
+        unsigned gids[ChunkCellCount];
+        mGidMapper.cellsToGids(tileLayer,
+                               QRect(position.x(), position.y(), CHUNK_SIZE, CHUNK_SIZE),
+                               gids);
+
+        uchar *out = data + index * chunkDataSize;
+        for (unsigned gid : gids) {
+            qToLittleEndian<quint32>(gid, out);
+            out += 4;
+        }
+    });
+}
+
+void TmbWriter::writeObjects(const ObjectGroup &objectGroup,
+                             quint32 &firstObject,
+                             quint32 &objectCount)
+{
+    firstObject = recordCount(ObjectSection);
+    objectCount = objectGroup.objectCount();
+
+    for (const MapObject *mapObject : objectGroup.objects())
+        writeObject(*mapObject);
+}
+
+void TmbWriter::writeObject(const MapObject &mapObject)
+{
+    quint32 flags = 0;
+    if (mapObject.isVisible())
+        flags |= ObjectVisible;
+
+    quint32 tid = 0;
+    if (mapObject.isTemplateInstance())
+        tid = mTidMapper.templateRefToTid(mapObject.templateRef());
+
+    quint32 changedProperties = 0;
+    for (int bit = 0; (1 << bit) <= MapObject::ShapeProperty; ++bit) {
+        const auto property = static_cast<MapObject::Property>(1 << bit);
+        if (mapObject.propertyChanged(property))
+            changedProperties |= property;
+    }
+
+    quint32 firstPoint = 0;
+    quint32 pointCount = 0;
+    if (mapObject.isPolyShape()) {
+        firstPoint = recordCount(PointSection);
+        pointCount = mapObject.polygon().size();
+
+        RecordWriter points(mSections[PointSection]);
+        for (const QPointF &point : mapObject.polygon()) {
+            points.f64(point.x());
+            points.f64(point.y());
+        }
+    }
+
+    quint32 text = 0;
+    if (mapObject.shape() == MapObject::Text) {
+        const TextData &textData = mapObject.textData();
+
+        quint32 textFlags = 0;
+        if (textData.font.bold())
+            textFlags |= TextBold;
+        if (textData.font.italic())
+            textFlags |= TextItalic;
+        if (textData.font.underline())
+            textFlags |= TextUnderline;
+        if (textData.font.strikeOut())
+            textFlags |= TextStrikeOut;
+        if (textData.font.kerning())
+            textFlags |= TextKerning;
+        if (textData.wordWrap)
+            textFlags |= TextWordWrap;
+
+        text = recordCount(TextSection) + 1;
+
+        RecordWriter textRecord(mSections[TextSection]);
+        textRecord.u32(string(textData.text));
+        textRecord.u32(string(textData.font.family()));
+        textRecord.i32(textData.font.pixelSize());
+        textRecord.u32(textFlags);
+        textRecord.u32(textData.color.rgba());
+        textRecord.u32(textData.alignment);
+    }
+
+    RecordWriter record(mSections[ObjectSection]);
+    record.u32(mapObject.id());
+    record.u32(flags);
+    record.u32(string(mapObject.name()));
+    record.u32(string(mapObject.type()));
+    record.u32(mGidMapper.cellToGid(mapObject.cell()));
+    record.u32(tid);
+    record.u32(mapObject.shape());
+    record.u32(changedProperties);
+    record.f64(mapObject.x());
+    record.f64(mapObject.y());
+    record.f64(mapObject.width());
+    record.f64(mapObject.height());
+    record.f64(mapObject.rotation());
+    writeProperties(mapObject.properties(), record);
+    record.u32(firstPoint);
+    record.u32(pointCount);
+    record.u32(text);
+    record.u32(0);
+}
+
+/**
+ * Writes the \a properties to the property section and stores the index of
+ * the first property and the number of properties in the \a record.
+ */
+void TmbWriter::writeProperties(const Properties &properties,
+                                RecordWriter &record)
+{
+    record.u32(recordCount(PropertySection));
+    record.u32(properties.size());
+
+    RecordWriter propertyRecord(mSections[PropertySection]);
+
+    Properties::const_iterator it = properties.constBegin();
+    Properties::const_iterator it_end = properties.constEnd();
+    for (; it != it_end; ++it) {
+        const QVariant exportValue = toExportValue(it.value(), mDir);
+
+        propertyRecord.u32(string(it.key()));
+        propertyRecord.u32(string(typeToName(it.value().userType())));
+        propertyRecord.u32(string(exportValue.toString()));
+    }
+}
+
+/**
+ * Returns the index of the given \a string in the string table, adding it
+ * when necessary.
+ */
+quint32 TmbWriter::string(const QString &string)
+{
+    auto it = mStringIndexes.constFind(string);
+    if (it != mStringIndexes.constEnd())
+        return it.value();
+
+    QByteArray &stringData = mSections[StringDataSection];
+    const QByteArray utf8 = string.toUtf8();
+
+    const quint32 index = recordCount(StringSection);
+
+    RecordWriter record(mSections[StringSection]);
+    record.u32(stringData.size());
+    record.u32(utf8.size());
+
+    stringData.append(utf8);
+    mStringIndexes.insert(string, index);
+
+    return index;
+}
+
+quint32 TmbWriter::recordCount(Section section) const
+{
+    return mSections[section].size() / recordSize(section);
+}
+
+} // namespace Tmb
@@ -0,0 +1,100 @@
+/*
+ * tmbwriter.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "tmb_global.h"
+#include "tmbformat.h"
+
+#include "gidmapper.h"
+#include "properties.h"
+#include "tidmapper.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QHash>
+
+class QIODevice;
+
+namespace Tiled {
+class Layer;
+class Map;
+class MapObject;
+class ObjectGroup;
+class TileLayer;
+class Tileset;
+}
+
+namespace Tmb {
+
+/**
+ * Writes maps in the TMB format.
+ */
+class TMBSHARED_EXPORT TmbWriter
+{
+    Q_DECLARE_TR_FUNCTIONS(TmbWriter)
+
+public:
+    TmbWriter();
+
+    /**
+     * Writes a TMB map to the given \a device. The \a path is used to
+     * create relative references to external files.
+     *
+     * Error checking will need to be done on the \a device after calling
+     * this function.
+     */
+    void writeMap(const Tiled::Map *map, QIODevice *device,
+                  const QString &path);
+
+    /**
+     * Writes a TMB map to the given \a fileName.
+     *
+     * Returns false and sets errorString() when writing failed.
+     * \overload
+     */
+    bool writeMap(const Tiled::Map *map, const QString &fileName);
+
+    QString errorString() const { return mError; }
+
+private:
+    void writeMapRecord(const Tiled::Map &map);
+    void writeTileset(const Tiled::Tileset &tileset, unsigned firstGid);
+    void writeLayer(const Tiled::Layer &layer);
+    void writeTileLayerChunks(const Tiled::TileLayer &tileLayer,
+                              quint32 &firstChunk, quint32 &chunkCount);
+    void writeObjects(const Tiled::ObjectGroup &objectGroup,
+                      quint32 &firstObject, quint32 &objectCount);
+    void writeObject(const Tiled::MapObject &mapObject);
+    void writeProperties(const Tiled::Properties &properties,
+                         RecordWriter &record);
+
+    quint32 string(const QString &string);
+    quint32 recordCount(Section section) const;
+
+    QString mError;
+    QDir mDir;
+    Tiled::GidMapper mGidMapper;
+    Tiled::TidMapper mTidMapper;
+    QHash<QString, quint32> mStringIndexes;
+    QByteArray mSections[SectionCount];
+};
+
+} // namespace Tmb
@@ -4,5 +4,6 @@ CONFIG   += ordered
 SUBDIRS = libtiled tiled plugins \
     tmxviewer \
     tmxrasterizer \
+    tmbconverter \
     automappingconverter \
     terraingenerator
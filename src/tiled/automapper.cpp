@@ -33,11 +33,16 @@
 #include "maprenderer.h"
 #include "object.h"
 #include "objectgroup.h"
+#include "parallel.h"
 #include "tile.h"
 #include "tilelayer.h"
 #include "tilesetmanager.h"
 
 #include <QDebug>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <climits>
 
 using namespace Tiled;
 using namespace Tiled::Internal;
@@ -61,6 +66,11 @@ AutoMapper::AutoMapper(MapDocument *workingDocument, Map *rules,
     , mDeleteTiles(false)
     , mAutoMappingRadius(0)
     , mNoOverlappingRules(false)
+    , mParallelMatching(false)
+    , mIncremental(false)
+    , mAppliedRuleCount(0)
+    , mAppliedRuleSequence(0)
+    , mRandomSeed(0)
 {
     Q_ASSERT(mMapRules);
 
@@ -338,6 +348,8 @@ bool AutoMapper::prepareAutoMap()
     if (!setupTilesets())
         return false;
 
+    compileRules();
+
     return true;
 }
 
@@ -410,6 +422,9 @@ bool AutoMapper::setupTilesets()
 void AutoMapper::autoMap(QRegion *where)
 {
     Q_ASSERT(mRulesInput.size() == mRulesOutput.size());
+
+    mRandomSeed = static_cast<uint>(qrand());
+
     // first resize the active area
     if (mAutoMappingRadius) {
         QRegion region;
@@ -422,9 +437,25 @@ void AutoMapper::autoMap(QRegion *where)
         *where += region;
     }
 
+    // revert the output of earlier runs that no longer matches, and make sure
+    // the rules get another chance at the reverted area. A full run replaces
+    // the output everywhere, so the earlier records are no longer needed.
+    if (mIncremental)
+        *where += revertStaleOutput(*where);
+    else
+        clearAppliedRules();
+
+    // rules are only checked at positions where they overlap the given
+    // region (see applyRule), so only the area around it needs to be indexed
+    const QSize maxRuleSize = maximumRuleSize();
+    mIndexArea = where->boundingRect().adjusted(-2 * maxRuleSize.width(),
+                                                -2 * maxRuleSize.height(),
+                                                2 * maxRuleSize.width(),
+                                                2 * maxRuleSize.height());
+
     // delete all the relevant area, if the property "DeleteTiles" is set
     if (mDeleteTiles) {
-        const QRegion setLayersRegion = getSetLayersRegion();
+        const QRegion setLayersRegion = getSetLayersRegion(*where);
         for (RuleOutput &translationTable : mLayerList) {
             foreach (Layer *layer, translationTable.keys()) {
                 const int index = translationTable.value(layer);
@@ -447,158 +478,245 @@ void AutoMapper::autoMap(QRegion *where)
     // locations
     QRegion ret;
     foreach (const QRect &rect, where->rects()) {
-        for (int i = 0; i < mRulesInput.size(); ++i) {
-            // at the moment the parallel execution does not work yet
-            // TODO: make multithreading available!
-            // either by dividing the rules or the region to multiple threads
+        for (int i = 0; i < mRulesInput.size(); ++i)
             ret = ret.united(applyRule(i, rect));
-        }
     }
     *where = where->united(ret);
 }
 
-QRegion AutoMapper::getSetLayersRegion() const
+QRegion AutoMapper::getSetLayersRegion(const QRegion &where) const
 {
     QRegion result;
     for (const QString &name : mInputRules.names) {
         const int index = mMapWork->indexOfLayer(name, Layer::TileLayerType);
         if (index == -1)
             continue;
-        TileLayer *setLayer = mMapWork->layerAt(index)->asTileLayer();
-        result |= setLayer->region();
+        const TileLayer *setLayer = mMapWork->layerAt(index)->asTileLayer();
+
+        // only look at the given region rather than the whole layer, and
+        // skip over missing chunks entirely
+        for (const QRect &rect : where.rects()) {
+            setLayer->forEachSpan(rect, [&] (const Chunk *chunk, int x, int y, int length) {
+                if (!chunk)
+                    return;
+
+                const int end = x + length;
+                while (x < end) {
+                    if (chunk->cellAt(x & CHUNK_MASK, y & CHUNK_MASK).isEmpty()) {
+                        ++x;
+                        continue;
+                    }
+
+                    const int rangeStart = x;
+                    while (x < end && !chunk->cellAt(x & CHUNK_MASK, y & CHUNK_MASK).isEmpty())
+                        ++x;
+                    result += QRect(rangeStart, y, x - rangeStart, 1);
+                }
+            });
+        }
     }
     return result;
 }
 
-static bool compareLayerTo(const TileLayer *setLayer,
-                           const QVector<TileLayer*> &listYes,
-                           const QVector<TileLayer*> &listNo,
-                           const QRegion &ruleRegion, const QPoint &offset);
+QSize AutoMapper::maximumRuleSize() const
+{
+    QSize size(0, 0);
+    for (const QRegion &ruleInputRegion : mRulesInput)
+        size = size.expandedTo(ruleInputRegion.boundingRect().size());
+    return size;
+}
 
-QRect AutoMapper::applyRule(const int ruleIndex, const QRect &where)
+static QPoint chunkCoordinates(const QPoint &pos)
 {
-    QRect ret;
+    const int x = pos.x();
+    const int y = pos.y();
+    return QPoint(x < 0 ? (x + 1) / CHUNK_SIZE - 1 : x / CHUNK_SIZE,
+                  y < 0 ? (y + 1) / CHUNK_SIZE - 1 : y / CHUNK_SIZE);
+}
 
-    if (mLayerList.isEmpty())
-        return ret;
+// Above this amount of recorded rules, the records are dropped to limit the
+// memory used while drawing with automapping enabled for a long time
+static const int MaximumAppliedRules = 1 << 20;
 
-    const QRegion &ruleInputRegion = mRulesInput.at(ruleIndex);
+void AutoMapper::applyRuleOutput(int ruleIndex, int outputIndex,
+                                 const QPoint &offset)
+{
     const QRegion &ruleOutputRegion = mRulesOutput.at(ruleIndex);
-    QRect rbr = ruleInputRegion.boundingRect();
-
-    // Since the rule itself is translated, we need to adjust the borders of the
-    // loops. Decrease the size at all sides by one: There must be at least one
-    // tile overlap to the rule.
-    const int minX = where.left() - rbr.left() - rbr.width() + 1;
-    const int minY = where.top() - rbr.top() - rbr.height() + 1;
-
-    const int maxX = where.right() - rbr.left() + rbr.width() - 1;
-    const int maxY = where.bottom() - rbr.top() + rbr.height() - 1;
+    const RuleOutput &translationTable = mLayerList.at(outputIndex);
 
-    // In this list of regions it is stored which parts or the map have already
-    // been altered by exactly this rule. We store all the altered parts to
-    // make sure there are no overlaps of the same rule applied to
-    // (neighbouring) places
-    QVector<QRegion> appliedRegions;
-    if (mNoOverlappingRules)
-        appliedRegions.resize(mMapWork->layerCount());
+    if (!mIncremental) {
+        copyMapRegion(ruleOutputRegion, offset, translationTable);
+        return;
+    }
 
-    for (int y = minY; y <= maxY; ++y)
-    for (int x = minX; x <= maxX; ++x) {
-        bool anyMatch = false;
+    // Remember the cells that are about to be replaced
+    QVector<OverwrittenCell> cells;
 
-        const auto &inputRules = mInputRules;
-        for (const InputIndex &inputIndex : inputRules) {
-            bool allLayerNamesMatch = true;
+    for (auto it = translationTable.begin(), end = translationTable.end(); it != end; ++it) {
+        const TileLayer *fromTileLayer = it.key()->asTileLayer();
+        const TileLayer *toTileLayer = mMapWork->layerAt(it.value())->asTileLayer();
+        if (!fromTileLayer || !toTileLayer)
+            continue;
 
-            QMapIterator<QString, InputConditions> inputIndexIterator(inputIndex);
-            while (inputIndexIterator.hasNext()) {
-                inputIndexIterator.next();
+        for (const QRect &rect : ruleOutputRegion.rects()) {
+            for (int y = rect.top(); y <= rect.bottom(); ++y) {
+                for (int x = rect.left(); x <= rect.right(); ++x) {
+                    const Cell &cell = fromTileLayer->cellAt(x, y);
+                    const QPoint pos = QPoint(x, y) + offset;
 
-                const QString &name = inputIndexIterator.key();
-                const InputConditions &conditions = inputIndexIterator.value();
+                    if (cell.isEmpty())
+                        continue;
+                    if (!mMapWork->infinite() && !toTileLayer->contains(pos))
+                        continue;
 
-                const int i = mMapWork->indexOfLayer(name, Layer::TileLayerType);
-                if (i == -1) {
-                    allLayerNamesMatch = false;
-                } else {
-                    const TileLayer *setLayer = mMapWork->layerAt(i)->asTileLayer();
-                    allLayerNamesMatch &= compareLayerTo(setLayer,
-                                                         conditions.listYes,
-                                                         conditions.listNo,
-                                                         ruleInputRegion,
-                                                         QPoint(x, y));
+                    const Cell previous = toTileLayer->cellAt(pos);
+                    if (previous != cell)
+                        cells.append(OverwrittenCell { it.value(), pos, cell, previous });
                 }
             }
-            if (allLayerNamesMatch) {
-                anyMatch = true;
-                break;
-            }
         }
+    }
 
-        if (anyMatch) {
-            // choose by chance which group of rule_layers should be used:
-            const int r = qrand() % mLayerList.size();
-            const RuleOutput &translationTable = mLayerList.at(r);
+    copyMapRegion(ruleOutputRegion, offset, translationTable);
+    recordAppliedRule(ruleIndex, outputIndex, offset, cells);
+}
 
-            if (!mNoOverlappingRules) {
-                copyMapRegion(ruleOutputRegion, QPoint(x, y), translationTable);
-                ret = ret.united(rbr.translated(QPoint(x, y)));
-                continue;
-            }
+void AutoMapper::recordAppliedRule(int ruleIndex, int outputIndex,
+                                   const QPoint &offset,
+                                   const QVector<OverwrittenCell> &cells)
+{
+    // Applied rules are stored by the chunk in which their input starts
+    const QRect rbr = mRulesInput.at(ruleIndex).boundingRect();
+    const QPoint start = rbr.topLeft() + offset;
+    const int key = (ruleIndex * CHUNK_SIZE + (start.y() & CHUNK_MASK)) * CHUNK_SIZE
+            + (start.x() & CHUNK_MASK);
+
+    QHash<int, AppliedRule> &appliedRules = mAppliedRules[chunkCoordinates(start)];
+    auto it = appliedRules.find(key);
+    if (it != appliedRules.end()) {
+        // Applied again at the same place. The cells replaced the first time
+        // are kept, since the new output only replaced the earlier output.
+        AppliedRule &appliedRule = it.value();
+        appliedRule.outputIndex = outputIndex;
+        appliedRule.sequence = mAppliedRuleSequence++;
+
+        for (const OverwrittenCell &cell : cells) {
+            auto known = std::find_if(appliedRule.cells.begin(), appliedRule.cells.end(),
+                                      [&] (const OverwrittenCell &c) {
+                return c.layerIndex == cell.layerIndex && c.pos == cell.pos;
+            });
+            if (known != appliedRule.cells.end())
+                known->written = cell.written;
+            else
+                appliedRule.cells.append(cell);
+        }
+        return;
+    }
 
-            bool missmatch = false;
-            const QList<Layer*> layers = translationTable.keys();
+    if (mAppliedRuleCount >= MaximumAppliedRules) {
+        clearAppliedRules();
+        recordAppliedRule(ruleIndex, outputIndex, offset, cells);
+        return;
+    }
 
-            // check if there are no overlaps within this rule.
-            QVector<QRegion> ruleRegionInLayer;
-            for (int i = 0; i < layers.size(); ++i) {
-                Layer *layer = layers.at(i);
+    AppliedRule appliedRule;
+    appliedRule.ruleIndex = ruleIndex;
+    appliedRule.outputIndex = outputIndex;
+    appliedRule.offset = offset;
+    appliedRule.sequence = mAppliedRuleSequence++;
+    appliedRule.cells = cells;
+    appliedRules.insert(key, appliedRule);
+    ++mAppliedRuleCount;
+}
 
-                QRegion appliedPlace;
+void AutoMapper::clearAppliedRules()
+{
+    mAppliedRules.clear();
+    mAppliedRuleCount = 0;
+}
 
-                if (TileLayer *tileLayer = layer->asTileLayer())
-                    appliedPlace = tileLayer->region();
-                else if (ObjectGroup *objectGroup = layer->asObjectGroup())
-                    appliedPlace = tileRegionOfObjectGroup(objectGroup);
-                else
-                    continue;
+QRegion AutoMapper::revertStaleOutput(const QRegion &where)
+{
+    QRegion reverted;
 
-                ruleRegionInLayer.append(appliedPlace.intersected(ruleOutputRegion));
+    if (mAppliedRules.isEmpty() || where.isEmpty())
+        return reverted;
 
-                if (appliedRegions.at(i).intersects(ruleRegionInLayer.at(i).translated(x, y))) {
-                    missmatch = true;
-                    break;
+    const QSize maxRuleSize = maximumRuleSize();
+
+    // Only the chunks in which the input of a rule overlapping the given
+    // region can start need to be checked
+    const QRect bounds = where.boundingRect();
+    const QPoint firstChunk = chunkCoordinates(bounds.topLeft() - QPoint(maxRuleSize.width(),
+                                                                         maxRuleSize.height()));
+    const QPoint lastChunk = chunkCoordinates(bounds.bottomRight());
+
+    QVector<AppliedRule> staleRules;
+
+    for (int chunkY = firstChunk.y(); chunkY <= lastChunk.y(); ++chunkY) {
+        for (int chunkX = firstChunk.x(); chunkX <= lastChunk.x(); ++chunkX) {
+            auto it = mAppliedRules.find(QPoint(chunkX, chunkY));
+            if (it == mAppliedRules.end())
+                continue;
+
+            QHash<int, AppliedRule> &appliedRules = it.value();
+            for (auto ruleIt = appliedRules.begin(); ruleIt != appliedRules.end(); ) {
+                const AppliedRule &appliedRule = ruleIt.value();
+                const QRegion &ruleInputRegion = mRulesInput.at(appliedRule.ruleIndex);
+
+                if (!ruleInputRegion.translated(appliedRule.offset).intersects(where) ||
+                        matchRule(mCompiledRules.at(appliedRule.ruleIndex), appliedRule.offset)) {
+                    ++ruleIt;
+                    continue;
                 }
+
+                staleRules.append(appliedRule);
+                ruleIt = appliedRules.erase(ruleIt);
+                --mAppliedRuleCount;
             }
-            if (missmatch)
-                continue;
 
-            copyMapRegion(ruleOutputRegion, QPoint(x, y), translationTable);
-            ret = ret.united(rbr.translated(QPoint(x, y)));
-            for (int i = 0; i < translationTable.size(); ++i)
-                appliedRegions[i] += ruleRegionInLayer[i].translated(x, y);
+            if (appliedRules.isEmpty())
+                mAppliedRules.erase(it);
         }
     }
 
-    return ret;
+    // Revert only after all rules have been checked, since reverting may
+    // affect whether other rules match. The most recently applied rules are
+    // reverted first, so that where outputs overlap, each rule restores the
+    // cells that were there before it. Only cells that still hold the output
+    // of the rule are restored, other changes are left alone.
+    std::sort(staleRules.begin(), staleRules.end(),
+              [] (const AppliedRule &a, const AppliedRule &b) {
+        return a.sequence > b.sequence;
+    });
+
+    for (const AppliedRule &appliedRule : staleRules) {
+        for (const OverwrittenCell &cell : appliedRule.cells) {
+            TileLayer *tileLayer = mMapWork->layerAt(cell.layerIndex)->asTileLayer();
+            if (tileLayer && tileLayer->cellAt(cell.pos) == cell.written)
+                tileLayer->setCell(cell.pos.x(), cell.pos.y(), cell.previous);
+        }
+
+        const QRegion &ruleOutputRegion = mRulesOutput.at(appliedRule.ruleIndex);
+        reverted += ruleOutputRegion.translated(appliedRule.offset);
+    }
+
+    return reverted;
 }
 
 /**
- * Returns a list of all cells which can be found within all tile layers
+ * Returns a set of all cells which can be found within all tile layers
  * within the given region.
  */
-static QVector<Cell> cellsInRegion(const QVector<TileLayer*> &list,
-                                   const QRegion &r)
+static QSet<Cell> cellsInRegion(const QVector<TileLayer*> &list,
+                                const QRegion &r)
 {
-    QVector<Cell> cells;
+    QSet<Cell> cells;
     for (const TileLayer *tilelayer : list) {
         foreach (const QRect &rect, r.rects()) {
             for (int x = rect.left(); x <= rect.right(); ++x) {
                 for (int y = rect.top(); y <= rect.bottom(); ++y) {
-                    const Cell &cell = tilelayer->cellAt(x, y);
-                    if (!cells.contains(cell))
-                        cells.append(cell);
+                    cells.insert(tilelayer->cellAt(x, y));
                 }
             }
         }
@@ -609,13 +727,13 @@ static QVector<Cell> cellsInRegion(const QVector<TileLayer*> &list,
 /**
  * This function is one of the core functions for understanding the
  * automapping.
- * In this function a certain region (of the set layer) is compared to
- * several other layers (ruleSet and ruleNotSet).
- * This comparison will determine if a rule of automapping matches,
+ * In this function the conditions a certain region (of the set layer) has
+ * to fulfill are derived from several other layers (ruleSet and ruleNotSet).
+ * These conditions determine if a rule of automapping matches,
  * so if this rule is applied at this region given
  * by a QRegion and Offset given by a QPoint.
  *
- * This compares the tile layer setLayer to several others given
+ * The tile layer setLayer is compared to several others given
  * in the QList listYes (ruleSet) and OList listNo (ruleNotSet).
  * The tile layer setLayer is examined at QRegion ruleRegion + offset
  * The tile layers within listYes and listNo are examined at QRegion ruleRegion.
@@ -625,7 +743,7 @@ static QVector<Cell> cellsInRegion(const QVector<TileLayer*> &list,
  * lead to canceling the comparison, returning false.
  *
  * The comparison is done for each position within the QRegion ruleRegion.
- * If all positions of the region are considered "good" return true.
+ * If all positions of the region are considered "good" the rule matches.
  *
  * Now there are several cases to distinguish:
  *  - both listYes and listNo are empty:
@@ -663,41 +781,32 @@ static QVector<Cell> cellsInRegion(const QVector<TileLayer*> &list,
  *      It was not added to the case, when having only listNo layers to
  *      avoid total symmetry between those lists.
  *
- * If all positions are considered good, return true.
- * return false otherwise.
+ * Since the rule layers don't change while automapping, the above is
+ * evaluated only once per position in the rule region, resulting in a set of
+ * allowed and forbidden cells for each position. Positions that don't
+ * constrain the set layer are left out.
  *
- * @return bool, if the tile layer matches the given list of layers.
+ * @return bool, false when the conditions can never be fulfilled.
  */
-static bool compareLayerTo(const TileLayer *setLayer,
-                           const QVector<TileLayer*> &listYes,
-                           const QVector<TileLayer*> &listNo,
-                           const QRegion &ruleRegion, const QPoint &offset)
+static bool compileLayerCondition(const InputConditions &conditions,
+                                  const QRegion &ruleRegion,
+                                  CompiledLayerCondition &compiled)
 {
+    const QVector<TileLayer*> &listYes = conditions.listYes;
+    const QVector<TileLayer*> &listNo = conditions.listNo;
+
     if (listYes.isEmpty() && listNo.isEmpty())
         return false;
 
-    QVector<Cell> cells;
+    QSet<Cell> cells;
     if (listNo.isEmpty())
         cells = cellsInRegion(listYes, ruleRegion);
 
     foreach (const QRect &rect, ruleRegion.rects()) {
-        for (int x = rect.left(); x <= rect.right(); ++x) {
-            for (int y = rect.top(); y <= rect.bottom(); ++y) {
-                // this is only used in the case where only one list has layers
-                // it is needed for the exception mentioned above
-                bool ruleDefinedListYes = false;
-
-                bool matchListYes = false;
-                bool matchListNo  = false;
-
-                const Cell &c1 = setLayer->cellAt(x + offset.x(),
-                                                  y + offset.y());
-
-                // ruleDefined will be set when there is a tile in at least
-                // one layer. if there is a tile in at least one layer, only
-                // the given tiles in the different listYes layers are valid.
-                // if there is given no tile at all in the listYes layers,
-                // consider all tiles valid.
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            for (int x = rect.left(); x <= rect.right(); ++x) {
+                CompiledCellCondition cellCondition;
+                cellCondition.pos = QPoint(x, y);
 
                 for (const TileLayer *comparedTileLayer : listYes) {
                     if (!comparedTileLayer->contains(x, y))
@@ -705,52 +814,372 @@ static bool compareLayerTo(const TileLayer *setLayer,
 
                     const Cell &c2 = comparedTileLayer->cellAt(x, y);
                     if (!c2.isEmpty())
-                        ruleDefinedListYes = true;
-
-                    if (!c2.isEmpty() && c1 == c2)
-                        matchListYes = true;
+                        cellCondition.allowed.insert(c2);
                 }
                 for (const TileLayer *comparedTileLayer : listNo) {
                     if (!comparedTileLayer->contains(x, y))
                         return false;
 
                     const Cell &c2 = comparedTileLayer->cellAt(x, y);
-
-                    if (!c2.isEmpty() && c1 == c2)
-                        matchListNo = true;
+                    if (!c2.isEmpty())
+                        cellCondition.forbidden.insert(c2);
                 }
 
-                // when there are only layers in the listNo
-                // check only if these layers are unmatched
-                // no need to check explicitly the exception in this case.
-                if (listYes.isEmpty()) {
-                    if (matchListNo)
-                        return false;
-                    else
-                        continue;
+                // when there is a tile in at least one of the listYes
+                // layers, only those tiles are valid. Otherwise, in case
+                // there are only listYes layers, all tiles except the ones
+                // used within the rule region are valid (the exception).
+                cellCondition.matchRequired = !cellCondition.allowed.isEmpty();
+                if (listNo.isEmpty() && !cellCondition.matchRequired)
+                    cellCondition.forbidden = cells;
+
+                if (cellCondition.matchRequired || !cellCondition.forbidden.isEmpty())
+                    compiled.cells.append(cellCondition);
+            }
+        }
+    }
+
+    // Check the most selective positions first
+    std::stable_sort(compiled.cells.begin(), compiled.cells.end(),
+                     [] (const CompiledCellCondition &a, const CompiledCellCondition &b) {
+        return a.matchRequired && !b.matchRequired;
+    });
+
+    return true;
+}
+
+void AutoMapper::compileRules()
+{
+    mCompiledRules.clear();
+    mCompiledRules.resize(mRulesInput.size());
+
+    // The working map layers the output of the rules is copied to
+    QSet<const Layer*> outputLayers;
+    for (const RuleOutput &translationTable : mLayerList)
+        for (int index : translationTable)
+            outputLayers.insert(mMapWork->layerAt(index));
+
+    for (int i = 0; i < mRulesInput.size(); ++i) {
+        const QRegion &ruleInputRegion = mRulesInput.at(i);
+        CompiledRule &rule = mCompiledRules[i];
+        rule.writesToInput = false;
+
+        for (const InputIndex &inputIndex : mInputRules) {
+            CompiledInputIndex compiledIndex;
+            bool canMatch = true;
+
+            QMapIterator<QString, InputConditions> inputIndexIterator(inputIndex);
+            while (inputIndexIterator.hasNext() && canMatch) {
+                inputIndexIterator.next();
+
+                const QString &name = inputIndexIterator.key();
+                const int layerIndex = mMapWork->indexOfLayer(name, Layer::TileLayerType);
+                if (layerIndex == -1) {
+                    canMatch = false;
+                    break;
                 }
-                // when there are only layers in the listYes
-                // check if these layers are matched, or if the exception works
-                if (listNo.isEmpty()) {
-                    if (matchListYes)
-                        continue;
-                    if (!ruleDefinedListYes && !cells.contains(c1))
-                        continue;
-                    return false;
+
+                CompiledLayerCondition layerCondition;
+                layerCondition.setLayer = mMapWork->layerAt(layerIndex)->asTileLayer();
+                canMatch = compileLayerCondition(inputIndexIterator.value(),
+                                                 ruleInputRegion,
+                                                 layerCondition);
+
+                if (outputLayers.contains(layerCondition.setLayer))
+                    rule.writesToInput = true;
+
+                compiledIndex.append(layerCondition);
+            }
+
+            // Input indexes that can never match are left out entirely
+            if (canMatch)
+                rule.inputIndexes.append(compiledIndex);
+        }
+    }
+}
+
+bool AutoMapper::matchRule(const CompiledRule &rule, const QPoint &offset) const
+{
+    for (const CompiledInputIndex &inputIndex : rule.inputIndexes) {
+        bool allLayerNamesMatch = true;
+
+        for (const CompiledLayerCondition &layerCondition : inputIndex) {
+            const TileLayer *setLayer = layerCondition.setLayer;
+
+            for (const CompiledCellCondition &condition : layerCondition.cells) {
+                const Cell &cell = setLayer->cellAt(condition.pos + offset);
+
+                if ((condition.matchRequired && !condition.allowed.contains(cell)) ||
+                        condition.forbidden.contains(cell)) {
+                    allLayerNamesMatch = false;
+                    break;
                 }
+            }
+
+            if (!allLayerNamesMatch)
+                break;
+        }
+
+        if (allLayerNamesMatch)
+            return true;
+    }
 
-                // there are layers in both lists:
-                // no need to consider ruleDefinedListXXX
-                if ((matchListYes || !ruleDefinedListYes) && !matchListNo)
+    return false;
+}
+
+static bool comparePositions(const QPoint &p1, const QPoint &p2)
+{
+    return p1.y() < p2.y() || (p1.y() == p2.y() && p1.x() < p2.x());
+}
+
+bool AutoMapper::collectCandidates(const CompiledRule &rule,
+                                   const QRect &area,
+                                   QVector<QPoint> &candidates)
+{
+    for (const CompiledInputIndex &inputIndex : rule.inputIndexes) {
+        // Find the position that requires a match with the least amount of
+        // occurrences of its allowed cells on the working map
+        const TileLayer *anchorLayer = nullptr;
+        const CompiledCellCondition *anchor = nullptr;
+        int anchorCount = INT_MAX;
+
+        for (const CompiledLayerCondition &layerCondition : inputIndex) {
+            const CellPositions &positions = cellPositions(layerCondition.setLayer);
+
+            for (const CompiledCellCondition &condition : layerCondition.cells) {
+                if (!condition.matchRequired)
                     continue;
-                else
-                    return false;
+
+                int count = 0;
+                for (const Cell &cell : condition.allowed) {
+                    auto it = positions.find(cell);
+                    if (it != positions.end())
+                        count += it.value().size();
+                }
+
+                if (count < anchorCount) {
+                    anchorLayer = layerCondition.setLayer;
+                    anchor = &condition;
+                    anchorCount = count;
+                }
+            }
+        }
+
+        // Without any required match, this input index could match anywhere
+        if (!anchor)
+            return false;
+
+        const CellPositions &positions = cellPositions(anchorLayer);
+        for (const Cell &cell : anchor->allowed) {
+            auto it = positions.find(cell);
+            if (it == positions.end())
+                continue;
+
+            for (const QPoint &pos : it.value()) {
+                const QPoint offset = pos - anchor->pos;
+                if (area.contains(offset))
+                    candidates.append(offset);
             }
         }
     }
+
+    std::sort(candidates.begin(), candidates.end(), comparePositions);
+    candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                     candidates.end());
+
     return true;
 }
 
+const CellPositions &AutoMapper::cellPositions(const TileLayer *layer)
+{
+    auto it = mCellPositions.find(layer);
+    if (it != mCellPositions.end())
+        return it.value();
+
+    CellPositions &positions = mCellPositions[layer];
+    const QRect bounds = layer->bounds().translated(-layer->position()).intersected(mIndexArea);
+
+    layer->forEachSpan(bounds, [&] (const Chunk *chunk, int x, int y, int length) {
+        if (!chunk)
+            return;
+
+        for (int end = x + length; x < end; ++x) {
+            const Cell cell = chunk->cellAt(x & CHUNK_MASK, y & CHUNK_MASK);
+            if (!cell.isEmpty())
+                positions[cell].append(QPoint(x, y));
+        }
+    });
+
+    return positions;
+}
+
+// Below this amount of positions, matching is not worth spreading out
+static const int MinimumPositionsForParallelMatching = 4096;
+
+QVector<QPoint> AutoMapper::matchRuleParallel(const CompiledRule &rule,
+                                              const QRect &area,
+                                              const QVector<QPoint> &candidates,
+                                              bool useCandidates) const
+{
+    // Use a few bands per thread, since rules don't match evenly everywhere
+    const int positionCount = useCandidates ? candidates.size() : area.height();
+    const int threadCount = QThreadPool::globalInstance()->maxThreadCount();
+    const int bandCount = qBound(1, threadCount * 4, qMax(1, positionCount));
+
+    QVector<QVector<QPoint>> bandMatches(bandCount);
+
+    parallelFor(bandCount, [&] (int band) {
+        const int begin = static_cast<int>(qint64(positionCount) * band / bandCount);
+        const int end = static_cast<int>(qint64(positionCount) * (band + 1) / bandCount);
+        QVector<QPoint> &matches = bandMatches[band];
+
+        if (useCandidates) {
+            for (int i = begin; i < end; ++i)
+                if (matchRule(rule, candidates.at(i)))
+                    matches.append(candidates.at(i));
+        } else {
+            for (int y = area.top() + begin; y < area.top() + end; ++y) {
+                for (int x = area.left(); x <= area.right(); ++x) {
+                    const QPoint offset(x, y);
+                    if (matchRule(rule, offset))
+                        matches.append(offset);
+                }
+            }
+        }
+    });
+
+    // The bands are in order, so concatenating them results in the same order
+    // in which the serial scan finds the matches
+    QVector<QPoint> result;
+    for (const QVector<QPoint> &matches : bandMatches)
+        result += matches;
+
+    return result;
+}
+
+int AutoMapper::outputIndexAt(int ruleIndex, const QPoint &offset) const
+{
+    // Mix the seed and the position into a well-distributed value
+    quint32 h = mRandomSeed;
+    h ^= static_cast<quint32>(ruleIndex) * 0x9E3779B1u;
+    h ^= static_cast<quint32>(offset.x()) * 0x85EBCA77u;
+    h ^= static_cast<quint32>(offset.y()) * 0xC2B2AE3Du;
+    h ^= h >> 16;
+    h *= 0x7FEB352Du;
+    h ^= h >> 15;
+    h *= 0x846CA68Bu;
+    h ^= h >> 16;
+
+    return static_cast<int>(h % static_cast<quint32>(mLayerList.size()));
+}
+
+QRect AutoMapper::applyRule(const int ruleIndex, const QRect &where)
+{
+    QRect ret;
+
+    if (mLayerList.isEmpty())
+        return ret;
+
+    const CompiledRule &rule = mCompiledRules.at(ruleIndex);
+    const QRegion &ruleInputRegion = mRulesInput.at(ruleIndex);
+    const QRegion &ruleOutputRegion = mRulesOutput.at(ruleIndex);
+    QRect rbr = ruleInputRegion.boundingRect();
+
+    // Since the rule itself is translated, we need to adjust the borders of the
+    // loops. Decrease the size at all sides by one: There must be at least one
+    // tile overlap to the rule.
+    const int minX = where.left() - rbr.left() - rbr.width() + 1;
+    const int minY = where.top() - rbr.top() - rbr.height() + 1;
+
+    const int maxX = where.right() - rbr.left() + rbr.width() - 1;
+    const int maxY = where.bottom() - rbr.top() + rbr.height() - 1;
+
+    // In this list of regions it is stored which parts or the map have already
+    // been altered by exactly this rule. We store all the altered parts to
+    // make sure there are no overlaps of the same rule applied to
+    // (neighbouring) places
+    QVector<QRegion> appliedRegions;
+    if (mNoOverlappingRules)
+        appliedRegions.resize(mMapWork->layerCount());
+
+    auto applyMatch = [&] (int x, int y) {
+        // choose by chance which group of rule_layers should be used:
+        const int r = outputIndexAt(ruleIndex, QPoint(x, y));
+        const RuleOutput &translationTable = mLayerList.at(r);
+
+        if (!mNoOverlappingRules) {
+            applyRuleOutput(ruleIndex, r, QPoint(x, y));
+            ret = ret.united(rbr.translated(QPoint(x, y)));
+            return;
+        }
+
+        const QList<Layer*> layers = translationTable.keys();
+
+        // check if there are no overlaps within this rule.
+        QVector<QRegion> ruleRegionInLayer;
+        for (int i = 0; i < layers.size(); ++i) {
+            Layer *layer = layers.at(i);
+
+            QRegion appliedPlace;
+
+            if (TileLayer *tileLayer = layer->asTileLayer())
+                appliedPlace = tileLayer->region().intersected(ruleOutputRegion);
+            else if (ObjectGroup *objectGroup = layer->asObjectGroup())
+                appliedPlace = tileRegionOfObjectGroup(objectGroup, ruleOutputRegion);
+            else
+                continue;
+
+            ruleRegionInLayer.append(appliedPlace);
+
+            if (appliedRegions.at(i).intersects(ruleRegionInLayer.at(i).translated(x, y)))
+                return;
+        }
+
+        applyRuleOutput(ruleIndex, r, QPoint(x, y));
+        ret = ret.united(rbr.translated(QPoint(x, y)));
+        for (int i = 0; i < translationTable.size(); ++i)
+            appliedRegions[i] += ruleRegionInLayer[i].translated(x, y);
+    };
+
+    // When the output of the rule can't change its own input, only the
+    // positions where the rule could match need to be checked. The order of
+    // the candidates matches the full scan below, so the result is the same.
+    QVector<QPoint> candidates;
+    const QRect area(QPoint(minX, minY), QPoint(maxX, maxY));
+    const bool useCandidates = !rule.writesToInput &&
+            collectCandidates(rule, area, candidates);
+
+    // For the same reason, all matches can then be found up front in
+    // parallel, to be applied afterwards in the same order.
+    if (mParallelMatching && !rule.writesToInput && !area.isEmpty()) {
+        const qint64 positionCount = useCandidates ? candidates.size()
+                                                   : qint64(area.width()) * area.height();
+
+        if (positionCount >= MinimumPositionsForParallelMatching) {
+            const QVector<QPoint> matches = matchRuleParallel(rule, area,
+                                                              candidates,
+                                                              useCandidates);
+            for (const QPoint &offset : matches)
+                applyMatch(offset.x(), offset.y());
+
+            return ret;
+        }
+    }
+
+    if (useCandidates) {
+        for (const QPoint &offset : candidates)
+            if (matchRule(rule, offset))
+                applyMatch(offset.x(), offset.y());
+    } else {
+        for (int y = minY; y <= maxY; ++y)
+            for (int x = minX; x <= maxX; ++x)
+                if (matchRule(rule, QPoint(x, y)))
+                    applyMatch(x, y);
+    }
+
+    return ret;
+}
+
 void AutoMapper::copyMapRegion(const QRegion &region, QPoint offset,
                                const RuleOutput &layerTranslation)
 {
@@ -812,12 +1241,20 @@ void AutoMapper::copyTileRegion(const TileLayer *srcLayer, int srcX, int srcY,
     const int offsetX = srcX - dstX;
     const int offsetY = srcY - dstY;
 
+    // Keep the cell index used for finding rule candidates up to date
+    auto positionsIt = mCellPositions.find(dstLayer);
+    CellPositions *positions = positionsIt != mCellPositions.end() ? &positionsIt.value()
+                                                                   : nullptr;
+
     for (int x = startX; x < endX; ++x) {
         for (int y = startY; y < endY; ++y) {
             const Cell &cell = srcLayer->cellAt(x + offsetX, y + offsetY);
             if (!cell.isEmpty()) {
                 // this is without graphics update, it's done afterwards for all
                 dstLayer->setCell(x, y, cell);
+
+                if (positions)
+                    (*positions)[cell].append(QPoint(x, y));
             }
         }
     }
@@ -846,6 +1283,8 @@ void AutoMapper::copyObjectRegion(const ObjectGroup *srcLayer, int srcX, int src
 
 void AutoMapper::cleanAll()
 {
+    mCompiledRules.clear();
+    mCellPositions.clear();
     cleanTilesets();
     cleanTileLayers();
 }
@@ -20,8 +20,10 @@
 
 #pragma once
 
+#include "tilelayer.h"
 #include "tileset.h"
 
+#include <QHash>
 #include <QList>
 #include <QMap>
 #include <QRegion>
@@ -35,7 +37,6 @@ class Layer;
 class Map;
 class MapObject;
 class ObjectGroup;
-class TileLayer;
 
 namespace Internal {
 
@@ -64,6 +65,79 @@ public:
     QString index;
 };
 
+/**
+ * A single position of a compiled input condition. The cell found at this
+ * position of the working map needs to be one of the \a allowed cells when
+ * \a matchRequired is set, and may never be one of the \a forbidden cells.
+ */
+class CompiledCellCondition
+{
+public:
+    QPoint pos;
+    bool matchRequired;
+    QSet<Cell> allowed;
+    QSet<Cell> forbidden;
+};
+
+/**
+ * The input conditions of one layer name, resolved against the layer of the
+ * working map they are checked on.
+ */
+class CompiledLayerCondition
+{
+public:
+    const TileLayer *setLayer;
+    QVector<CompiledCellCondition> cells;
+};
+
+// All layer conditions of one input index, which all need to match
+typedef QVector<CompiledLayerCondition> CompiledInputIndex;
+
+/**
+ * A rule of the rules map in a form that is cheap to match against the
+ * working map. A rule matches when any of its input indexes matches.
+ */
+class CompiledRule
+{
+public:
+    QVector<CompiledInputIndex> inputIndexes;
+    bool writesToInput;     // output may change the cells the input reads
+};
+
+// Maps the cells of a working map layer to the positions they are found at
+typedef QHash<Cell, QVector<QPoint>> CellPositions;
+
+/**
+ * A cell written by the output of a rule, along with the cell it replaced.
+ */
+class OverwrittenCell
+{
+public:
+    int layerIndex;
+    QPoint pos;
+    Cell written;
+    Cell previous;
+};
+
+/**
+ * Records where a rule was applied and which of the output layer groups
+ * was used, so that the output can be reverted once the rule no longer
+ * matches. The cells replaced by the output are kept for restoring them.
+ */
+class AppliedRule
+{
+public:
+    int ruleIndex;
+    int outputIndex;
+    QPoint offset;
+    unsigned sequence;      // increases with each applied rule
+    QVector<OverwrittenCell> cells;
+};
+
+// Maps chunk coordinates to the rules applied with their input in that chunk,
+// keyed by the rule index and the position of the rule input in the chunk
+typedef QHash<QPoint, QHash<int, AppliedRule>> AppliedRules;
+
 
 /**
  * This class does all the work for the automapping feature.
@@ -118,6 +192,29 @@ public:
      */
     void autoMap(QRegion *where);
 
+    /**
+     * Sets whether the positions at which a rule matches are searched for
+     * on multiple threads. The outcome of the automapping is the same
+     * either way.
+     */
+    void setParallelMatching(bool enabled) { mParallelMatching = enabled; }
+    bool parallelMatching() const { return mParallelMatching; }
+
+    /**
+     * Sets whether autoMap() is updating the output of earlier runs, as is
+     * the case when automapping while drawing. In this mode, the tile output
+     * of rules that no longer match within the given region is reverted.
+     */
+    void setIncremental(bool incremental) { mIncremental = incremental; }
+    bool isIncremental() const { return mIncremental; }
+
+    /**
+     * Forgets where rules were applied by earlier runs, for example because
+     * those changes were undone. Stale output from those runs will no longer
+     * be reverted.
+     */
+    void clearAppliedRules();
+
     /**
      * This cleans all data structures, which are setup via prepareAutoMap,
      * so the auto mapper becomes ready for its next automatic mapping.
@@ -180,9 +277,89 @@ private:
     bool setupTilesets();
 
     /**
-     * Returns the conjunction of all regions of all setlayers.
+     * Compiles the input conditions of all rules against the layers of the
+     * working map, storing the result in mCompiledRules.
+     */
+    void compileRules();
+
+    /**
+     * Returns whether the compiled \a rule matches the working map when it
+     * is translated by \a offset.
+     */
+    bool matchRule(const CompiledRule &rule, const QPoint &offset) const;
+
+    /**
+     * Collects the offsets within \a area at which the given \a rule could
+     * possibly match, sorted in the order in which rules are applied.
+     *
+     * @return false when the candidates can't be narrowed down, in which
+     *         case all positions of \a area need to be checked.
+     */
+    bool collectCandidates(const CompiledRule &rule, const QRect &area,
+                           QVector<QPoint> &candidates);
+
+    /**
+     * Returns the offsets at which the given \a rule matches, checking
+     * either the \a candidates or, when \a useCandidates is false, all
+     * positions of \a area. The work is split into row bands which are
+     * matched using parallelFor().
+     *
+     * Only valid for rules that don't write to their own input, since all
+     * matches are determined before any output is applied.
+     */
+    QVector<QPoint> matchRuleParallel(const CompiledRule &rule,
+                                      const QRect &area,
+                                      const QVector<QPoint> &candidates,
+                                      bool useCandidates) const;
+
+    /**
+     * Chooses one of the output translation tables for a match of the rule
+     * at \a ruleIndex at \a offset. The choice is random, but depends only
+     * on the position and the seed chosen at the start of autoMap().
+     */
+    int outputIndexAt(int ruleIndex, const QPoint &offset) const;
+
+    /**
+     * Returns the positions of all cells in the given working map layer
+     * within mIndexArea. The index is built on first use and kept up to
+     * date by copyTileRegion() until cleanAll() is called.
+     */
+    const CellPositions &cellPositions(const TileLayer *layer);
+
+    /**
+     * Returns the size of the bounding rectangle of the largest rule input.
+     */
+    QSize maximumRuleSize() const;
+
+    /**
+     * Copies the output of the rule at \a ruleIndex to \a offset, using the
+     * output layer group at \a outputIndex. For incremental runs, the
+     * application is recorded along with the cells it overwrote.
+     */
+    void applyRuleOutput(int ruleIndex, int outputIndex, const QPoint &offset);
+
+    /**
+     * Remembers that the rule at \a ruleIndex was applied at \a offset,
+     * using the output layer group at \a outputIndex and replacing the
+     * given \a cells.
+     */
+    void recordAppliedRule(int ruleIndex, int outputIndex, const QPoint &offset,
+                           const QVector<OverwrittenCell> &cells);
+
+    /**
+     * Reverts the tile output of the recorded rules which have their input
+     * within \a where, but which no longer match. The overwritten cells are
+     * restored, except where the output has since been changed.
+     *
+     * @return the region in which output was reverted
      */
-    QRegion getSetLayersRegion() const;
+    QRegion revertStaleOutput(const QRegion &where);
+
+    /**
+     * Returns the conjunction of the regions of all setlayers within
+     * \a where.
+     */
+    QRegion getSetLayersRegion(const QRegion &where) const;
 
     /**
      * This copies all Tiles from TileLayer src to TileLayer dst
@@ -309,6 +486,31 @@ private:
      */
     QVector<QRegion> mRulesOutput;
 
+    /**
+     * The rules compiled by prepareAutoMap(), matching the indexes of
+     * mRulesInput and mRulesOutput.
+     */
+    QVector<CompiledRule> mCompiledRules;
+
+    /**
+     * Index from cell to positions for each working map layer used as
+     * anchor by a compiled rule.
+     */
+    QHash<const TileLayer*, CellPositions> mCellPositions;
+
+    /**
+     * The area of the working map in which rules can match during the
+     * current autoMap() call. Only this area is indexed by cellPositions().
+     */
+    QRect mIndexArea;
+
+    /**
+     * The rules applied by previous incremental calls to autoMap(), by chunk.
+     */
+    AppliedRules mAppliedRules;
+    int mAppliedRuleCount;
+    unsigned mAppliedRuleSequence;
+
     /**
      * The inner set with layers to indexes is needed for translating
      * tile layers from mMapRules to mMapWork.
@@ -349,6 +551,21 @@ private:
      */
     bool mNoOverlappingRules;
 
+    /**
+     * Determines whether rule matching is spread over multiple threads.
+     */
+    bool mParallelMatching;
+
+    /**
+     * Determines whether stale output is reverted, see setIncremental().
+     */
+    bool mIncremental;
+
+    /**
+     * Seed for choosing the output of a match, set at the start of autoMap().
+     */
+    uint mRandomSeed;
+
     QSet<QString> mTouchedTileLayers;
     QSet<QString> mTouchedObjectGroups;
 
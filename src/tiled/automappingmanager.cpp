@@ -20,6 +20,7 @@
 
 #include "automappingmanager.h"
 
+#include "automapper.h"
 #include "automapperwrapper.h"
 #include "map.h"
 #include "mapdocument.h"
@@ -30,6 +31,7 @@
 #include <QFileInfo>
 #include <QScopedPointer>
 #include <QTextStream>
+#include <QUndoStack>
 
 using namespace Tiled;
 using namespace Tiled::Internal;
@@ -38,6 +40,7 @@ AutomappingManager::AutomappingManager(QObject *parent)
     : QObject(parent)
     , mMapDocument(nullptr)
     , mLoaded(false)
+    , mAppliedRulesCommand(nullptr)
 {
 }
 
@@ -77,6 +80,27 @@ void AutomappingManager::autoMap(const QRegion &where, Layer *touchedLayer)
         autoMapInternal(where, touchedLayer);
 }
 
+/**
+ * Automapping while drawing remembers where rules were applied, so that their
+ * output can be reverted once they no longer match. These records are only
+ * valid as long as the last automapping command is done, so they are dropped
+ * as soon as that command is undone or removed from the stack.
+ */
+void AutomappingManager::undoIndexChanged(int index)
+{
+    if (!mAppliedRulesCommand)
+        return;
+
+    const QUndoStack *undoStack = mMapDocument->undoStack();
+    for (int i = index - 1; i >= 0; --i)
+        if (undoStack->command(i) == mAppliedRulesCommand)
+            return;
+
+    mAppliedRulesCommand = nullptr;
+    for (AutoMapper *autoMapper : mAutoMappers)
+        autoMapper->clearAppliedRules();
+}
+
 void AutomappingManager::autoMapInternal(const QRegion &where,
                                          Layer *touchedLayer)
 {
@@ -108,6 +132,12 @@ void AutomappingManager::autoMapInternal(const QRegion &where,
         passedAutoMappers = mAutoMappers;
     }
     if (!passedAutoMappers.isEmpty()) {
+        const bool parallelMatching = Preferences::instance()->automappingParallelMatching();
+        for (AutoMapper *a : passedAutoMappers) {
+            a->setParallelMatching(parallelMatching);
+            a->setIncremental(automatic);
+        }
+
         // use a copy of the region, so each automapper can manipulate it and the
         // following automappers do see the impact
         QRegion region(where);
@@ -117,6 +147,8 @@ void AutomappingManager::autoMapInternal(const QRegion &where,
         AutoMapperWrapper *aw = new AutoMapperWrapper(mMapDocument, passedAutoMappers, &region);
         undoStack->push(aw);
         undoStack->endMacro();
+
+        mAppliedRulesCommand = undoStack->command(undoStack->index() - 1);
     }
     foreach (AutoMapper *automapper, mAutoMappers) {
         mWarning += automapper->warningString();
@@ -199,14 +231,19 @@ bool AutomappingManager::loadFile(const QString &filePath)
 void AutomappingManager::setMapDocument(MapDocument *mapDocument)
 {
     cleanUp();
-    if (mMapDocument)
+    if (mMapDocument) {
         mMapDocument->disconnect(this);
+        mMapDocument->undoStack()->disconnect(this);
+    }
 
     mMapDocument = mapDocument;
+    mAppliedRulesCommand = nullptr;
 
     if (mMapDocument) {
         connect(mMapDocument, SIGNAL(regionEdited(QRegion,Layer*)),
                 this, SLOT(autoMap(QRegion,Layer*)));
+        connect(mMapDocument->undoStack(), SIGNAL(indexChanged(int)),
+                this, SLOT(undoIndexChanged(int)));
     }
 
     mLoaded = false;
@@ -25,6 +25,8 @@
 #include <QString>
 #include <QVector>
 
+class QUndoCommand;
+
 namespace Tiled {
 
 class Layer;
@@ -75,6 +77,7 @@ public slots:
 
 private slots:
     void autoMap(const QRegion &where, Layer *touchedLayer);
+    void undoIndexChanged(int index);
 
 private:
     Q_DISABLE_COPY(AutomappingManager)
@@ -122,6 +125,13 @@ private:
      */
     bool mLoaded;
 
+    /**
+     * The command pushed by the last automapping. The rules applied so far
+     * are remembered only while this command is on the done part of the
+     * undo stack.
+     */
+    const QUndoCommand *mAppliedRulesCommand;
+
     /**
      * Contains all errors which occurred until canceling.
      * If mError is not empty, no serious result can be expected.
@@ -37,8 +37,20 @@ void eraseRegionObjectGroup(MapDocument *mapDocument,
                             const QRegion &where)
 {
     QUndoStack *undo = mapDocument->undoStack();
+    const MapRenderer *renderer = mapDocument->renderer();
 
-    const auto objects = layer->objects();
+    // Only the objects around the region need to be checked. The area is
+    // grown by a tile, since converting between tile and pixel coordinates
+    // is not linear for all orientations.
+    const QRect area = where.boundingRect().adjusted(-1, -1, 2, 2);
+    const QPolygonF pixelArea {
+        renderer->tileToPixelCoords(area.topLeft()),
+        renderer->tileToPixelCoords(area.topRight()),
+        renderer->tileToPixelCoords(area.bottomRight()),
+        renderer->tileToPixelCoords(area.bottomLeft())
+    };
+
+    const auto objects = layer->objectsIn(pixelArea.boundingRect());
     for (MapObject *obj : objects) {
         // TODO: we are checking bounds, which is only correct for rectangles and
         // tile objects. polygons and polylines are not covered correctly by this
@@ -64,23 +76,33 @@ void eraseRegionObjectGroup(MapDocument *mapDocument,
     }
 }
 
-QRegion tileRegionOfObjectGroup(const ObjectGroup *layer)
+QRegion tileRegionOfObjectGroup(const ObjectGroup *layer,
+                                const QRegion &within)
 {
+    // The area is grown by a pixel, since the bounds are aligned below
+    const QRectF area = QRectF(within.boundingRect()).adjusted(-1, -1, 1, 1);
+
     QRegion ret;
-    for (MapObject *obj : layer->objects()) {
+    const auto objects = layer->objectsIn(area);
+    for (MapObject *obj : objects) {
         // TODO: we are using bounds, which is only correct for rectangles and
         // tile objects. polygons and polylines are not probably covering less
         // tiles.
         ret += obj->bounds().toAlignedRect();
     }
-    return ret;
+    return ret.intersected(within);
 }
 
 const QList<MapObject*> objectsInRegion(const ObjectGroup *layer,
                                         const QRegion &where)
 {
     QList<MapObject*> ret;
-    for (MapObject *obj : layer->objects()) {
+
+    // The area is grown by a pixel, since the bounds are aligned below
+    const QRectF area = QRectF(where.boundingRect()).adjusted(-1, -1, 1, 1);
+
+    const auto candidates = layer->objectsIn(area);
+    for (MapObject *obj : candidates) {
         // TODO: we are checking bounds, which is only correct for rectangles and
         // tile objects. polygons and polylines are not covered correctly by this
         // erase method (we are in fact deleting too many objects)
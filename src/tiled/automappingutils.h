@@ -38,7 +38,8 @@ void eraseRegionObjectGroup(MapDocument *mapDocument,
                             ObjectGroup *layer,
                             const QRegion &where);
 
-QRegion tileRegionOfObjectGroup(const ObjectGroup *layer);
+QRegion tileRegionOfObjectGroup(const ObjectGroup *layer,
+                                const QRegion &within);
 
 } // namespace Internal
 } // namespace Tiled
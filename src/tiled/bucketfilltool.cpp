@@ -140,7 +140,10 @@ void BucketFillTool::tilePositionChanged(const QPoint &tilePos)
     // Optimization: we don't need to recalculate the fill area
     // if the new mouse position is still over the filled region
     // and the shift modifier hasn't changed.
-    if (!mFillRegion.contains(tilePos) || shiftPressed != mLastShiftStatus) {
+    const bool overFilledArea = shiftPressed ? mFillRegion.contains(tilePos)
+                                             : mFloodFill.contains(tilePos);
+
+    if (!overFilledArea || shiftPressed != mLastShiftStatus) {
 
         // Clear overlay to make way for a new one
         clearOverlay();
@@ -151,7 +154,8 @@ void BucketFillTool::tilePositionChanged(const QPoint &tilePos)
         // Get the new fill region
         if (!shiftPressed) {
             // If not holding shift, a region is generated from the current pos
-            mFillRegion = regionComputer.computePaintableFillRegion(tilePos);
+            mFloodFill = regionComputer.computeFill(tilePos);
+            mFillRegion = regionComputer.paintableFillRegion(mFloodFill);
         } else {
             // If holding shift, the region is the selection bounds
             mFillRegion = mapDocument()->selectedArea();
@@ -306,6 +310,7 @@ void BucketFillTool::clearOverlay()
     brushItem()->clear();
     mFillOverlay.clear();
     mFillRegion = QRegion();
+    mFloodFill = FloodFill();
 }
 
 void BucketFillTool::makeConnections()
@@ -23,6 +23,7 @@
 #pragma once
 
 #include "abstracttiletool.h"
+#include "floodfill.h"
 #include "randompicker.h"
 #include "tilelayer.h"
 #include "tilestamp.h"
@@ -99,6 +100,7 @@ private:
     TileStamp mStamp;
     SharedTileLayer mFillOverlay;
     QRegion mFillRegion;
+    FloodFill mFloodFill;
     QVector<SharedTileset> mMissingTilesets;
 
     bool mIsActive;
@@ -43,13 +43,15 @@ public:
         Orientation,
         RenderOrder,
         BackgroundColor,
-        LayerDataFormat
+        LayerDataFormat,
+        CompressionLevel
     };
 
     /**
      * Constructs a command that changes the value of the given property.
      *
-     * Can only be used for the HexSideLength property.
+     * Can only be used for the TileWidth, TileHeight, Infinite,
+     * HexSideLength and CompressionLevel properties.
      *
      * @param mapDocument       the map document of the map
      * @param backgroundColor   the new color to apply for the background
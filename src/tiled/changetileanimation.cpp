@@ -20,6 +20,7 @@
 
 #include "changetileanimation.h"
 
+#include "mapdocument.h"
 #include "tilesetdocument.h"
 #include "tilesetmanager.h"
 
@@ -49,6 +50,9 @@ void ChangeTileAnimation::swap()
 
     TilesetManager::instance()->resetTileAnimations();
     emit mTilesetDocument->tileAnimationChanged(mTile);
+
+    for (MapDocument *mapDocument : mTilesetDocument->mapDocuments())
+        emit mapDocument->tileAnimationChanged(mTile);
 }
 
 } // namespace Internal
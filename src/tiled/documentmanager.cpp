@@ -31,11 +31,15 @@
 #include "mapeditor.h"
 #include "mapformat.h"
 #include "map.h"
+#include "maploader.h"
+#include "maploadingwidget.h"
 #include "maprenderer.h"
 #include "mapscene.h"
 #include "mapview.h"
 #include "noeditorwidget.h"
+#include "objectgroup.h"
 #include "preferences.h"
+#include "templatemanager.h"
 #include "tilesetdocument.h"
 #include "tilesetdocumentsmodel.h"
 #include "tilesetmanager.h"
@@ -121,11 +125,13 @@ DocumentManager::DocumentManager(QObject *parent)
     , mNoEditorWidget(new NoEditorWidget(mWidget))
     , mTabBar(new QTabBar(mWidget))
     , mFileChangedWarning(new FileChangedWarning(mWidget))
+    , mMapLoadingWidget(new MapLoadingWidget(mWidget))
     , mBrokenLinksModel(new BrokenLinksModel(this))
     , mBrokenLinksWidget(new BrokenLinksWidget(mBrokenLinksModel, mWidget))
     , mMapEditor(nullptr) // todo: look into removing this
     , mUndoGroup(new QUndoGroup(this))
     , mFileSystemWatcher(new FileSystemWatcher(this))
+    , mMapLoadsFinished(0)
 {
     mBrokenLinksWidget->setVisible(false);
 
@@ -140,9 +146,14 @@ DocumentManager::DocumentManager(QObject *parent)
     connect(mFileChangedWarning, &FileChangedWarning::reload, this, &DocumentManager::reloadCurrentDocument);
     connect(mFileChangedWarning, &FileChangedWarning::ignore, this, &DocumentManager::hideChangedWarning);
 
+    mMapLoadingWidget->setVisible(false);
+
+    connect(mMapLoadingWidget, &MapLoadingWidget::cancel, this, &DocumentManager::cancelMapLoading);
+
     QVBoxLayout *vertical = new QVBoxLayout(mWidget);
     vertical->addWidget(mTabBar);
     vertical->addWidget(mFileChangedWarning);
+    vertical->addWidget(mMapLoadingWidget);
     vertical->addWidget(mBrokenLinksWidget);
     vertical->setMargin(0);
     vertical->setSpacing(0);
@@ -333,9 +344,15 @@ void DocumentManager::addDocument(Document *document)
     mUndoGroup->addStack(document->undoStack());
 
     if (MapDocument *mapDocument = qobject_cast<MapDocument*>(document)) {
-        for (const SharedTileset &tileset : mapDocument->map()->tilesets())
+        for (const SharedTileset &tileset : mapDocument->map()->tilesets()) {
+            // Tileset images are decoded on demand, but usually they will be
+            // needed as soon as the map is shown
+            tileset->decodeImagesInBackground();
             addToTilesetDocument(tileset, mapDocument);
+        }
     } else if (TilesetDocument *tilesetDocument = qobject_cast<TilesetDocument*>(document)) {
+        tilesetDocument->tileset()->decodeImagesInBackground();
+
         // We may have opened a bare tileset that wasn't seen before
         if (!mTilesetDocumentsModel->contains(tilesetDocument)) {
             mTilesetToDocument.insert(tilesetDocument->tileset(), tilesetDocument);
@@ -382,6 +399,136 @@ void DocumentManager::addDocument(Document *document)
     //    centerViewOn(0, 0);
 }
 
+/**
+ * Starts reading the map \a fileName on a worker thread. Once it has been
+ * read, a MapDocument is created for it and added, after which
+ * mapDocumentLoaded() is emitted. When reading fails, mapLoadError() is
+ * emitted instead.
+ *
+ * Several maps can be loading at the same time. They are added in the order
+ * in which they were requested.
+ */
+void DocumentManager::loadMapInBackground(const QString &fileName, MapFormat *format)
+{
+    // Map readers may look for this instance, which needs to be created on
+    // the GUI thread
+    TemplateManager::instance();
+
+    MapLoader *loader = new MapLoader(fileName, format, this);
+    loader->setCompactTileLayers(Preferences::instance()->compactTileLayers());
+    connect(loader, &MapLoader::finished, this, &DocumentManager::mapLoaderFinished);
+    mMapLoaders.append(loader);
+    loader->start();
+
+    updateMapLoadingWidget();
+}
+
+/**
+ * Returns whether the map \a fileName is currently being loaded in the
+ * background.
+ */
+bool DocumentManager::isLoadingMap(const QString &fileName) const
+{
+    const QString canonicalFilePath = QFileInfo(fileName).canonicalFilePath();
+    if (canonicalFilePath.isEmpty()) // file doesn't exist
+        return false;
+
+    for (const MapLoader *loader : mMapLoaders)
+        if (QFileInfo(loader->fileName()).canonicalFilePath() == canonicalFilePath)
+            return true;
+
+    return false;
+}
+
+/**
+ * Makes the document with the given \a fileName the current one once the
+ * maps that are currently loading have been added. Used to restore the
+ * current document of a session.
+ */
+void DocumentManager::switchToDocumentWhenLoaded(const QString &fileName)
+{
+    const int index = findDocument(fileName);
+    if (index != -1)
+        switchToDocument(index);
+
+    if (!mMapLoaders.isEmpty())
+        mFileToSwitchTo = fileName;
+}
+
+/**
+ * Adds the maps that finished loading, as long as all maps requested before
+ * them have been added as well.
+ */
+void DocumentManager::mapLoaderFinished()
+{
+    while (!mMapLoaders.isEmpty() && mMapLoaders.first()->isFinished()) {
+        MapLoader *loader = mMapLoaders.takeFirst();
+        loader->deleteLater();
+        ++mMapLoadsFinished;
+
+        Map *map = loader->takeMap();
+        if (!map) {
+            emit mapLoadError(loader->fileName(), loader->errorString());
+            continue;
+        }
+
+        MapDocument *mapDocument = MapDocument::fromLoadedMap(map,
+                                                              loader->fileName(),
+                                                              loader->format());
+        addDocument(mapDocument);
+        emit mapDocumentLoaded(mapDocument);
+    }
+
+    if (!mFileToSwitchTo.isEmpty()) {
+        const int index = findDocument(mFileToSwitchTo);
+        if (index != -1)
+            switchToDocument(index);
+    }
+
+    if (mMapLoaders.isEmpty()) {
+        mMapLoadsFinished = 0;
+        mFileToSwitchTo.clear();
+    }
+
+    updateMapLoadingWidget();
+}
+
+/**
+ * Cancels loading all maps that are still being loaded in the background.
+ */
+void DocumentManager::cancelMapLoading()
+{
+    for (MapLoader *loader : mMapLoaders) {
+        loader->cancel();
+        disconnect(loader, &MapLoader::finished, this, &DocumentManager::mapLoaderFinished);
+
+        // The loader needs to stay around until its worker is done with it
+        if (loader->isFinished())
+            loader->deleteLater();
+        else
+            connect(loader, &MapLoader::finished, loader, &QObject::deleteLater);
+    }
+
+    mMapLoaders.clear();
+    mMapLoadsFinished = 0;
+    mFileToSwitchTo.clear();
+
+    updateMapLoadingWidget();
+}
+
+void DocumentManager::updateMapLoadingWidget()
+{
+    if (mMapLoaders.isEmpty()) {
+        mMapLoadingWidget->setVisible(false);
+        return;
+    }
+
+    const int total = mMapLoadsFinished + mMapLoaders.size();
+    mMapLoadingWidget->setProgress(mMapLoadsFinished, total,
+                                   mMapLoaders.first()->fileName());
+    mMapLoadingWidget->setVisible(true);
+}
+
 /**
  * Returns whether the given document has unsaved modifications. For map files
  * with embedded tilesets, that includes checking whether any of the embedded
@@ -610,6 +757,8 @@ bool DocumentManager::reloadDocumentAt(int index)
 
 void DocumentManager::closeAllDocuments()
 {
+    cancelMapLoading();
+
     while (!mDocuments.isEmpty())
         closeCurrentDocument();
 }
@@ -881,6 +1030,15 @@ static bool mayNeedColumnCountAdjustment(const Tileset &tileset)
 
 void DocumentManager::tilesetImagesChanged(Tileset *tileset)
 {
+    // The reloaded images may have a different size
+    for (Document *document : mDocuments) {
+        if (MapDocument *mapDocument = qobject_cast<MapDocument*>(document)) {
+            const auto objectGroups = mapDocument->map()->objectGroups();
+            for (ObjectGroup *objectGroup : objectGroups)
+                objectGroup->tileSizesChanged(tileset);
+        }
+    }
+
     if (!mayNeedColumnCountAdjustment(*tileset))
         return;
 
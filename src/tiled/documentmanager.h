@@ -38,6 +38,7 @@ class QTabBar;
 namespace Tiled {
 
 class FileSystemWatcher;
+class MapFormat;
 
 namespace Internal {
 
@@ -49,6 +50,8 @@ class Editor;
 class FileChangedWarning;
 class MapDocument;
 class MapEditor;
+class MapLoader;
+class MapLoadingWidget;
 class MapScene;
 class MapView;
 class TilesetDocument;
@@ -123,6 +126,10 @@ public:
      */
     void addDocument(Document *document);
 
+    void loadMapInBackground(const QString &fileName, MapFormat *format);
+    bool isLoadingMap(const QString &fileName) const;
+    void switchToDocumentWhenLoaded(const QString &fileName);
+
     bool isDocumentModified(Document *document) const;
     bool isDocumentChangedOnDisk(Document *document) const;
 
@@ -212,6 +219,16 @@ signals:
      */
     void reloadError(const QString &error);
 
+    /**
+     * Emitted when a map loaded in the background has been added.
+     */
+    void mapDocumentLoaded(MapDocument *mapDocument);
+
+    /**
+     * Emitted when an error occurred while loading a map in the background.
+     */
+    void mapLoadError(const QString &fileName, const QString &error);
+
     void tilesetDocumentAdded(TilesetDocument *tilesetDocument);
     void tilesetDocumentRemoved(TilesetDocument *tilesetDocument);
 
@@ -244,6 +261,9 @@ private slots:
 
     void tilesetImagesChanged(Tileset *tileset);
 
+    void mapLoaderFinished();
+    void cancelMapLoading();
+
 private:
     DocumentManager(QObject *parent = nullptr);
     ~DocumentManager();
@@ -253,6 +273,8 @@ private:
     void addToTilesetDocument(const SharedTileset &tileset, MapDocument *mapDocument);
     void removeFromTilesetDocument(const SharedTileset &tileset, MapDocument *mapDocument);
 
+    void updateMapLoadingWidget();
+
     QList<Document*> mDocuments;
     TilesetDocumentsModel *mTilesetDocumentsModel;
 
@@ -260,6 +282,7 @@ private:
     QWidget *mNoEditorWidget;
     QTabBar *mTabBar;
     FileChangedWarning *mFileChangedWarning;
+    MapLoadingWidget *mMapLoadingWidget;
     BrokenLinksModel *mBrokenLinksModel;
     BrokenLinksWidget *mBrokenLinksWidget;
     QStackedLayout *mEditorStack;
@@ -273,6 +296,10 @@ private:
 
     QMap<SharedTileset, TilesetDocument*> mTilesetToDocument;
 
+    QList<MapLoader*> mMapLoaders;
+    int mMapLoadsFinished;
+    QString mFileToSwitchTo;
+
     static DocumentManager *mInstance;
 };
 
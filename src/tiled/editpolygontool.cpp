@@ -448,6 +448,8 @@ void EditPolygonTool::updateSelection(QGraphicsSceneMouseEvent *event)
 
     const QSet<MapObjectItem*> oldSelection = mapScene()->selectedObjectItems();
 
+    mapScene()->createObjectItemsIn(rect);
+
     const auto intersectedItems = mapScene()->items(rect,
                                                     Qt::IntersectsItemShape,
                                                     Qt::DescendingOrder,
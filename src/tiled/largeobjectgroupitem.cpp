@@ -0,0 +1,451 @@
+/*
+ * largeobjectgroupitem.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "largeobjectgroupitem.h"
+
+#include "mapdocument.h"
+#include "mapobject.h"
+#include "mapobjectitem.h"
+#include "maprenderer.h"
+#include "tile.h"
+#include "tilelayer.h"
+
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QtMath>
+
+#include <algorithm>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+// Objects smaller than this on screen, in pixels, are drawn as rectangles
+static const qreal SimplifiedObjectSize = 3;
+
+// Size of the cells in which crowded objects are filled as a whole, in item
+// coordinates. This is done when the cells are smaller than
+// AggregatedCellSize on screen, in pixels, and contain more than
+// AggregatedObjectCount objects.
+static const int CellSize = 256;
+static const qreal AggregatedCellSize = 16;
+static const int AggregatedObjectCount = 16;
+
+/**
+ * Returns the transformation applied to the given \a object, which is
+ * rotated around its position at \a pixelPos.
+ */
+static QTransform objectTransform(const MapObject *object, const QPointF &pixelPos)
+{
+    QTransform transform;
+    if (object->rotation() != 0) {
+        transform.translate(pixelPos.x(), pixelPos.y());
+        transform.rotate(object->rotation());
+        transform.translate(-pixelPos.x(), -pixelPos.y());
+    }
+    return transform;
+}
+
+/**
+ * Returns the bounding rect in pixel coordinates of the given \a rect in
+ * screen coordinates.
+ */
+static QRectF screenToPixelRect(const MapRenderer *renderer, const QRectF &rect)
+{
+    const QPointF corners[] = {
+        renderer->screenToPixelCoords(rect.topLeft()),
+        renderer->screenToPixelCoords(rect.topRight()),
+        renderer->screenToPixelCoords(rect.bottomLeft()),
+        renderer->screenToPixelCoords(rect.bottomRight())
+    };
+
+    QPointF topLeft = corners[0];
+    QPointF bottomRight = corners[0];
+    for (const QPointF &corner : corners) {
+        topLeft.rx() = qMin(topLeft.x(), corner.x());
+        topLeft.ry() = qMin(topLeft.y(), corner.y());
+        bottomRight.rx() = qMax(bottomRight.x(), corner.x());
+        bottomRight.ry() = qMax(bottomRight.y(), corner.y());
+    }
+
+    return QRectF(topLeft, bottomRight);
+}
+
+LargeObjectGroupItem::LargeObjectGroupItem(ObjectGroup *objectGroup,
+                                           MapDocument *mapDocument,
+                                           QGraphicsItem *parent)
+    : ObjectGroupItem(objectGroup, parent)
+    , mMapDocument(mapDocument)
+    , mMargin(0)
+{
+    setFlag(QGraphicsItem::ItemHasNoContents, false);
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+
+    syncWithObjects();
+}
+
+/**
+ * Updates all objects. Should be called when the appearance of all of them
+ * may have changed, for example because the map orientation changed.
+ */
+void LargeObjectGroupItem::syncWithObjects()
+{
+    const QList<MapObject*> &objects = objectGroup()->objects();
+
+    mEntries.clear();
+    mEntries.reserve(objects.size());
+    mTileObjects.clear();
+    mMargin = 0;
+
+    for (MapObject *object : objects)
+        syncEntry(object);
+
+    QRectF boundingRect;
+    for (auto it = mEntries.cbegin(), end = mEntries.cend(); it != end; ++it)
+        if (it.key()->isVisible())
+            boundingRect |= it.value().bounds;
+
+    if (mBoundingRect != boundingRect) {
+        prepareGeometryChange();
+        mBoundingRect = boundingRect;
+    }
+
+    update();
+}
+
+/**
+ * Updates the given \a objects, which may have moved or changed appearance.
+ * Objects that are not part of this group are ignored.
+ */
+void LargeObjectGroupItem::syncWithObjects(const QList<MapObject*> &objects)
+{
+    for (MapObject *object : objects) {
+        auto it = mEntries.find(object);
+        if (it == mEntries.end())
+            continue;
+
+        update(it.value().bounds);
+        syncEntry(object);
+
+        const QRectF &bounds = mEntries[object].bounds;
+        if (object->isVisible())
+            updateBoundingRect(bounds);
+        update(bounds);
+    }
+}
+
+/**
+ * Adds the objects from \a first to \a last, which were inserted into the
+ * object group.
+ */
+void LargeObjectGroupItem::objectsInserted(int first, int last)
+{
+    const QList<MapObject*> &objects = objectGroup()->objects();
+
+    for (int i = first; i <= last; ++i) {
+        MapObject *object = objects.at(i);
+        syncEntry(object);
+
+        const QRectF &bounds = mEntries[object].bounds;
+        if (object->isVisible())
+            updateBoundingRect(bounds);
+        update(bounds);
+    }
+}
+
+/**
+ * Forgets about the given \a objects, which were removed from the object
+ * group. Objects that are not part of this group are ignored.
+ *
+ * The bounding rect is not reduced, since that would require looking at all
+ * remaining objects.
+ */
+void LargeObjectGroupItem::objectsRemoved(const QList<MapObject*> &objects)
+{
+    for (MapObject *object : objects) {
+        auto it = mEntries.find(object);
+        if (it == mEntries.end())
+            continue;
+
+        update(it.value().bounds);
+        mEntries.erase(it);
+        mTileObjects.remove(object);
+        mObjectsWithItem.remove(object);
+    }
+}
+
+/**
+ * Updates the drawing order of the objects from \a first to \a last, which
+ * were moved within the object group.
+ */
+void LargeObjectGroupItem::objectsIndexChanged(int first, int last)
+{
+    const QList<MapObject*> &objects = objectGroup()->objects();
+
+    for (int i = first; i <= last; ++i) {
+        MapObject *object = objects.at(i);
+        syncEntry(object);
+        update(mEntries[object].bounds);
+    }
+}
+
+/**
+ * Returns the objects that may intersect with the given \a rect, in item
+ * coordinates, in the order in which they are stored in the group.
+ */
+QList<MapObject*> LargeObjectGroupItem::candidatesIn(const QRectF &rect) const
+{
+    const MapRenderer *renderer = mMapDocument->renderer();
+    const QRectF pixelRect = screenToPixelRect(renderer, rect);
+    return objectGroup()->objectsIn(pixelRect.adjusted(-mMargin, -mMargin,
+                                                       mMargin, mMargin));
+}
+
+/**
+ * Returns the visible objects whose shape contains the given \a scenePos,
+ * the top-most one first.
+ */
+QList<MapObject*> LargeObjectGroupItem::objectsAt(const QPointF &scenePos) const
+{
+    const MapRenderer *renderer = mMapDocument->renderer();
+    const QPointF pos = mapFromScene(scenePos);
+    const QList<MapObject*> candidates = candidatesIn(QRectF(pos, QSizeF(0, 0)));
+
+    QList<MapObject*> objects;
+
+    // Iterate backwards, so that the sorting below keeps top-most objects first
+    for (auto it = candidates.crbegin(), end = candidates.crend(); it != end; ++it) {
+        MapObject *object = *it;
+        const Entry &entry = mEntries[object];
+        if (!object->isVisible() || !entry.bounds.contains(pos))
+            continue;
+
+        const QPointF pixelPos = renderer->pixelToScreenCoords(object->position());
+        const QTransform transform = objectTransform(object, pixelPos);
+
+        if (renderer->shape(object).contains(transform.inverted().map(pos)))
+            objects.append(object);
+    }
+
+    std::stable_sort(objects.begin(), objects.end(), [this] (MapObject *a, MapObject *b) {
+        return mEntries[a].z > mEntries[b].z;
+    });
+
+    return objects;
+}
+
+/**
+ * Returns the visible objects whose bounds intersect with the given
+ * \a sceneRect.
+ */
+QList<MapObject*> LargeObjectGroupItem::objectsIn(const QRectF &sceneRect) const
+{
+    const QRectF rect = mapRectFromScene(sceneRect);
+
+    QList<MapObject*> objects;
+
+    const QList<MapObject*> candidates = candidatesIn(rect);
+    for (MapObject *object : candidates)
+        if (object->isVisible() && mEntries[object].bounds.intersects(rect))
+            objects.append(object);
+
+    return objects;
+}
+
+/**
+ * Sets whether the given \a object is currently displayed by a MapObjectItem,
+ * in which case this item does not draw it.
+ */
+void LargeObjectGroupItem::setObjectHasItem(MapObject *object, bool hasItem)
+{
+    if (hasItem)
+        mObjectsWithItem.insert(object);
+    else
+        mObjectsWithItem.remove(object);
+
+    auto it = mEntries.find(object);
+    if (it != mEntries.end())
+        update(it.value().bounds);
+}
+
+/**
+ * Repaints the objects showing any of the given animated \a tiles.
+ */
+void LargeObjectGroupItem::repaintTiles(const QSet<const Tile*> &tiles)
+{
+    for (MapObject *object : mTileObjects)
+        if (object->isVisible() && tiles.contains(object->cell().tile()))
+            update(mEntries[object].bounds);
+}
+
+QRectF LargeObjectGroupItem::boundingRect() const
+{
+    return mBoundingRect;
+}
+
+void LargeObjectGroupItem::paint(QPainter *painter,
+                                 const QStyleOptionGraphicsItem *option,
+                                 QWidget *)
+{
+    MapRenderer *renderer = mMapDocument->renderer();
+
+    const qreal scale = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    renderer->setPainterScale(scale);
+
+    const QRectF &exposed = option->exposedRect;
+    const QList<MapObject*> candidates = candidatesIn(exposed);
+
+    QVector<MapObject*> objects;
+    objects.reserve(candidates.size());
+
+    for (MapObject *object : candidates) {
+        if (!object->isVisible() || mObjectsWithItem.contains(object))
+            continue;
+        if (mEntries[object].bounds.intersects(exposed))
+            objects.append(object);
+    }
+
+    if (CellSize * scale < AggregatedCellSize) {
+        // Fill crowded cells as a whole, since their objects would be too
+        // small to tell apart anyway. Objects are put in the cell containing
+        // their center, unless they are larger than a cell.
+        auto cellOf = [] (const QRectF &bounds) {
+            const QPointF center = bounds.center();
+            return QPoint(qFloor(center.x() / CellSize),
+                          qFloor(center.y() / CellSize));
+        };
+        auto isSmall = [] (const QRectF &bounds) {
+            return bounds.width() <= CellSize && bounds.height() <= CellSize;
+        };
+
+        QHash<QPoint, int> objectCounts;
+        for (MapObject *object : objects) {
+            const QRectF &bounds = mEntries[object].bounds;
+            if (isSmall(bounds))
+                ++objectCounts[cellOf(bounds)];
+        }
+
+        QHash<QPoint, QRectF> crowdedCells;
+        QHash<QPoint, QColor> crowdedCellColors;
+
+        auto it = std::remove_if(objects.begin(), objects.end(), [&] (MapObject *object) {
+            const Entry &entry = mEntries[object];
+            if (!isSmall(entry.bounds))
+                return false;
+
+            const QPoint cell = cellOf(entry.bounds);
+            if (objectCounts.value(cell) <= AggregatedObjectCount)
+                return false;
+
+            QRectF &cellBounds = crowdedCells[cell];
+            cellBounds |= entry.bounds;
+            if (!crowdedCellColors.contains(cell))
+                crowdedCellColors.insert(cell, entry.color);
+            return true;
+        });
+        objects.erase(it, objects.end());
+
+        painter->save();
+        painter->setPen(Qt::NoPen);
+
+        for (auto cell = crowdedCells.cbegin(), end = crowdedCells.cend(); cell != end; ++cell) {
+            QColor color = crowdedCellColors.value(cell.key());
+            color.setAlpha(128);
+            painter->fillRect(cell.value(), color);
+        }
+
+        painter->restore();
+    }
+
+    std::stable_sort(objects.begin(), objects.end(), [this] (MapObject *a, MapObject *b) {
+        return mEntries[a].z < mEntries[b].z;
+    });
+
+    for (MapObject *object : objects) {
+        const Entry &entry = mEntries[object];
+
+        const QSizeF screenSize = entry.bounds.size() * scale;
+        if (qMax(screenSize.width(), screenSize.height()) < SimplifiedObjectSize) {
+            painter->fillRect(entry.bounds, entry.color);
+            continue;
+        }
+
+        const QPointF pixelPos = renderer->pixelToScreenCoords(object->position());
+
+        if (object->rotation() != 0) {
+            painter->save();
+            painter->setTransform(objectTransform(object, pixelPos), true);
+            renderer->drawMapObject(painter, object, entry.color);
+            painter->restore();
+        } else {
+            renderer->drawMapObject(painter, object, entry.color);
+        }
+    }
+}
+
+/**
+ * Updates the entry of the given \a object.
+ *
+ * The spatial index of the object group is in pixel coordinates, and its
+ * bounds of an object contain at least the pixel bounds of the object and
+ * its polygon. The object may be drawn outside of these bounds, for example
+ * because of its tile image or the outline. The largest such overhang is
+ * remembered as the margin by which queries of the index are extended.
+ */
+void LargeObjectGroupItem::syncEntry(MapObject *object)
+{
+    const MapRenderer *renderer = mMapDocument->renderer();
+
+    const QPointF pixelPos = renderer->pixelToScreenCoords(object->position());
+
+    Entry &entry = mEntries[object];
+    entry.bounds = objectTransform(object, pixelPos).mapRect(renderer->boundingRect(object));
+    entry.color = MapObjectItem::objectColor(object);
+
+    if (objectGroup()->drawOrder() == ObjectGroup::TopDownOrder)
+        entry.z = pixelPos.y();
+    else
+        entry.z = 0;    // Sorting is stable, so the index order remains
+
+    QRectF pixelBounds = object->bounds().normalized();
+    if (!object->polygon().isEmpty())
+        pixelBounds |= object->polygon().boundingRect().translated(object->position());
+
+    const QRectF drawnBounds = screenToPixelRect(renderer, entry.bounds);
+    mMargin = std::max({ mMargin,
+                         pixelBounds.left() - drawnBounds.left(),
+                         drawnBounds.right() - pixelBounds.right(),
+                         pixelBounds.top() - drawnBounds.top(),
+                         drawnBounds.bottom() - pixelBounds.bottom() });
+
+    const Tile *tile = object->cell().tile();
+    if (tile && tile->isAnimated())
+        mTileObjects.insert(object);
+    else
+        mTileObjects.remove(object);
+}
+
+void LargeObjectGroupItem::updateBoundingRect(const QRectF &bounds)
+{
+    const QRectF boundingRect = mBoundingRect | bounds;
+    if (mBoundingRect != boundingRect) {
+        prepareGeometryChange();
+        mBoundingRect = boundingRect;
+    }
+}
@@ -0,0 +1,98 @@
+/*
+ * largeobjectgroupitem.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "objectgroupitem.h"
+
+#include <QColor>
+#include <QHash>
+#include <QSet>
+
+namespace Tiled {
+
+class MapObject;
+class Tile;
+
+namespace Internal {
+
+class MapDocument;
+
+/**
+ * A graphics item for object groups with many objects. Rather than having a
+ * MapObjectItem for each object, it draws the objects itself, looking up the
+ * ones in the exposed area through the spatial index of the object group.
+ *
+ * MapObjectItems are still used for the objects that are selected or under
+ * the mouse, so that the tools can interact with them. These objects are
+ * skipped when drawing the group.
+ *
+ * When zoomed out far, small objects are drawn as plain rectangles and
+ * crowded areas are filled as a whole.
+ */
+class LargeObjectGroupItem : public ObjectGroupItem
+{
+public:
+    LargeObjectGroupItem(ObjectGroup *objectGroup,
+                         MapDocument *mapDocument,
+                         QGraphicsItem *parent = nullptr);
+
+    void syncWithObjects();
+    void syncWithObjects(const QList<MapObject*> &objects);
+
+    void objectsInserted(int first, int last);
+    void objectsRemoved(const QList<MapObject*> &objects);
+    void objectsIndexChanged(int first, int last);
+
+    QList<MapObject*> objectsAt(const QPointF &scenePos) const;
+    QList<MapObject*> objectsIn(const QRectF &sceneRect) const;
+
+    void setObjectHasItem(MapObject *object, bool hasItem);
+
+    void repaintTiles(const QSet<const Tile*> &tiles);
+
+    // QGraphicsItem
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter,
+               const QStyleOptionGraphicsItem *option,
+               QWidget *widget = nullptr) override;
+
+private:
+    struct Entry
+    {
+        QRectF bounds;      // Bounds in item coordinates, including rotation
+        qreal z;            // Used for sorting when drawing
+        QColor color;
+    };
+
+    void syncEntry(MapObject *object);
+    QList<MapObject*> candidatesIn(const QRectF &rect) const;
+    void updateBoundingRect(const QRectF &bounds);
+
+    MapDocument *mMapDocument;
+    QHash<MapObject*, Entry> mEntries;
+    QSet<MapObject*> mTileObjects;      // Objects showing animated tiles
+    QSet<MapObject*> mObjectsWithItem;
+    QRectF mBoundingRect;
+    qreal mMargin;                      // See syncEntry()
+};
+
+} // namespace Internal
+} // namespace Tiled
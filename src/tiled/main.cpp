@@ -21,24 +21,41 @@
  */
 
 #include "commandlineparser.h"
+#include "imagereference.h"
 #include "languagemanager.h"
 #include "mainwindow.h"
 #include "mapdocument.h"
 #include "mapformat.h"
 #include "mapreader.h"
+#include "mapwriter.h"
+#include "parallel.h"
 #include "pluginmanager.h"
 #include "preferences.h"
 #include "sparkleautoupdater.h"
 #include "standardautoupdater.h"
 #include "stylehelper.h"
+#include "templategroup.h"
+#include "templatemanager.h"
 #include "tiledapplication.h"
 #include "tileset.h"
+#include "tilesetformat.h"
+#include "tilesetmanager.h"
+#include "tmxmapformat.h"
 #include "winsparkleautoupdater.h"
 
+#include <QAtomicInt>
 #include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
 #include <QFileInfo>
+#include <QHash>
 #include <QJsonArray>
 #include <QJsonDocument>
+#include <QMutex>
+#include <QRegularExpression>
+#include <QSet>
+#include <QTextStream>
+#include <QThread>
 #include <QtPlugin>
 
 #ifdef Q_OS_WIN
@@ -67,6 +84,7 @@ public:
     bool showedVersion;
     bool disableOpenGL;
     bool exportMap;
+    bool exportMaps;
     bool newInstance;
 
 private:
@@ -74,6 +92,7 @@ private:
     void justQuit();
     void setDisableOpenGL();
     void setExportMap();
+    void setExportMaps();
     void showExportFormats();
     void startNewInstance();
 
@@ -98,6 +117,7 @@ CommandLineHandler::CommandLineHandler()
     , showedVersion(false)
     , disableOpenGL(false)
     , exportMap(false)
+    , exportMaps(false)
     , newInstance(false)
 {
     option<&CommandLineHandler::showVersion>(
@@ -120,6 +140,11 @@ CommandLineHandler::CommandLineHandler()
                 QLatin1String("--export-map"),
                 tr("Export the specified tmx file to target"));
 
+    option<&CommandLineHandler::setExportMaps>(
+                QChar(),
+                QLatin1String("--export-maps"),
+                tr("Export many tmx files to a target directory"));
+
     option<&CommandLineHandler::showExportFormats>(
                 QChar(),
                 QLatin1String("--export-formats"),
@@ -156,6 +181,11 @@ void CommandLineHandler::setExportMap()
     exportMap = true;
 }
 
+void CommandLineHandler::setExportMaps()
+{
+    exportMaps = true;
+}
+
 void CommandLineHandler::showExportFormats()
 {
     PluginManager::instance()->loadPlugins();
@@ -176,6 +206,402 @@ void CommandLineHandler::startNewInstance()
 }
 
 
+/**
+ * The number of maps per processor core that are kept in memory at a time
+ * during a batch export.
+ */
+static const int ExportBatchSizePerCore = 4;
+
+static MapFormat *findWritableMapFormat(const QString &shortName)
+{
+    const auto formats = PluginManager::objects<MapFormat>();
+    for (MapFormat *format : formats) {
+        if (!format->hasCapabilities(MapFormat::Write))
+            continue;
+        if (format->shortName().compare(shortName, Qt::CaseInsensitive) == 0)
+            return format;
+    }
+    return nullptr;
+}
+
+/**
+ * Returns the first file extension from the name filter of \a format.
+ */
+static QString fileExtension(const MapFormat *format)
+{
+    static const QRegularExpression extension(QLatin1String("\\*\\.([^\\s\\)]+)"));
+
+    const QRegularExpressionMatch match = extension.match(format->nameFilter());
+    if (match.hasMatch())
+        return match.captured(1);
+
+    return format->shortName();
+}
+
+/**
+ * Returns the file in \a dir to which the map \a fileName is exported.
+ */
+static QString exportTargetFile(const QDir &dir,
+                                const QString &fileName,
+                                const QString &suffix)
+{
+    return dir.filePath(QFileInfo(fileName).completeBaseName() +
+                        QLatin1Char('.') + suffix);
+}
+
+/**
+ * Checks that no two of the given maps would be exported to the same file,
+ * which happens when maps in different directories have the same name.
+ */
+static bool checkExportTargets(const QDir &dir,
+                               const QString &suffix,
+                               const QStringList &fileNames)
+{
+    QHash<QString, QString> mapOfTarget;
+
+    for (const QString &fileName : fileNames) {
+        const QString targetFile = exportTargetFile(dir, fileName, suffix);
+        const QString previous = mapOfTarget.value(targetFile);
+
+        if (!previous.isEmpty()) {
+            qWarning().noquote() << QCoreApplication::translate("Command line", "Both %1 and %2 would be exported to %3")
+                                    .arg(previous, fileName, targetFile);
+            return false;
+        }
+
+        mapOfTarget.insert(targetFile, fileName);
+    }
+
+    return true;
+}
+
+/**
+ * Prints the given \a message to the standard output. Used for reporting
+ * progress, as opposed to warnings and errors.
+ */
+static void printMessage(const QString &message)
+{
+    QTextStream out(stdout);
+    out << message << QLatin1Char('\n');
+}
+
+/**
+ * Expands the files given to --export-maps. An argument starting with '@'
+ * names a file that lists one map per line, and wildcards in the file name
+ * part of an argument are matched against the files in its directory.
+ */
+static bool expandMapFiles(const QStringList &arguments, QStringList &fileNames)
+{
+    for (const QString &argument : arguments) {
+        if (argument.startsWith(QLatin1Char('@'))) {
+            QFile file(argument.mid(1));
+            if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+                qWarning().noquote() << QCoreApplication::translate("Command line", "Failed to read map list %1: %2")
+                                        .arg(file.fileName(), file.errorString());
+                return false;
+            }
+
+            QTextStream stream(&file);
+            stream.setCodec("UTF-8");
+            while (!stream.atEnd()) {
+                const QString line = stream.readLine().trimmed();
+                if (!line.isEmpty() && !line.startsWith(QLatin1Char('#')))
+                    fileNames.append(line);
+            }
+        } else if (argument.contains(QLatin1Char('*')) || argument.contains(QLatin1Char('?'))) {
+            const QFileInfo fileInfo(argument);
+            const QDir dir = fileInfo.dir();
+            const QStringList matches = dir.entryList(QStringList(fileInfo.fileName()),
+                                                      QDir::Files, QDir::Name);
+            for (const QString &match : matches)
+                fileNames.append(dir.filePath(match));
+        } else {
+            fileNames.append(argument);
+        }
+    }
+
+    return true;
+}
+
+namespace {
+
+/**
+ * The external tilesets loaded during a batch export, shared by all maps.
+ * Can be used from several threads at once. A tileset is read while holding
+ * the lock, so that each tileset is only read once.
+ */
+class ExportTilesetCache
+{
+public:
+    SharedTileset load(const QString &fileName, QString *error);
+
+private:
+    struct Entry
+    {
+        SharedTileset tileset;
+        QString error;
+    };
+
+    QMutex mMutex;
+    QHash<QString, Entry> mEntries;
+};
+
+SharedTileset ExportTilesetCache::load(const QString &fileName, QString *error)
+{
+    QMutexLocker locker(&mMutex);
+
+    auto it = mEntries.find(fileName);
+    if (it == mEntries.end()) {
+        Entry entry;
+        entry.tileset = Tiled::readTileset(fileName, &entry.error);
+        it = mEntries.insert(fileName, entry);
+    }
+
+    if (error)
+        *error = it->error;
+    return it->tileset;
+}
+
+/**
+ * A map reader that can be used on several threads at once during a batch
+ * export. External tilesets come from the shared ExportTilesetCache.
+ * Template groups are left as placeholders, since they can only be loaded
+ * on the main thread.
+ */
+class ExportMapReader : public MapReader
+{
+public:
+    explicit ExportMapReader(ExportTilesetCache &tilesets)
+        : mTilesets(tilesets)
+    {}
+
+protected:
+    SharedTileset readExternalTileset(const QString &source,
+                                      QString *error) override
+    {
+        return mTilesets.load(source, error);
+    }
+
+    TemplateGroup *loadTemplateGroup(const QString &, QString *) override
+    {
+        return nullptr;
+    }
+
+private:
+    ExportTilesetCache &mTilesets;
+};
+
+struct ExportJob
+{
+    ExportJob()
+        : map(nullptr)
+        , elapsed(0)
+    {}
+
+    QString fileName;
+    Map *map;
+    QString error;
+    qint64 elapsed;
+};
+
+} // anonymous namespace
+
+/**
+ * Loads the template groups of \a map through the TemplateManager, which
+ * keeps them around for the following maps.
+ */
+static void loadTemplateGroups(Map *map)
+{
+    TemplateManager *templateManager = TemplateManager::instance();
+
+    const auto templateGroups = map->templateGroups();
+    for (TemplateGroup *placeholder : templateGroups) {
+        if (placeholder->loaded())
+            continue;
+
+        QString error;
+        TemplateGroup *templateGroup =
+                templateManager->loadTemplateGroup(placeholder->fileName(), &error);
+
+        if (templateGroup) {
+            map->replaceTemplateGroup(placeholder, templateGroup);
+            delete placeholder;
+        }
+    }
+}
+
+/**
+ * Exports the given maps, reporting the result and time taken for each of
+ * them.
+ *
+ * The maps are handled in batches, to bound the memory used. The maps of a
+ * batch are read in parallel, sharing their external tilesets through an
+ * ExportTilesetCache. Their template groups are then loaded on the main
+ * thread. Finally the maps are written, in parallel for the TMX format. Other
+ * formats store the error of the last write in the format instance and may
+ * not expect to be used from other threads, so they are written one after
+ * the other on the main thread.
+ */
+static int exportMapsInBatches(MapFormat *format,
+                               const QString &targetDirectory,
+                               const QStringList &fileNames)
+{
+    const QDir dir(targetDirectory);
+    const QString suffix = fileExtension(format);
+    const bool isTmx = qobject_cast<TmxMapFormat*>(format) != nullptr;
+    const bool dtdEnabled = Preferences::instance()->dtdEnabled();
+
+    ExportTilesetCache tilesetCache;
+    TilesetManager *tilesetManager = TilesetManager::instance();
+    QSet<SharedTileset> sharedTilesets;
+
+    QMutex outputMutex;
+    QAtomicInt failures(0);
+
+    auto writeMap = [&] (const ExportJob &job) {
+        QElapsedTimer timer;
+        timer.start();
+
+        const QString targetFile = exportTargetFile(dir, job.fileName, suffix);
+        bool written;
+        QString error;
+
+        if (isTmx) {
+            // Same as TmxMapFormat::write, except that the error is not
+            // stored in the shared format instance
+            MapWriter writer;
+            writer.setDtdEnabled(dtdEnabled);
+            written = writer.writeMap(job.map, targetFile);
+            error = writer.errorString();
+        } else {
+            written = format->write(job.map, targetFile);
+            error = format->errorString();
+        }
+
+        if (!written) {
+            qWarning().noquote() << QCoreApplication::translate("Command line", "Failed to export %1: %2")
+                                    .arg(job.fileName, error);
+            failures.ref();
+            return;
+        }
+
+        QMutexLocker locker(&outputMutex);
+        printMessage(QCoreApplication::translate("Command line", "Exported %1 to %2 in %3 ms")
+                     .arg(job.fileName, targetFile)
+                     .arg(job.elapsed + timer.elapsed()));
+    };
+
+    const int batchSize = qMax(1, QThread::idealThreadCount()) * ExportBatchSizePerCore;
+
+    for (int first = 0; first < fileNames.size(); first += batchSize) {
+        QVector<ExportJob> jobs(qMin(batchSize, fileNames.size() - first));
+        ExportJob *jobsData = jobs.data();
+
+        parallelFor(jobs.size(), [&] (int index) {
+            ExportJob &job = jobsData[index];
+            job.fileName = fileNames.at(first + index);
+
+            QElapsedTimer timer;
+            timer.start();
+
+            ExportMapReader reader(tilesetCache);
+            job.map = reader.readMap(job.fileName);
+            if (!job.map)
+                job.error = reader.errorString();
+
+            job.elapsed = timer.elapsed();
+        });
+
+        for (ExportJob &job : jobs) {
+            if (!job.map) {
+                qWarning().noquote() << QCoreApplication::translate("Command line", "Failed to load %1: %2")
+                                        .arg(job.fileName, job.error);
+                failures.ref();
+                continue;
+            }
+
+            // Make the tilesets known to the TilesetManager, so that the
+            // templates referring to them use the same instances
+            for (const SharedTileset &tileset : job.map->tilesets()) {
+                if (tileset->isExternal() && !sharedTilesets.contains(tileset)) {
+                    tilesetManager->addReference(tileset);
+                    sharedTilesets.insert(tileset);
+                }
+            }
+
+            QElapsedTimer timer;
+            timer.start();
+            loadTemplateGroups(job.map);
+            job.elapsed += timer.elapsed();
+        }
+
+        if (isTmx) {
+            parallelFor(jobs.size(), [&] (int index) {
+                if (jobsData[index].map)
+                    writeMap(jobsData[index]);
+            });
+        } else {
+            for (const ExportJob &job : jobs)
+                if (job.map)
+                    writeMap(job);
+        }
+
+        for (const ExportJob &job : jobs)
+            delete job.map;
+    }
+
+    for (const SharedTileset &tileset : sharedTilesets)
+        tilesetManager->removeReference(tileset);
+
+    return failures.load() > 0 ? 1 : 0;
+}
+
+/**
+ * Handles --export-maps <format> <target directory> <files...>, which exports
+ * many maps without starting Tiled for each of them.
+ */
+static int exportMaps(const QStringList &arguments)
+{
+    if (arguments.size() < 3) {
+        qWarning().noquote() << QCoreApplication::translate("Command line", "Export syntax is --export-maps <format> <target directory> <tmx files or @list files...>");
+        return 1;
+    }
+
+    const QString &formatName = arguments.at(0);
+    const QString &targetDirectory = arguments.at(1);
+
+    MapFormat *format = findWritableMapFormat(formatName);
+    if (!format) {
+        qWarning().noquote() << QCoreApplication::translate("Command line", "Format not recognized (see --export-formats)");
+        return 1;
+    }
+
+    QStringList fileNames;
+    if (!expandMapFiles(arguments.mid(2), fileNames))
+        return 1;
+
+    fileNames.removeDuplicates();
+
+    if (!checkExportTargets(QDir(targetDirectory), fileExtension(format), fileNames))
+        return 1;
+
+    if (!QDir().mkpath(targetDirectory)) {
+        qWarning().noquote() << QCoreApplication::translate("Command line", "Failed to create target directory %1")
+                                .arg(targetDirectory);
+        return 1;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const int exitCode = exportMapsInBatches(format, targetDirectory, fileNames);
+
+    printMessage(QCoreApplication::translate("Command line", "Processed %n map(s) in %1 ms", nullptr, fileNames.size())
+                 .arg(timer.elapsed()));
+
+    return exitCode;
+}
+
 int main(int argc, char *argv[])
 {
 #if defined(Q_OS_WIN) && (!defined(Q_CC_MINGW) || __MINGW32_MAJOR_VERSION >= 5)
@@ -225,6 +651,10 @@ int main(int argc, char *argv[])
 
     PluginManager::instance()->loadPlugins();
 
+    // Exporting maps from the command line does not need the tile pixels
+    if (commandLine.exportMap || commandLine.exportMaps)
+        setImageLoadingMode(SkipImages);
+
     if (commandLine.exportMap) {
         // Get the path to the source file and target file
         if (commandLine.filesToOpen().length() < 2) {
@@ -241,14 +671,7 @@ int main(int argc, char *argv[])
 
         if (filter) {
             // Find the map format supporting the given filter
-            for (MapFormat *format : formats) {
-                if (!format->hasCapabilities(MapFormat::Write))
-                    continue;
-                if (format->shortName().compare(*filter, Qt::CaseInsensitive) == 0) {
-                    chosenFormat = format;
-                    break;
-                }
-            }
+            chosenFormat = findWritableMapFormat(*filter);
             if (!chosenFormat) {
                 qWarning().noquote() << QCoreApplication::translate("Command line", "Format not recognized (see --export-formats)");
                 return 1;
@@ -291,6 +714,9 @@ int main(int argc, char *argv[])
         return 0;
     }
 
+    if (commandLine.exportMaps)
+        return exportMaps(commandLine.filesToOpen());
+
     if (!commandLine.filesToOpen().isEmpty() && !commandLine.newInstance) {
         // Convert files to absolute paths because the already running Tiled
         // instance likely does not have the same working directory.
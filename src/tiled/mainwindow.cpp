@@ -417,6 +417,10 @@ MainWindow::MainWindow(QWidget *parent, Qt::WindowFlags flags)
             this, SLOT(closeDocument(int)));
     connect(mDocumentManager, SIGNAL(reloadError(QString)),
             this, SLOT(reloadError(QString)));
+    connect(mDocumentManager, &DocumentManager::mapDocumentLoaded,
+            this, &MainWindow::mapDocumentLoaded);
+    connect(mDocumentManager, &DocumentManager::mapLoadError,
+            this, &MainWindow::mapLoadError);
 
     QShortcut *switchToLeftDocument = new QShortcut(tr("Alt+Left"), this);
     connect(switchToLeftDocument, SIGNAL(activated()),
@@ -585,6 +589,9 @@ bool MainWindow::openFile(const QString &fileName, FileFormat *fileFormat)
         return true;
     }
 
+    if (mDocumentManager->isLoadingMap(fileName))
+        return true;
+
     if (!fileFormat) {
         // Try to find a plugin that implements support for this format
         const auto formats = PluginManager::objects<FileFormat>();
@@ -601,12 +608,16 @@ bool MainWindow::openFile(const QString &fileName, FileFormat *fileFormat)
         return false;
     }
 
+    if (MapFormat *mapFormat = qobject_cast<MapFormat*>(fileFormat)) {
+        // Continued in mapDocumentLoaded or mapLoadError
+        mDocumentManager->loadMapInBackground(fileName, mapFormat);
+        return true;
+    }
+
     QString error;
     Document *document = nullptr;
 
-    if (MapFormat *mapFormat = qobject_cast<MapFormat*>(fileFormat)) {
-        document = MapDocument::load(fileName, mapFormat, &error);
-    } else if (TilesetFormat *tilesetFormat = qobject_cast<TilesetFormat*>(fileFormat)) {
+    if (TilesetFormat *tilesetFormat = qobject_cast<TilesetFormat*>(fileFormat)) {
         // It could be, that we have already loaded this tileset while loading some map.
         if (TilesetDocument *tilesetDocument = mDocumentManager->findTilesetDocument(fileName)) {
             document = tilesetDocument;
@@ -622,38 +633,50 @@ bool MainWindow::openFile(const QString &fileName, FileFormat *fileFormat)
 
     mDocumentManager->addDocument(document);
 
-    if (MapDocument *mapDocument = qobject_cast<MapDocument*>(document)) {
-        mDocumentManager->checkTilesetColumns(mapDocument);
-
-        // When opening a map using new template groups, ask whether to load it into Tiled or not.
-        bool embedTemplateGroups = false;
-        for (auto templateGroup : mapDocument->map()->templateGroups()) {
-            if (!templateGroup->embedded()) {
-                const QMessageBox::StandardButton reply = QMessageBox::question(
-                    this,
-                    tr("Load Template Groups"),
-                    tr("Some Template Groups used in this map aren't loaded into Tiled. Would you like to load them?"),
-                    QMessageBox::Yes | QMessageBox::No,
-                    QMessageBox::Yes);
-                embedTemplateGroups = reply == QMessageBox::Yes;
-                break;
-            }
+    Preferences::instance()->addRecentFile(fileName);
+    return true;
+}
+
+/**
+ * Finishes opening a map that was loaded in the background.
+ */
+void MainWindow::mapDocumentLoaded(MapDocument *mapDocument)
+{
+    mDocumentManager->checkTilesetColumns(mapDocument);
+
+    // When opening a map using new template groups, ask whether to load it into Tiled or not.
+    bool embedTemplateGroups = false;
+    for (auto templateGroup : mapDocument->map()->templateGroups()) {
+        if (!templateGroup->embedded()) {
+            const QMessageBox::StandardButton reply = QMessageBox::question(
+                this,
+                tr("Load Template Groups"),
+                tr("Some Template Groups used in this map aren't loaded into Tiled. Would you like to load them?"),
+                QMessageBox::Yes | QMessageBox::No,
+                QMessageBox::Yes);
+            embedTemplateGroups = reply == QMessageBox::Yes;
+            break;
         }
+    }
 
-        auto model = ObjectTemplateModel::instance();
-        for (auto templateGroup : mapDocument->map()->templateGroups()) {
-            if (!templateGroup->embedded()) {
-                if (embedTemplateGroups) {
-                    model->addTemplateGroup(templateGroup);
-                } else {
-                    mapDocument->addNonEmbeddedTemplateGroup(templateGroup);
-                }
+    auto model = ObjectTemplateModel::instance();
+    for (auto templateGroup : mapDocument->map()->templateGroups()) {
+        if (!templateGroup->embedded()) {
+            if (embedTemplateGroups) {
+                model->addTemplateGroup(templateGroup);
+            } else {
+                mapDocument->addNonEmbeddedTemplateGroup(templateGroup);
             }
         }
     }
 
-    Preferences::instance()->addRecentFile(fileName);
-    return true;
+    Preferences::instance()->addRecentFile(mapDocument->fileName());
+}
+
+void MainWindow::mapLoadError(const QString &fileName, const QString &error)
+{
+    QMessageBox::critical(this, tr("Error Opening File"),
+                          tr("%1:\n\n%2").arg(fileName, error));
 }
 
 bool MainWindow::openFile(const QString &fileName)
@@ -685,9 +708,7 @@ void MainWindow::openLastFiles()
 
     QString lastActiveDocument =
             mSettings.value(QLatin1String("lastActive")).toString();
-    int documentIndex = mDocumentManager->findDocument(lastActiveDocument);
-    if (documentIndex != -1)
-        mDocumentManager->switchToDocument(documentIndex);
+    mDocumentManager->switchToDocumentWhenLoaded(lastActiveDocument);
 
     mSettings.endGroup();
 }
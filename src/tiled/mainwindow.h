@@ -52,6 +52,7 @@ namespace Internal {
 class ActionManager;
 class AutomappingManager;
 class DocumentManager;
+class MapDocument;
 class MapDocumentActionHandler;
 class MapScene;
 class MapView;
@@ -84,7 +85,10 @@ public:
      * When a \a format is given, it is used to open the file. Otherwise, a
      * format is searched using MapFormat::supportsFile.
      *
-     * @return whether the file was successfully opened
+     * Maps are loaded in the background, in which case this function returns
+     * before the map has been opened.
+     *
+     * @return whether the file was successfully opened, or started loading
      */
     bool openFile(const QString &fileName, FileFormat *fileFormat);
 
@@ -157,6 +161,8 @@ private slots:
     void closeDocument(int index);
 
     void reloadError(const QString &error);
+    void mapDocumentLoaded(MapDocument *mapDocument);
+    void mapLoadError(const QString &fileName, const QString &error);
     void autoMappingError(bool automatic);
     void autoMappingWarning(bool automatic);
 
@@ -70,6 +70,20 @@
 using namespace Tiled;
 using namespace Tiled::Internal;
 
+/**
+ * Switches the given tile layer, or the tile layers within the given group
+ * layer, to compact storage.
+ */
+static void makeTileLayersCompact(Layer *layer)
+{
+    if (TileLayer *tileLayer = layer->asTileLayer()) {
+        tileLayer->setCompact(true);
+    } else if (GroupLayer *groupLayer = layer->asGroupLayer()) {
+        for (Layer *childLayer : groupLayer->layers())
+            makeTileLayersCompact(childLayer);
+    }
+}
+
 MapDocument::MapDocument(Map *map, const QString &fileName)
     : Document(MapDocumentType, fileName)
     , mMap(map)
@@ -79,6 +93,11 @@ MapDocument::MapDocument(Map *map, const QString &fileName)
 {
     mCurrentObject = map;
 
+    if (Preferences::instance()->compactTileLayers()) {
+        for (Layer *layer : map->layers())
+            makeTileLayersCompact(layer);
+    }
+
     createRenderer();
 
     mCurrentLayer = (map->layerCount() == 0) ? nullptr : map->layerAt(0);
@@ -179,6 +198,13 @@ MapDocument *MapDocument::load(const QString &fileName,
         return nullptr;
     }
 
+    return fromLoadedMap(map, fileName, format);
+}
+
+MapDocument *MapDocument::fromLoadedMap(Map *map,
+                                        const QString &fileName,
+                                        MapFormat *format)
+{
     MapDocument *document = new MapDocument(map, fileName);
     document->setReaderFormat(format);
     if (format->hasCapabilities(MapFormat::Write))
@@ -877,6 +903,9 @@ void MapDocument::onObjectsMoved(const QModelIndex &parent, int start, int end,
 
 void MapDocument::onLayerAdded(Layer *layer)
 {
+    if (Preferences::instance()->compactTileLayers())
+        makeTileLayersCompact(layer);
+
     emit layerAdded(layer);
 
     // Select the first layer that gets added to the map
@@ -87,6 +87,14 @@ public:
                              MapFormat *format,
                              QString *error = nullptr);
 
+    /**
+     * Creates a MapDocument for a \a map that was read from \a fileName
+     * using the given \a format.
+     */
+    static MapDocument *fromLoadedMap(Map *map,
+                                      const QString &fileName,
+                                      MapFormat *format);
+
     QString lastExportFileName() const;
     void setLastExportFileName(const QString &fileName);
 
@@ -290,6 +298,7 @@ signals:
     void tilesetTileOffsetChanged(Tileset *tileset);
     void tileTypeChanged(Tile *tile);
     void tileImageSourceChanged(Tile *tile);
+    void tileAnimationChanged(Tile *tile);
 
 private slots:
     void onObjectsRemoved(const QList<MapObject*> &objects);
@@ -0,0 +1,256 @@
+/*
+ * maploader.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "maploader.h"
+
+#include "map.h"
+#include "mapformat.h"
+#include "mapreader.h"
+#include "templategroup.h"
+#include "templatemanager.h"
+#include "tilelayer.h"
+#include "tileset.h"
+#include "tilesetmanager.h"
+#include "tmxmapformat.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QRunnable>
+#include <QThreadPool>
+
+namespace Tiled {
+namespace Internal {
+
+class MapLoaderTask : public QRunnable
+{
+public:
+    MapLoaderTask(MapLoader *loader, void (MapLoader::*step)())
+        : mLoader(loader)
+        , mStep(step)
+    {}
+
+    void run() override
+    {
+        (mLoader->*mStep)();
+    }
+
+private:
+    MapLoader *mLoader;
+    void (MapLoader::*mStep)();
+};
+
+/**
+ * Returns the mutex serializing the reads through the given \a format, which
+ * stores the error of the last read in the format instance.
+ */
+static QMutex *readMutex(MapFormat *format)
+{
+    static QMutex mutex;
+    static QHash<MapFormat*, QMutex*> readMutexes;
+
+    QMutexLocker locker(&mutex);
+    QMutex *&readMutex = readMutexes[format];
+    if (!readMutex)
+        readMutex = new QMutex;
+    return readMutex;
+}
+
+MapLoader::MapLoader(const QString &fileName, MapFormat *format,
+                     QObject *parent)
+    : QObject(parent)
+    , mFileName(fileName)
+    , mFormat(format)
+    , mCompactTileLayers(false)
+    , mTasksStarted(0)
+    , mFinished(false)
+{
+}
+
+/**
+ * Cancels the load and waits for the worker thread to be done with it.
+ */
+MapLoader::~MapLoader()
+{
+    cancel();
+    mDone.acquire(mTasksStarted);
+}
+
+void MapLoader::start()
+{
+    Q_ASSERT(mTasksStarted == 0);
+    startTask(&MapLoader::readMap);
+}
+
+void MapLoader::cancel()
+{
+    mCanceled.storeRelease(1);
+}
+
+bool MapLoader::isCanceled() const
+{
+    return mCanceled.loadAcquire() != 0;
+}
+
+/**
+ * Returns the loaded map, passing its ownership to the caller. Returns null
+ * when the map could not be read, in which case errorString() says why.
+ */
+Map *MapLoader::takeMap()
+{
+    Q_ASSERT(mFinished);
+    return mMap.take();
+}
+
+void MapLoader::startTask(void (MapLoader::*step)())
+{
+    ++mTasksStarted;
+    QThreadPool::globalInstance()->start(new MapLoaderTask(this, step));
+}
+
+/**
+ * Reads the map and switches its tile layers to compact storage when
+ * requested. Called on the thread pool.
+ */
+void MapLoader::readMap()
+{
+    if (!isCanceled()) {
+        if (qobject_cast<TmxMapFormat*>(mFormat)) {
+            // Same as TmxMapFormat::read, except that the error is not
+            // stored in the shared format instance. This allows several TMX
+            // maps to be read at the same time.
+            MapReader reader;
+            mMap.reset(reader.readMap(mFileName));
+            if (!mMap)
+                mError = reader.errorString();
+        } else {
+            QMutexLocker locker(readMutex(mFormat));
+
+            mMap.reset(mFormat->read(mFileName));
+            if (!mMap)
+                mError = mFormat->errorString();
+        }
+    }
+
+    if (mMap && mCompactTileLayers) {
+        LayerIterator iterator(mMap.data());
+        while (Layer *layer = iterator.next())
+            if (TileLayer *tileLayer = layer->asTileLayer())
+                tileLayer->setCompact(true);
+    }
+
+    QMetaObject::invokeMethod(this, "mapRead", Qt::QueuedConnection);
+
+    // Must be last, since the loader may be deleted right after
+    mDone.release();
+}
+
+/**
+ * Switches the map to the tilesets that are already loaded and loads its
+ * template groups, which can only be done on the GUI thread. Then starts
+ * decoding the images of the tilesets that are new.
+ */
+void MapLoader::mapRead()
+{
+    if (!mMap || isCanceled()) {
+        finish();
+        return;
+    }
+
+    TilesetManager *tilesetManager = TilesetManager::instance();
+
+    const auto tilesets = mMap->tilesets();
+    for (const SharedTileset &tileset : tilesets) {
+        SharedTileset loaded;
+        if (!tileset->fileName().isEmpty())
+            loaded = tilesetManager->findTileset(tileset->fileName());
+
+        if (loaded && loaded != tileset)
+            mMap->replaceTileset(tileset, loaded);
+        else if (!loaded)
+            mTilesetsToDecode.append(tileset);
+    }
+
+    TemplateManager *templateManager = TemplateManager::instance();
+
+    const auto templateGroups = mMap->templateGroups();
+    for (TemplateGroup *placeholder : templateGroups) {
+        if (placeholder->loaded())
+            continue;
+
+        QString error;
+        TemplateGroup *templateGroup =
+                templateManager->loadTemplateGroup(placeholder->fileName(), &error);
+
+        if (templateGroup) {
+            mMap->replaceTemplateGroup(placeholder, templateGroup);
+            delete placeholder;
+        }
+    }
+
+    if (mTilesetsToDecode.isEmpty())
+        finish();
+    else
+        startTask(&MapLoader::decodeImages);
+}
+
+/**
+ * Decodes the images of the tilesets that are not shared with any open
+ * document yet. Called on the thread pool.
+ *
+ * Tilesets with images that could not be decoded are remembered, so that
+ * finish() can mark their tiles as failing to load.
+ */
+void MapLoader::decodeImages()
+{
+    for (const SharedTileset &tileset : mTilesetsToDecode) {
+        if (isCanceled())
+            break;
+        if (!tileset->decodeImages())
+            mTilesetsWithErrors.append(tileset);
+    }
+
+    QMetaObject::invokeMethod(this, "finish", Qt::QueuedConnection);
+
+    // Must be last, since the loader may be deleted right after
+    mDone.release();
+}
+
+/**
+ * Loads the images of the tilesets in which decoding failed, which sets the
+ * LoadingError status on the affected tiles. This way, the map is reported
+ * like one with missing images, rather than only failing once the tiles are
+ * first drawn.
+ */
+void MapLoader::finish()
+{
+    if (!isCanceled()) {
+        for (const SharedTileset &tileset : mTilesetsWithErrors)
+            tileset->loadDeferredImages();
+    }
+
+    mTilesetsWithErrors.clear();
+    mTilesetsToDecode.clear();
+    mFinished = true;
+    emit finished();
+}
+
+} // namespace Internal
+} // namespace Tiled
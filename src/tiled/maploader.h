@@ -0,0 +1,106 @@
+/*
+ * maploader.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include "tileset.h"
+
+#include <QAtomicInt>
+#include <QObject>
+#include <QScopedPointer>
+#include <QSemaphore>
+#include <QString>
+#include <QVector>
+
+namespace Tiled {
+
+class Map;
+class MapFormat;
+
+namespace Internal {
+
+/**
+ * Reads a map on the global thread pool, so that the user interface stays
+ * responsive while loading large maps.
+ *
+ * After reading the map, it is switched to the tilesets that are already
+ * loaded on the thread the loader lives in. Then the images of its remaining
+ * tilesets are decoded on the thread pool as well. Once done, the finished()
+ * signal is emitted and the map can be taken with takeMap().
+ *
+ * Reading can't be interrupted. Canceling a load only means that its map is
+ * thrown away, and that tileset images are no longer decoded.
+ */
+class MapLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    MapLoader(const QString &fileName, MapFormat *format,
+              QObject *parent = nullptr);
+    ~MapLoader() override;
+
+    const QString &fileName() const { return mFileName; }
+    MapFormat *format() const { return mFormat; }
+
+    /**
+     * Sets whether the tile layers of the map are switched to compact
+     * storage after reading. Needs to be set before calling start().
+     */
+    void setCompactTileLayers(bool compact) { mCompactTileLayers = compact; }
+
+    void start();
+
+    void cancel();
+    bool isCanceled() const;
+
+    bool isFinished() const { return mFinished; }
+    Map *takeMap();
+    const QString &errorString() const { return mError; }
+
+signals:
+    void finished();
+
+private slots:
+    void mapRead();
+    void finish();
+
+private:
+    void startTask(void (MapLoader::*step)());
+    void readMap();
+    void decodeImages();
+
+    const QString mFileName;
+    MapFormat * const mFormat;
+    QAtomicInt mCanceled;
+    QSemaphore mDone;
+    bool mCompactTileLayers;
+    int mTasksStarted;
+    bool mFinished;
+
+    QScopedPointer<Map> mMap;
+    QString mError;
+    QVector<SharedTileset> mTilesetsToDecode;
+    QVector<SharedTileset> mTilesetsWithErrors;
+};
+
+} // namespace Internal
+} // namespace Tiled
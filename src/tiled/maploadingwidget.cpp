@@ -0,0 +1,94 @@
+/*
+ * maploadingwidget.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "maploadingwidget.h"
+
+#include <QFileInfo>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPainter>
+#include <QProgressBar>
+#include <QPushButton>
+
+namespace Tiled {
+namespace Internal {
+
+MapLoadingWidget::MapLoadingWidget(QWidget *parent)
+    : QWidget(parent)
+    , mLabel(new QLabel(this))
+    , mProgressBar(new QProgressBar(this))
+{
+    QPushButton *cancelButton = new QPushButton(tr("Cancel"), this);
+
+    mProgressBar->setTextVisible(false);
+    mProgressBar->setMaximumWidth(200);
+
+    QHBoxLayout *layout = new QHBoxLayout;
+    layout->addWidget(mLabel);
+    layout->addWidget(mProgressBar);
+    layout->addWidget(cancelButton);
+    layout->addStretch(1);
+    setLayout(layout);
+
+    connect(cancelButton, &QPushButton::clicked, this, &MapLoadingWidget::cancel);
+}
+
+/**
+ * Updates the progress, where \a loaded out of \a total maps have been
+ * loaded and \a fileName is the next map to be done.
+ *
+ * Since there is no progress information while a single map is read, the
+ * progress bar only shows activity when loading one map.
+ */
+void MapLoadingWidget::setProgress(int loaded, int total, const QString &fileName)
+{
+    const QString name = QFileInfo(fileName).fileName();
+
+    if (total == 1) {
+        mLabel->setText(tr("Loading %1...").arg(name));
+        mProgressBar->setRange(0, 0);
+    } else {
+        mLabel->setText(tr("Loading %1 (%2 of %3)...")
+                        .arg(name).arg(loaded + 1).arg(total));
+        mProgressBar->setRange(0, total);
+        mProgressBar->setValue(loaded);
+    }
+}
+
+void MapLoadingWidget::paintEvent(QPaintEvent *event)
+{
+    QWidget::paintEvent(event);
+
+    const QPalette p = palette();
+    const QRect r = rect();
+    const QColor light = p.midlight().color();
+    const QColor shadow = p.mid().color();
+
+    QPainter painter(this);
+    painter.setPen(light);
+    painter.drawLine(r.bottomLeft(), r.bottomRight());
+    painter.setPen(shadow);
+    painter.drawLine(r.left(), r.bottom() - 1,
+                     r.right(), r.bottom() - 1);
+}
+
+} // namespace Internal
+} // namespace Tiled
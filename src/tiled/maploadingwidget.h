@@ -0,0 +1,57 @@
+/*
+ * maploadingwidget.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <QWidget>
+
+class QLabel;
+class QProgressBar;
+
+namespace Tiled {
+namespace Internal {
+
+/**
+ * Shows the progress of the maps being loaded in the background, with a
+ * button to cancel loading them.
+ */
+class MapLoadingWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    MapLoadingWidget(QWidget *parent = nullptr);
+
+    void setProgress(int loaded, int total, const QString &fileName);
+
+signals:
+    void cancel();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    QLabel *mLabel;
+    QProgressBar *mProgressBar;
+};
+
+} // namespace Internal
+} // namespace Tiled
@@ -44,16 +44,19 @@
 #include "tileselectionitem.h"
 #include "imagelayer.h"
 #include "imagelayeritem.h"
+#include "largeobjectgroupitem.h"
 #include "stylehelper.h"
 #include "toolmanager.h"
 #include "tilesetmanager.h"
 
 #include <QApplication>
 #include <QGraphicsSceneMouseEvent>
+#include <QGraphicsView>
 #include <QPainter>
 #include <QKeyEvent>
 #include <QMimeData>
 #include <QPalette>
+#include <QtMath>
 
 #include <cmath>
 
@@ -62,6 +65,7 @@ using namespace Tiled::Internal;
 
 static const qreal darkeningFactor = 0.6;
 static const qreal opacityFactor = 0.4;
+static const int MaxRepaintRects = 32;
 
 MapScene::MapScene(QObject *parent):
     QGraphicsScene(parent),
@@ -80,9 +84,9 @@ MapScene::MapScene(QObject *parent):
 
     TilesetManager *tilesetManager = TilesetManager::instance();
     connect(tilesetManager, &TilesetManager::tilesetImagesChanged,
-            this, &MapScene::repaintTileset);
-    connect(tilesetManager, &TilesetManager::repaintTileset,
-            this, &MapScene::repaintTileset);
+            this, &MapScene::tilesetImagesChanged);
+    connect(tilesetManager, &TilesetManager::repaintTiles,
+            this, &MapScene::repaintTiles);
 
     Preferences *prefs = Preferences::instance();
     connect(prefs, &Preferences::showGridChanged, this, &MapScene::setGridVisible);
@@ -91,6 +95,8 @@ MapScene::MapScene(QObject *parent):
     connect(prefs, &Preferences::highlightCurrentLayerChanged, this, &MapScene::setHighlightCurrentLayer);
     connect(prefs, SIGNAL(gridColorChanged(QColor)), this, SLOT(update()));
     connect(prefs, &Preferences::objectLineWidthChanged, this, &MapScene::setObjectLineWidth);
+    connect(prefs, &Preferences::tileLayerCacheSizeChanged, this, &MapScene::setTileLayerCacheSize);
+    connect(prefs, &Preferences::objectItemLimitChanged, this, &MapScene::setObjectItemLimit);
 
     mDarkRectangle->setPen(Qt::NoPen);
     mDarkRectangle->setBrush(Qt::black);
@@ -101,6 +107,8 @@ MapScene::MapScene(QObject *parent):
     mObjectLineWidth = prefs->objectLineWidth();
     mShowTileObjectOutlines = prefs->showTileObjectOutlines();
     mHighlightCurrentLayer = prefs->highlightCurrentLayer();
+    mTileLayerRenderCache.setMaxSize(prefs->tileLayerCacheSize());
+    mObjectItemLimit = prefs->objectItemLimit();
 
     // Install an event filter so that we can get key events on behalf of the
     // active tool without having to have the current focus.
@@ -152,6 +160,8 @@ void MapScene::setMapDocument(MapDocument *mapDocument)
                 this, &MapScene::adaptToTilesetTileSizeChanges);
         connect(mMapDocument, &MapDocument::tileImageSourceChanged,
                 this, &MapScene::adaptToTileSizeChanges);
+        connect(mMapDocument, &MapDocument::tileAnimationChanged,
+                this, &MapScene::tileAnimationChanged);
         connect(mMapDocument, &MapDocument::tilesetReplaced,
                 this, &MapScene::tilesetReplaced);
         connect(mMapDocument, &MapDocument::objectsInserted,
@@ -190,6 +200,8 @@ void MapScene::refreshScene()
 {
     mLayerItems.clear();
     mObjectItems.clear();
+    mOnDemandObjects.clear();
+    mTileLayerRenderCache.invalidate();
 
     removeItem(mDarkRectangle);
     clear();
@@ -239,25 +251,24 @@ LayerItem *MapScene::createLayerItem(Layer *layer)
 
     switch (layer->layerType()) {
     case Layer::TileLayerType:
-        layerItem = new TileLayerItem(static_cast<TileLayer*>(layer), mMapDocument);
+        layerItem = new TileLayerItem(static_cast<TileLayer*>(layer), mMapDocument,
+                                      &mTileLayerRenderCache);
         break;
 
     case Layer::ObjectGroupType: {
         auto og = static_cast<ObjectGroup*>(layer);
-        const ObjectGroup::DrawOrder drawOrder = og->drawOrder();
+
+        // Large object groups draw their objects themselves, since creating
+        // an item for each object gets too slow
+        if (og->objectCount() > mObjectItemLimit) {
+            layerItem = new LargeObjectGroupItem(og, mMapDocument);
+            break;
+        }
+
         ObjectGroupItem *ogItem = new ObjectGroupItem(og);
         int objectIndex = 0;
-        for (MapObject *object : og->objects()) {
-            MapObjectItem *item = new MapObjectItem(object, mMapDocument,
-                                                    ogItem);
-            if (drawOrder == ObjectGroup::TopDownOrder)
-                item->setZValue(item->y());
-            else
-                item->setZValue(objectIndex);
-
-            mObjectItems.insert(object, item);
-            ++objectIndex;
-        }
+        for (MapObject *object : og->objects())
+            createObjectItem(object, ogItem, objectIndex++);
         layerItem = ogItem;
         break;
     }
@@ -288,6 +299,118 @@ LayerItem *MapScene::createLayerItem(Layer *layer)
     return layerItem;
 }
 
+MapObjectItem *MapScene::createObjectItem(MapObject *object,
+                                          ObjectGroupItem *objectGroupItem,
+                                          int index)
+{
+    MapObjectItem *item = new MapObjectItem(object, mMapDocument,
+                                            objectGroupItem);
+    if (object->objectGroup()->drawOrder() == ObjectGroup::TopDownOrder)
+        item->setZValue(item->y());
+    else
+        item->setZValue(index);
+
+    mObjectItems.insert(object, item);
+    return item;
+}
+
+QList<LargeObjectGroupItem*> MapScene::largeObjectGroupItems() const
+{
+    QList<LargeObjectGroupItem*> items;
+    for (LayerItem *item : mLayerItems)
+        if (LargeObjectGroupItem *largeItem = dynamic_cast<LargeObjectGroupItem*>(item))
+            items.append(largeItem);
+    return items;
+}
+
+void MapScene::syncLargeObjectGroupItems()
+{
+    const auto largeItems = largeObjectGroupItems();
+    for (LargeObjectGroupItem *item : largeItems)
+        item->syncWithObjects();
+}
+
+/**
+ * Returns the item of the given \a object, which is part of the large object
+ * group drawn by \a item. The item is created when it doesn't exist yet.
+ */
+MapObjectItem *MapScene::ensureObjectItem(LargeObjectGroupItem *item,
+                                          MapObject *object)
+{
+    if (MapObjectItem *objectItem = itemForObject(object))
+        return objectItem;
+
+    int index = 0;
+    if (object->objectGroup()->drawOrder() == ObjectGroup::IndexOrder)
+        index = object->objectGroup()->objects().indexOf(object);
+
+    item->setObjectHasItem(object, true);
+    mOnDemandObjects.insert(object);
+    return createObjectItem(object, item, index);
+}
+
+void MapScene::createObjectItemsIn(const QRectF &rect)
+{
+    const auto largeItems = largeObjectGroupItems();
+    for (LargeObjectGroupItem *item : largeItems) {
+        if (!item->isVisible())
+            continue;
+
+        const auto objects = item->objectsIn(rect);
+        for (MapObject *object : objects) {
+            if (mOnDemandObjects.size() >= mObjectItemLimit)
+                return;
+
+            ensureObjectItem(item, object);
+        }
+    }
+}
+
+/**
+ * Creates the items for the objects of large object groups at the given
+ * \a scenePos, so that the tools can find them.
+ *
+ * When \a releaseOthers is true, the items created before for objects that
+ * are no longer under the mouse and are not selected are deleted.
+ */
+void MapScene::updateObjectItemsUnderMouse(const QPointF &scenePos,
+                                           bool releaseOthers)
+{
+    QSet<MapObject*> hoveredObjects;
+
+    const auto largeItems = largeObjectGroupItems();
+    for (LargeObjectGroupItem *item : largeItems) {
+        if (!item->isVisible())
+            continue;
+
+        const auto objects = item->objectsAt(scenePos);
+        for (MapObject *object : objects) {
+            ensureObjectItem(item, object);
+            hoveredObjects.insert(object);
+        }
+    }
+
+    if (!releaseOthers)
+        return;
+
+    for (auto it = mOnDemandObjects.begin(); it != mOnDemandObjects.end(); ) {
+        MapObject *object = *it;
+        MapObjectItem *item = mObjectItems.value(object);
+
+        if (hoveredObjects.contains(object) || mSelectedObjectItems.contains(item)) {
+            ++it;
+            continue;
+        }
+
+        auto largeItem = static_cast<LargeObjectGroupItem*>(item->parentItem());
+        largeItem->setObjectHasItem(object, false);
+
+        mObjectItems.remove(object);
+        delete item;
+        it = mOnDemandObjects.erase(it);
+    }
+}
+
 void MapScene::updateDefaultBackgroundColor()
 {
     mDefaultBackgroundColor = QGuiApplication::palette().dark().color();
@@ -370,6 +493,9 @@ void MapScene::repaintRegion(const QRegion &region, Layer *layer)
                             margins.right(),
                             margins.bottom());
 
+        if (TileLayer *tileLayer = layer->asTileLayer())
+            mTileLayerRenderCache.invalidate(tileLayer, boundingRect);
+
         boundingRect.translate(layer->totalOffset());
 
         update(boundingRect);
@@ -420,6 +546,7 @@ void MapScene::currentLayerChanged()
  */
 void MapScene::mapChanged()
 {
+    mTileLayerRenderCache.invalidate();
     updateSceneRect();
 
     for (QGraphicsItem *item : mLayerItems) {
@@ -430,6 +557,8 @@ void MapScene::mapChanged()
     for (MapObjectItem *item : mObjectItems)
         item->syncWithMapObject();
 
+    syncLargeObjectGroupItems();
+
     const Map *map = mMapDocument->map();
     if (map->backgroundColor().isValid())
         setBackgroundBrush(map->backgroundColor());
@@ -437,17 +566,152 @@ void MapScene::mapChanged()
         setBackgroundBrush(mDefaultBackgroundColor);
 }
 
-void MapScene::repaintTileset(Tileset *tileset)
+/**
+ * Returns the cells of \a layer, in local coordinates, that may be visible
+ * within \a rect, taking into account the draw \a margins of the tiles.
+ */
+static QRect cellsInRect(const MapRenderer *renderer,
+                         const TileLayer *layer,
+                         const QRectF &rect,
+                         const QMargins &margins)
+{
+    const QRectF area = rect.adjusted(-margins.right(),
+                                      -margins.bottom(),
+                                      margins.left(),
+                                      margins.top());
+
+    const QPolygonF corners = {
+        renderer->screenToTileCoords(area.topLeft()),
+        renderer->screenToTileCoords(area.topRight()),
+        renderer->screenToTileCoords(area.bottomLeft()),
+        renderer->screenToTileCoords(area.bottomRight()),
+    };
+
+    const QRectF bounds = corners.boundingRect();
+    return QRect(QPoint(qFloor(bounds.left()) - 1, qFloor(bounds.top()) - 1),
+                 QPoint(qCeil(bounds.right()) + 1, qCeil(bounds.bottom()) + 1))
+            .intersected(layer->bounds())
+            .translated(-layer->position());
+}
+
+/**
+ * Repaints the visible cells and tile objects showing any of the given
+ * \a tiles, after their animation moved on to another frame.
+ */
+void MapScene::repaintTiles(Tileset *tileset, const QVector<Tile*> &tiles)
 {
     if (!mMapDocument)
         return;
 
-    if (contains(mMapDocument->map()->tilesets(), tileset))
+    if (!contains(mMapDocument->map()->tilesets(), tileset))
+        return;
+
+    mTileLayerRenderCache.invalidateAnimated(tileset);
+
+    QRectF visibleArea;
+    for (QGraphicsView *view : views())
+        visibleArea |= view->mapToScene(view->viewport()->rect()).boundingRect();
+
+    if (visibleArea.isEmpty())
+        return;
+
+    QSet<const Tile*> changedTiles;
+    changedTiles.reserve(tiles.size());
+    for (const Tile *tile : tiles)
+        changedTiles.insert(tile);
+
+    const MapRenderer *renderer = mMapDocument->renderer();
+    const QMargins margins = mMapDocument->map()->drawMargins();
+
+    QVector<QRectF> dirtyRects;
+    QRectF dirtyBounds;
+
+    for (LayerItem *item : mLayerItems) {
+        if (!item->isVisible() || !item->layer()->isTileLayer())
+            continue;
+
+        const TileLayer *tileLayer = static_cast<TileLayer*>(item->layer());
+        const QPointF offset = tileLayer->totalOffset();
+        const auto &animatedCells = tileLayer->animatedCells();
+        if (animatedCells.isEmpty())
+            continue;
+
+        const QRectF layerArea = visibleArea.translated(-offset);
+        const QRect cells = cellsInRect(renderer, tileLayer, layerArea, margins);
+
+        auto repaintCell = [&] (const QPoint &pos) {
+            const QRect cellRect(pos + tileLayer->position(), QSize(1, 1));
+            QRectF boundingRect = renderer->boundingRect(cellRect);
+
+            boundingRect.adjust(-margins.left(),
+                                -margins.top(),
+                                margins.right(),
+                                margins.bottom());
+
+            if (boundingRect.intersects(layerArea)) {
+                boundingRect.translate(offset);
+                if (dirtyRects.size() <= MaxRepaintRects)
+                    dirtyRects.append(boundingRect);
+                dirtyBounds |= boundingRect;
+            }
+        };
+
+        // Look at either the visible cells or the animated cells, whichever
+        // are fewer
+        if (qint64(cells.width()) * cells.height() < animatedCells.size()) {
+            for (int y = cells.top(); y <= cells.bottom(); ++y)
+                for (int x = cells.left(); x <= cells.right(); ++x)
+                    if (changedTiles.contains(tileLayer->cellAt(x, y).tile()))
+                        repaintCell(QPoint(x, y));
+        } else {
+            for (auto it = animatedCells.begin(), end = animatedCells.end(); it != end; ++it)
+                if (cells.contains(it.key()) && changedTiles.contains(it.value()))
+                    repaintCell(it.key());
+        }
+    }
+
+    // Repainting many separate areas is slower than repainting their bounds
+    if (dirtyRects.size() > MaxRepaintRects) {
+        update(dirtyBounds);
+    } else {
+        for (const QRectF &rect : dirtyRects)
+            update(rect);
+    }
+
+    for (MapObjectItem *item : mObjectItems)
+        if (item->isVisible() && changedTiles.contains(item->mapObject()->cell().tile()))
+            item->update();
+
+    const auto largeItems = largeObjectGroupItems();
+    for (LargeObjectGroupItem *item : largeItems)
+        if (item->isVisible())
+            item->repaintTiles(changedTiles);
+}
+
+void MapScene::tilesetImagesChanged(Tileset *tileset)
+{
+    if (!mMapDocument)
+        return;
+
+    if (contains(mMapDocument->map()->tilesets(), tileset)) {
+        mTileLayerRenderCache.invalidate(tileset);
         update();
+    }
+}
+
+/**
+ * Discards the cached rendering of any cells showing the given \a tile, since
+ * they are only known to need repainting while the tile is animated.
+ */
+void MapScene::tileAnimationChanged(Tile *tile)
+{
+    mTileLayerRenderCache.invalidate(tile->tileset());
+    update();
 }
 
 void MapScene::tileLayerDrawMarginsChanged(TileLayer *tileLayer)
 {
+    mTileLayerRenderCache.invalidate(tileLayer);
     TileLayerItem *item = static_cast<TileLayerItem*>(mLayerItems.value(tileLayer));
     item->syncWithTileLayer();
 }
@@ -463,6 +727,20 @@ void MapScene::layerAdded(Layer *layer)
 
 void MapScene::layerRemoved(Layer *layer)
 {
+    // Also covers any tile layers within a removed group layer
+    mTileLayerRenderCache.invalidate();
+
+    // Forget about the items created for objects of removed large groups,
+    // which are deleted along with their layer item
+    for (auto it = mOnDemandObjects.begin(); it != mOnDemandObjects.end(); ) {
+        if (layer->isParentOrSelf((*it)->objectGroup())) {
+            mObjectItems.remove(*it);
+            it = mOnDemandObjects.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
     delete mLayerItems.take(layer);
 }
 
@@ -555,6 +833,7 @@ void MapScene::imageLayerChanged(ImageLayer *imageLayer)
  */
 void MapScene::adaptToTilesetTileSizeChanges(Tileset *tileset)
 {
+    mTileLayerRenderCache.invalidate();
     update();
 
     for (QGraphicsItem *item : mLayerItems)
@@ -566,10 +845,13 @@ void MapScene::adaptToTilesetTileSizeChanges(Tileset *tileset)
         if (cell.tileset() == tileset)
             item->syncWithMapObject();
     }
+
+    syncLargeObjectGroupItems();
 }
 
 void MapScene::adaptToTileSizeChanges(Tile *tile)
 {
+    mTileLayerRenderCache.invalidate();
     update();
 
     for (QGraphicsItem *item : mLayerItems)
@@ -581,6 +863,8 @@ void MapScene::adaptToTileSizeChanges(Tile *tile)
         if (cell.tile() == tile)
             item->syncWithMapObject();
     }
+
+    syncLargeObjectGroupItems();
 }
 
 void MapScene::tilesetReplaced(int index, Tileset *tileset)
@@ -608,19 +892,13 @@ void MapScene::objectsInserted(ObjectGroup *objectGroup, int first, int last)
 
     Q_ASSERT(ogItem);
 
-    const ObjectGroup::DrawOrder drawOrder = objectGroup->drawOrder();
-
-    for (int i = first; i <= last; ++i) {
-        MapObject *object = objectGroup->objectAt(i);
-
-        MapObjectItem *item = new MapObjectItem(object, mMapDocument, ogItem);
-        if (drawOrder == ObjectGroup::TopDownOrder)
-            item->setZValue(item->y());
-        else
-            item->setZValue(i);
-
-        mObjectItems.insert(object, item);
+    if (LargeObjectGroupItem *largeItem = dynamic_cast<LargeObjectGroupItem*>(ogItem)) {
+        largeItem->objectsInserted(first, last);
+        return;
     }
+
+    for (int i = first; i <= last; ++i)
+        createObjectItem(objectGroup->objectAt(i), ogItem, i);
 }
 
 /**
@@ -628,14 +906,21 @@ void MapScene::objectsInserted(ObjectGroup *objectGroup, int first, int last)
  */
 void MapScene::objectsRemoved(const QList<MapObject*> &objects)
 {
+    const auto largeItems = largeObjectGroupItems();
+
     for (MapObject *o : objects) {
         auto i = mObjectItems.find(o);
-        Q_ASSERT(i != mObjectItems.end());
+        if (i == mObjectItems.end())
+            continue;   // Part of a large object group without an item
 
         mSelectedObjectItems.remove(i.value());
+        mOnDemandObjects.remove(o);
         delete i.value();
         mObjectItems.erase(i);
     }
+
+    for (LargeObjectGroupItem *largeItem : largeItems)
+        largeItem->objectsRemoved(objects);
 }
 
 /**
@@ -643,12 +928,13 @@ void MapScene::objectsRemoved(const QList<MapObject*> &objects)
  */
 void MapScene::objectsChanged(const QList<MapObject*> &objects)
 {
-    for (MapObject *object : objects) {
-        MapObjectItem *item = itemForObject(object);
-        Q_ASSERT(item);
+    for (MapObject *object : objects)
+        if (MapObjectItem *item = itemForObject(object))
+            item->syncWithMapObject();
 
-        item->syncWithMapObject();
-    }
+    const auto largeItems = largeObjectGroupItems();
+    for (LargeObjectGroupItem *largeItem : largeItems)
+        largeItem->syncWithObjects(objects);
 }
 
 /**
@@ -657,15 +943,16 @@ void MapScene::objectsChanged(const QList<MapObject*> &objects)
 void MapScene::objectsIndexChanged(ObjectGroup *objectGroup,
                                    int first, int last)
 {
+    LayerItem *layerItem = mLayerItems.value(objectGroup);
+    if (LargeObjectGroupItem *largeItem = dynamic_cast<LargeObjectGroupItem*>(layerItem))
+        largeItem->objectsIndexChanged(first, last);
+
     if (objectGroup->drawOrder() != ObjectGroup::IndexOrder)
         return;
 
-    for (int i = first; i <= last; ++i) {
-        MapObjectItem *item = itemForObject(objectGroup->objectAt(i));
-        Q_ASSERT(item);
-
-        item->setZValue(i);
-    }
+    for (int i = first; i <= last; ++i)
+        if (MapObjectItem *item = itemForObject(objectGroup->objectAt(i)))
+            item->setZValue(i);
 }
 
 void MapScene::updateSelectedObjectItems()
@@ -675,7 +962,15 @@ void MapScene::updateSelectedObjectItems()
     QSet<MapObjectItem*> items;
     for (MapObject *object : objects) {
         MapObjectItem *item = itemForObject(object);
-        Q_ASSERT(item);
+
+        // Objects in large object groups only get an item when needed
+        if (!item) {
+            LayerItem *layerItem = mLayerItems.value(object->objectGroup());
+            auto largeItem = dynamic_cast<LargeObjectGroupItem*>(layerItem);
+            Q_ASSERT(largeItem);
+
+            item = ensureObjectItem(largeItem, object);
+        }
 
         items.insert(item);
     }
@@ -688,6 +983,8 @@ void MapScene::syncAllObjectItems()
 {
     for (MapObjectItem *item : mObjectItems)
         item->syncWithMapObject();
+
+    syncLargeObjectGroupItems();
 }
 
 /**
@@ -713,12 +1010,11 @@ void MapScene::setObjectLineWidth(qreal lineWidth)
         mMapDocument->renderer()->setObjectLineWidth(lineWidth);
 
         // Changing the line width can change the size of the object items
-        if (!mObjectItems.isEmpty()) {
-            for (MapObjectItem *item : mObjectItems)
-                item->syncWithMapObject();
+        for (MapObjectItem *item : mObjectItems)
+            item->syncWithMapObject();
 
-            update();
-        }
+        syncLargeObjectGroupItems();
+        update();
     }
 }
 
@@ -745,6 +1041,25 @@ void MapScene::setHighlightCurrentLayer(bool highlightCurrentLayer)
     updateCurrentLayerHighlight();
 }
 
+void MapScene::setTileLayerCacheSize(int megabytes)
+{
+    mTileLayerRenderCache.setMaxSize(megabytes);
+    update();
+}
+
+void MapScene::setObjectItemLimit(int limit)
+{
+    if (mObjectItemLimit == limit)
+        return;
+
+    mObjectItemLimit = limit;
+
+    if (mMapDocument) {
+        refreshScene();
+        updateSelectedObjectItems();
+    }
+}
+
 void MapScene::drawForeground(QPainter *painter, const QRectF &rect)
 {
     if (!mMapDocument || !mGridVisible)
@@ -800,6 +1115,11 @@ void MapScene::mouseMoveEvent(QGraphicsSceneMouseEvent *mouseEvent)
     if (!mMapDocument)
         return;
 
+    // Items of objects in large object groups are only released while no
+    // button is pressed, since the tools may hold on to them while dragging
+    updateObjectItemsUnderMouse(mouseEvent->scenePos(),
+                                mouseEvent->buttons() == Qt::NoButton);
+
     QGraphicsScene::mouseMoveEvent(mouseEvent);
     if (mouseEvent->isAccepted())
         return;
@@ -813,6 +1133,9 @@ void MapScene::mouseMoveEvent(QGraphicsSceneMouseEvent *mouseEvent)
 
 void MapScene::mousePressEvent(QGraphicsSceneMouseEvent *mouseEvent)
 {
+    if (mMapDocument)
+        updateObjectItemsUnderMouse(mouseEvent->scenePos(), false);
+
     QGraphicsScene::mousePressEvent(mouseEvent);
     if (mouseEvent->isAccepted())
         return;
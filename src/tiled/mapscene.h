@@ -23,10 +23,13 @@
 
 #pragma once
 
+#include "tilelayerrendercache.h"
+
 #include <QColor>
 #include <QGraphicsScene>
 #include <QMap>
 #include <QSet>
+#include <QVector>
 
 namespace Tiled {
 
@@ -41,6 +44,7 @@ class Tileset;
 namespace Internal {
 
 class AbstractTool;
+class LargeObjectGroupItem;
 class LayerItem;
 class MapDocument;
 class MapObjectItem;
@@ -99,6 +103,17 @@ public:
     MapObjectItem *itemForObject(MapObject *object) const
     { return mObjectItems.value(object); }
 
+    /**
+     * Makes sure there is a MapObjectItem for each object within the given
+     * \a rect, including the objects of large object groups that are
+     * otherwise drawn without an item for each object. Should be called
+     * before looking for object items in an area.
+     *
+     * No more items are created on demand than the object item limit, since
+     * that would get too slow. Further objects in the area are then skipped.
+     */
+    void createObjectItemsIn(const QRectF &rect);
+
     /**
      * Enables the selected tool at this map scene.
      * Therefore it tells that tool, that this is the active map scene.
@@ -145,6 +160,9 @@ private slots:
      */
     void setHighlightCurrentLayer(bool highlightCurrentLayer);
 
+    void setTileLayerCacheSize(int megabytes);
+    void setObjectItemLimit(int limit);
+
     /**
      * Refreshes the map scene.
      */
@@ -158,7 +176,9 @@ private slots:
     void currentLayerChanged();
 
     void mapChanged();
-    void repaintTileset(Tileset *tileset);
+    void repaintTiles(Tileset *tileset, const QVector<Tile*> &tiles);
+    void tilesetImagesChanged(Tileset *tileset);
+    void tileAnimationChanged(Tile *tile);
     void tileLayerDrawMarginsChanged(TileLayer *tileLayer);
 
     void layerAdded(Layer *layer);
@@ -184,6 +204,16 @@ private slots:
 private:
     void createLayerItems(const QList<Layer *> &layers);
     LayerItem *createLayerItem(Layer *layer);
+    MapObjectItem *createObjectItem(MapObject *object,
+                                    ObjectGroupItem *objectGroupItem,
+                                    int index);
+
+    QList<LargeObjectGroupItem*> largeObjectGroupItems() const;
+    void syncLargeObjectGroupItems();
+    MapObjectItem *ensureObjectItem(LargeObjectGroupItem *item,
+                                    MapObject *object);
+    void updateObjectItemsUnderMouse(const QPointF &scenePos,
+                                     bool releaseOthers);
 
     void updateDefaultBackgroundColor();
     void updateSceneRect();
@@ -202,12 +232,16 @@ private:
     Qt::KeyboardModifiers mCurrentModifiers;
     QPointF mLastMousePos;
     QMap<Layer*, LayerItem*> mLayerItems;
+    TileLayerRenderCache mTileLayerRenderCache;
     QGraphicsRectItem *mDarkRectangle;
     QColor mDefaultBackgroundColor;
     ObjectSelectionItem *mObjectSelectionItem;
 
     QMap<MapObject*, MapObjectItem*> mObjectItems;
     QSet<MapObjectItem*> mSelectedObjectItems;
+
+    int mObjectItemLimit;
+    QSet<MapObject*> mOnDemandObjects;  // Objects of large groups with an item
 };
 
 } // namespace Internal
@@ -22,14 +22,36 @@
 
 #include "map.h"
 #include "mapdocument.h"
+#include "preferences.h"
 #include "tilelayer.h"
 #include "tilepainter.h"
 
 #include <QCoreApplication>
+#include <QScopedPointer>
+#include <QUndoStack>
 
 using namespace Tiled;
 using namespace Tiled::Internal;
 
+UncompressedPaintChanges::UncompressedPaintChanges(QUndoStack *undoStack)
+    : QObject(undoStack)
+    , mMemoryUsage(0)
+{
+}
+
+/**
+ * Returns the uncompressed changes of the given \a undoStack, creating them
+ * when they don't exist yet.
+ */
+UncompressedPaintChanges *UncompressedPaintChanges::forUndoStack(QUndoStack *undoStack)
+{
+    auto changes = undoStack->findChild<UncompressedPaintChanges*>(QString(),
+                                                                   Qt::FindDirectChildrenOnly);
+    if (!changes)
+        changes = new UncompressedPaintChanges(undoStack);
+    return changes;
+}
+
 PaintTileLayer::PaintTileLayer(MapDocument *mapDocument,
                                TileLayer *target,
                                int x,
@@ -38,16 +60,13 @@ PaintTileLayer::PaintTileLayer(MapDocument *mapDocument,
                                QUndoCommand *parent)
     : QUndoCommand(parent)
     , mMapDocument(mapDocument)
+    , mUncompressedChanges(UncompressedPaintChanges::forUndoStack(mapDocument->undoStack()))
     , mTarget(target)
-    , mSource(source->clone())
-    , mX(x)
-    , mY(y)
-    , mPaintedRegion(source->region().translated(QPoint(x, y) - source->position()))
+    , mDelta(TileLayerDelta::record(target, x, y, source,
+                                    source->region().translated(QPoint(x, y) - source->position())))
+    , mMemoryUsage(0)
     , mMergeable(false)
 {
-    mErased = mTarget->copy(mX - mTarget->x(),
-                            mY - mTarget->y(),
-                            mSource->width(), mSource->height());
     setText(QCoreApplication::translate("Undo Commands", "Paint"));
 }
 
@@ -60,29 +79,23 @@ PaintTileLayer::PaintTileLayer(MapDocument *mapDocument,
                                QUndoCommand *parent)
     : QUndoCommand(parent)
     , mMapDocument(mapDocument)
+    , mUncompressedChanges(UncompressedPaintChanges::forUndoStack(mapDocument->undoStack()))
     , mTarget(target)
-    , mSource(source->clone())
-    , mX(x)
-    , mY(y)
-    , mPaintedRegion(paintRegion)
+    , mDelta(TileLayerDelta::record(target, x, y, source, paintRegion))
+    , mMemoryUsage(0)
     , mMergeable(false)
 {
-    mErased = mTarget->copy(mX - mTarget->x(),
-                            mY - mTarget->y(),
-                            mSource->width(), mSource->height());
     setText(QCoreApplication::translate("Undo Commands", "Paint"));
 }
 
 PaintTileLayer::~PaintTileLayer()
 {
-    delete mSource;
-    delete mErased;
+    forgetDelta();
 }
 
 void PaintTileLayer::undo()
 {
-    TilePainter painter(mMapDocument, mTarget);
-    painter.setCells(mX, mY, mErased, mPaintedRegion);
+    paint(TileLayerDelta::OldCells);
 
     QUndoCommand::undo(); // undo child commands
 }
@@ -91,8 +104,7 @@ void PaintTileLayer::redo()
 {
     QUndoCommand::redo(); // redo child commands
 
-    TilePainter painter(mMapDocument, mTarget);
-    painter.setCells(mX, mY, mSource, mPaintedRegion);
+    paint(TileLayerDelta::NewCells);
 }
 
 bool PaintTileLayer::mergeWith(const QUndoCommand *other)
@@ -103,33 +115,80 @@ bool PaintTileLayer::mergeWith(const QUndoCommand *other)
           o->mMergeable))
         return false;
 
-    const QRegion newRegion = o->mPaintedRegion.subtracted(mPaintedRegion);
-    const QRegion combinedRegion = mPaintedRegion.united(o->mPaintedRegion);
-    const QRect bounds = QRect(mX, mY, mSource->width(), mSource->height());
-    const QRect combinedBounds = combinedRegion.boundingRect();
+    TileLayerDelta later = o->mDelta;
+    later.decompress();
 
-    // Resize the erased tiles and source layers when necessary
-    if (bounds != combinedBounds) {
-        const QPoint shift = bounds.topLeft() - combinedBounds.topLeft();
-        mErased->resize(combinedBounds.size(), shift);
-        mSource->resize(combinedBounds.size(), shift);
-    }
+    mDelta.decompress();
+    mDelta.merge(later);
+    deltaUsed();
 
-    mX = combinedBounds.left();
-    mY = combinedBounds.top();
-    mPaintedRegion = combinedRegion;
+    return true;
+}
 
-    // Copy the painted tiles from the other command over
-    const QPoint pos = QPoint(o->mX, o->mY) - combinedBounds.topLeft();
-    mSource->merge(pos, o->mSource);
+void PaintTileLayer::paint(TileLayerDelta::Side side)
+{
+    mDelta.decompress();
+    deltaUsed();
 
-    // Copy the newly erased tiles from the other command over
-    foreach (const QRect &rect, newRegion.rects())
-        for (int y = rect.top(); y <= rect.bottom(); ++y)
-            for (int x = rect.left(); x <= rect.right(); ++x)
-                mErased->setCell(x - mX,
-                                 y - mY,
-                                 o->mErased->cellAt(x - o->mX, y - o->mY));
+    if (mDelta.isEmpty())
+        return;
 
-    return true;
+    const QRect &bounds = mDelta.bounds();
+    QScopedPointer<TileLayer> layer(mDelta.createLayer(side));
+
+    TilePainter painter(mMapDocument, mTarget);
+    painter.setCells(bounds.x(), bounds.y(), layer.data(), mDelta.region());
+}
+
+/**
+ * Marks the changes of this command as most recently used and updates the
+ * memory they use. The changes need to be decompressed.
+ */
+void PaintTileLayer::deltaUsed()
+{
+    forgetDelta();
+
+    mMemoryUsage = mDelta.memoryUsage();
+    mUncompressedChanges->mCommands.append(this);
+    mUncompressedChanges->mMemoryUsage += mMemoryUsage;
+
+    compressOldChanges();
+}
+
+/**
+ * Removes this command from the uncompressed changes of its undo stack.
+ */
+void PaintTileLayer::forgetDelta()
+{
+    if (mUncompressedChanges->mCommands.removeOne(this))
+        mUncompressedChanges->mMemoryUsage -= mMemoryUsage;
+}
+
+/**
+ * Compresses the changes of the least recently used commands of the undo
+ * stack until its uncompressed changes fit within the undo compression
+ * threshold. The most recently used command is left alone, since it is
+ * likely to be merged with.
+ *
+ * This reduces the memory used by the undo history, but doesn't bound it.
+ * Dropping the oldest commands is not possible, since QUndoStack only allows
+ * setting an undo limit while it is empty.
+ */
+void PaintTileLayer::compressOldChanges()
+{
+    const int threshold = Preferences::instance()->undoCompressionThreshold();
+    if (threshold <= 0)
+        return;
+
+    const qint64 maximumUsage = qint64(threshold) * 1024 * 1024;
+
+    QList<PaintTileLayer*> &commands = mUncompressedChanges->mCommands;
+    qint64 &memoryUsage = mUncompressedChanges->mMemoryUsage;
+
+    while (memoryUsage > maximumUsage && commands.size() > 1) {
+        PaintTileLayer *command = commands.takeFirst();
+        memoryUsage -= command->mMemoryUsage;
+        command->mDelta.compress();
+        command->mMemoryUsage = 0;
+    }
 }
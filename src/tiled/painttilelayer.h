@@ -20,11 +20,16 @@
 
 #pragma once
 
+#include "tilelayerdelta.h"
 #include "undocommands.h"
 
+#include <QList>
+#include <QObject>
 #include <QRegion>
 #include <QUndoCommand>
 
+class QUndoStack;
+
 namespace Tiled {
 
 class TileLayer;
@@ -32,9 +37,38 @@ class TileLayer;
 namespace Internal {
 
 class MapDocument;
+class PaintTileLayer;
+
+/**
+ * Keeps track of the paint commands of an undo stack whose changes are not
+ * compressed, from least to most recently used, and of the memory used by
+ * their changes.
+ *
+ * It is a child of the undo stack, so that it outlives the commands.
+ */
+class UncompressedPaintChanges : public QObject
+{
+    Q_OBJECT
+
+public:
+    static UncompressedPaintChanges *forUndoStack(QUndoStack *undoStack);
+
+private:
+    explicit UncompressedPaintChanges(QUndoStack *undoStack);
+
+    friend class PaintTileLayer;
+
+    QList<PaintTileLayer*> mCommands;
+    qint64 mMemoryUsage;
+};
 
 /**
  * A command that paints one tile layer on top of another tile layer.
+ *
+ * Only the cells that changed are remembered, along with their previous
+ * contents. Once the uncompressed changes exceed the threshold set in the
+ * preferences, the changes of the least recently used commands are
+ * compressed.
  */
 class PaintTileLayer : public QUndoCommand
 {
@@ -85,12 +119,17 @@ public:
     bool mergeWith(const QUndoCommand *other) override;
 
 private:
+    void paint(TileLayerDelta::Side side);
+    void deltaUsed();
+    void forgetDelta();
+
+    void compressOldChanges();
+
     MapDocument *mMapDocument;
+    UncompressedPaintChanges *mUncompressedChanges;
     TileLayer *mTarget;
-    TileLayer *mSource;
-    TileLayer *mErased;
-    int mX, mY;
-    QRegion mPaintedRegion;
+    TileLayerDelta mDelta;
+    qint64 mMemoryUsage;
     bool mMergeable;
 };
 
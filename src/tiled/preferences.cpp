@@ -63,6 +63,7 @@ Preferences::Preferences()
     mDtdEnabled = boolValue("DtdEnabled");
     mSafeSavingEnabled = boolValue("SafeSavingEnabled", true);
     mReloadTilesetsOnChange = boolValue("ReloadTilesets", true);
+    mCompactTileLayers = boolValue("CompactTileLayers");
     mStampsDirectory = stringValue("StampsDirectory");
     mObjectTypesFile = stringValue("ObjectTypesFile");
     mTemplateDocumentsFile = stringValue("TemplateDocumentsFile");
@@ -82,6 +83,9 @@ Preferences::Preferences()
     mGridFine = intValue("GridFine", 4);
     mObjectLineWidth = realValue("ObjectLineWidth", 2);
     mHighlightCurrentLayer = boolValue("HighlightCurrentLayer");
+    mTileLayerCacheSize = intValue("TileLayerCacheSize", 128);
+    mObjectItemLimit = intValue("ObjectItemLimit", 10000);
+    mUndoCompressionThreshold = intValue("UndoCompressionThreshold", 256);
     mShowTilesetGrid = boolValue("ShowTilesetGrid", true);
     mLanguage = stringValue("Language");
     mUseOpenGL = boolValue("OpenGL");
@@ -126,6 +130,7 @@ Preferences::Preferences()
 
     mSettings->beginGroup(QLatin1String("Automapping"));
     mAutoMapDrawing = boolValue("WhileDrawing");
+    mAutoMapParallelMatching = boolValue("ParallelMatching", true);
     mSettings->endGroup();
 
     mSettings->beginGroup(QLatin1String("MapsDirectory"));
@@ -322,6 +327,55 @@ void Preferences::setHighlightCurrentLayer(bool highlight)
     emit highlightCurrentLayerChanged(mHighlightCurrentLayer);
 }
 
+/**
+ * Sets the memory budget in megabytes for caching pre-rendered parts of tile
+ * layers in each map view. A size of 0 disables the cache.
+ */
+void Preferences::setTileLayerCacheSize(int megabytes)
+{
+    if (mTileLayerCacheSize == megabytes)
+        return;
+
+    mTileLayerCacheSize = megabytes;
+    mSettings->setValue(QLatin1String("Interface/TileLayerCacheSize"),
+                        mTileLayerCacheSize);
+    emit tileLayerCacheSizeChanged(mTileLayerCacheSize);
+}
+
+/**
+ * Sets the number of objects above which an object layer is drawn as a whole,
+ * instead of creating an item for each of its objects.
+ */
+void Preferences::setObjectItemLimit(int limit)
+{
+    if (mObjectItemLimit == limit)
+        return;
+
+    mObjectItemLimit = limit;
+    mSettings->setValue(QLatin1String("Interface/ObjectItemLimit"),
+                        mObjectItemLimit);
+    emit objectItemLimitChanged(mObjectItemLimit);
+}
+
+/**
+ * Sets the amount of memory, in megabytes, that the uncompressed changes in
+ * the undo history of tile painting may use before older changes get
+ * compressed. A value of 0 disables the compression.
+ *
+ * This does not limit the memory used by the undo history, since compressed
+ * changes are still kept.
+ */
+void Preferences::setUndoCompressionThreshold(int megabytes)
+{
+    if (mUndoCompressionThreshold == megabytes)
+        return;
+
+    mUndoCompressionThreshold = megabytes;
+    mSettings->setValue(QLatin1String("Interface/UndoCompressionThreshold"),
+                        mUndoCompressionThreshold);
+    emit undoCompressionThresholdChanged(mUndoCompressionThreshold);
+}
+
 void Preferences::setShowTilesetGrid(bool showTilesetGrid)
 {
     if (mShowTilesetGrid == showTilesetGrid)
@@ -418,6 +472,20 @@ void Preferences::setReloadTilesetsOnChanged(bool value)
     tilesetManager->setReloadTilesetsOnChange(mReloadTilesetsOnChange);
 }
 
+/**
+ * Sets whether the tile layers of maps opened from now on use compact
+ * storage for their cells.
+ */
+void Preferences::setCompactTileLayers(bool compact)
+{
+    if (mCompactTileLayers == compact)
+        return;
+
+    mCompactTileLayers = compact;
+    mSettings->setValue(QLatin1String("Storage/CompactTileLayers"),
+                        mCompactTileLayers);
+}
+
 void Preferences::setUseOpenGL(bool useOpenGL)
 {
     if (mUseOpenGL == useOpenGL)
@@ -507,6 +575,12 @@ void Preferences::setAutomappingDrawing(bool enabled)
     mSettings->setValue(QLatin1String("Automapping/WhileDrawing"), enabled);
 }
 
+void Preferences::setAutomappingParallelMatching(bool enabled)
+{
+    mAutoMapParallelMatching = enabled;
+    mSettings->setValue(QLatin1String("Automapping/ParallelMatching"), enabled);
+}
+
 QString Preferences::mapsDirectory() const
 {
     return mMapsDirectory;
@@ -57,6 +57,9 @@ public:
     qreal objectLineWidth() const { return mObjectLineWidth; }
 
     bool highlightCurrentLayer() const { return mHighlightCurrentLayer; }
+    int tileLayerCacheSize() const { return mTileLayerCacheSize; }
+    int objectItemLimit() const { return mObjectItemLimit; }
+    int undoCompressionThreshold() const { return mUndoCompressionThreshold; }
     bool showTilesetGrid() const { return mShowTilesetGrid; }
 
     enum ObjectLabelVisiblity {
@@ -101,6 +104,9 @@ public:
     bool reloadTilesetsOnChange() const;
     void setReloadTilesetsOnChanged(bool value);
 
+    bool compactTileLayers() const { return mCompactTileLayers; }
+    void setCompactTileLayers(bool compact);
+
     bool useOpenGL() const { return mUseOpenGL; }
     void setUseOpenGL(bool useOpenGL);
 
@@ -119,6 +125,7 @@ public:
     void setLastPath(FileType fileType, const QString &path);
 
     bool automappingDrawing() const { return mAutoMapDrawing; }
+    bool automappingParallelMatching() const { return mAutoMapParallelMatching; }
 
     QString mapsDirectory() const;
     void setMapsDirectory(const QString &path);
@@ -168,8 +175,12 @@ public slots:
     void setGridFine(int gridFine);
     void setObjectLineWidth(qreal lineWidth);
     void setHighlightCurrentLayer(bool highlight);
+    void setTileLayerCacheSize(int megabytes);
+    void setObjectItemLimit(int limit);
+    void setUndoCompressionThreshold(int megabytes);
     void setShowTilesetGrid(bool showTilesetGrid);
     void setAutomappingDrawing(bool enabled);
+    void setAutomappingParallelMatching(bool enabled);
     void setOpenLastFilesOnStartup(bool load);
     void setPluginEnabled(const QString &fileName, bool enabled);
 
@@ -186,6 +197,9 @@ signals:
     void gridFineChanged(int gridFine);
     void objectLineWidthChanged(qreal lineWidth);
     void highlightCurrentLayerChanged(bool highlight);
+    void tileLayerCacheSizeChanged(int megabytes);
+    void objectItemLimitChanged(int limit);
+    void undoCompressionThresholdChanged(int megabytes);
     void showTilesetGridChanged(bool showTilesetGrid);
     void objectLabelVisibilityChanged(ObjectLabelVisiblity);
 
@@ -230,6 +244,9 @@ private:
     int mGridFine;
     qreal mObjectLineWidth;
     bool mHighlightCurrentLayer;
+    int mTileLayerCacheSize;
+    int mObjectItemLimit;
+    int mUndoCompressionThreshold;
     bool mShowTilesetGrid;
     bool mOpenLastFilesOnStartup;
     ObjectLabelVisiblity mObjectLabelVisibility;
@@ -243,10 +260,12 @@ private:
     bool mSafeSavingEnabled;
     QString mLanguage;
     bool mReloadTilesetsOnChange;
+    bool mCompactTileLayers;
     bool mUseOpenGL;
     ObjectTypes mObjectTypes;
 
     bool mAutoMapDrawing;
+    bool mAutoMapParallelMatching;
 
     QString mMapsDirectory;
     QString mStampsDirectory;
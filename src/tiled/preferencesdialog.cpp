@@ -84,6 +84,10 @@ PreferencesDialog::PreferencesDialog(QWidget *parent)
             preferences, &Preferences::setOpenLastFilesOnStartup);
     connect(mUi->safeSaving, &QCheckBox::toggled,
             preferences, &Preferences::setSafeSavingEnabled);
+    connect(mUi->compactTileLayers, &QCheckBox::toggled,
+            preferences, &Preferences::setCompactTileLayers);
+    connect(mUi->automappingParallelMatching, &QCheckBox::toggled,
+            preferences, &Preferences::setAutomappingParallelMatching);
 
     connect(mUi->languageCombo, SIGNAL(currentIndexChanged(int)),
             SLOT(languageSelected(int)));
@@ -146,6 +150,8 @@ void PreferencesDialog::fromPreferences()
     mUi->enableDtd->setChecked(prefs->dtdEnabled());
     mUi->openLastFiles->setChecked(prefs->openLastFilesOnStartup());
     mUi->safeSaving->setChecked(prefs->safeSavingEnabled());
+    mUi->compactTileLayers->setChecked(prefs->compactTileLayers());
+    mUi->automappingParallelMatching->setChecked(prefs->automappingParallelMatching());
     if (mUi->openGL->isEnabled())
         mUi->openGL->setChecked(prefs->useOpenGL());
 
@@ -108,6 +108,17 @@ PropertyBrowser::PropertyBrowser(QWidget *parent)
     mLayerFormatNames.append(QCoreApplication::translate("PreferencesDialog", "Base64 (gzip compressed)"));
     mLayerFormatNames.append(QCoreApplication::translate("PreferencesDialog", "Base64 (zlib compressed)"));
     mLayerFormatNames.append(QCoreApplication::translate("PreferencesDialog", "CSV"));
+    mLayerFormatValues << Map::XML << Map::Base64 << Map::Base64Gzip << Map::Base64Zlib << Map::CSV;
+
+    // Only offer the formats relying on optional libraries when available
+    if (layerDataFormatSupported(Map::Base64Zstd)) {
+        mLayerFormatNames.append(QCoreApplication::translate("PreferencesDialog", "Base64 (Zstandard compressed)"));
+        mLayerFormatValues.append(Map::Base64Zstd);
+    }
+    if (layerDataFormatSupported(Map::Base64Lz4)) {
+        mLayerFormatNames.append(QCoreApplication::translate("PreferencesDialog", "Base64 (LZ4 compressed)"));
+        mLayerFormatValues.append(Map::Base64Lz4);
+    }
 
     mRenderOrderNames.append(QCoreApplication::translate("PreferencesDialog", "Right Down"));
     mRenderOrderNames.append(QCoreApplication::translate("PreferencesDialog", "Right Up"));
@@ -618,6 +629,13 @@ void PropertyBrowser::addMapProperties()
 
     layerFormatProperty->setAttribute(QLatin1String("enumNames"), mLayerFormatNames);
 
+    QtVariantProperty *compressionLevelProperty =
+            addProperty(CompressionLevelProperty, QVariant::Int,
+                        tr("Compression Level"), groupProperty);
+
+    compressionLevelProperty->setAttribute(QLatin1String("minimum"), -1);
+    compressionLevelProperty->setToolTip(tr("Use -1 for the default level of the compression method"));
+
     QtVariantProperty *renderOrderProperty =
             addProperty(RenderOrderProperty,
                         QtVariantPropertyManager::enumTypeId(),
@@ -963,10 +981,15 @@ void PropertyBrowser::applyMapValue(PropertyId id, const QVariant &val)
         break;
     }
     case LayerFormatProperty: {
-        Map::LayerDataFormat format = static_cast<Map::LayerDataFormat>(val.toInt());
+        Map::LayerDataFormat format = mLayerFormatValues.value(val.toInt(), Map::Base64Zlib);
         command = new ChangeMapProperty(mMapDocument, format);
         break;
     }
+    case CompressionLevelProperty: {
+        command = new ChangeMapProperty(mMapDocument, ChangeMapProperty::CompressionLevel,
+                                        val.toInt());
+        break;
+    }
     case RenderOrderProperty: {
         Map::RenderOrder renderOrder = static_cast<Map::RenderOrder>(val.toInt());
         command = new ChangeMapProperty(mMapDocument, renderOrder);
@@ -1544,7 +1567,11 @@ void PropertyBrowser::updateProperties()
         mIdToProperty[HexSideLengthProperty]->setValue(map->hexSideLength());
         mIdToProperty[StaggerAxisProperty]->setValue(map->staggerAxis());
         mIdToProperty[StaggerIndexProperty]->setValue(map->staggerIndex());
-        mIdToProperty[LayerFormatProperty]->setValue(map->layerDataFormat());
+        mIdToProperty[LayerFormatProperty]->setValue(mLayerFormatValues.indexOf(map->layerDataFormat()));
+        mIdToProperty[CompressionLevelProperty]->setAttribute(QLatin1String("maximum"),
+                                                              maximumCompressionLevel(compressionMethod(map->layerDataFormat())));
+        mIdToProperty[CompressionLevelProperty]->setValue(map->compressionLevel());
+        mIdToProperty[CompressionLevelProperty]->setEnabled(isCompressed(map->layerDataFormat()));
         mIdToProperty[RenderOrderProperty]->setValue(map->renderOrder());
         mIdToProperty[BackgroundColorProperty]->setValue(map->backgroundColor());
         break;
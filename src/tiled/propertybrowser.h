@@ -22,8 +22,10 @@
 
 #include <QHash>
 #include <QUndoCommand>
+#include <QVector>
 
 #include <QtTreePropertyBrowser>
+#include "map.h"
 #include "properties.h"
 
 class QtGroupPropertyManager;
@@ -142,6 +144,7 @@ private:
         StaggerIndexProperty,
         RenderOrderProperty,
         LayerFormatProperty,
+        CompressionLevelProperty,
         ImageSourceProperty,
         TilesetImageParametersProperty,
         FlippingProperty,
@@ -230,6 +233,7 @@ private:
     QStringList mOrientationNames;
     QStringList mTilesetOrientationNames;
     QStringList mLayerFormatNames;
+    QVector<Map::LayerDataFormat> mLayerFormatValues;
     QStringList mRenderOrderNames;
     QStringList mFlippingFlagNames;
     QStringList mDrawOrderNames;
@@ -147,6 +147,7 @@ SOURCES += aboutdialog.cpp \
     imagecolorpickerwidget.cpp \
     imagelayeritem.cpp \
     languagemanager.cpp \
+    largeobjectgroupitem.cpp \
     layerdock.cpp \
     layeritem.cpp \
     layermodel.cpp \
@@ -158,6 +159,8 @@ SOURCES += aboutdialog.cpp \
     mapdocumentactionhandler.cpp \
     mapdocument.cpp \
     mapeditor.cpp \
+    maploader.cpp \
+    maploadingwidget.cpp \
     mapobjectitem.cpp \
     mapobjectmodel.cpp \
     mapscene.cpp \
@@ -226,6 +229,7 @@ SOURCES += aboutdialog.cpp \
     tiledapplication.cpp \
     tiledproxystyle.cpp \
     tilelayeritem.cpp \
+    tilelayerrendercache.cpp \
     tilepainter.cpp \
     tileselectionitem.cpp \
     tileselectiontool.cpp \
@@ -341,6 +345,7 @@ HEADERS += aboutdialog.h \
     imagecolorpickerwidget.h \
     imagelayeritem.h \
     languagemanager.h \
+    largeobjectgroupitem.h \
     layerdock.h \
     layeritem.h \
     layermodel.h \
@@ -352,6 +357,8 @@ HEADERS += aboutdialog.h \
     mapdocumentactionhandler.h \
     mapdocument.h \
     mapeditor.h \
+    maploader.h \
+    maploadingwidget.h \
     mapobjectitem.h \
     mapobjectmodel.h \
     mapscene.h \
@@ -423,6 +430,7 @@ HEADERS += aboutdialog.h \
     tiledapplication.h \
     tiledproxystyle.h \
     tilelayeritem.h \
+    tilelayerrendercache.h \
     tilepainter.h \
     tileselectionitem.h \
     tileselectiontool.h \
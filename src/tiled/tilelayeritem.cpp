@@ -24,6 +24,7 @@
 #include "map.h"
 #include "mapdocument.h"
 #include "maprenderer.h"
+#include "tilelayerrendercache.h"
 
 #include <QPainter>
 #include <QStyleOptionGraphicsItem>
@@ -31,9 +32,12 @@
 using namespace Tiled;
 using namespace Tiled::Internal;
 
-TileLayerItem::TileLayerItem(TileLayer *layer, MapDocument *mapDocument, QGraphicsItem *parent)
+TileLayerItem::TileLayerItem(TileLayer *layer, MapDocument *mapDocument,
+                             TileLayerRenderCache *renderCache,
+                             QGraphicsItem *parent)
     : LayerItem(layer, parent)
     , mMapDocument(mapDocument)
+    , mRenderCache(renderCache)
 {
     setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
 
@@ -70,5 +74,8 @@ void TileLayerItem::paint(QPainter *painter,
 {
     MapRenderer *renderer = mMapDocument->renderer();
     // TODO: Display a border around the layer when selected
+    if (mRenderCache && mRenderCache->draw(painter, renderer, tileLayer(), option->exposedRect))
+        return;
+
     renderer->drawTileLayer(painter, tileLayer(), option->exposedRect);
 }
@@ -28,6 +28,7 @@ namespace Tiled {
 namespace Internal {
 
 class MapDocument;
+class TileLayerRenderCache;
 
 /**
  * A graphics item displaying a tile layer in a QGraphicsView.
@@ -40,8 +41,12 @@ public:
      *
      * @param layer       the tile layer to be displayed
      * @param mapDocument the map document owning the map of this layer
+     * @param renderCache the cache to draw the layer from, or nullptr to
+     *                    always draw the layer directly
      */
-    TileLayerItem(TileLayer *layer, MapDocument *mapDocument, QGraphicsItem *parent = nullptr);
+    TileLayerItem(TileLayer *layer, MapDocument *mapDocument,
+                  TileLayerRenderCache *renderCache = nullptr,
+                  QGraphicsItem *parent = nullptr);
 
     TileLayer *tileLayer() const;
 
@@ -63,6 +68,7 @@ public:
 
 private:
     MapDocument *mMapDocument;
+    TileLayerRenderCache *mRenderCache;
     QRectF mBoundingRect;
 };
 
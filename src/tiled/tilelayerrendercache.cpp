@@ -0,0 +1,301 @@
+/*
+ * tilelayerrendercache.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tilelayerrendercache.h"
+
+#include "map.h"
+#include "maprenderer.h"
+#include "tile.h"
+#include "tilelayer.h"
+
+#include <QPaintDevice>
+#include <QtMath>
+
+#include <algorithm>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+// Size of the render tiles on screen, in device independent pixels
+static const int RenderTileSize = 256;
+
+QRectF TileLayerRenderCache::Key::rect() const
+{
+    return QRectF((QPointF(position) * RenderTileSize - phase) / scale,
+                  QSizeF(RenderTileSize, RenderTileSize) / scale);
+}
+
+TileLayerRenderCache::TileLayerRenderCache()
+{
+    setMaxSize(128);
+}
+
+TileLayerRenderCache::~TileLayerRenderCache()
+{
+    mRenderTiles.clear();
+}
+
+/**
+ * Sets the maximum size of the cache in \a megabytes. A size of 0 disables
+ * the cache.
+ */
+void TileLayerRenderCache::setMaxSize(int megabytes)
+{
+    // The cost of each render tile is its size in kilobytes
+    mRenderTiles.setMaxCost(std::max(0, megabytes) * 1024);
+}
+
+/**
+ * Draws the \a exposed part of the given tile \a layer using the cached
+ * render tiles, rendering any missing ones with the given \a renderer.
+ *
+ * Returns false when the layer could not be drawn from the cache, for example
+ * because the painter is rotated or the exposed area needs more render tiles
+ * than fit in the cache. The layer should be drawn directly in that case.
+ */
+bool TileLayerRenderCache::draw(QPainter *painter,
+                                const MapRenderer *renderer,
+                                const TileLayer *layer,
+                                const QRectF &exposed)
+{
+    const QTransform transform = painter->worldTransform();
+    if (transform.type() > QTransform::TxScale)
+        return false;
+
+    const qreal scale = transform.m11();
+    if (scale <= 0 || scale != transform.m22())
+        return false;
+
+    const qreal devicePixelRatio = painter->device()->devicePixelRatioF();
+    const int pixelSize = qCeil(RenderTileSize * devicePixelRatio);
+    const int cost = std::max(1, pixelSize * pixelSize * 4 / 1024);
+
+    // The render tiles are drawn at whole pixels. The remaining fraction of
+    // the translation is rendered into them, to keep them aligned with the
+    // rest of the scene.
+    const QPoint origin(qFloor(transform.dx()), qFloor(transform.dy()));
+    const QPointF phase(transform.dx() - origin.x(), transform.dy() - origin.y());
+
+    const QRectF area(exposed.topLeft() * scale + phase,
+                      exposed.size() * scale);
+
+    const int left = qFloor(area.left() / RenderTileSize);
+    const int top = qFloor(area.top() / RenderTileSize);
+    const int right = qCeil(area.right() / RenderTileSize) - 1;
+    const int bottom = qCeil(area.bottom() / RenderTileSize) - 1;
+
+    const qint64 tileCount = qint64(right - left + 1) * (bottom - top + 1);
+    if (tileCount * cost > mRenderTiles.maxCost())
+        return false;
+
+    painter->save();
+    painter->setWorldTransform(QTransform::fromTranslate(origin.x(), origin.y()));
+
+    for (int y = top; y <= bottom; ++y) {
+        for (int x = left; x <= right; ++x) {
+            const Key key { layer, scale, devicePixelRatio, phase, QPoint(x, y) };
+            const QPoint pos(x * RenderTileSize, y * RenderTileSize);
+
+            if (RenderTile *renderTile = mRenderTiles.object(key)) {
+                painter->drawPixmap(pos, renderTile->pixmap);
+            } else {
+                renderTile = render(renderer, layer, key, painter->renderHints());
+                painter->drawPixmap(pos, renderTile->pixmap);
+                addToIndex(*renderTile);
+                mRenderTiles.insert(key, renderTile, cost);
+            }
+        }
+    }
+
+    painter->restore();
+    return true;
+}
+
+/**
+ * Discards all render tiles.
+ */
+void TileLayerRenderCache::invalidate()
+{
+    mRenderTiles.clear();
+}
+
+/**
+ * Discards the render tiles of the given \a layer.
+ */
+void TileLayerRenderCache::invalidate(const TileLayer *layer)
+{
+    remove(mKeysByLayer.value(layer));
+}
+
+/**
+ * Discards the render tiles of the given \a layer that intersect with
+ * \a rect, which is in pixels relative to the layer.
+ */
+void TileLayerRenderCache::invalidate(const TileLayer *layer, const QRectF &rect)
+{
+    QSet<Key> keys;
+
+    const auto it = mKeysByLayer.constFind(layer);
+    if (it != mKeysByLayer.constEnd())
+        for (const Key &key : *it)
+            if (key.rect().intersects(rect))
+                keys.insert(key);
+
+    remove(keys);
+}
+
+/**
+ * Discards the render tiles that show any tiles from the given \a tileset.
+ */
+void TileLayerRenderCache::invalidate(const Tileset *tileset)
+{
+    remove(mKeysByTileset.value(tileset));
+}
+
+/**
+ * Discards the render tiles that show any animated tiles from the given
+ * \a tileset.
+ */
+void TileLayerRenderCache::invalidateAnimated(const Tileset *tileset)
+{
+    remove(mKeysByAnimatedTileset.value(tileset));
+}
+
+void TileLayerRenderCache::addToIndex(const RenderTile &renderTile)
+{
+    mKeysByLayer[renderTile.key.layer].insert(renderTile.key);
+    for (const Tileset *tileset : renderTile.tilesets)
+        mKeysByTileset[tileset].insert(renderTile.key);
+    for (const Tileset *tileset : renderTile.animatedTilesets)
+        mKeysByAnimatedTileset[tileset].insert(renderTile.key);
+}
+
+template<typename IndexKey>
+void TileLayerRenderCache::removeFromIndex(QHash<IndexKey, QSet<Key>> &index,
+                                           IndexKey indexKey,
+                                           const Key &key)
+{
+    auto it = index.find(indexKey);
+    if (it == index.end())
+        return;
+
+    it->remove(key);
+    if (it->isEmpty())
+        index.erase(it);
+}
+
+void TileLayerRenderCache::removeFromIndex(const RenderTile &renderTile)
+{
+    removeFromIndex(mKeysByLayer, renderTile.key.layer, renderTile.key);
+    for (const Tileset *tileset : renderTile.tilesets)
+        removeFromIndex(mKeysByTileset, tileset, renderTile.key);
+    for (const Tileset *tileset : renderTile.animatedTilesets)
+        removeFromIndex(mKeysByAnimatedTileset, tileset, renderTile.key);
+}
+
+/**
+ * Removes the render tiles with the given \a keys. The set must not be one
+ * of the indexes, since removing the render tiles changes them.
+ */
+void TileLayerRenderCache::remove(const QSet<Key> &keys)
+{
+    for (const Key &key : keys)
+        mRenderTiles.remove(key);
+}
+
+/**
+ * Returns the area of cells that may be visible within \a rect, taking into
+ * account tiles extending beyond their cell.
+ */
+static QRect cellsInRect(const MapRenderer *renderer,
+                         const TileLayer *layer,
+                         const QRectF &rect)
+{
+    const QMargins drawMargins = layer->drawMargins();
+    const int margin = std::max({ drawMargins.left(), drawMargins.top(),
+                                  drawMargins.right(), drawMargins.bottom() });
+
+    QSize tileSize;
+    if (const Map *map = layer->map())
+        tileSize = map->tileSize();
+
+    const QRectF area = rect.adjusted(-margin - tileSize.width(),
+                                      -margin - tileSize.height(),
+                                      margin + tileSize.width(),
+                                      margin + tileSize.height());
+
+    const QPolygonF corners = {
+        renderer->screenToTileCoords(area.topLeft()),
+        renderer->screenToTileCoords(area.topRight()),
+        renderer->screenToTileCoords(area.bottomLeft()),
+        renderer->screenToTileCoords(area.bottomRight()),
+    };
+
+    const QRectF bounds = corners.boundingRect();
+    return QRect(QPoint(qFloor(bounds.left()), qFloor(bounds.top())),
+                 QPoint(qCeil(bounds.right()), qCeil(bounds.bottom())))
+            .intersected(layer->bounds())
+            .translated(-layer->position());
+}
+
+TileLayerRenderCache::RenderTile *TileLayerRenderCache::render(const MapRenderer *renderer,
+                                                               const TileLayer *layer,
+                                                               const Key &key,
+                                                               QPainter::RenderHints renderHints)
+{
+    RenderTile *renderTile = new RenderTile(this, key);
+
+    const int pixelSize = qCeil(RenderTileSize * key.devicePixelRatio);
+    renderTile->pixmap = QPixmap(pixelSize, pixelSize);
+    renderTile->pixmap.setDevicePixelRatio(key.devicePixelRatio);
+    renderTile->pixmap.fill(Qt::transparent);
+
+    const QRectF rect = key.rect();
+
+    QPainter painter(&renderTile->pixmap);
+    painter.setRenderHints(renderHints);
+    painter.translate(key.phase - key.position * RenderTileSize);
+    painter.scale(key.scale, key.scale);
+    renderer->drawTileLayer(&painter, layer, rect);
+    painter.end();
+
+    // Remember the tilesets used, so that this render tile can be discarded
+    // when their images change or their tiles are animated
+    layer->forEachSpan(cellsInRect(renderer, layer, rect),
+                       [&] (const Chunk *chunk, int x, int y, int length) {
+        if (!chunk)
+            return;
+
+        for (int i = 0; i < length; ++i) {
+            const Cell cell = chunk->cellAt((x + i) & CHUNK_MASK, y & CHUNK_MASK);
+            const Tile *tile = cell.tile();
+            if (!tile)
+                continue;
+
+            const Tileset *tileset = tile->tileset();
+            if (!renderTile->tilesets.contains(tileset))
+                renderTile->tilesets.append(tileset);
+            if (tile->isAnimated() && !renderTile->animatedTilesets.contains(tileset))
+                renderTile->animatedTilesets.append(tileset);
+        }
+    });
+
+    return renderTile;
+}
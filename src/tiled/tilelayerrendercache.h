@@ -0,0 +1,141 @@
+/*
+ * tilelayerrendercache.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QCache>
+#include <QHash>
+#include <QPainter>
+#include <QPixmap>
+#include <QPoint>
+#include <QSet>
+#include <QVector>
+
+namespace Tiled {
+
+class MapRenderer;
+class TileLayer;
+class Tileset;
+
+namespace Internal {
+
+/**
+ * Caches pre-rendered parts of tile layers, so that repainting the map view
+ * while panning is mostly a matter of drawing these images.
+ *
+ * Each layer is divided into square render tiles of a fixed size on screen,
+ * which are rendered separately for each zoom level. When the total size of
+ * the render tiles exceeds the budget, the least recently used ones are
+ * discarded.
+ */
+class TileLayerRenderCache
+{
+public:
+    TileLayerRenderCache();
+    ~TileLayerRenderCache();
+
+    void setMaxSize(int megabytes);
+
+    bool draw(QPainter *painter,
+              const MapRenderer *renderer,
+              const TileLayer *layer,
+              const QRectF &exposed);
+
+    void invalidate();
+    void invalidate(const TileLayer *layer);
+    void invalidate(const TileLayer *layer, const QRectF &rect);
+    void invalidate(const Tileset *tileset);
+    void invalidateAnimated(const Tileset *tileset);
+
+private:
+    struct Key
+    {
+        const TileLayer *layer;
+        qreal scale;
+        qreal devicePixelRatio;
+        QPointF phase;      // sub-pixel offset of the layer on screen
+        QPoint position;
+
+        bool operator==(const Key &other) const
+        {
+            return layer == other.layer &&
+                    scale == other.scale &&
+                    devicePixelRatio == other.devicePixelRatio &&
+                    phase == other.phase &&
+                    position == other.position;
+        }
+
+        QRectF rect() const;
+
+        friend uint qHash(const Key &key, uint seed = 0)
+        {
+            return qHash(key.layer, seed) ^
+                    qHash(key.scale, seed) ^
+                    qHash(key.position.x() * 31 + key.position.y(), seed);
+        }
+    };
+
+    /**
+     * A rendered part of a layer. Removes itself from the indexes of the
+     * cache when it is deleted, which QCache does when evicting it.
+     */
+    struct RenderTile
+    {
+        RenderTile(TileLayerRenderCache *cache, const Key &key)
+            : cache(cache)
+            , key(key)
+        {}
+
+        ~RenderTile() { cache->removeFromIndex(*this); }
+
+        TileLayerRenderCache *cache;
+        Key key;
+        QPixmap pixmap;
+        QVector<const Tileset*> tilesets;
+        QVector<const Tileset*> animatedTilesets;
+    };
+
+    RenderTile *render(const MapRenderer *renderer,
+                       const TileLayer *layer,
+                       const Key &key,
+                       QPainter::RenderHints renderHints);
+
+    void addToIndex(const RenderTile &renderTile);
+    void removeFromIndex(const RenderTile &renderTile);
+
+    template<typename IndexKey>
+    static void removeFromIndex(QHash<IndexKey, QSet<Key>> &index,
+                                IndexKey indexKey,
+                                const Key &key);
+
+    void remove(const QSet<Key> &keys);
+
+    // The keys of the cached render tiles, by layer and by the tilesets they
+    // show. Declared before the cache, since they are needed while it is
+    // destroyed.
+    QHash<const TileLayer*, QSet<Key>> mKeysByLayer;
+    QHash<const Tileset*, QSet<Key>> mKeysByTileset;
+    QHash<const Tileset*, QSet<Key>> mKeysByAnimatedTileset;
+
+    QCache<Key, RenderTile> mRenderTiles;
+};
+
+} // namespace Internal
+} // namespace Tiled
@@ -24,8 +24,6 @@
 #include "mapdocument.h"
 #include "map.h"
 
-#include <QQueue>
-
 using namespace Tiled;
 using namespace Tiled::Internal;
 
@@ -184,141 +182,21 @@ void TilePainter::erase(const QRegion &region)
     emit mMapDocument->regionChanged(paintable, mTileLayer);
 }
 
-static QRegion fillRegion(const TileLayer *layer, QPoint fillOrigin,
-                          Map::Orientation orientation,
-                          Map::StaggerAxis staggerAxis,
-                          Map::StaggerIndex staggerIndex)
+FloodFill TilePainter::computeFill(const QPoint &fillOrigin) const
 {
-    // Create that region that will hold the fill
-    QRegion fillRegion;
-    QRect bounds = layer->map()->infinite() ? layer->bounds() : layer->rect();
-
-    // Silently quit if parameters are unsatisfactory
-    if (!bounds.contains(fillOrigin))
-        return fillRegion;
-
-    bounds.translate(-layer->position());
-
-    // Cache cell that we will match other cells against
-    const Cell matchCell = layer->cellAt(fillOrigin);
-
-    int startX = bounds.left();
-    int startY = bounds.top();
-    int endX = bounds.right() + 1;
-    int endY = bounds.bottom() + 1;
-    int layerWidth = endX - startX;
-    int layerHeight = endY - startY;
-
-    int indexOffset = -(startX + startY * layerWidth);
-
-    const bool isStaggered = orientation == Map::Hexagonal || orientation == Map::Staggered;
-
-    // Create a queue to hold cells that need filling
-    QQueue<QPoint> fillPositions;
-    fillPositions.enqueue(fillOrigin);
-
-    // Create an array that will store which cells have been processed
-    // This is faster than checking if a given cell is in the region/list
-    QVector<bool> processedCellsVec(layerWidth * layerHeight);
-    bool *processedCells = processedCellsVec.data();
-
-    // Loop through queued positions and fill them, while at the same time
-    // checking adjacent positions to see if they should be added
-    while (!fillPositions.isEmpty()) {
-        const QPoint currentPoint = fillPositions.dequeue();
-        const int startOfLine = currentPoint.y() * layerWidth;
-
-        // Seek as far left as we can
-        int left = currentPoint.x();
-        while (left > startX && layer->cellAt(left - 1, currentPoint.y()) == matchCell) {
-            --left;
-            processedCells[indexOffset + startOfLine + left] = true;
-        }
-
-        // Seek as far right as we can
-        int right = currentPoint.x();
-        while (right + 1 < endX && layer->cellAt(right + 1, currentPoint.y()) == matchCell) {
-            ++right;
-            processedCells[indexOffset + startOfLine + right] = true;
-        }
-
-        // Add cells between left and right to the region
-        fillRegion += QRegion(left, currentPoint.y(), right - left + 1, 1);
-
-        bool leftColumnIsStaggered = false;
-        bool rightColumnIsStaggered = false;
-
-        // For hexagonal maps with a staggered Y-axis, we may need to extend the search range
-        if (isStaggered) {
-            if (staggerAxis == Map::StaggerY) {
-                bool rowIsStaggered = ((layer->y() + currentPoint.y()) & 1) ^ staggerIndex;
-                if (rowIsStaggered)
-                    right = qMin(right + 1, endX - 1);
-                else
-                    left = qMax(left - 1, startX);
-            } else {
-                leftColumnIsStaggered = ((layer->x() + left) & 1) ^ staggerIndex;
-                rightColumnIsStaggered = ((layer->x() + right) & 1) ^ staggerIndex;
-            }
-        }
-
-        // Loop between left and right and check if cells above or below need
-        // to be added to the queue.
-        auto findFillPositions = [=,&fillPositions](int left, int right, int y) {
-            bool adjacentCellAdded = false;
-
-            for (int x = left; x <= right; ++x) {
-                const int index = y * layerWidth + x;
-
-                if (!processedCells[indexOffset + index] && layer->cellAt(x, y) == matchCell) {
-                    // Do not add the cell to the queue if an adjacent cell was added.
-                    if (!adjacentCellAdded) {
-                        fillPositions.enqueue(QPoint(x, y));
-                        adjacentCellAdded = true;
-                    }
-                } else {
-                    adjacentCellAdded = false;
-                }
-
-                processedCells[indexOffset + index] = true;
-            }
-        };
-
-        if (currentPoint.y() > startY) {
-            int _left = left;
-            int _right = right;
-
-            if (isStaggered && staggerAxis == Map::StaggerX) {
-                if (!leftColumnIsStaggered)
-                    _left = qMax(left - 1, startX);
-                if (!rightColumnIsStaggered)
-                    _right = qMin(right + 1, endX - 1);
-            }
-
-            findFillPositions(_left, _right, currentPoint.y() - 1);
-        }
-
-        if (currentPoint.y() + 1 < endY) {
-            int _left = left;
-            int _right = right;
-
-            if (isStaggered && staggerAxis == Map::StaggerX) {
-                if (leftColumnIsStaggered)
-                    _left = qMax(left - 1, startX);
-                if (rightColumnIsStaggered)
-                    _right = qMin(right + 1, endX - 1);
-            }
-
-            findFillPositions(_left, _right, currentPoint.y() + 1);
-        }
-    }
-
-    return fillRegion;
+    Map *map = mMapDocument->map();
+    return FloodFill::compute(mTileLayer, fillOrigin,
+                              map->orientation(), map->staggerAxis(), map->staggerIndex());
 }
 
 QRegion TilePainter::computePaintableFillRegion(const QPoint &fillOrigin) const
 {
-    QRegion region = computeFillRegion(fillOrigin);
+    return paintableFillRegion(computeFill(fillOrigin));
+}
+
+QRegion TilePainter::paintableFillRegion(const FloodFill &fill) const
+{
+    QRegion region = fill.toRegion();
 
     const QRegion &selection = mMapDocument->selectedArea();
     if (!selection.isEmpty())
@@ -329,10 +207,7 @@ QRegion TilePainter::computePaintableFillRegion(const QPoint &fillOrigin) const
 
 QRegion TilePainter::computeFillRegion(const QPoint &fillOrigin) const
 {
-    Map *map = mMapDocument->map();
-    QRegion region = fillRegion(mTileLayer, fillOrigin - mTileLayer->position(),
-                                map->orientation(), map->staggerAxis(), map->staggerIndex());
-    return region.translated(mTileLayer->position());
+    return computeFill(fillOrigin).toRegion();
 }
 
 bool TilePainter::isDrawable(int x, int y) const
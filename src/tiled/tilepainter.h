@@ -21,6 +21,7 @@
 
 #pragma once
 
+#include "floodfill.h"
 #include "tilelayer.h"
 
 #include <QRegion>
@@ -91,12 +92,25 @@ public:
      */
     void erase(const QRegion &region);
 
+    /**
+     * Computes the area made up of all cells of the same type as that at
+     * \a fillOrigin that are connected. Does not take into account the
+     * current selection.
+     */
+    FloodFill computeFill(const QPoint &fillOrigin) const;
+
     /**
      * Computes the paintable fill region made up of all cells of the same type
      * as that at \a fillOrigin that are connected.
      */
     QRegion computePaintableFillRegion(const QPoint &fillOrigin) const;
 
+    /**
+     * Returns the part of the given \a fill that is within the current
+     * selection, if any.
+     */
+    QRegion paintableFillRegion(const FloodFill &fill) const;
+
     /**
      * Computes a fill region made up of all cells of the same type as that
      * at \a fillOrigin that are connected. Does not take into account the
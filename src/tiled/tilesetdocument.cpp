@@ -22,6 +22,7 @@
 
 #include "mapdocument.h"
 #include "map.h"
+#include "objectgroup.h"
 #include "terrain.h"
 #include "wangset.h"
 #include "tile.h"
@@ -112,6 +113,7 @@ bool TilesetDocument::save(const QString &fileName, QString *error)
     undoStack()->setClean();
 
     mTileset->setFileName(fileName);
+    TilesetManager::instance()->tilesetFileNameChanged(*mTileset);
     setFileName(fileName);
 
     mLastSaved = QFileInfo(fileName).lastModified();
@@ -205,6 +207,7 @@ void TilesetDocument::swapTileset(SharedTileset &tileset)
     setCurrentObject(mTileset.data());
 
     mTileset->swap(*tileset);
+    tileSizesChanged();
     emit tilesetChanged(mTileset.data());
 }
 
@@ -305,6 +308,7 @@ void TilesetDocument::setTileImage(Tile *tile, const QPixmap &image, const QUrl
     Q_ASSERT(tile->tileset() == mTileset.data());
 
     mTileset->setTileImage(tile, image, source);
+    tileSizesChanged();
 
     emit tileImageSourceChanged(tile);
 
@@ -312,6 +316,19 @@ void TilesetDocument::setTileImage(Tile *tile, const QPixmap &image, const QUrl
         emit mapDocument->tileImageSourceChanged(tile);
 }
 
+/**
+ * Lets the object groups of the maps using this tileset know that the size
+ * of its tiles may have changed, so that they update the tile object bounds.
+ */
+void TilesetDocument::tileSizesChanged()
+{
+    for (MapDocument *mapDocument : mapDocuments()) {
+        const auto objectGroups = mapDocument->map()->objectGroups();
+        for (ObjectGroup *objectGroup : objectGroups)
+            objectGroup->tileSizesChanged(mTileset.data());
+    }
+}
+
 void TilesetDocument::onPropertyAdded(Object *object, const QString &name)
 {
     for (MapDocument *mapDocument : mapDocuments())
@@ -149,6 +149,8 @@ private slots:
     void onWangSetRemoved(WangSet *wangSet);
 
 private:
+    void tileSizesChanged();
+
     SharedTileset mTileset;
     QList<MapDocument*> mMapDocuments;
 
@@ -23,6 +23,7 @@
 #include "changetileterrain.h"
 #include "changetilewangid.h"
 #include "map.h"
+#include "maprenderer.h"
 #include "preferences.h"
 #include "stylehelper.h"
 #include "terrain.h"
@@ -531,11 +532,11 @@ void TileDelegate::paint(QPainter *painter,
     if (!tile)
         return;
 
-    const QPixmap &tileImage = tile->image();
+    const QPixmap &tileImage = tile->atlasImage();
     const int extra = mTilesetView->drawGrid() ? 1 : 0;
     const qreal zoom = mTilesetView->scale();
 
-    QSize tileSize = tileImage.size();
+    QSize tileSize = tile->size();
     if (tileImage.isNull()) {
         Tileset *tileset = model->tileset();
         if (tileset->isCollection()) {
@@ -559,7 +560,8 @@ void TileDelegate::paint(QPainter *painter,
             painter->setRenderHint(QPainter::SmoothPixmapTransform);
 
     if (!tileImage.isNull())
-        painter->drawPixmap(targetRect, tileImage);
+        painter->drawPixmap(QRectF(targetRect), tileImage,
+                            CellRenderer::sourceRect(painter, tileImage, tile->imageRect()));
     else
         mTilesetView->imageMissingIcon().paint(painter, targetRect, Qt::AlignBottom | Qt::AlignLeft);
 
@@ -568,8 +570,8 @@ void TileDelegate::paint(QPainter *painter,
     if (mTilesetView->markAnimatedTiles() && tile->isAnimated()) {
         painter->save();
 
-        qreal scale = qMin(tileImage.width() / 32.0,
-                           tileImage.height() / 32.0);
+        qreal scale = qMin(tile->width() / 32.0,
+                           tile->height() / 32.0);
 
         painter->setClipRect(targetRect);
         painter->translate(targetRect.right(),
@@ -673,10 +675,9 @@ QSize TileDelegate::sizeHint(const QStyleOptionViewItem & /* option */,
     const int extra = mTilesetView->drawGrid() ? 1 : 0;
 
     if (const Tile *tile = m->tileAt(index)) {
-        const QPixmap &image = tile->image();
-        QSize tileSize = image.size();
+        QSize tileSize = tile->size();
 
-        if (image.isNull()) {
+        if (tile->atlasImage().isNull()) {
             Tileset *tileset = m->tileset();
             if (tileset->isCollection()) {
                 tileSize = QSize(32, 32);
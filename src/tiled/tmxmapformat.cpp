@@ -131,6 +131,25 @@ SharedTileset TsxTilesetFormat::read(const QString &fileName)
     return tileset;
 }
 
+/**
+ * Reads the tileset with its own MapReader, so that several tilesets can be
+ * read at the same time.
+ */
+SharedTileset TsxTilesetFormat::readWithError(const QString &fileName, QString *error)
+{
+    MapReader reader;
+    SharedTileset tileset = reader.readTileset(fileName);
+
+    if (error) {
+        if (!tileset)
+            *error = reader.errorString();
+        else
+            *error = QString();
+    }
+
+    return tileset;
+}
+
 bool TsxTilesetFormat::write(const Tileset &tileset, const QString &fileName)
 {
     Preferences *prefs = Preferences::instance();
@@ -88,6 +88,7 @@ public:
     TsxTilesetFormat(QObject *parent = nullptr);
 
     SharedTileset read(const QString &fileName) override;
+    SharedTileset readWithError(const QString &fileName, QString *error) override;
 
     bool write(const Tileset &tileset, const QString &fileName) override;
 
@@ -25,6 +25,13 @@
 #include "tilelayer.h"
 #include "wangset.h"
 
+#include <QBitArray>
+#include <QHash>
+#include <QtAlgorithms>
+
+#include <algorithm>
+#include <random>
+
 using namespace Tiled;
 using namespace Internal;
 
@@ -45,6 +52,8 @@ WangFiller::WangFiller(WangSet *wangSet,
     : mWangSet(wangSet)
     , mStaggeredRenderer(staggeredRenderer)
     , mStaggerAxis(staggerAxis)
+    , mFillMethod(PropagatingFill)
+    , mSeed(qrand())
 {
 }
 
@@ -145,6 +154,15 @@ TileLayer *WangFiller::fillRegion(const TileLayer &back,
 {
     Q_ASSERT(mWangSet);
 
+    if (mFillMethod == GreedyFill)
+        return fillRegionGreedy(back, fillRegion);
+
+    return fillRegionPropagating(back, fillRegion);
+}
+
+TileLayer *WangFiller::fillRegionGreedy(const TileLayer &back,
+                                        const QRegion &fillRegion) const
+{
     QRect boundingRect = fillRegion.boundingRect();
 
     TileLayer *tileLayer = new TileLayer(QString(),
@@ -243,10 +261,447 @@ TileLayer *WangFiller::fillRegion(const TileLayer &back,
     return tileLayer;
 }
 
-const Cell &WangFiller::getCell(const TileLayer &back,
-                                const TileLayer &front,
-                                const QRegion &fillRegion,
-                                QPoint point) const
+/**
+ * Returns the color at the given nibble of \a wangId, where the even nibbles
+ * are the edges and the odd nibbles are the corners.
+ */
+static unsigned slotColor(WangId wangId, int slot)
+{
+    return (wangId >> (slot * 4)) & 0xf;
+}
+
+/**
+ * Returns whether a tile with the \a adjacent wangId can be placed at the
+ * given position around a tile with \a wangId. The shared edges and corners
+ * are those set by WangId::updateToAdjacent. A 0 matches any color.
+ */
+static bool canBeAdjacent(WangId wangId, WangId adjacent, int position)
+{
+    const int index = position / 2;
+    int slots[3][2];
+    int count;
+
+    if (position & 1) {
+        slots[0][0] = index * 2 + 1;
+        slots[0][1] = ((index + 2) % 4) * 2 + 1;
+        count = 1;
+    } else {
+        slots[0][0] = index * 2;
+        slots[0][1] = ((index + 2) % 4) * 2;
+        slots[1][0] = index * 2 + 1;
+        slots[1][1] = ((index + 1) % 4) * 2 + 1;
+        slots[2][0] = ((index + 3) % 4) * 2 + 1;
+        slots[2][1] = ((index + 2) % 4) * 2 + 1;
+        count = 3;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        const unsigned color = slotColor(wangId, slots[i][0]);
+        const unsigned adjacentColor = slotColor(adjacent, slots[i][1]);
+        if (color && adjacentColor && color != adjacentColor)
+            return false;
+    }
+
+    return true;
+}
+
+namespace {
+
+/**
+ * Keeps track of the wangIds that are still possible for each cell of the
+ * region being filled, as a bitset over the wangIds used in the wang set.
+ *
+ * Whenever the candidates of a cell are reduced, the candidates of its
+ * neighbors that no longer have a matching candidate are removed as well,
+ * until the whole region is consistent again. Changes are recorded, so that
+ * a choice leading to a cell without candidates can be undone.
+ */
+class CandidateGrid
+{
+public:
+    CandidateGrid(const QVector<WangId> &wangIds, int cellCount)
+        : mWangIdCount(wangIds.size())
+        , mWords((mWangIdCount + 63) / 64)
+        , mCandidates(cellCount * mWords)
+        , mNeighbors(cellCount * 8, -1)
+        , mQueued(cellCount)
+        , mAll(mWords)
+        , mSupported(mWords)
+        , mCompatible(8 * mWangIdCount * mWords)
+    {
+        for (int i = 0; i < mWangIdCount; ++i)
+            mAll[i / 64] |= quint64(1) << (i % 64);
+
+        for (int position = 0; position < 8; ++position) {
+            for (int i = 0; i < mWangIdCount; ++i) {
+                quint64 *compatible = compatibleAt(position, i);
+                for (int j = 0; j < mWangIdCount; ++j)
+                    if (canBeAdjacent(wangIds.at(i), wangIds.at(j), position))
+                        compatible[j / 64] |= quint64(1) << (j % 64);
+            }
+        }
+    }
+
+    int words() const { return mWords; }
+    const QVector<quint64> &all() const { return mAll; }
+
+    void setNeighbor(int cell, int position, int neighbor)
+    { mNeighbors[cell * 8 + position] = neighbor; }
+
+    quint64 *candidatesAt(int cell) { return mCandidates.data() + cell * mWords; }
+
+    bool isEmpty(int cell) const
+    {
+        const quint64 *candidates = mCandidates.constData() + cell * mWords;
+        for (int w = 0; w < mWords; ++w)
+            if (candidates[w])
+                return false;
+        return true;
+    }
+
+    /**
+     * Returns whether the candidates at any position are restricted by a
+     * neighbor that may still be anything.
+     */
+    bool allRestrictsNeighbors()
+    {
+        for (int position = 0; position < 8; ++position) {
+            std::fill(mSupported.begin(), mSupported.end(), 0);
+            for (int i = 0; i < mWangIdCount; ++i)
+                unite(mSupported.data(), compatibleAt(position, i));
+            if (mSupported != mAll)
+                return true;
+        }
+        return false;
+    }
+
+    void enqueue(int cell)
+    {
+        if (!mQueued.testBit(cell)) {
+            mQueued.setBit(cell);
+            mQueue.append(cell);
+        }
+    }
+
+    /**
+     * Leaves only \a wangIdIndex as candidate of the given \a cell.
+     */
+    void assign(int cell, int wangIdIndex)
+    {
+        save(cell);
+        quint64 *candidates = candidatesAt(cell);
+        std::fill(candidates, candidates + mWords, 0);
+        candidates[wangIdIndex / 64] = quint64(1) << (wangIdIndex % 64);
+        enqueue(cell);
+    }
+
+    /**
+     * Removes the candidates of neighbors of the queued cells that no longer
+     * fit any of their candidates, until no more changes are made.
+     *
+     * Returns false as soon as a cell is left without candidates, unless
+     * \a allowEmpty is true, in which case such cells are left empty and
+     * don't restrict their neighbors.
+     */
+    bool propagate(bool allowEmpty)
+    {
+        while (!mQueue.isEmpty()) {
+            const int cell = mQueue.takeLast();
+            mQueued.clearBit(cell);
+
+            if (isEmpty(cell))
+                continue;
+
+            for (int position = 0; position < 8; ++position) {
+                const int neighbor = mNeighbors.at(cell * 8 + position);
+                if (neighbor < 0 || !restrict(neighbor, supported(cell, position)))
+                    continue;
+
+                if (isEmpty(neighbor) && !allowEmpty) {
+                    for (int queued : mQueue)
+                        mQueued.clearBit(queued);
+                    mQueue.clear();
+                    return false;
+                }
+
+                enqueue(neighbor);
+            }
+        }
+
+        return true;
+    }
+
+    int changeCount() const { return mChangedCells.size(); }
+
+    /**
+     * Undoes the changes made to the candidates since there were \a count
+     * changes.
+     */
+    void undo(int count)
+    {
+        while (mChangedCells.size() > count) {
+            const int cell = mChangedCells.takeLast();
+            const int offset = mChangedCells.size() * mWords;
+            std::copy(mChangedCandidates.constBegin() + offset,
+                      mChangedCandidates.constBegin() + offset + mWords,
+                      candidatesAt(cell));
+            mChangedCandidates.resize(offset);
+        }
+    }
+
+    /**
+     * Forgets about the recorded changes, which can then no longer be undone.
+     */
+    void commit()
+    {
+        mChangedCells.clear();
+        mChangedCandidates.clear();
+    }
+
+private:
+    quint64 *compatibleAt(int position, int wangIdIndex)
+    { return mCompatible.data() + (position * mWangIdCount + wangIdIndex) * mWords; }
+
+    void unite(quint64 *bits, const quint64 *other) const
+    {
+        for (int w = 0; w < mWords; ++w)
+            bits[w] |= other[w];
+    }
+
+    // Returns the candidates which fit at the given position around one of
+    // the candidates of the cell
+    const QVector<quint64> &supported(int cell, int position)
+    {
+        std::fill(mSupported.begin(), mSupported.end(), 0);
+
+        const quint64 *candidates = candidatesAt(cell);
+        for (int w = 0; w < mWords; ++w) {
+            quint64 bits = candidates[w];
+            while (bits) {
+                const int bit = qCountTrailingZeroBits(bits);
+                bits &= bits - 1;
+                unite(mSupported.data(), compatibleAt(position, w * 64 + bit));
+            }
+        }
+
+        return mSupported;
+    }
+
+    // Removes the candidates of the cell that are not in the given set,
+    // returning whether any were removed
+    bool restrict(int cell, const QVector<quint64> &allowed)
+    {
+        quint64 *candidates = candidatesAt(cell);
+
+        bool changed = false;
+        for (int w = 0; w < mWords && !changed; ++w)
+            changed = candidates[w] & ~allowed.at(w);
+
+        if (!changed)
+            return false;
+
+        save(cell);
+        for (int w = 0; w < mWords; ++w)
+            candidates[w] &= allowed.at(w);
+
+        return true;
+    }
+
+    void save(int cell)
+    {
+        const quint64 *candidates = candidatesAt(cell);
+        mChangedCells.append(cell);
+        for (int w = 0; w < mWords; ++w)
+            mChangedCandidates.append(candidates[w]);
+    }
+
+    const int mWangIdCount;
+    const int mWords;
+    QVector<quint64> mCandidates;
+    QVector<int> mNeighbors;
+    QVector<int> mQueue;
+    QBitArray mQueued;
+    QVector<quint64> mAll;
+    QVector<quint64> mSupported;
+    QVector<quint64> mCompatible;
+    QVector<int> mChangedCells;
+    QVector<quint64> mChangedCandidates;
+};
+
+} // anonymous namespace
+
+TileLayer *WangFiller::fillRegionPropagating(const TileLayer &back,
+                                             const QRegion &fillRegion) const
+{
+    const QRect bounds = fillRegion.boundingRect();
+
+    TileLayer *tileLayer = new TileLayer(QString(),
+                                         bounds.x(),
+                                         bounds.y(),
+                                         bounds.width(),
+                                         bounds.height());
+
+    // The distinct wangIds that may be chosen, along with their tiles
+    QVector<WangId> wangIds;
+    QVector<QVector<WangTile>> wangTilesOfWangId;
+    QVector<qreal> weights;
+    QHash<WangId, int> wangIdIndex;
+
+    for (const WangTile &wangTile : mWangSet->wangTiles()) {
+        const WangId wangId = wangTile.wangId();
+        const qreal probability = mWangSet->wangIdProbability(wangId);
+        if (probability <= 0)
+            continue;
+
+        auto it = wangIdIndex.find(wangId);
+        if (it == wangIdIndex.end()) {
+            it = wangIdIndex.insert(wangId, wangIds.size());
+            wangIds.append(wangId);
+            wangTilesOfWangId.append(QVector<WangTile>());
+            weights.append(0);
+        }
+
+        wangTilesOfWangId[it.value()].append(wangTile);
+        weights[it.value()] += probability;
+    }
+
+    if (wangIds.isEmpty())
+        return tileLayer;
+
+    // Mark the cells in the region, to avoid looking them up in the QRegion
+    const int width = bounds.width();
+    const int cellCount = width * bounds.height();
+
+    QBitArray inRegion(cellCount);
+    for (const QRect &rect : fillRegion.rects())
+        for (int y = rect.top(); y <= rect.bottom(); ++y)
+            for (int x = rect.left(); x <= rect.right(); ++x)
+                inRegion.setBit((y - bounds.y()) * width + x - bounds.x());
+
+    CandidateGrid grid(wangIds, cellCount);
+    const bool restrictAll = grid.allRestrictsNeighbors();
+
+    // Cells next to the region restrict the candidates to the wangIds that
+    // match them, same as for findMatchingWangTiles
+    QHash<WangId, QVector<quint64>> matchingCandidates;
+    matchingCandidates.insert(0, grid.all());
+
+    for (int cell = 0; cell < cellCount; ++cell) {
+        if (!inRegion.testBit(cell))
+            continue;
+
+        const QPoint point(bounds.x() + cell % width, bounds.y() + cell / width);
+
+        QPoint adjacentPoints[8];
+        getSurroundingPoints(point, mStaggeredRenderer, mStaggerAxis, adjacentPoints);
+
+        Cell surroundingCells[8];
+        bool bordersRegion = false;
+
+        for (int i = 0; i < 8; ++i) {
+            const QPoint p = adjacentPoints[i] - bounds.topLeft();
+            const int neighbor = p.y() * width + p.x();
+
+            if (p.x() >= 0 && p.x() < width && p.y() >= 0 && p.y() < bounds.height()
+                    && inRegion.testBit(neighbor)) {
+                grid.setNeighbor(cell, i, neighbor);
+            } else {
+                surroundingCells[i] = back.cellAt(adjacentPoints[i]);
+                bordersRegion = true;
+            }
+        }
+
+        const WangId wangId = bordersRegion ? mWangSet->wangIdFromSurrounding(surroundingCells)
+                                            : WangId();
+
+        auto it = matchingCandidates.find(wangId);
+        if (it == matchingCandidates.end()) {
+            unsigned mask = 0;
+            for (int slot = 0; slot < 8; ++slot)
+                if (slotColor(wangId, slot))
+                    mask |= 0xfu << (slot * 4);
+
+            QVector<quint64> candidates(grid.words());
+            for (int i = 0; i < wangIds.size(); ++i)
+                if ((wangIds.at(i) & mask) == wangId)
+                    candidates[i / 64] |= quint64(1) << (i % 64);
+
+            it = matchingCandidates.insert(wangId, candidates);
+        }
+
+        std::copy(it.value().constBegin(), it.value().constEnd(), grid.candidatesAt(cell));
+
+        if (restrictAll || wangId)
+            grid.enqueue(cell);
+    }
+
+    grid.propagate(true);
+    grid.commit();
+
+    std::mt19937 random(mSeed);
+
+    // Choose a wangId for each cell, trying the other candidates when the
+    // choice would leave another cell without candidates
+    QVector<int> choices;
+    for (int cell = 0; cell < cellCount; ++cell) {
+        if (!inRegion.testBit(cell) || grid.isEmpty(cell))
+            continue;
+
+        choices.clear();
+        qreal sum = 0;
+        const quint64 *candidates = grid.candidatesAt(cell);
+        for (int i = 0; i < wangIds.size(); ++i) {
+            if (candidates[i / 64] & (quint64(1) << (i % 64))) {
+                choices.append(i);
+                sum += weights.at(i);
+            }
+        }
+
+        int firstChoice = -1;
+        int choice = -1;
+
+        while (!choices.isEmpty()) {
+            const qreal threshold = std::uniform_real_distribution<qreal>(0, std::max<qreal>(sum, 0))(random);
+            int c = 0;
+            for (qreal total = weights.at(choices.at(0)); total < threshold && c < choices.size() - 1; )
+                total += weights.at(choices.at(++c));
+
+            const int candidate = choices.takeAt(c);
+            sum -= weights.at(candidate);
+            if (firstChoice == -1)
+                firstChoice = candidate;
+
+            const int changeCount = grid.changeCount();
+            grid.assign(cell, candidate);
+            if (grid.propagate(false)) {
+                choice = candidate;
+                break;
+            }
+            grid.undo(changeCount);
+        }
+
+        if (choice == -1) {
+            // No choice leaves all other cells with candidates, so settle for
+            // the first one and leave the cells without candidates empty
+            choice = firstChoice;
+            grid.assign(cell, choice);
+            grid.propagate(true);
+        }
+
+        grid.commit();
+
+        const QVector<WangTile> &wangTiles = wangTilesOfWangId.at(choice);
+        const int tileIndex = std::uniform_int_distribution<int>(0, wangTiles.size() - 1)(random);
+        tileLayer->setCell(cell % width, cell / width, wangTiles.at(tileIndex).makeCell());
+    }
+
+    return tileLayer;
+}
+
+Cell WangFiller::getCell(const TileLayer &back,
+                         const TileLayer &front,
+                         const QRegion &fillRegion,
+                         QPoint point) const
 {
     if (!fillRegion.contains(point))
         return back.cellAt(point);
@@ -42,6 +42,19 @@ namespace Internal {
 class WangFiller
 {
 public:
+    /**
+     * The ways in which fillRegion() can choose the cells. PropagatingFill
+     * is the default. GreedyFill is the method used before it was added,
+     * and is faster but may leave cells empty or not matching.
+     */
+    enum FillMethod {
+        // Fills the cells one by one, only checking the adjacent cells
+        GreedyFill,
+        // Keeps track of the possible tiles of all cells, propagating the
+        // effect of each choice through the region
+        PropagatingFill
+    };
+
     explicit WangFiller(WangSet *wangSet,  //the map we are filling to is infinite.
                         StaggeredRenderer *staggeredRenderer = nullptr,
                         Map::StaggerAxis staggerAxis = Map::StaggerX);
@@ -49,6 +62,15 @@ public:
     WangSet *wangSet() const { return mWangSet; }
     void setWangSet(WangSet *wangSet);
 
+    FillMethod fillMethod() const { return mFillMethod; }
+    void setFillMethod(FillMethod fillMethod) { mFillMethod = fillMethod; }
+
+    /* Sets the seed for the random choices made by fillRegion() when using
+     * the PropagatingFill method. Filling the same region with the same seed
+     * gives the same result.
+     * */
+    void setSeed(unsigned seed) { mSeed = seed; }
+
     /* finds a cell from the attached wangSet which fits
      * the given surroundings.
      * If lookForward is true, this will only choose a cell
@@ -64,18 +86,24 @@ public:
      * If lookForward is true, this will only choose a cell
      * which allows all empty adjacent cells to also
      * be filled. If non exist, then no cell will be choosen.
+     * How the cells are chosen depends on the fillMethod().
      * */
     TileLayer *fillRegion(const TileLayer &back,
                           const QRegion &fillRegion) const;
 
 private:
+    TileLayer *fillRegionGreedy(const TileLayer &back,
+                                const QRegion &fillRegion) const;
+    TileLayer *fillRegionPropagating(const TileLayer &back,
+                                     const QRegion &fillRegion) const;
+
     //gets a cell from either the back or front, based on
     //the fill region. Point, front, and fillRegion
     //are relative to back.
-    const Cell &getCell(const TileLayer &back,
-                        const TileLayer &front,
-                        const QRegion &fillRegion,
-                        QPoint point) const;
+    Cell getCell(const TileLayer &back,
+                 const TileLayer &front,
+                 const QRegion &fillRegion,
+                 QPoint point) const;
 
     //gets a wangId based on front and back.
     //adjacent cells are gotten from getCell()
@@ -93,6 +121,8 @@ private:
     WangSet *mWangSet;
     StaggeredRenderer *mStaggeredRenderer;
     Map::StaggerAxis mStaggerAxis;
+    FillMethod mFillMethod;
+    unsigned mSeed;
 };
 
 } // namespace Internal
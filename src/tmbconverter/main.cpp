@@ -0,0 +1,190 @@
+/*
+ * main.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "imagereference.h"
+#include "map.h"
+#include "mapreader.h"
+#include "mapwriter.h"
+#include "tmbreader.h"
+#include "tmbwriter.h"
+
+#include <QDebug>
+#include <QGuiApplication>
+#include <QRect>
+#include <QScopedPointer>
+#include <QStringList>
+
+using namespace Tiled;
+
+namespace {
+
+struct CommandLineOptions {
+    CommandLineOptions()
+        : showHelp(false)
+        , showVersion(false)
+    {}
+
+    bool showHelp;
+    bool showVersion;
+    QString fileToOpen;
+    QString fileToSave;
+    QRect region;
+};
+
+} // anonymous namespace
+
+static void showHelp()
+{
+    // TODO: Make translatable
+    qWarning() <<
+            "Usage:\n"
+            "  tmbconverter [options] [input file] [output file]\n"
+            "\n"
+            "Converts a TMX map to the TMB binary map format, or back. Files with\n"
+            "a .tmb extension are written as TMB, others as TMX.\n"
+            "\n"
+            "Options:\n"
+            "  -h --help               : Display this help\n"
+            "  -v --version            : Display the version\n"
+            "     --region X,Y,W,H     : Only decode the tile layer data of a TMB map\n"
+            "                            that intersects the given region\n";
+}
+
+static void showVersion()
+{
+    qWarning().noquote() << "TMB Map Converter"
+                         << QCoreApplication::applicationVersion();
+}
+
+static bool parseRegion(const QString &string, QRect &region)
+{
+    const QStringList parts = string.split(QLatin1Char(','));
+    if (parts.size() != 4)
+        return false;
+
+    int values[4];
+    for (int i = 0; i < 4; ++i) {
+        bool ok;
+        values[i] = parts.at(i).toInt(&ok);
+        if (!ok)
+            return false;
+    }
+
+    region = QRect(values[0], values[1], values[2], values[3]);
+    return !region.isEmpty();
+}
+
+static void parseCommandLineArguments(CommandLineOptions &options)
+{
+    const QStringList arguments = QCoreApplication::arguments();
+
+    for (int i = 1; i < arguments.size(); ++i) {
+        const QString &arg = arguments.at(i);
+        if (arg == QLatin1String("--help") || arg == QLatin1String("-h")) {
+            options.showHelp = true;
+        } else if (arg == QLatin1String("--version")
+                || arg == QLatin1String("-v")) {
+            options.showVersion = true;
+        } else if (arg == QLatin1String("--region")) {
+            i++;
+            if (i >= arguments.size()) {
+                options.showHelp = true;
+            } else if (!parseRegion(arguments.at(i), options.region)) {
+                qWarning() << arguments.at(i) << ": the specified region is not valid.";
+                options.showHelp = true;
+            }
+        } else if (arg.isEmpty()) {
+            options.showHelp = true;
+        } else if (arg.at(0) == QLatin1Char('-')) {
+            qWarning() << "Unknown option" << arg;
+            options.showHelp = true;
+        } else if (options.fileToOpen.isEmpty()) {
+            options.fileToOpen = arg;
+        } else if (options.fileToSave.isEmpty()) {
+            options.fileToSave = arg;
+        } else {
+            // All args are already defined. Show help.
+            options.showHelp = true;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QGuiApplication a(argc, argv);
+
+    a.setOrganizationDomain(QLatin1String("mapeditor.org"));
+    a.setApplicationName(QLatin1String("TmbConverter"));
+    a.setApplicationVersion(QLatin1String("1.0"));
+
+    CommandLineOptions options;
+    parseCommandLineArguments(options);
+
+    if (options.showVersion) {
+        showVersion();
+        return 0;
+    }
+    if (options.showHelp || options.fileToOpen.isEmpty() || options.fileToSave.isEmpty()) {
+        showHelp();
+        return 0;
+    }
+
+    // Converting only copies image references, so the pixels are never needed
+    setImageLoadingMode(SkipImages);
+
+    QScopedPointer<Map> map;
+    QString errorString;
+
+    if (Tmb::TmbReader::isTmbFile(options.fileToOpen)) {
+        Tmb::TmbReader reader;
+        map.reset(reader.readMap(options.fileToOpen, options.region));
+        errorString = reader.errorString();
+    } else {
+        MapReader reader;
+        map.reset(reader.readMap(options.fileToOpen));
+        errorString = reader.errorString();
+    }
+
+    if (!map) {
+        qWarning().noquote() << "Error while reading" << options.fileToOpen
+                             << ":\n" << errorString;
+        return 1;
+    }
+
+    bool written;
+
+    if (options.fileToSave.endsWith(QLatin1String(".tmb"), Qt::CaseInsensitive)) {
+        Tmb::TmbWriter writer;
+        written = writer.writeMap(map.data(), options.fileToSave);
+        errorString = writer.errorString();
+    } else {
+        MapWriter writer;
+        written = writer.writeMap(map.data(), options.fileToSave);
+        errorString = writer.errorString();
+    }
+
+    if (!written) {
+        qWarning().noquote() << "Error while writing" << options.fileToSave
+                             << ":\n" << errorString;
+        return 1;
+    }
+
+    return 0;
+}
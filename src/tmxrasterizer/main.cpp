@@ -42,9 +42,12 @@ struct CommandLineOptions {
         , scale(1.0)
         , tileSize(0)
         , size(0)
+        , splitSize(0)
+        , pyramid(false)
         , useAntiAliasing(false)
         , smoothImages(true)
         , ignoreVisibility(false)
+        , verbose(false)
     {}
 
     bool showHelp;
@@ -54,9 +57,12 @@ struct CommandLineOptions {
     qreal scale;
     int tileSize;
     int size;
+    int splitSize;
+    bool pyramid;
     bool useAntiAliasing;
     bool smoothImages;
     bool ignoreVisibility;
+    bool verbose;
     QStringList layersToHide;
 };
 
@@ -77,6 +83,13 @@ static void showHelp()
             "                            Overrides the --scale option\n"
             "     --size SIZE          : The output image fits within a SIZE x SIZE square\n"
             "                            Overrides the --scale and --tilesize options\n"
+            "     --split SIZE         : Writes the output as separate images of SIZE x SIZE pixels,\n"
+            "                            named after the output file with their column and row added\n"
+            "                            (NAME_X_Y.EXT). Keeps memory use low for huge maps\n"
+            "     --pyramid            : Writes a pyramid of 256x256 tiles for slippy map viewers to the\n"
+            "                            output directory, as Z/X/Y.png. The highest zoom level is\n"
+            "                            rendered at the requested scale\n"
+            "     --verbose            : Print the time taken by each zoom level of the pyramid\n"
             "  -a --anti-aliasing      : Antialias edges of primitives\n"
             "     --no-smoothing       : Use nearest neighbour instead of smooth blending of pixels\n"
             "     --ignore-visibility  : Ignore all layer visibility flags in the map file, and render all\n"
@@ -140,6 +153,22 @@ static void parseCommandLineArguments(CommandLineOptions &options)
                     options.showHelp = true;
                 }
             }
+        } else if (arg == QLatin1String("--split")) {
+            i++;
+            if (i >= arguments.size()) {
+                options.showHelp = true;
+            } else {
+                bool splitSizeIsInt;
+                options.splitSize = arguments.at(i).toInt(&splitSizeIsInt);
+                if (!splitSizeIsInt || options.splitSize <= 0) {
+                    qWarning() << arguments.at(i) << ": the specified split size is not a positive integer.";
+                    options.showHelp = true;
+                }
+            }
+        } else if (arg == QLatin1String("--pyramid")) {
+            options.pyramid = true;
+        } else if (arg == QLatin1String("--verbose")) {
+            options.verbose = true;
         } else if (arg == QLatin1String("--hide-layer")) {
             i++;
             if (i >= arguments.size()) {
@@ -203,6 +232,9 @@ int main(int argc, char *argv[])
     w.setSmoothImages(options.smoothImages);
     w.setIgnoreVisibility(options.ignoreVisibility);
     w.setLayersToHide(options.layersToHide);
+    w.setSplitSize(options.splitSize);
+    w.setPyramid(options.pyramid);
+    w.setVerbose(options.verbose);
 
     if (options.size > 0) {
         w.setSize(options.size);
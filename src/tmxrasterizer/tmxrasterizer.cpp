@@ -35,21 +35,33 @@
 #include "mapreader.h"
 #include "objectgroup.h"
 #include "orthogonalrenderer.h"
+#include "parallel.h"
 #include "staggeredrenderer.h"
 #include "tilelayer.h"
+#include "tileset.h"
 
+#include <QAtomicInt>
 #include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
 #include <QImageWriter>
+#include <QScopedPointer>
 
 using namespace Tiled;
 
+static const int PyramidTileSize = 256;
+
 TmxRasterizer::TmxRasterizer():
     mScale(1.0),
     mTileSize(0),
     mSize(0),
+    mSplitSize(0),
+    mPyramid(false),
     mUseAntiAliasing(false),
     mSmoothImages(true),
-    mIgnoreVisibility(false)
+    mIgnoreVisibility(false),
+    mVerbose(false)
 {
 }
 
@@ -57,7 +69,7 @@ TmxRasterizer::~TmxRasterizer()
 {
 }
 
-bool TmxRasterizer::shouldDrawLayer(const Layer *layer)
+bool TmxRasterizer::shouldDrawLayer(const Layer *layer) const
 {
     if (layer->isObjectGroup() || layer->isGroupLayer())
         return false;
@@ -71,13 +83,57 @@ bool TmxRasterizer::shouldDrawLayer(const Layer *layer)
     return !layer->isHidden();
 }
 
+static MapRenderer *createRenderer(const Map *map)
+{
+    switch (map->orientation()) {
+    case Map::Isometric:
+        return new IsometricRenderer(map);
+    case Map::Staggered:
+        return new StaggeredRenderer(map);
+    case Map::Hexagonal:
+        return new HexagonalRenderer(map);
+    case Map::Orthogonal:
+    default:
+        return new OrthogonalRenderer(map);
+    }
+}
+
+static bool isTransparent(const QImage &image)
+{
+    Q_ASSERT(image.format() == QImage::Format_ARGB32);
+
+    for (int y = 0; y < image.height(); ++y) {
+        const QRgb *line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+        for (int x = 0; x < image.width(); ++x)
+            if (qAlpha(line[x]) != 0)
+                return false;
+    }
+
+    return true;
+}
+
+static bool writeImage(const QImage &image, const QString &imageFileName)
+{
+    QImageWriter imageWriter(imageFileName);
+
+    if (!imageWriter.canWrite())
+        imageWriter.setFormat("png");
+
+    if (!imageWriter.write(image)) {
+        qWarning("Error while writing \"%s\": %s",
+                 qUtf8Printable(imageFileName),
+                 qUtf8Printable(imageWriter.errorString()));
+        return false;
+    }
+
+    return true;
+}
+
 int TmxRasterizer::render(const QString &mapFileName,
                           const QString &imageFileName)
 {
-    Map *map;
-    MapRenderer *renderer;
     MapReader reader;
-    map = reader.readMap(mapFileName);
+    QScopedPointer<Map> map(reader.readMap(mapFileName));
     if (!map) {
         qWarning("Error while reading \"%s\":\n%s",
                  qUtf8Printable(mapFileName),
@@ -85,21 +141,20 @@ int TmxRasterizer::render(const QString &mapFileName,
         return 1;
     }
 
-    switch (map->orientation()) {
-    case Map::Isometric:
-        renderer = new IsometricRenderer(map);
-        break;
-    case Map::Staggered:
-        renderer = new StaggeredRenderer(map);
-        break;
-    case Map::Hexagonal:
-        renderer = new HexagonalRenderer(map);
-        break;
-    case Map::Orthogonal:
-    default:
-        renderer = new OrthogonalRenderer(map);
-        break;
-    }
+    // Decode the tileset images in parallel. The pixmaps are all created
+    // here, since this can only be done on the main thread, whereas the
+    // tiles of a pyramid are rendered on several threads.
+    for (const SharedTileset &tileset : map->tilesets())
+        tileset->decodeImagesInBackground();
+    for (const SharedTileset &tileset : map->tilesets())
+        tileset->loadDeferredImages();
+
+    LayerIterator iterator(map.data());
+    while (const Layer *layer = iterator.next())
+        if (const ImageLayer *imageLayer = dynamic_cast<const ImageLayer*>(layer))
+            imageLayer->image();
+
+    QScopedPointer<MapRenderer> renderer(createRenderer(map.data()));
 
     QRect mapBoundingRect = renderer->mapBoundingRect();
     QSize mapSize = mapBoundingRect.size();
@@ -124,19 +179,44 @@ int TmxRasterizer::render(const QString &mapFileName,
     mapSize.rwidth() *= xScale;
     mapSize.rheight() *= yScale;
 
-    QImage image(mapSize, QImage::Format_ARGB32);
+    QTransform transform = QTransform::fromScale(xScale, yScale);
+    transform.translate(margins.left(), margins.top());
+    transform.translate(-mapOffset.x(), -mapOffset.y());
+
+    if (mPyramid) {
+        return renderPyramid(*map, transform, mapSize, imageFileName) ? 0 : 1;
+    }
+
+    if (mSplitSize > 0) {
+        return renderSplit(*map, *renderer, transform, mapSize,
+                           imageFileName) ? 0 : 1;
+    }
+
+    const QImage image = renderImage(*map, *renderer, transform,
+                                     QRect(QPoint(), mapSize));
+
+    return writeImage(image, imageFileName) ? 0 : 1;
+}
+
+/**
+ * Renders the part \a rect of the output image, in which the map is drawn
+ * using the given \a transform. Only the tiles in this part are drawn.
+ */
+QImage TmxRasterizer::renderImage(const Map &map,
+                                  MapRenderer &renderer,
+                                  const QTransform &transform,
+                                  const QRect &rect) const
+{
+    QImage image(rect.size(), QImage::Format_ARGB32);
     image.fill(Qt::transparent);
     QPainter painter(&image);
 
     painter.setRenderHint(QPainter::Antialiasing, mUseAntiAliasing);
     painter.setRenderHint(QPainter::SmoothPixmapTransform, mSmoothImages);
-    painter.setTransform(QTransform::fromScale(xScale, yScale));
-
-    painter.translate(margins.left(), margins.top());
-    painter.translate(-mapOffset);
+    painter.setTransform(transform * QTransform::fromTranslate(-rect.x(), -rect.y()));
 
     // Perform a similar rendering than found in exportasimagedialog.cpp
-    LayerIterator iterator(map);
+    LayerIterator iterator(&map);
     while (const Layer *layer = iterator.next()) {
         if (!shouldDrawLayer(layer))
             continue;
@@ -146,33 +226,202 @@ int TmxRasterizer::render(const QString &mapFileName,
         painter.setOpacity(layer->effectiveOpacity());
         painter.translate(offset);
 
+        // The part of the layer covered by the image
+        const QRectF exposed = painter.transform().inverted().mapRect(QRectF(image.rect()));
+
         const TileLayer *tileLayer = dynamic_cast<const TileLayer*>(layer);
         const ImageLayer *imageLayer = dynamic_cast<const ImageLayer*>(layer);
 
         if (tileLayer) {
-            renderer->drawTileLayer(&painter, tileLayer);
+            renderer.drawTileLayer(&painter, tileLayer, exposed);
         } else if (imageLayer) {
-            renderer->drawImageLayer(&painter, imageLayer);
+            renderer.drawImageLayer(&painter, imageLayer, exposed);
         }
 
         painter.translate(-offset);
     }
 
-    delete renderer;
-    delete map;
+    return image;
+}
 
-    // Save image
-    QImageWriter imageWriter(imageFileName);
+/**
+ * Renders the output image as a grid of separate images of at most the split
+ * size, which are written next to \a imageFileName as NAME_X_Y.EXT, where X
+ * and Y are the column and row of the image in the grid.
+ *
+ * Only one of these images exists at a time, so the memory needed does not
+ * depend on the size of the map.
+ */
+bool TmxRasterizer::renderSplit(const Map &map,
+                                MapRenderer &renderer,
+                                const QTransform &transform,
+                                const QSize &imageSize,
+                                const QString &imageFileName) const
+{
+    const QFileInfo fileInfo(imageFileName);
+    const QString suffix = fileInfo.suffix().isEmpty() ? QStringLiteral("png")
+                                                       : fileInfo.suffix();
+    const QString baseName = fileInfo.dir().filePath(fileInfo.completeBaseName());
 
-    if (!imageWriter.canWrite())
-        imageWriter.setFormat("png");
+    for (int y = 0, row = 0; y < imageSize.height(); y += mSplitSize, ++row) {
+        for (int x = 0, column = 0; x < imageSize.width(); x += mSplitSize, ++column) {
+            const QRect rect = QRect(x, y, mSplitSize, mSplitSize) & QRect(QPoint(), imageSize);
+            const QImage image = renderImage(map, renderer, transform, rect);
 
-    if (!imageWriter.write(image)) {
-        qWarning("Error while writing \"%s\": %s",
-                 qUtf8Printable(imageFileName),
-                 qUtf8Printable(imageWriter.errorString()));
-        return 1;
+            const QString partFileName = QStringLiteral("%1_%2_%3.%4")
+                    .arg(baseName).arg(column).arg(row).arg(suffix);
+
+            if (!writeImage(image, partFileName))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Renders a pyramid of 256x256 tiles for use with slippy map viewers. The
+ * tiles are written to \a directory as Z/X/Y.png, where Z is the zoom level.
+ *
+ * The tiles of the highest zoom level show the map at the requested scale.
+ * They are rendered in parallel, each with its own renderer. This relies on
+ * all tile and image layer pixmaps having been created beforehand, so that
+ * drawing them only reads them. Each lower level is built by scaling down
+ * the tiles of the level above it, which are read back from disk so that
+ * memory use stays bounded. Fully transparent tiles are not written.
+ *
+ * In verbose mode, the time taken by each level is printed.
+ */
+bool TmxRasterizer::renderPyramid(const Map &map,
+                                  const QTransform &transform,
+                                  const QSize &imageSize,
+                                  const QString &directory) const
+{
+    int maxZoom = 0;
+    while ((PyramidTileSize << maxZoom) < qMax(imageSize.width(), imageSize.height()))
+        ++maxZoom;
+
+    const QDir dir(directory);
+    QAtomicInt failures(0);
+
+    auto tileFileName = [&] (int zoom, int x, int y) {
+        return dir.filePath(QStringLiteral("%1/%2/%3.png").arg(zoom).arg(x).arg(y));
+    };
+
+    auto writeTile = [&] (const QImage &image, int zoom, int x, int y) {
+        if (!writeImage(image, tileFileName(zoom, x, y)))
+            failures.ref();
+    };
+
+    auto makeColumnDirectories = [&] (int zoom, int columns) {
+        for (int x = 0; x < columns; ++x) {
+            if (!dir.mkpath(QStringLiteral("%1/%2").arg(zoom).arg(x))) {
+                qWarning("Error while creating directory \"%s\"",
+                         qUtf8Printable(dir.filePath(QStringLiteral("%1/%2").arg(zoom).arg(x))));
+                return false;
+            }
+        }
+        return true;
+    };
+
+    QElapsedTimer timer;
+    timer.start();
+
+    auto reportLevel = [&] (int zoom, const QVector<char> &written) {
+        if (mVerbose) {
+            qWarning("Zoom level %d: wrote %d of %d tiles in %lld ms",
+                     zoom, int(written.count(true)), written.size(),
+                     timer.restart());
+        }
+    };
+
+    // Render the highest zoom level
+    int columns = (imageSize.width() + PyramidTileSize - 1) / PyramidTileSize;
+    int rows = (imageSize.height() + PyramidTileSize - 1) / PyramidTileSize;
+
+    if (!makeColumnDirectories(maxZoom, columns))
+        return false;
+
+    // Which tiles of the current level were written. Tracking this avoids
+    // picking up files left behind by an earlier run.
+    QVector<char> written(columns * rows, false);
+    char *writtenData = written.data();
+
+    parallelFor(columns * rows, [&] (int index) {
+        const int x = index % columns;
+        const int y = index / columns;
+        const QRect rect(x * PyramidTileSize, y * PyramidTileSize,
+                         PyramidTileSize, PyramidTileSize);
+
+        // Renderers are cheap to create and not meant to be shared
+        const QScopedPointer<MapRenderer> renderer(createRenderer(&map));
+
+        const QImage image = renderImage(map, *renderer, transform, rect);
+        if (isTransparent(image))
+            return;
+
+        writeTile(image, maxZoom, x, y);
+        writtenData[index] = true;
+    });
+
+    reportLevel(maxZoom, written);
+
+    // Build the lower levels by scaling down the tiles of the level above
+    for (int zoom = maxZoom - 1; zoom >= 0; --zoom) {
+        const QVector<char> above = written;
+        const int columnsAbove = columns;
+        const int rowsAbove = rows;
+
+        columns = (columns + 1) / 2;
+        rows = (rows + 1) / 2;
+
+        if (!makeColumnDirectories(zoom, columns))
+            return false;
+
+        written = QVector<char>(columns * rows, false);
+        writtenData = written.data();
+
+        parallelFor(columns * rows, [&] (int index) {
+            const int x = index % columns;
+            const int y = index / columns;
+            const int half = PyramidTileSize / 2;
+
+            QImage image;
+
+            for (int i = 0; i < 4; ++i) {
+                const int xAbove = x * 2 + (i & 1);
+                const int yAbove = y * 2 + (i >> 1);
+                if (xAbove >= columnsAbove || yAbove >= rowsAbove)
+                    continue;
+                if (!above.at(xAbove + yAbove * columnsAbove))
+                    continue;
+
+                const QImage tile(tileFileName(zoom + 1, xAbove, yAbove));
+                if (tile.isNull())
+                    continue;
+
+                if (image.isNull()) {
+                    image = QImage(PyramidTileSize, PyramidTileSize, QImage::Format_ARGB32);
+                    image.fill(Qt::transparent);
+                }
+
+                QPainter painter(&image);
+                painter.setCompositionMode(QPainter::CompositionMode_Source);
+                painter.drawImage((i & 1) * half, (i >> 1) * half,
+                                  tile.scaled(half, half,
+                                              Qt::IgnoreAspectRatio,
+                                              Qt::SmoothTransformation));
+            }
+
+            if (image.isNull())
+                return;
+
+            writeTile(image, zoom, x, y);
+            writtenData[index] = true;
+        });
+
+        reportLevel(zoom, written);
     }
 
-    return 0;
+    return failures.load() == 0;
 }
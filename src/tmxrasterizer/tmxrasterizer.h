@@ -30,8 +30,15 @@
 
 #include "layer.h"
 
+#include <QImage>
 #include <QString>
 #include <QStringList>
+#include <QTransform>
+
+namespace Tiled {
+class Map;
+class MapRenderer;
+}
 
 using namespace Tiled;
 
@@ -44,16 +51,22 @@ public:
 
     qreal scale() const { return mScale; }
     int tileSize() const { return mTileSize; }
+    int splitSize() const { return mSplitSize; }
+    bool pyramid() const { return mPyramid; }
     bool useAntiAliasing() const { return mUseAntiAliasing; }
     bool smoothImages() const { return mSmoothImages; }
     bool IgnoreVisibility() const { return mIgnoreVisibility; }
+    bool verbose() const { return mVerbose; }
 
     void setScale(qreal scale) { mScale = scale; }
     void setTileSize(int tileSize) { mTileSize = tileSize; }
     void setSize(int size) { mSize = size; }
+    void setSplitSize(int splitSize) { mSplitSize = splitSize; }
+    void setPyramid(bool pyramid) { mPyramid = pyramid; }
     void setAntiAliasing(bool useAntiAliasing) { mUseAntiAliasing = useAntiAliasing; }
     void setSmoothImages(bool smoothImages) { mSmoothImages = smoothImages; }
     void setIgnoreVisibility(bool IgnoreVisibility) { mIgnoreVisibility = IgnoreVisibility; }
+    void setVerbose(bool verbose) { mVerbose = verbose; }
 
     void setLayersToHide(QStringList layersToHide) { mLayersToHide = layersToHide; }
 
@@ -63,11 +76,30 @@ private:
     qreal mScale;
     int mTileSize;
     int mSize;
+    int mSplitSize;
+    bool mPyramid;
     bool mUseAntiAliasing;
     bool mSmoothImages;
     bool mIgnoreVisibility;
+    bool mVerbose;
     QStringList mLayersToHide;
 
-    bool shouldDrawLayer(const Layer *layer);
+    bool shouldDrawLayer(const Layer *layer) const;
+
+    QImage renderImage(const Map &map,
+                       MapRenderer &renderer,
+                       const QTransform &transform,
+                       const QRect &rect) const;
+
+    bool renderSplit(const Map &map,
+                     MapRenderer &renderer,
+                     const QTransform &transform,
+                     const QSize &imageSize,
+                     const QString &imageFileName) const;
+
+    bool renderPyramid(const Map &map,
+                       const QTransform &transform,
+                       const QSize &imageSize,
+                       const QString &directory) const;
 
 };
@@ -0,0 +1,189 @@
+#include "map.h"
+#include "orthogonalrenderer.h"
+#include "tile.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QtTest/QtTest>
+
+#include <random>
+
+using namespace Tiled;
+
+static const int TileSize = 8;
+static const int TilesetColumns = 16;
+
+class test_CellRenderer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void tilesShareTilesetImage();
+    void renderMatchesSeparateImages();
+    void smoothScalingStaysWithinTile();
+
+    void renderLayer_data();
+    void renderLayer();
+};
+
+/**
+ * Creates an image-based tileset in which every tile has its own color.
+ */
+static SharedTileset createAtlasTileset()
+{
+    QImage image(TileSize * TilesetColumns, TileSize * TilesetColumns,
+                 QImage::Format_ARGB32);
+
+    QPainter painter(&image);
+    for (int y = 0; y < TilesetColumns; ++y) {
+        for (int x = 0; x < TilesetColumns; ++x) {
+            const QRect rect(x * TileSize, y * TileSize, TileSize, TileSize);
+            painter.fillRect(rect, QColor::fromHsv((x * 22) % 360, 255, 128 + y * 8));
+            painter.fillRect(rect.adjusted(0, 0, -TileSize / 2, -TileSize / 2), Qt::white);
+        }
+    }
+    painter.end();
+
+    SharedTileset tileset = Tileset::create(QLatin1String("atlas"), TileSize, TileSize);
+    tileset->loadFromImage(image, QString());
+    return tileset;
+}
+
+/**
+ * Creates a tileset with the same tiles as \a atlas, but with each tile
+ * using its own image.
+ */
+static SharedTileset createSeparateTileset(const Tileset &atlas)
+{
+    SharedTileset tileset = Tileset::create(QLatin1String("separate"), TileSize, TileSize);
+    for (const Tile *tile : atlas.tiles())
+        tileset->addTile(tile->image());
+    return tileset;
+}
+
+static Map *createRandomMap(Tileset *tileset, int size)
+{
+    Map *map = new Map(Map::Orthogonal, size, size, TileSize, TileSize);
+    map->addTileset(tileset->sharedPointer());
+
+    TileLayer *layer = new TileLayer(QString(), 0, 0, size, size);
+
+    std::mt19937 random(size);
+    std::uniform_int_distribution<int> tileId(0, tileset->tileCount() - 1);
+    std::uniform_int_distribution<int> flip(0, 7);
+
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            Cell cell(tileset->findTile(tileId(random)));
+            const int flags = flip(random);
+            cell.setFlippedHorizontally(flags & 1);
+            cell.setFlippedVertically(flags & 2);
+            cell.setFlippedAntiDiagonally(flags & 4);
+            layer->setCell(x, y, cell);
+        }
+    }
+
+    map->addLayer(layer);
+    return map;
+}
+
+static QImage render(const Map *map)
+{
+    const OrthogonalRenderer renderer(map);
+
+    QImage image(renderer.mapBoundingRect().size(), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    renderer.drawTileLayer(&painter, static_cast<TileLayer*>(map->layerAt(0)));
+    painter.end();
+
+    return image;
+}
+
+void test_CellRenderer::tilesShareTilesetImage()
+{
+    SharedTileset tileset = createAtlasTileset();
+    QCOMPARE(tileset->tileCount(), TilesetColumns * TilesetColumns);
+
+    const QPixmap &atlasImage = tileset->findTile(0)->atlasImage();
+    QCOMPARE(atlasImage.size(), QSize(TileSize * TilesetColumns, TileSize * TilesetColumns));
+
+    for (const Tile *tile : tileset->tiles()) {
+        QCOMPARE(tile->atlasImage().cacheKey(), atlasImage.cacheKey());
+        QCOMPARE(tile->size(), QSize(TileSize, TileSize));
+        QCOMPARE(tile->imageRect().topLeft(),
+                 QPoint(tile->id() % TilesetColumns, tile->id() / TilesetColumns) * TileSize);
+        QCOMPARE(tile->image().toImage(), atlasImage.copy(tile->imageRect()).toImage());
+    }
+}
+
+void test_CellRenderer::renderMatchesSeparateImages()
+{
+    SharedTileset atlas = createAtlasTileset();
+    SharedTileset separate = createSeparateTileset(*atlas);
+
+    QScopedPointer<Map> atlasMap(createRandomMap(atlas.data(), 32));
+    QScopedPointer<Map> separateMap(createRandomMap(separate.data(), 32));
+
+    QCOMPARE(render(atlasMap.data()), render(separateMap.data()));
+}
+
+void test_CellRenderer::smoothScalingStaysWithinTile()
+{
+    QImage atlasImage(TileSize * 2, TileSize, QImage::Format_ARGB32);
+    atlasImage.fill(Qt::blue);
+    QPainter(&atlasImage).fillRect(0, 0, TileSize, TileSize, Qt::red);
+
+    SharedTileset tileset = Tileset::create(QLatin1String("atlas"), TileSize, TileSize);
+    tileset->loadFromImage(atlasImage, QString());
+    QCOMPARE(tileset->tileCount(), 2);
+
+    QImage image(TileSize * 4, TileSize * 4, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.translate(0.25, 0.25);
+    painter.scale(2.7, 2.7);
+    {
+        CellRenderer cellRenderer(&painter);
+        cellRenderer.render(Cell(tileset->findTile(0)), QPointF(0, TileSize),
+                            QSizeF(TileSize, TileSize), CellRenderer::BottomLeft);
+    }
+    painter.end();
+
+    for (int y = 0; y < image.height(); ++y)
+        for (int x = 0; x < image.width(); ++x)
+            QCOMPARE(qBlue(image.pixel(x, y)), 0);
+}
+
+void test_CellRenderer::renderLayer_data()
+{
+    QTest::addColumn<bool>("sharedImage");
+
+    QTest::newRow("separate") << false;
+    QTest::newRow("shared") << true;
+}
+
+void test_CellRenderer::renderLayer()
+{
+    QFETCH(bool, sharedImage);
+
+    SharedTileset atlas = createAtlasTileset();
+    SharedTileset tileset = sharedImage ? atlas : createSeparateTileset(*atlas);
+
+    QScopedPointer<Map> map(createRandomMap(tileset.data(), 256));
+    const OrthogonalRenderer renderer(map.data());
+    const TileLayer *layer = static_cast<TileLayer*>(map->layerAt(0));
+
+    QImage image(renderer.mapBoundingRect().size(), QImage::Format_ARGB32_Premultiplied);
+
+    QBENCHMARK {
+        QPainter painter(&image);
+        renderer.drawTileLayer(&painter, layer);
+    }
+}
+
+QTEST_MAIN(test_CellRenderer)
+#include "test_cellrenderer.moc"
@@ -0,0 +1,172 @@
+#include "floodfill.h"
+#include "map.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QtTest/QtTest>
+
+#include <random>
+
+using namespace Tiled;
+
+class test_FloodFill : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void matchesConnectedCells_data();
+    void matchesConnectedCells();
+    void originOutsideLayer();
+    void layerWithOffset();
+
+    void computeFill_data();
+    void computeFill();
+};
+
+/**
+ * Creates a map with a single layer in which each cell is randomly set to one
+ * of \a tileCount tiles.
+ */
+static Map *createRandomMap(int size, int tileCount, unsigned seed)
+{
+    Map *map = new Map(Map::Orthogonal, size, size, 1, 1);
+
+    SharedTileset tileset = Tileset::create(QLatin1String("tiles"), 1, 1);
+    for (int i = 0; i < tileCount; ++i)
+        tileset->addTile(QPixmap(1, 1));
+    map->addTileset(tileset);
+
+    TileLayer *layer = new TileLayer(QString(), 0, 0, size, size);
+
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<int> tileId(0, tileCount - 1);
+
+    for (int y = 0; y < size; ++y)
+        for (int x = 0; x < size; ++x)
+            layer->setCell(x, y, Cell(tileset->findTile(tileId(random))));
+
+    map->addLayer(layer);
+    return map;
+}
+
+/**
+ * Finds the cells connected to \a origin one cell at a time.
+ */
+static QRegion connectedCells(const TileLayer *layer, QPoint origin)
+{
+    const Cell matchCell = layer->cellAt(origin);
+
+    QVector<bool> visited(layer->width() * layer->height());
+    QVector<QPoint> stack { origin };
+    visited[origin.y() * layer->width() + origin.x()] = true;
+
+    QRegion region;
+
+    while (!stack.isEmpty()) {
+        const QPoint p = stack.takeLast();
+        region += QRect(p, QSize(1, 1));
+
+        const QPoint neighbors[] = {
+            p + QPoint(1, 0), p + QPoint(-1, 0), p + QPoint(0, 1), p + QPoint(0, -1)
+        };
+
+        for (const QPoint &n : neighbors) {
+            if (!layer->contains(n) || visited[n.y() * layer->width() + n.x()])
+                continue;
+            visited[n.y() * layer->width() + n.x()] = true;
+            if (layer->cellAt(n) == matchCell)
+                stack.append(n);
+        }
+    }
+
+    return region;
+}
+
+void test_FloodFill::matchesConnectedCells_data()
+{
+    QTest::addColumn<int>("tileCount");
+
+    QTest::newRow("2 tiles") << 2;
+    QTest::newRow("3 tiles") << 3;
+}
+
+void test_FloodFill::matchesConnectedCells()
+{
+    QFETCH(int, tileCount);
+
+    QScopedPointer<Map> map(createRandomMap(32, tileCount, tileCount));
+    const TileLayer *layer = static_cast<TileLayer*>(map->layerAt(0));
+
+    for (int i = 0; i < 32; ++i) {
+        const QPoint origin(i * 7 % 32, i * 13 % 32);
+        const QRegion expected = connectedCells(layer, origin);
+
+        const FloodFill fill = FloodFill::compute(layer, origin,
+                                                  Map::Orthogonal,
+                                                  Map::StaggerY,
+                                                  Map::StaggerOdd);
+
+        QCOMPARE(fill.toRegion(), expected);
+
+        for (int y = 0; y < 32; ++y)
+            for (int x = 0; x < 32; ++x)
+                QCOMPARE(fill.contains(QPoint(x, y)), expected.contains(QPoint(x, y)));
+    }
+}
+
+void test_FloodFill::originOutsideLayer()
+{
+    QScopedPointer<Map> map(createRandomMap(8, 1, 0));
+    const TileLayer *layer = static_cast<TileLayer*>(map->layerAt(0));
+
+    const FloodFill fill = FloodFill::compute(layer, QPoint(8, 0),
+                                              Map::Orthogonal,
+                                              Map::StaggerY,
+                                              Map::StaggerOdd);
+
+    QVERIFY(fill.isEmpty());
+    QVERIFY(fill.toRegion().isEmpty());
+    QVERIFY(!fill.contains(QPoint(8, 0)));
+}
+
+void test_FloodFill::layerWithOffset()
+{
+    QScopedPointer<Map> map(createRandomMap(8, 1, 0));
+    TileLayer *layer = static_cast<TileLayer*>(map->layerAt(0));
+    layer->setPosition(4, 2);
+
+    const FloodFill fill = FloodFill::compute(layer, QPoint(4, 2),
+                                              Map::Orthogonal,
+                                              Map::StaggerY,
+                                              Map::StaggerOdd);
+
+    QCOMPARE(fill.toRegion(), QRegion(4, 2, 8, 8));
+    QVERIFY(fill.contains(QPoint(11, 9)));
+    QVERIFY(!fill.contains(QPoint(3, 2)));
+}
+
+void test_FloodFill::computeFill_data()
+{
+    QTest::addColumn<int>("tileCount");
+
+    QTest::newRow("uniform") << 1;
+    QTest::newRow("fragmented") << 2;
+}
+
+void test_FloodFill::computeFill()
+{
+    QFETCH(int, tileCount);
+
+    QScopedPointer<Map> map(createRandomMap(512, tileCount, 0));
+    const TileLayer *layer = static_cast<TileLayer*>(map->layerAt(0));
+
+    QBENCHMARK {
+        FloodFill::compute(layer, QPoint(256, 256),
+                           Map::Orthogonal,
+                           Map::StaggerY,
+                           Map::StaggerOdd).toRegion();
+    }
+}
+
+QTEST_MAIN(test_FloodFill)
+#include "test_floodfill.moc"
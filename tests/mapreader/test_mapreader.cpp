@@ -1,8 +1,15 @@
+#include "compression.h"
+#include "gidmapper.h"
 #include "map.h"
 #include "mapobject.h"
+#include "maptovariantconverter.h"
 #include "objectgroup.h"
+#include "tile.h"
 #include "tilelayer.h"
 #include "mapreader.h"
+#include "mapwriter.h"
+#include "tileset.h"
+#include "varianttomapconverter.h"
 
 #include <QtTest/QtTest>
 
@@ -14,6 +21,27 @@ class test_MapReader : public QObject
 
 private slots:
     void loadMap();
+
+    void roundTrip_data();
+    void roundTrip();
+
+    void compression_data();
+    void compression();
+
+    void decompressInto_data();
+    void decompressInto();
+
+    void loadInfiniteMap_data();
+    void loadInfiniteMap();
+
+    void saveInfiniteMap_data();
+    void saveInfiniteMap();
+
+    void deferredImages_data();
+    void deferredImages();
+
+private:
+    Map *createInfiniteMap(Map::LayerDataFormat format, int size);
 };
 
 void test_MapReader::loadMap()
@@ -53,5 +81,384 @@ void test_MapReader::loadMap()
     QCOMPARE(mapObject->height(), qreal(64));
 }
 
+void test_MapReader::roundTrip_data()
+{
+    QTest::addColumn<Map::LayerDataFormat>("format");
+    QTest::addColumn<bool>("infinite");
+
+    const QList<QPair<const char*, Map::LayerDataFormat>> formats {
+        { "xml", Map::XML },
+        { "csv", Map::CSV },
+        { "base64", Map::Base64 },
+        { "base64-gzip", Map::Base64Gzip },
+        { "base64-zlib", Map::Base64Zlib },
+        { "base64-zstd", Map::Base64Zstd },
+        { "base64-lz4", Map::Base64Lz4 },
+    };
+
+    for (const auto &format : formats) {
+        QTest::newRow(format.first) << format.second << false;
+        QTest::newRow(QByteArray(format.first).append("-infinite").constData())
+                << format.second << true;
+    }
+}
+
+static void compareTileLayers(const TileLayer *a, const TileLayer *b)
+{
+    QVERIFY(a);
+    QVERIFY(b);
+    QCOMPARE(a->bounds(), b->bounds());
+
+    const QRect bounds = a->bounds();
+    for (int y = bounds.top(); y <= bounds.bottom(); ++y) {
+        for (int x = bounds.left(); x <= bounds.right(); ++x) {
+            const Cell cellA = a->cellAt(x, y);
+            const Cell cellB = b->cellAt(x, y);
+            QCOMPARE(cellA.tileId(), cellB.tileId());
+            QCOMPARE(cellA.isEmpty(), cellB.isEmpty());
+            QCOMPARE(cellA.flippedHorizontally(), cellB.flippedHorizontally());
+            QCOMPARE(cellA.flippedVertically(), cellB.flippedVertically());
+        }
+    }
+}
+
+void test_MapReader::roundTrip()
+{
+    QFETCH(Map::LayerDataFormat, format);
+    QFETCH(bool, infinite);
+
+    if (!layerDataFormatSupported(format))
+        QSKIP("Compression method not supported by this build");
+
+    Map map(Map::Orthogonal, 40, 30, 32, 32, infinite);
+    map.setLayerDataFormat(format);
+    if (isCompressed(format))
+        map.setCompressionLevel(3);
+
+    SharedTileset tileset = Tileset::create(QLatin1String("Tileset"), 32, 32);
+    map.addTileset(tileset);
+
+    TileLayer *tileLayer = new TileLayer(QLatin1String("Tiles"), 0, 0, 40, 30);
+    Cell cell;
+    for (int y = 0; y < 30; ++y) {
+        for (int x = 0; x < 40; ++x) {
+            if ((x + y) % 5 == 0)
+                continue;
+            cell.setTile(tileset.data(), (x * 3 + y) % 64);
+            cell.setFlippedHorizontally(x % 2);
+            cell.setFlippedVertically(y % 3 == 0);
+            tileLayer->setCell(x, y, cell);
+        }
+    }
+    map.addLayer(tileLayer);
+
+    // TMX
+    QBuffer buffer;
+    buffer.open(QIODevice::ReadWrite);
+
+    MapWriter writer;
+    writer.writeMap(&map, &buffer);
+    buffer.seek(0);
+
+    MapReader reader;
+    QScopedPointer<Map> loaded(reader.readMap(&buffer));
+    QVERIFY2(loaded, qPrintable(reader.errorString()));
+    QCOMPARE(loaded->layerDataFormat(), format);
+    QCOMPARE(loaded->compressionLevel(), map.compressionLevel());
+    compareTileLayers(tileLayer, loaded->layerAt(0)->asTileLayer());
+
+    // JSON
+    MapToVariantConverter mapToVariant;
+    const QVariant variant = mapToVariant.toVariant(map, QDir());
+
+    VariantToMapConverter variantToMap;
+    QScopedPointer<Map> converted(variantToMap.toMap(variant, QDir()));
+    QVERIFY2(converted, qPrintable(variantToMap.errorString()));
+    QCOMPARE(converted->compressionLevel(), map.compressionLevel());
+    compareTileLayers(tileLayer, converted->layerAt(0)->asTileLayer());
+}
+
+void test_MapReader::compression_data()
+{
+    QTest::addColumn<QString>("fileName");
+    QTest::addColumn<int>("method");
+
+    const QStringList maps {
+        QLatin1String("../../examples/desert.tmx"),
+        QLatin1String("../../examples/sewers.tmx"),
+        QLatin1String("../../examples/isometric_grass_and_water.tmx"),
+    };
+
+    for (const QString &fileName : maps) {
+        const QByteArray name = QFileInfo(fileName).completeBaseName().toLatin1();
+        QTest::newRow(QByteArray(name + "-zlib").constData()) << fileName << int(Zlib);
+        QTest::newRow(QByteArray(name + "-zstd").constData()) << fileName << int(Zstandard);
+        QTest::newRow(QByteArray(name + "-lz4").constData()) << fileName << int(Lz4);
+    }
+}
+
+/*
+ * Compares the compressed size and the decompression speed of the supported
+ * compression methods, on the layer data of some of the example maps.
+ */
+void test_MapReader::compression()
+{
+    QFETCH(QString, fileName);
+    QFETCH(int, method);
+
+    const CompressionMethod compressionMethod = static_cast<CompressionMethod>(method);
+    if (!compressionSupported(compressionMethod))
+        QSKIP("Compression method not supported by this build");
+
+    MapReader reader;
+    QScopedPointer<Map> map(reader.readMap(fileName));
+    QVERIFY2(map, qPrintable(reader.errorString()));
+
+    GidMapper gidMapper(map->tilesets());
+    QByteArray layerData;
+    for (const TileLayer *tileLayer : map->tileLayers()) {
+        const QByteArray encoded = gidMapper.encodeLayerData(*tileLayer, Map::Base64);
+        layerData.append(QByteArray::fromBase64(encoded));
+    }
+
+    const QByteArray compressed = compress(layerData, compressionMethod);
+    QVERIFY(!compressed.isNull());
+
+    qInfo("%d bytes compressed to %d bytes (%.1f%%)",
+          layerData.size(), compressed.size(),
+          100.0 * compressed.size() / qMax(1, layerData.size()));
+
+    QByteArray decompressed;
+    QBENCHMARK {
+        decompressed = decompress(compressed, layerData.size(), compressionMethod);
+    }
+
+    QCOMPARE(decompressed, layerData);
+}
+
+void test_MapReader::decompressInto_data()
+{
+    QTest::addColumn<int>("method");
+
+    QTest::newRow("gzip") << int(Gzip);
+    QTest::newRow("zlib") << int(Zlib);
+    QTest::newRow("zstd") << int(Zstandard);
+    QTest::newRow("lz4") << int(Lz4);
+}
+
+void test_MapReader::decompressInto()
+{
+    QFETCH(int, method);
+
+    const CompressionMethod compressionMethod = static_cast<CompressionMethod>(method);
+    if (!compressionSupported(compressionMethod))
+        QSKIP("Compression method not supported by this build");
+
+    QByteArray data;
+    for (int i = 0; i < 4000; ++i)
+        data.append(char(i % 7 + i / 100));
+
+    const QByteArray compressed = compress(data, compressionMethod);
+
+    QByteArray out(data.size() + 1, Qt::Uninitialized);
+
+    // Decompressing twice on the same thread reuses the stream
+    QVERIFY(decompress(compressed, out.data(), data.size(), compressionMethod));
+    QCOMPARE(out.left(data.size()), data);
+    QVERIFY(decompress(compressed, out.data(), data.size(), compressionMethod));
+    QCOMPARE(out.left(data.size()), data);
+
+    // The size needs to match exactly
+    QVERIFY(!decompress(compressed, out.data(), data.size() - 1, compressionMethod));
+    QVERIFY(!decompress(compressed, out.data(), data.size() + 1, compressionMethod));
+
+    // Corrupt data is detected
+    QVERIFY(!decompress(compressed.left(compressed.size() / 2), out.data(),
+                        data.size(), compressionMethod));
+
+    // Too high compression levels are reduced to the highest level of the method
+    const int maximumLevel = maximumCompressionLevel(compressionMethod);
+    QCOMPARE(compress(data, compressionMethod, maximumLevel + 10),
+             compress(data, compressionMethod, maximumLevel));
+}
+
+// Large enough for the layer data to be read and written in several batches,
+// while keeping the benchmarks quick to run as part of the unit tests
+static const int InfiniteMapSize = 1024;
+
+Map *test_MapReader::createInfiniteMap(Map::LayerDataFormat format, int size)
+{
+    Map *map = new Map(Map::Orthogonal, size, size, 32, 32, true);
+    map->setLayerDataFormat(format);
+
+    SharedTileset tileset = Tileset::create(QLatin1String("Tileset"), 32, 32);
+    map->addTileset(tileset);
+
+    TileLayer *tileLayer = new TileLayer(QLatin1String("Tiles"), 0, 0, size, size);
+    Cell cell;
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            cell.setTile(tileset.data(), (x * 7 + y * 13) % 256);
+            tileLayer->setCell(x, y, cell);
+        }
+    }
+    map->addLayer(tileLayer);
+
+    return map;
+}
+
+void test_MapReader::loadInfiniteMap_data()
+{
+    QTest::addColumn<Map::LayerDataFormat>("format");
+
+    QTest::newRow("base64-zlib") << Map::Base64Zlib;
+    QTest::newRow("base64") << Map::Base64;
+    QTest::newRow("csv") << Map::CSV;
+}
+
+void test_MapReader::loadInfiniteMap()
+{
+    QFETCH(Map::LayerDataFormat, format);
+
+    const int size = InfiniteMapSize;
+    QScopedPointer<Map> map(createInfiniteMap(format, size));
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.path() + QLatin1String("/infinite.tmx");
+
+    MapWriter writer;
+    QVERIFY(writer.writeMap(map.data(), fileName));
+
+    QScopedPointer<Map> loaded;
+
+    QBENCHMARK {
+        MapReader reader;
+        loaded.reset(reader.readMap(fileName));
+    }
+
+    QVERIFY(loaded);
+    QCOMPARE(loaded->layerCount(), 1);
+
+    TileLayer *loadedLayer = loaded->layerAt(0)->asTileLayer();
+    QVERIFY(loadedLayer);
+    QCOMPARE(loadedLayer->bounds(), QRect(0, 0, size, size));
+    QCOMPARE(loadedLayer->cellAt(0, 0).tileId(), 0);
+    QCOMPARE(loadedLayer->cellAt(100, 200).tileId(), (100 * 7 + 200 * 13) % 256);
+    QCOMPARE(loadedLayer->cellAt(size - 1, size - 1).tileId(),
+             ((size - 1) * 7 + (size - 1) * 13) % 256);
+}
+
+void test_MapReader::saveInfiniteMap_data()
+{
+    loadInfiniteMap_data();
+}
+
+void test_MapReader::saveInfiniteMap()
+{
+    QFETCH(Map::LayerDataFormat, format);
+
+    const int size = InfiniteMapSize;
+    QScopedPointer<Map> map(createInfiniteMap(format, size));
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.path() + QLatin1String("/infinite.tmx");
+
+    QBENCHMARK {
+        MapWriter writer;
+        QVERIFY(writer.writeMap(map.data(), fileName));
+    }
+
+    // Make sure the written map reads back the same
+    MapReader reader;
+    QScopedPointer<Map> loaded(reader.readMap(fileName));
+    QVERIFY(loaded);
+
+    const TileLayer *tileLayer = map->layerAt(0)->asTileLayer();
+    const TileLayer *loadedLayer = loaded->layerAt(0)->asTileLayer();
+    QVERIFY(loadedLayer);
+
+    for (int y = 0; y < size; y += 97) {
+        for (int x = 0; x < size; x += 89) {
+            QCOMPARE(loadedLayer->cellAt(x, y).tileId(),
+                     tileLayer->cellAt(x, y).tileId());
+        }
+    }
+}
+
+void test_MapReader::deferredImages_data()
+{
+    QTest::addColumn<int>("mode");
+
+    QTest::newRow("immediately") << int(LoadImagesImmediately);
+    QTest::newRow("on demand") << int(LoadImagesOnDemand);
+    QTest::newRow("skip") << int(SkipImages);
+}
+
+void test_MapReader::deferredImages()
+{
+    QFETCH(int, mode);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QImage image(64, 32, QImage::Format_ARGB32);
+    image.fill(Qt::red);
+    const QString imageFileName = dir.path() + QLatin1String("/tiles.png");
+    QVERIFY(image.save(imageFileName));
+
+    SharedTileset tileset = Tileset::create(QLatin1String("tiles"), 32, 32);
+    QVERIFY(tileset->loadFromImage(imageFileName));
+
+    const QString tilesetFileName = dir.path() + QLatin1String("/tiles.tsx");
+    MapWriter writer;
+    QVERIFY(writer.writeTileset(*tileset, tilesetFileName));
+
+    // Restores the global loading mode also when a check fails
+    struct ImageLoadingModeGuard {
+        ImageLoadingMode previous = imageLoadingMode();
+        ~ImageLoadingModeGuard() { setImageLoadingMode(previous); }
+    } modeGuard;
+
+    setImageLoadingMode(ImageLoadingMode(mode));
+
+    MapReader reader;
+    SharedTileset loaded = reader.readTileset(tilesetFileName);
+    QVERIFY(loaded);
+    QCOMPARE(loaded->imageStatus(), LoadingReady);
+    QCOMPARE(loaded->tileCount(), 2);
+    QCOMPARE(loaded->imageWidth(), 64);
+
+    // Tiles have their size even when their image was not decoded
+    const Tile *tile = loaded->findTile(1);
+    QCOMPARE(tile->size(), QSize(32, 32));
+    QCOMPARE(tile->image().isNull(), mode == SkipImages);
+    if (mode != SkipImages)
+        QCOMPARE(tile->image().toImage().pixel(0, 0), QColor(Qt::red).rgb());
+
+    // An image that can be measured but not decoded is reported once used
+    {
+        QFile file(imageFileName);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(file.resize(64));   // keeps the header with the image size
+    }
+    loaded = reader.readTileset(tilesetFileName);
+    QVERIFY(loaded);
+    if (mode == LoadImagesOnDemand) {
+        QCOMPARE(loaded->imageStatus(), LoadingReady);
+        QVERIFY(loaded->findTile(1)->image().isNull());
+        QCOMPARE(loaded->findTile(1)->imageStatus(), LoadingError);
+    }
+    if (mode != SkipImages)
+        QCOMPARE(loaded->imageStatus(), LoadingError);
+
+    // A missing image is still noticed while reading
+    QVERIFY(QFile::remove(imageFileName));
+    loaded = reader.readTileset(tilesetFileName);
+    QVERIFY(loaded);
+    QCOMPARE(loaded->imageStatus(), LoadingError);
+}
+
 QTEST_MAIN(test_MapReader)
 #include "test_mapreader.moc"
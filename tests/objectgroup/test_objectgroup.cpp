@@ -0,0 +1,257 @@
+#include "mapobject.h"
+#include "objectgroup.h"
+#include "tile.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QtTest/QtTest>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+using namespace Tiled;
+
+class test_ObjectGroup : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void objectsInMatchesAllObjects();
+    void indexFollowsChanges();
+    void nearestObject();
+    void rotatedObject();
+    void largeObject();
+    void tileSizeChanges();
+
+    void objectsIn_data();
+    void objectsIn();
+};
+
+/**
+ * Creates an object group with \a count unrotated rectangle objects at
+ * random positions within an area of \a size by \a size pixels. Some of the
+ * objects have no size.
+ */
+static ObjectGroup *createRandomObjectGroup(int count, qreal size, unsigned seed)
+{
+    ObjectGroup *objectGroup = new ObjectGroup;
+
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<qreal> position(0, size);
+    std::uniform_real_distribution<qreal> extent(0, 300);
+
+    for (int i = 0; i < count; ++i) {
+        QSizeF objectSize;
+        if (i % 5 != 0)
+            objectSize = QSizeF(extent(random), extent(random));
+
+        objectGroup->addObject(new MapObject(QString(), QString(),
+                                             QPointF(position(random), position(random)),
+                                             objectSize));
+    }
+
+    return objectGroup;
+}
+
+static bool overlaps(const QRectF &a, const QRectF &b)
+{
+    return a.left() <= b.right() && b.left() <= a.right() &&
+            a.top() <= b.bottom() && b.top() <= a.bottom();
+}
+
+/**
+ * Finds the objects overlapping \a rect by checking each object.
+ */
+static QList<MapObject*> objectsOverlapping(const ObjectGroup *objectGroup,
+                                            const QRectF &rect)
+{
+    QList<MapObject*> objects;
+    for (MapObject *object : objectGroup->objects())
+        if (overlaps(object->bounds(), rect))
+            objects.append(object);
+    return objects;
+}
+
+static qreal distance(const QRectF &rect, const QPointF &pos)
+{
+    const qreal dx = std::max({ rect.left() - pos.x(), qreal(0), pos.x() - rect.right() });
+    const qreal dy = std::max({ rect.top() - pos.y(), qreal(0), pos.y() - rect.bottom() });
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+static void compareWithAllObjects(const ObjectGroup *objectGroup,
+                                  qreal size, unsigned seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<qreal> position(-500, size + 500);
+    std::uniform_real_distribution<qreal> extent(0, 1000);
+
+    for (int i = 0; i < 100; ++i) {
+        const QRectF rect(position(random), position(random),
+                          extent(random), extent(random));
+
+        QCOMPARE(objectGroup->objectsIn(rect), objectsOverlapping(objectGroup, rect));
+
+        const QPointF pos = rect.center();
+        QCOMPARE(objectGroup->objectsAt(pos),
+                 objectsOverlapping(objectGroup, QRectF(pos, QSizeF(0, 0))));
+    }
+}
+
+void test_ObjectGroup::objectsInMatchesAllObjects()
+{
+    QScopedPointer<ObjectGroup> objectGroup(createRandomObjectGroup(1000, 4000, 1));
+    compareWithAllObjects(objectGroup.data(), 4000, 2);
+}
+
+void test_ObjectGroup::indexFollowsChanges()
+{
+    QScopedPointer<ObjectGroup> objectGroup(createRandomObjectGroup(1000, 4000, 1));
+
+    // Create the index before making changes
+    QVERIFY(!objectGroup->objectsIn(QRectF(0, 0, 4000, 4000)).isEmpty());
+
+    std::mt19937 random(3);
+    std::uniform_real_distribution<qreal> position(0, 4000);
+    std::uniform_real_distribution<qreal> extent(0, 300);
+
+    for (int i = 0; i < 200; ++i) {
+        MapObject *object = objectGroup->objectAt(i * 5 % objectGroup->objectCount());
+        switch (i % 4) {
+        case 0:
+            object->setPosition(QPointF(position(random), position(random)));
+            break;
+        case 1:
+            object->setSize(extent(random), extent(random));
+            break;
+        case 2:
+            object->setBounds(QRectF(position(random), position(random),
+                                     extent(random), extent(random)));
+            break;
+        case 3: {
+            MapObject *removed = objectGroup->objectAt(i);
+            objectGroup->removeObjectAt(i);
+            delete removed;
+            break;
+        }
+        }
+    }
+
+    objectGroup->insertObject(10, new MapObject(QString(), QString(),
+                                                QPointF(100, 100),
+                                                QSizeF(10, 10)));
+    objectGroup->moveObjects(0, 500, 20);
+
+    compareWithAllObjects(objectGroup.data(), 4000, 4);
+}
+
+void test_ObjectGroup::nearestObject()
+{
+    QScopedPointer<ObjectGroup> objectGroup(createRandomObjectGroup(500, 20000, 5));
+
+    std::mt19937 random(6);
+    std::uniform_real_distribution<qreal> position(-5000, 25000);
+
+    for (int i = 0; i < 100; ++i) {
+        const QPointF pos(position(random), position(random));
+
+        MapObject *expected = nullptr;
+        qreal expectedDistance = std::numeric_limits<qreal>::max();
+        for (MapObject *object : objectGroup->objects()) {
+            const qreal d = distance(object->bounds(), pos);
+            if (d < expectedDistance) {
+                expected = object;
+                expectedDistance = d;
+            }
+        }
+
+        QCOMPARE(objectGroup->nearestObject(pos), expected);
+    }
+
+    ObjectGroup emptyGroup;
+    QVERIFY(!emptyGroup.nearestObject(QPointF(0, 0)));
+}
+
+void test_ObjectGroup::rotatedObject()
+{
+    ObjectGroup objectGroup;
+    MapObject *object = new MapObject(QString(), QString(),
+                                      QPointF(1000, 1000),
+                                      QSizeF(400, 10));
+    objectGroup.addObject(object);
+
+    QVERIFY(objectGroup.objectsAt(QPointF(995, 1300)).isEmpty());
+
+    object->setRotation(90);
+    QCOMPARE(objectGroup.objectsAt(QPointF(995, 1300)),
+             QList<MapObject*>() << object);
+}
+
+void test_ObjectGroup::largeObject()
+{
+    ObjectGroup objectGroup;
+    MapObject *object = new MapObject(QString(), QString(),
+                                      QPointF(-100000, -100000),
+                                      QSizeF(200000, 200000));
+    objectGroup.addObject(object);
+
+    QCOMPARE(objectGroup.objectsAt(QPointF(0, 0)), QList<MapObject*>() << object);
+    QCOMPARE(objectGroup.nearestObject(QPointF(500000, 0)), object);
+
+    object->setSize(10, 10);
+    QVERIFY(objectGroup.objectsAt(QPointF(0, 0)).isEmpty());
+    QCOMPARE(objectGroup.objectsAt(QPointF(-99995, -99995)),
+             QList<MapObject*>() << object);
+}
+
+void test_ObjectGroup::tileSizeChanges()
+{
+    SharedTileset tileset = Tileset::create(QLatin1String("tiles"), 32, 32);
+    Tile *tile = tileset->addTile(QPixmap(32, 32));
+
+    ObjectGroup objectGroup;
+    MapObject *object = new MapObject(QString(), QString(),
+                                      QPointF(1000, 1000),
+                                      QSizeF(32, 32));
+    object->setCell(Cell(tile));
+    objectGroup.addObject(object);
+
+    QVERIFY(objectGroup.objectsAt(QPointF(1010, 850)).isEmpty());
+
+    tileset->setTileImage(tile, QPixmap(32, 200));
+    objectGroup.tileSizesChanged(tileset.data());
+
+    QCOMPARE(objectGroup.objectsAt(QPointF(1010, 850)),
+             QList<MapObject*>() << object);
+}
+
+void test_ObjectGroup::objectsIn_data()
+{
+    QTest::addColumn<bool>("indexed");
+
+    QTest::newRow("all objects") << false;
+    QTest::newRow("index") << true;
+}
+
+void test_ObjectGroup::objectsIn()
+{
+    QFETCH(bool, indexed);
+
+    QScopedPointer<ObjectGroup> objectGroup(createRandomObjectGroup(100000, 100000, 7));
+    const QRectF rect(50000, 50000, 1000, 1000);
+
+    if (indexed) {
+        QBENCHMARK {
+            objectGroup->objectsIn(rect);
+        }
+    } else {
+        QBENCHMARK {
+            objectsOverlapping(objectGroup.data(), rect);
+        }
+    }
+}
+
+QTEST_MAIN(test_ObjectGroup)
+#include "test_objectgroup.moc"
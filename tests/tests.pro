@@ -1,4 +1,13 @@
 TEMPLATE=subdirs
 SUBDIRS = \
+    cellrenderer \
+    floodfill \
     mapreader \
-    staggeredrenderer
+    objectgroup \
+    staggeredrenderer \
+    tilelayer \
+    tilelayerdelta \
+    tilesetmanager \
+    tmbformat \
+    wangfiller \
+    wangset
@@ -0,0 +1,347 @@
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+class test_TileLayer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void compactRoundTrip();
+    void compactFallback();
+    void compactIterator();
+    void compactClone();
+
+    void chunkGrid();
+    void chunkGridShared();
+    void forEachSpan();
+    void animatedCells();
+
+    void memoryUsage_data();
+    void memoryUsage();
+
+    void cellAt_data();
+    void cellAt();
+
+private:
+    void fillRandom(TileLayer &layer, int width, int height);
+
+    SharedTileset mTileset1;
+    SharedTileset mTileset2;
+};
+
+/**
+ * Returns the bytes used by the cells of the given layer. Only the cell
+ * storage of the chunks is counted, which is what compact storage reduces.
+ */
+static qint64 cellMemory(const TileLayer &layer)
+{
+    qint64 bytes = 0;
+
+    for (int y = 0; y < layer.height(); y += CHUNK_SIZE) {
+        for (int x = 0; x < layer.width(); x += CHUNK_SIZE) {
+            if (const Chunk *chunk = layer.findChunk(x, y)) {
+                const qint64 cellSize = chunk->isCompact() ? sizeof(quint32)
+                                                           : sizeof(Cell);
+                bytes += CHUNK_SIZE * CHUNK_SIZE * cellSize;
+            }
+        }
+    }
+
+    return bytes;
+}
+
+void test_TileLayer::initTestCase()
+{
+    mTileset1 = Tileset::create(QLatin1String("Tileset1"), 32, 32);
+    mTileset2 = Tileset::create(QLatin1String("Tileset2"), 32, 32);
+}
+
+void test_TileLayer::fillRandom(TileLayer &layer, int width, int height)
+{
+    qsrand(42);
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            Cell cell;
+            cell.setTile(qrand() % 2 ? mTileset1.data() : mTileset2.data(),
+                         qrand() % 256);
+            cell.setFlippedHorizontally(qrand() % 2);
+            layer.setCell(x, y, cell);
+        }
+    }
+}
+
+void test_TileLayer::compactRoundTrip()
+{
+    TileLayer full(QString(), 0, 0, 100, 100);
+    fillRandom(full, 100, 100);
+
+    TileLayer compact(QString(), 0, 0, 100, 100);
+    compact.setCompact(true);
+    fillRandom(compact, 100, 100);
+
+    QVERIFY(compact.isCompact());
+    QVERIFY(full.computeDiffRegion(&compact).isEmpty());
+    QCOMPARE(full.region(), compact.region());
+    QCOMPARE(full.usedTilesets(), compact.usedTilesets());
+
+    // Converting an existing layer keeps all cells
+    QScopedPointer<TileLayer> converted(full.clone());
+    converted->setCompact(true);
+    QVERIFY(full.computeDiffRegion(converted.data()).isEmpty());
+    converted->setCompact(false);
+    QVERIFY(full.computeDiffRegion(converted.data()).isEmpty());
+
+    // Erasing and flipping operate on compact storage as well
+    compact.erase(QRegion(10, 10, 5, 5));
+    QVERIFY(compact.cellAt(12, 12).isEmpty());
+    compact.flip(FlipHorizontally);
+    QVERIFY(compact.isCompact());
+    full.erase(QRegion(10, 10, 5, 5));
+    full.flip(FlipHorizontally);
+    QVERIFY(full.computeDiffRegion(&compact).isEmpty());
+}
+
+void test_TileLayer::compactFallback()
+{
+    TileLayer layer(QString(), 0, 0, 64, 64);
+    layer.setCompact(true);
+
+    Cell cell;
+    cell.setTile(mTileset1.data(), 0x7FFFFFF);
+    cell.setFlippedVertically(true);
+    layer.setCell(3, 3, cell);
+
+    Cell other;
+    other.setTile(mTileset2.data(), 5);
+    layer.setCell(40, 40, other);
+
+    QCOMPARE(layer.cellAt(3, 3), cell);
+    QCOMPARE(layer.cellAt(40, 40), other);
+    QVERIFY(layer.cellAt(4, 4).isEmpty());
+}
+
+void test_TileLayer::compactIterator()
+{
+    TileLayer layer(QString(), 0, 0, 40, 40);
+    layer.setCompact(true);
+    fillRandom(layer, 40, 40);
+
+    const TileLayer &constLayer = layer;
+    int cells = 0;
+    for (auto it = constLayer.begin(), end = constLayer.end(); it != end; ++it) {
+        QCOMPARE(*it, layer.cellAt(it.key()));
+        ++cells;
+    }
+
+    // 3x3 chunks of 16x16 cells
+    QCOMPARE(cells, 9 * CHUNK_SIZE * CHUNK_SIZE);
+}
+
+void test_TileLayer::compactClone()
+{
+    TileLayer layer(QString(), 0, 0, 32, 32);
+    layer.setCompact(true);
+
+    Cell cell;
+    cell.setTile(mTileset1.data(), 1);
+    layer.setCell(0, 0, cell);
+
+    QScopedPointer<TileLayer> clone(layer.clone());
+
+    // Referring to another tileset in the clone leaves the original alone
+    Cell other;
+    other.setTile(mTileset2.data(), 2);
+    clone->setCell(1, 1, other);
+
+    QVERIFY(clone->isCompact());
+    QCOMPARE(clone->cellAt(0, 0), cell);
+    QCOMPARE(clone->cellAt(1, 1), other);
+    QVERIFY(layer.cellAt(1, 1).isEmpty());
+
+    layer.setCell(2, 2, other);
+    QCOMPARE(layer.cellAt(2, 2), other);
+    QVERIFY(clone->cellAt(2, 2).isEmpty());
+}
+
+void test_TileLayer::chunkGrid()
+{
+    TileLayer layer(QString(), 0, 0, 0, 0);
+
+    Cell cell;
+    cell.setTile(mTileset1.data(), 1);
+
+    // Growing in all directions, including far enough to fall back to the
+    // sparse lookup
+    const QVector<QPoint> points {
+        QPoint(0, 0), QPoint(-1, -1), QPoint(100, 3), QPoint(-70, 200),
+        QPoint(5000, -5000), QPoint(-100000, 100000), QPoint(17, 18)
+    };
+
+    for (const QPoint &point : points)
+        layer.setCell(point.x(), point.y(), cell);
+
+    for (const QPoint &point : points) {
+        QCOMPARE(layer.cellAt(point), cell);
+        QVERIFY(layer.findChunk(point.x(), point.y()));
+    }
+
+    QVERIFY(layer.cellAt(1, 1).isEmpty());
+    QVERIFY(!layer.findChunk(-20, -20));
+}
+
+void test_TileLayer::chunkGridShared()
+{
+    TileLayer layer(QString(), 0, 0, 64, 64);
+    fillRandom(layer, 64, 64);
+
+    QScopedPointer<TileLayer> clone(layer.clone());
+
+    Cell cell;
+    cell.setTile(mTileset2.data(), 300);
+    clone->setCell(10, 10, cell);
+    clone->setCell(100, 100, cell);
+
+    QCOMPARE(clone->cellAt(10, 10), cell);
+    QVERIFY(layer.cellAt(10, 10) != cell);
+    QVERIFY(layer.cellAt(100, 100).isEmpty());
+    QCOMPARE(layer.computeDiffRegion(clone.data()),
+             QRegion(10, 10, 1, 1) + QRegion(100, 100, 1, 1));
+}
+
+void test_TileLayer::forEachSpan()
+{
+    TileLayer layer(QString(), 0, 0, 64, 64);
+    fillRandom(layer, 40, 40);
+
+    const QRect rect(-5, 3, 60, 20);
+    int cells = 0;
+    int nonEmpty = 0;
+
+    layer.forEachSpan(rect, [&] (const Chunk *chunk, int x, int y, int length) {
+        QVERIFY(length > 0);
+        QVERIFY(length <= CHUNK_SIZE);
+        QCOMPARE(chunk, layer.findChunk(x, y));
+
+        for (int i = 0; i < length; ++i) {
+            const Cell cell = chunk ? chunk->cellAt((x + i) & CHUNK_MASK, y & CHUNK_MASK)
+                                    : Cell();
+            QCOMPARE(cell, layer.cellAt(x + i, y));
+            if (!cell.isEmpty())
+                ++nonEmpty;
+        }
+
+        cells += length;
+    });
+
+    QCOMPARE(cells, rect.width() * rect.height());
+    QCOMPARE(nonEmpty, 40 * 20);
+}
+
+void test_TileLayer::animatedCells()
+{
+    SharedTileset tileset = Tileset::create(QLatin1String("Animated"), 32, 32);
+    Tile *still = tileset->addTile(QPixmap());
+    Tile *animated = tileset->addTile(QPixmap());
+    animated->setFrames({ Frame { still->id(), 100 } });
+
+    TileLayer layer(QString(), 0, 0, 64, 64);
+    layer.setCell(1, 1, Cell(still));
+    layer.setCell(2, 2, Cell(animated));
+    layer.setCell(40, 3, Cell(animated));
+
+    QCOMPARE(layer.animatedCells().size(), 2);
+    QCOMPARE(layer.animatedCells().value(QPoint(2, 2)), animated);
+
+    // Once built, the index is kept up to date by setCell
+    layer.setCell(2, 2, Cell(still));
+    layer.setCell(5, 6, Cell(animated));
+    QVERIFY(!layer.animatedCells().contains(QPoint(2, 2)));
+    QCOMPARE(layer.animatedCells().value(QPoint(5, 6)), animated);
+    QCOMPARE(layer.animatedCells().size(), 2);
+
+    // Changing the animation of a tile is noticed
+    still->setFrames({ Frame { animated->id(), 100 } });
+    QCOMPARE(layer.animatedCells().size(), 4);
+    QCOMPARE(layer.animatedCells().value(QPoint(1, 1)), still);
+
+    // Tilesets used after the index was built are watched as well
+    SharedTileset otherTileset = Tileset::create(QLatin1String("Other"), 32, 32);
+    Tile *other = otherTileset->addTile(QPixmap());
+    layer.setCell(10, 10, Cell(other));
+    QVERIFY(!layer.animatedCells().contains(QPoint(10, 10)));
+    other->setFrames({ Frame { other->id(), 100 } });
+    QCOMPARE(layer.animatedCells().value(QPoint(10, 10)), other);
+
+    // Moving all cells rebuilds the index
+    layer.flip(FlipHorizontally);
+    QCOMPARE(layer.animatedCells().value(QPoint(63 - 40, 3)), animated);
+    QVERIFY(!layer.animatedCells().contains(QPoint(40, 3)));
+}
+
+void test_TileLayer::memoryUsage_data()
+{
+    QTest::addColumn<bool>("compact");
+
+    QTest::newRow("full") << false;
+    QTest::newRow("compact") << true;
+}
+
+void test_TileLayer::memoryUsage()
+{
+    QFETCH(bool, compact);
+
+    TileLayer layer(QString(), 0, 0, 2048, 2048);
+    layer.setCompact(compact);
+    fillRandom(layer, 2048, 2048);
+
+    const qint64 bytes = cellMemory(layer);
+    const qint64 cellCount = 2048 * 2048;
+    QCOMPARE(bytes, cellCount * qint64(compact ? sizeof(quint32) : sizeof(Cell)));
+
+    QTest::setBenchmarkResult(bytes, QTest::BytesAllocated);
+}
+
+void test_TileLayer::cellAt_data()
+{
+    QTest::addColumn<bool>("reader");
+
+    QTest::newRow("TileLayer::cellAt") << false;
+    QTest::newRow("CellReader") << true;
+}
+
+void test_TileLayer::cellAt()
+{
+    QFETCH(bool, reader);
+
+    TileLayer layer(QString(), 0, 0, 1024, 1024);
+    fillRandom(layer, 1024, 1024);
+
+    int nonEmpty = 0;
+
+    if (reader) {
+        QBENCHMARK {
+            CellReader cells(&layer);
+            for (int y = 0; y < 1024; ++y)
+                for (int x = 0; x < 1024; ++x)
+                    nonEmpty += !cells.cellAt(x, y).isEmpty();
+        }
+    } else {
+        QBENCHMARK {
+            for (int y = 0; y < 1024; ++y)
+                for (int x = 0; x < 1024; ++x)
+                    nonEmpty += !layer.cellAt(x, y).isEmpty();
+        }
+    }
+
+    QVERIFY(nonEmpty > 0);
+}
+
+QTEST_MAIN(test_TileLayer)
+#include "test_tilelayer.moc"
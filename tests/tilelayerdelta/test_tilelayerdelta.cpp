@@ -0,0 +1,250 @@
+#include "tilelayer.h"
+#include "tilelayerdelta.h"
+#include "tileset.h"
+
+#include <QtTest/QtTest>
+
+#include <random>
+
+using namespace Tiled;
+
+class test_TileLayerDelta : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void recordMatchesPainting();
+    void mergeMatchesSequence();
+    void compression();
+    void referencesTilesets();
+
+    void mergeStroke();
+
+private:
+    SharedTileset mTileset;
+};
+
+void test_TileLayerDelta::initTestCase()
+{
+    mTileset = Tileset::create(QLatin1String("tiles"), 1, 1);
+    for (int i = 0; i < 4; ++i)
+        mTileset->addTile(QPixmap(1, 1));
+}
+
+/**
+ * Creates a layer at \a x, \a y in which each cell is randomly set to one of
+ * the tiles of \a tileset or left empty.
+ */
+static TileLayer *createRandomLayer(const Tileset &tileset,
+                                    int x, int y, int width, int height,
+                                    std::mt19937 &random)
+{
+    TileLayer *layer = new TileLayer(QString(), x, y, width, height);
+    std::uniform_int_distribution<int> tileId(-1, tileset.tileCount() - 1);
+
+    for (int cellY = 0; cellY < height; ++cellY) {
+        for (int cellX = 0; cellX < width; ++cellX) {
+            const int id = tileId(random);
+            if (id >= 0)
+                layer->setCell(cellX, cellY, Cell(tileset.findTile(id)));
+        }
+    }
+
+    return layer;
+}
+
+/**
+ * Creates a region made of a few random rectangles around an area of
+ * \a size by \a size cells.
+ */
+static QRegion createRandomRegion(int size, std::mt19937 &random)
+{
+    std::uniform_int_distribution<int> position(-8, size);
+    std::uniform_int_distribution<int> extent(1, 20);
+
+    QRegion region;
+    for (int i = 0; i < 10; ++i)
+        region += QRect(position(random), position(random), extent(random), extent(random));
+    return region;
+}
+
+/**
+ * Paints \a source at \a x, \a y on \a target one cell at a time.
+ */
+static void paint(TileLayer *target, int x, int y,
+                  const TileLayer *source, const QRegion &region)
+{
+    const QRegion area = region & QRect(x, y, source->width(), source->height());
+
+    for (const QRect &rect : area.rects())
+        for (int cellY = rect.top(); cellY <= rect.bottom(); ++cellY)
+            for (int cellX = rect.left(); cellX <= rect.right(); ++cellX)
+                target->setCell(cellX - target->x(), cellY - target->y(),
+                                source->cellAt(cellX - x, cellY - y));
+}
+
+static void apply(TileLayer *target, const TileLayerDelta &delta,
+                  TileLayerDelta::Side side)
+{
+    if (delta.isEmpty())
+        return;
+
+    QScopedPointer<TileLayer> layer(delta.createLayer(side));
+    target->setCells(delta.bounds().x() - target->x(),
+                     delta.bounds().y() - target->y(),
+                     layer.data(),
+                     delta.region().translated(-target->position()));
+}
+
+static bool sameCells(const TileLayer *a, const TileLayer *b)
+{
+    for (int y = 0; y < a->height(); ++y)
+        for (int x = 0; x < a->width(); ++x)
+            if (!(a->cellAt(x, y) == b->cellAt(x, y)))
+                return false;
+    return true;
+}
+
+void test_TileLayerDelta::recordMatchesPainting()
+{
+    std::mt19937 random(1);
+
+    for (int i = 0; i < 20; ++i) {
+        QScopedPointer<TileLayer> target(createRandomLayer(*mTileset, 3, -5, 48, 48, random));
+        QScopedPointer<TileLayer> source(createRandomLayer(*mTileset, 0, 0, 40, 40, random));
+        const QRegion region = createRandomRegion(48, random) & target->rect();
+
+        const TileLayerDelta delta = TileLayerDelta::record(target.data(), 5, -2,
+                                                            source.data(), region);
+
+        QScopedPointer<TileLayer> expected(target->clone());
+        paint(expected.data(), 5, -2, source.data(), region);
+
+        // Only changed cells should be part of the delta
+        for (const QRect &rect : delta.region().rects()) {
+            for (int y = rect.top(); y <= rect.bottom(); ++y) {
+                for (int x = rect.left(); x <= rect.right(); ++x) {
+                    const QPoint pos = QPoint(x, y) - target->position();
+                    QVERIFY(!(target->cellAt(pos) == expected->cellAt(pos)));
+                }
+            }
+        }
+
+        QScopedPointer<TileLayer> painted(target->clone());
+        apply(painted.data(), delta, TileLayerDelta::NewCells);
+        QVERIFY(sameCells(painted.data(), expected.data()));
+
+        apply(painted.data(), delta, TileLayerDelta::OldCells);
+        QVERIFY(sameCells(painted.data(), target.data()));
+    }
+}
+
+void test_TileLayerDelta::mergeMatchesSequence()
+{
+    std::mt19937 random(2);
+
+    for (int i = 0; i < 20; ++i) {
+        QScopedPointer<TileLayer> original(createRandomLayer(*mTileset, 0, 0, 48, 48, random));
+        QScopedPointer<TileLayer> target(original->clone());
+
+        TileLayerDelta merged;
+
+        for (int j = 0; j < 5; ++j) {
+            QScopedPointer<TileLayer> source(createRandomLayer(*mTileset, 0, 0, 30, 30, random));
+            const QRegion region = createRandomRegion(48, random) & target->rect();
+            const int x = j * 4 - 4;
+
+            TileLayerDelta delta = TileLayerDelta::record(target.data(), x, j,
+                                                          source.data(), region);
+            paint(target.data(), x, j, source.data(), region);
+            merged.merge(delta);
+        }
+
+        QScopedPointer<TileLayer> painted(original->clone());
+        apply(painted.data(), merged, TileLayerDelta::NewCells);
+        QVERIFY(sameCells(painted.data(), target.data()));
+
+        apply(painted.data(), merged, TileLayerDelta::OldCells);
+        QVERIFY(sameCells(painted.data(), original.data()));
+    }
+}
+
+void test_TileLayerDelta::compression()
+{
+    std::mt19937 random(3);
+
+    QScopedPointer<TileLayer> target(createRandomLayer(*mTileset, 0, 0, 64, 64, random));
+    QScopedPointer<TileLayer> source(createRandomLayer(*mTileset, 0, 0, 64, 64, random));
+
+    TileLayerDelta delta = TileLayerDelta::record(target.data(), 0, 0, source.data(),
+                                                  QRegion(0, 0, 64, 64));
+    const QRegion region = delta.region();
+    const QRect bounds = delta.bounds();
+
+    delta.compress();
+    QVERIFY(delta.isCompressed());
+    QCOMPARE(delta.bounds(), bounds);
+
+    delta.decompress();
+    QVERIFY(!delta.isCompressed());
+    QCOMPARE(delta.region(), region);
+
+    QScopedPointer<TileLayer> painted(target->clone());
+    apply(painted.data(), delta, TileLayerDelta::NewCells);
+    QVERIFY(sameCells(painted.data(), source.data()));
+}
+
+void test_TileLayerDelta::referencesTilesets()
+{
+    SharedTileset tileset = Tileset::create(QLatin1String("temporary"), 1, 1);
+    Tile *tile = tileset->addTile(QPixmap(1, 1));
+    QWeakPointer<Tileset> weakTileset = tileset;
+
+    TileLayer target(QString(), 0, 0, 4, 4);
+    TileLayer source(QString(), 0, 0, 4, 4);
+
+    Cell cell(tile);
+    cell.setFlippedHorizontally(true);
+    source.setCell(1, 2, cell);
+
+    TileLayerDelta delta = TileLayerDelta::record(&target, 0, 0, &source,
+                                                  QRegion(0, 0, 4, 4));
+    tileset.reset();
+    QVERIFY(!weakTileset.isNull());
+
+    delta.compress();
+    delta.decompress();
+
+    QScopedPointer<TileLayer> layer(delta.createLayer(TileLayerDelta::NewCells));
+    QCOMPARE(layer->cellAt(0, 0), cell);
+
+    delta = TileLayerDelta();
+    QVERIFY(weakTileset.isNull());
+}
+
+/**
+ * Simulates a diagonal brush stroke across a large map, merging the changes
+ * of each step like the undo stack does.
+ */
+void test_TileLayerDelta::mergeStroke()
+{
+    TileLayer target(QString(), 0, 0, 4096, 4096);
+    TileLayer brush(QString(), 0, 0, 3, 3);
+    for (int y = 0; y < 3; ++y)
+        for (int x = 0; x < 3; ++x)
+            brush.setCell(x, y, Cell(mTileset->findTile(0)));
+
+    QBENCHMARK {
+        TileLayerDelta stroke;
+        for (int i = 0; i < 4000; ++i) {
+            stroke.merge(TileLayerDelta::record(&target, i, i, &brush,
+                                                QRegion(i, i, 3, 3)));
+        }
+        QCOMPARE(stroke.bounds(), QRect(0, 0, 4002, 4002));
+    }
+}
+
+QTEST_MAIN(test_TileLayerDelta)
+#include "test_tilelayerdelta.moc"
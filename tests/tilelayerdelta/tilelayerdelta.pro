@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+# Input
+SOURCES += test_tilelayerdelta.cpp
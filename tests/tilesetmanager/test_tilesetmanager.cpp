@@ -0,0 +1,136 @@
+#include "mapwriter.h"
+#include "tileset.h"
+#include "tilesetmanager.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+class test_TilesetManager : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void findReferencedTileset();
+    void fileNameChanged();
+    void loadTilesets();
+
+private:
+    QString writeTileset(const QString &name);
+
+    QTemporaryDir mDir;
+};
+
+void test_TilesetManager::initTestCase()
+{
+    QVERIFY(mDir.isValid());
+    QVERIFY(QDir(mDir.path()).mkdir(QLatin1String("sub")));
+}
+
+void test_TilesetManager::cleanupTestCase()
+{
+    TilesetManager::deleteInstance();
+}
+
+/**
+ * Writes a tileset called \a name to the temporary directory and returns its
+ * file name.
+ */
+QString test_TilesetManager::writeTileset(const QString &name)
+{
+    const QString fileName = mDir.filePath(name + QLatin1String(".tsx"));
+    SharedTileset tileset = Tileset::create(name, 32, 32);
+
+    MapWriter writer;
+    if (!writer.writeTileset(*tileset, fileName))
+        return QString();
+
+    return fileName;
+}
+
+void test_TilesetManager::findReferencedTileset()
+{
+    TilesetManager *manager = TilesetManager::instance();
+    const QString fileName = writeTileset(QLatin1String("find"));
+    QVERIFY(!fileName.isEmpty());
+
+    SharedTileset tileset = manager->loadTileset(fileName);
+    QVERIFY(tileset);
+    QCOMPARE(tileset->fileName(), fileName);
+
+    // Only referenced tilesets are found
+    QVERIFY(!manager->findTileset(fileName));
+
+    manager->addReference(tileset);
+    QCOMPARE(manager->findTileset(fileName), tileset);
+    QCOMPARE(manager->loadTileset(fileName), tileset);
+    QCOMPARE(manager->findTileset(mDir.filePath(QLatin1String("sub/../find.tsx"))), tileset);
+    QVERIFY(!manager->findTileset(QString()));
+
+    manager->removeReference(tileset);
+    QVERIFY(!manager->findTileset(fileName));
+}
+
+void test_TilesetManager::fileNameChanged()
+{
+    TilesetManager *manager = TilesetManager::instance();
+    const QString fileName = writeTileset(QLatin1String("old"));
+    const QString newFileName = writeTileset(QLatin1String("new"));
+
+    SharedTileset tileset = manager->loadTileset(fileName);
+    QVERIFY(tileset);
+    manager->addReference(tileset);
+
+    tileset->setFileName(newFileName);
+
+    // A renamed tileset is not found under its old name, even before the
+    // index is updated
+    QVERIFY(!manager->findTileset(fileName));
+
+    manager->tilesetFileNameChanged(*tileset);
+    QCOMPARE(manager->findTileset(newFileName), tileset);
+    QVERIFY(!manager->findTileset(fileName));
+
+    manager->removeReference(tileset);
+    QVERIFY(!manager->findTileset(newFileName));
+}
+
+void test_TilesetManager::loadTilesets()
+{
+    TilesetManager *manager = TilesetManager::instance();
+    const QString first = writeTileset(QLatin1String("first"));
+    const QString second = writeTileset(QLatin1String("second"));
+
+    const QStringList fileNames {
+        first,
+        second,
+        mDir.filePath(QLatin1String("sub/../first.tsx")),
+        mDir.filePath(QLatin1String("missing.tsx")),
+    };
+
+    QStringList errors;
+    const QVector<SharedTileset> tilesets = manager->loadTilesets(fileNames, &errors);
+
+    QCOMPARE(tilesets.size(), 4);
+    QCOMPARE(errors.size(), 4);
+
+    QVERIFY(tilesets.at(0));
+    QVERIFY(tilesets.at(1));
+    QVERIFY(tilesets.at(0) != tilesets.at(1));
+    QCOMPARE(tilesets.at(2), tilesets.at(0));
+    QVERIFY(!tilesets.at(3));
+
+    QVERIFY(errors.at(0).isEmpty());
+    QVERIFY(!errors.at(3).isEmpty());
+
+    // Referenced tilesets are reused by later loads
+    manager->addReferences(tilesets.mid(0, 2));
+    QCOMPARE(manager->loadTilesets(QStringList { second }).first(), tilesets.at(1));
+    manager->removeReferences(tilesets.mid(0, 2));
+}
+
+QTEST_MAIN(test_TilesetManager)
+#include "test_tilesetmanager.moc"
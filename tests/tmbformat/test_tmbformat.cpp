@@ -0,0 +1,209 @@
+#include "map.h"
+#include "mapreader.h"
+#include "mapwriter.h"
+#include "tilelayer.h"
+#include "tileset.h"
+#include "tmbreader.h"
+#include "tmbwriter.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+using namespace Tmb;
+
+class test_TmbFormat : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void roundTrip_data();
+    void roundTrip();
+
+    void readRegion();
+    void corruptFile();
+
+    void loadLargeMap_data();
+    void loadLargeMap();
+
+private:
+    Map *createLargeMap(int size);
+};
+
+static QByteArray toTmx(const Map *map, const QString &path)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+
+    MapWriter writer;
+    writer.writeMap(map, &buffer, path);
+
+    return buffer.data();
+}
+
+// The tilesets of a loaded map are different instances
+static void compareCells(const Cell &actual, const Cell &expected)
+{
+    QCOMPARE(actual.tileId(), expected.tileId());
+    QCOMPARE(actual.flippedHorizontally(), expected.flippedHorizontally());
+}
+
+void test_TmbFormat::roundTrip_data()
+{
+    QTest::addColumn<QString>("fileName");
+
+    QTest::newRow("mapobject") << QStringLiteral("../data/mapobject.tmx");
+    QTest::newRow("desert") << QStringLiteral("../../examples/desert.tmx");
+    QTest::newRow("sewers") << QStringLiteral("../../examples/sewers.tmx");
+    QTest::newRow("hexagonal") << QStringLiteral("../../examples/hexagonal-mini.tmx");
+    QTest::newRow("isometric") << QStringLiteral("../../examples/isometric_grass_and_water.tmx");
+    QTest::newRow("staggered") << QStringLiteral("../../examples/isometric_staggered_grass_and_water.tmx");
+    QTest::newRow("perspective") << QStringLiteral("../../examples/perspective_walls.tmx");
+    QTest::newRow("sticker-knight") << QStringLiteral("../../examples/sticker-knight/map/sandbox.tmx");
+}
+
+void test_TmbFormat::roundTrip()
+{
+    QFETCH(QString, fileName);
+
+    MapReader mapReader;
+    QScopedPointer<Map> map(mapReader.readMap(fileName));
+    QVERIFY2(map, qPrintable(mapReader.errorString()));
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString tmbFileName = dir.path() + QLatin1String("/map.tmb");
+
+    TmbWriter writer;
+    QVERIFY2(writer.writeMap(map.data(), tmbFileName), qPrintable(writer.errorString()));
+    QVERIFY(TmbReader::isTmbFile(tmbFileName));
+
+    TmbReader reader;
+    QScopedPointer<Map> loaded(reader.readMap(tmbFileName));
+    QVERIFY2(loaded, qPrintable(reader.errorString()));
+
+    // Both maps need to save to the same TMX
+    const QString path = QFileInfo(fileName).absolutePath();
+    QCOMPARE(toTmx(loaded.data(), path), toTmx(map.data(), path));
+}
+
+void test_TmbFormat::readRegion()
+{
+    QScopedPointer<Map> map(createLargeMap(256));
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.path() + QLatin1String("/region.tmb");
+
+    TmbWriter writer;
+    QVERIFY(writer.writeMap(map.data(), fileName));
+
+    TmbReader reader;
+    QScopedPointer<Map> loaded(reader.readMap(fileName, QRect(40, 40, 20, 20)));
+    QVERIFY(loaded);
+
+    const TileLayer *tileLayer = map->layerAt(0)->asTileLayer();
+    const TileLayer *loadedLayer = loaded->layerAt(0)->asTileLayer();
+    QVERIFY(loadedLayer);
+
+    // Only the chunks intersecting the region are decoded
+    QCOMPARE(loadedLayer->bounds(), QRect(32, 32, 32, 32));
+
+    for (int y = 32; y < 64; ++y)
+        for (int x = 32; x < 64; ++x)
+            compareCells(loadedLayer->cellAt(x, y), tileLayer->cellAt(x, y));
+}
+
+void test_TmbFormat::corruptFile()
+{
+    QScopedPointer<Map> map(createLargeMap(64));
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.path() + QLatin1String("/corrupt.tmb");
+
+    TmbWriter writer;
+    QVERIFY(writer.writeMap(map.data(), fileName));
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.resize(file.size() / 2));
+    file.close();
+
+    TmbReader reader;
+    QScopedPointer<Map> loaded(reader.readMap(fileName));
+    QVERIFY(!loaded);
+    QVERIFY(!reader.errorString().isEmpty());
+}
+
+Map *test_TmbFormat::createLargeMap(int size)
+{
+    Map *map = new Map(Map::Orthogonal, size, size, 32, 32, true);
+
+    SharedTileset tileset = Tileset::create(QLatin1String("Tileset"), 32, 32);
+    map->addTileset(tileset);
+
+    TileLayer *tileLayer = new TileLayer(QLatin1String("Tiles"), 0, 0, size, size);
+    Cell cell;
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            cell.setTile(tileset.data(), (x * 7 + y * 13) % 256);
+            cell.setFlippedHorizontally(x % 5 == 0);
+            tileLayer->setCell(x, y, cell);
+        }
+    }
+    map->addLayer(tileLayer);
+
+    return map;
+}
+
+void test_TmbFormat::loadLargeMap_data()
+{
+    QTest::addColumn<QString>("format");
+
+    QTest::newRow("tmx") << QStringLiteral("tmx");
+    QTest::newRow("tmb") << QStringLiteral("tmb");
+}
+
+void test_TmbFormat::loadLargeMap()
+{
+    QFETCH(QString, format);
+
+    QScopedPointer<Map> map(createLargeMap(4096));
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.path() + QLatin1String("/large.") + format;
+
+    if (format == QLatin1String("tmb")) {
+        TmbWriter writer;
+        QVERIFY(writer.writeMap(map.data(), fileName));
+    } else {
+        MapWriter writer;
+        QVERIFY(writer.writeMap(map.data(), fileName));
+    }
+
+    QScopedPointer<Map> loaded;
+
+    QBENCHMARK {
+        if (format == QLatin1String("tmb")) {
+            TmbReader reader;
+            loaded.reset(reader.readMap(fileName));
+        } else {
+            MapReader reader;
+            loaded.reset(reader.readMap(fileName));
+        }
+    }
+
+    QVERIFY(loaded);
+
+    const TileLayer *tileLayer = map->layerAt(0)->asTileLayer();
+    const TileLayer *loadedLayer = loaded->layerAt(0)->asTileLayer();
+    QVERIFY(loadedLayer);
+
+    for (int y = 0; y < 4096; y += 97)
+        for (int x = 0; x < 4096; x += 89)
+            compareCells(loadedLayer->cellAt(x, y), tileLayer->cellAt(x, y));
+}
+
+QTEST_MAIN(test_TmbFormat)
+#include "test_tmbformat.moc"
@@ -0,0 +1,17 @@
+include(../tests.pri)
+
+INCLUDEPATH += ../../src/plugins/tmb
+
+# Link against the TMB plugin, which exports its reader and writer
+win32 {
+    LIBS += -L$$OUT_PWD/../../plugins/tiled
+} else:macx {
+    LIBS += -L$$OUT_PWD/../../bin/Tiled.app/Contents/PlugIns
+} else {
+    LIBS += -L$$OUT_PWD/../../lib/tiled/plugins
+    QMAKE_LFLAGS += \'-Wl,-rpath,\$\$ORIGIN/../../lib/tiled/plugins\'
+}
+LIBS += -ltmb
+
+# Input
+SOURCES += test_tmbformat.cpp
@@ -0,0 +1,182 @@
+#include "mapreader.h"
+#include "tilelayer.h"
+#include "tileset.h"
+#include "wangfiller.h"
+#include "wangset.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+Q_DECLARE_METATYPE(Tiled::Internal::WangFiller::FillMethod)
+
+class test_WangFiller : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void sameSeedGivesSameResult();
+    void fillMatchesSurroundings();
+
+    void fillRegion_data();
+    void fillRegion();
+};
+
+static SharedTileset readTileset(const QString &fileName)
+{
+    MapReader reader;
+    SharedTileset tileset = reader.readTileset(QLatin1String("../wangtiles/") + fileName);
+    if (!tileset)
+        qWarning() << reader.errorString();
+    return tileset;
+}
+
+/**
+ * Returns the number of cells in \a layer that don't match the wangIds of the
+ * cells around them.
+ */
+static int mismatchCount(const WangSet *wangSet, const TileLayer &layer)
+{
+    static const QPoint aroundTilePoints[] = {
+        QPoint( 0, -1), QPoint( 1, -1), QPoint( 1,  0), QPoint( 1,  1),
+        QPoint( 0,  1), QPoint(-1,  1), QPoint(-1,  0), QPoint(-1, -1)
+    };
+
+    int count = 0;
+
+    for (int y = 0; y < layer.height(); ++y) {
+        for (int x = 0; x < layer.width(); ++x) {
+            const Cell cell = layer.cellAt(x, y);
+            if (cell.isEmpty())
+                continue;
+
+            Cell surroundingCells[8];
+            for (int i = 0; i < 8; ++i)
+                surroundingCells[i] = layer.cellAt(QPoint(x, y) + aroundTilePoints[i]);
+
+            const WangId wangId = wangSet->wangIdOfCell(cell);
+            const WangId surroundingWangId = wangSet->wangIdFromSurrounding(surroundingCells);
+
+            // Compare only the colors that are known on both sides
+            for (int i = 0; i < 4; ++i) {
+                if (wangId.edgeColor(i) && surroundingWangId.edgeColor(i)
+                        && wangId.edgeColor(i) != surroundingWangId.edgeColor(i)) {
+                    ++count;
+                    break;
+                }
+                if (wangId.cornerColor(i) && surroundingWangId.cornerColor(i)
+                        && wangId.cornerColor(i) != surroundingWangId.cornerColor(i)) {
+                    ++count;
+                    break;
+                }
+            }
+        }
+    }
+
+    return count;
+}
+
+static int emptyCount(const TileLayer &layer)
+{
+    int count = 0;
+    for (int y = 0; y < layer.height(); ++y)
+        for (int x = 0; x < layer.width(); ++x)
+            if (layer.cellAt(x, y).isEmpty())
+                ++count;
+    return count;
+}
+
+void test_WangFiller::sameSeedGivesSameResult()
+{
+    SharedTileset tileset = readTileset(QLatin1String("walkways.tsx"));
+    QVERIFY(tileset);
+
+    const TileLayer back(QString(), 0, 0, 64, 64);
+    const QRegion region(0, 0, 64, 64);
+
+    WangFiller wangFiller(tileset->wangSet(0));
+    wangFiller.setSeed(42);
+
+    QScopedPointer<TileLayer> first(wangFiller.fillRegion(back, region));
+    QScopedPointer<TileLayer> second(wangFiller.fillRegion(back, region));
+
+    for (int y = 0; y < 64; ++y)
+        for (int x = 0; x < 64; ++x)
+            QCOMPARE(first->cellAt(x, y), second->cellAt(x, y));
+}
+
+void test_WangFiller::fillMatchesSurroundings()
+{
+    SharedTileset tileset = readTileset(QLatin1String("grassAndWater.tsx"));
+    QVERIFY(tileset);
+    const WangSet *wangSet = tileset->wangSet(0);
+
+    // Surround the region with water
+    TileLayer back(QString(), 0, 0, 34, 34);
+    const WangId water(0x20202020);
+    const Cell waterCell = wangSet->findMatchingWangTile(water).makeCell();
+    QVERIFY(!waterCell.isEmpty());
+
+    for (int y = 0; y < 34; ++y)
+        for (int x = 0; x < 34; ++x)
+            back.setCell(x, y, waterCell);
+
+    const QRegion region(1, 1, 32, 32);
+
+    WangFiller wangFiller(tileset->wangSet(0));
+    wangFiller.setSeed(1);
+
+    QScopedPointer<TileLayer> filled(wangFiller.fillRegion(back, region));
+    back.setCells(1, 1, filled.data());
+
+    QCOMPARE(emptyCount(back), 0);
+    QCOMPARE(mismatchCount(wangSet, back), 0);
+}
+
+void test_WangFiller::fillRegion_data()
+{
+    QTest::addColumn<QString>("fileName");
+    QTest::addColumn<int>("wangSetIndex");
+    QTest::addColumn<WangFiller::FillMethod>("fillMethod");
+
+    QTest::newRow("walkways greedy") << QStringLiteral("walkways.tsx") << 0 << WangFiller::GreedyFill;
+    QTest::newRow("walkways propagating") << QStringLiteral("walkways.tsx") << 0 << WangFiller::PropagatingFill;
+    QTest::newRow("path and objects greedy") << QStringLiteral("PathAndObjects.tsx") << 0 << WangFiller::GreedyFill;
+    QTest::newRow("path and objects propagating") << QStringLiteral("PathAndObjects.tsx") << 0 << WangFiller::PropagatingFill;
+}
+
+void test_WangFiller::fillRegion()
+{
+    QFETCH(QString, fileName);
+    QFETCH(int, wangSetIndex);
+    QFETCH(WangFiller::FillMethod, fillMethod);
+
+    SharedTileset tileset = readTileset(fileName);
+    QVERIFY(tileset);
+
+    const TileLayer back(QString(), 0, 0, 256, 256);
+    const QRegion region(0, 0, 256, 256);
+
+    WangFiller wangFiller(tileset->wangSet(wangSetIndex));
+    wangFiller.setFillMethod(fillMethod);
+    wangFiller.setSeed(0);
+
+    QScopedPointer<TileLayer> filled;
+
+    QBENCHMARK_ONCE {
+        filled.reset(wangFiller.fillRegion(back, region));
+    }
+
+    QVERIFY(filled);
+    QCOMPARE(filled->size(), QSize(256, 256));
+    QVERIFY(emptyCount(*filled) < 256 * 256);
+
+    // Each choice of the propagating fill is checked against all cells around
+    // it, so the cells it fills always match
+    if (fillMethod == WangFiller::PropagatingFill)
+        QCOMPARE(mismatchCount(tileset->wangSet(wangSetIndex), *filled), 0);
+}
+
+QTEST_MAIN(test_WangFiller)
+#include "test_wangfiller.moc"
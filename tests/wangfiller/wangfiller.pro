@@ -0,0 +1,8 @@
+include(../tests.pri)
+
+# WangFiller is part of the editor, which is not a library
+INCLUDEPATH += ../../src/tiled
+
+# Input
+SOURCES += test_wangfiller.cpp \
+    ../../src/tiled/wangfiller.cpp
@@ -0,0 +1,215 @@
+/*
+ * test_wangset.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tile.h"
+#include "tileset.h"
+#include "wangset.h"
+
+#include <QtTest/QtTest>
+
+#include <algorithm>
+#include <random>
+
+using namespace Tiled;
+
+class test_WangSet : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void findMatchingWangTiles();
+    void removedTilesNoLongerMatch();
+    void cloneMatchesOriginal();
+    void colorCountChanges();
+
+    void wildWangIdIsUsed_data();
+    void wildWangIdIsUsed();
+};
+
+/**
+ * Creates a wang set with random wangIds assigned to \a tileCount tiles.
+ */
+static WangSet *createRandomWangSet(Tileset *tileset,
+                                    int tileCount,
+                                    int edgeColors,
+                                    int cornerColors)
+{
+    WangSet *wangSet = new WangSet(tileset, QLatin1String("random"), -1);
+    wangSet->setEdgeColorCount(edgeColors);
+    wangSet->setCornerColorCount(cornerColors);
+
+    std::mt19937 random(tileCount);
+    std::uniform_int_distribution<int> edgeColor(0, edgeColors > 1 ? edgeColors : 0);
+    std::uniform_int_distribution<int> cornerColor(0, cornerColors > 1 ? cornerColors : 0);
+
+    for (int i = 0; i < tileCount; ++i) {
+        Tile *tile = tileset->addTile(QPixmap(1, 1));
+
+        WangId wangId;
+        for (int j = 0; j < 4; ++j) {
+            wangId.setEdgeColor(j, edgeColor(random));
+            wangId.setCornerColor(j, cornerColor(random));
+        }
+
+        wangSet->addTile(tile, wangId);
+    }
+
+    return wangSet;
+}
+
+/**
+ * Finds the tiles matching \a wangId by looking up all its variations.
+ */
+static QList<WangTile> findMatchingWangTilesSlow(const WangSet *wangSet, WangId wangId)
+{
+    QList<WangTile> list;
+
+    for (const WangTile &wangTile : wangSet->wangTiles()) {
+        for (WangId id : wangId.variations(wangSet->edgeColorCount(),
+                                           wangSet->cornerColorCount())) {
+            if (wangTile.wangId() == id) {
+                list.append(wangTile);
+                break;
+            }
+        }
+    }
+
+    return list;
+}
+
+static QList<WangTile> sorted(QList<WangTile> wangTiles)
+{
+    std::sort(wangTiles.begin(), wangTiles.end());
+    return wangTiles;
+}
+
+static void compareMatches(const WangSet *wangSet)
+{
+    std::mt19937 random(0);
+    std::uniform_int_distribution<int> edgeColor(0, wangSet->edgeColorCount() > 1 ? wangSet->edgeColorCount() : 0);
+    std::uniform_int_distribution<int> cornerColor(0, wangSet->cornerColorCount() > 1 ? wangSet->cornerColorCount() : 0);
+    std::uniform_int_distribution<int> wild(0, 1);
+
+    for (int i = 0; i < 200; ++i) {
+        WangId wangId;
+        for (int j = 0; j < 4; ++j) {
+            wangId.setEdgeColor(j, wild(random) ? 0 : edgeColor(random));
+            wangId.setCornerColor(j, wild(random) ? 0 : cornerColor(random));
+        }
+
+        const QList<WangTile> expected = findMatchingWangTilesSlow(wangSet, wangId);
+        QCOMPARE(sorted(wangSet->findMatchingWangTiles(wangId)), sorted(expected));
+        QCOMPARE(wangSet->wildWangIdIsUsed(wangId), !expected.isEmpty());
+    }
+}
+
+void test_WangSet::findMatchingWangTiles()
+{
+    SharedTileset tileset = Tileset::create(QLatin1String("tiles"), 1, 1);
+
+    QScopedPointer<WangSet> edgesAndCorners(createRandomWangSet(tileset.data(), 300, 3, 3));
+    compareMatches(edgesAndCorners.data());
+
+    QScopedPointer<WangSet> cornersOnly(createRandomWangSet(tileset.data(), 100, 1, 2));
+    compareMatches(cornersOnly.data());
+}
+
+void test_WangSet::removedTilesNoLongerMatch()
+{
+    SharedTileset tileset = Tileset::create(QLatin1String("tiles"), 1, 1);
+    QScopedPointer<WangSet> wangSet(createRandomWangSet(tileset.data(), 200, 2, 2));
+
+    // Clear every other tile and change the wangId of the others
+    for (Tile *tile : tileset->tiles()) {
+        WangId wangId = wangSet->wangIdOfTile(tile);
+        if (tile->id() % 2)
+            wangId = 0;
+        else
+            wangId.setEdgeColor(0, wangId.edgeColor(0) == 1 ? 2 : 1);
+
+        wangSet->addTile(tile, wangId);
+    }
+
+    compareMatches(wangSet.data());
+}
+
+void test_WangSet::cloneMatchesOriginal()
+{
+    SharedTileset tileset = Tileset::create(QLatin1String("tiles"), 1, 1);
+    QScopedPointer<WangSet> wangSet(createRandomWangSet(tileset.data(), 100, 2, 3));
+    QScopedPointer<WangSet> clone(wangSet->clone(tileset.data()));
+    clone->setEdgeColorCount(2);
+    clone->setCornerColorCount(3);
+
+    compareMatches(clone.data());
+}
+
+void test_WangSet::colorCountChanges()
+{
+    SharedTileset tileset = Tileset::create(QLatin1String("tiles"), 1, 1);
+    QScopedPointer<WangSet> wangSet(createRandomWangSet(tileset.data(), 200, 3, 2));
+
+    // With a single edge color, the 0 edges are no longer wildcards, so the
+    // tiles that still have edge colors don't match
+    wangSet->setEdgeColorCount(1);
+    compareMatches(wangSet.data());
+
+    WangId wangId;
+    wangId.setCornerColor(0, 1);
+    for (const WangTile &wangTile : wangSet->findMatchingWangTiles(wangId))
+        QCOMPARE(wangTile.wangId() & 0x0f0f0f0f, 0u);
+
+    wangSet->setEdgeColorCount(3);
+    compareMatches(wangSet.data());
+
+    wangSet->setCornerColorCount(1);
+    compareMatches(wangSet.data());
+}
+
+void test_WangSet::wildWangIdIsUsed_data()
+{
+    QTest::addColumn<int>("colors");
+
+    QTest::newRow("3 colors") << 3;
+    QTest::newRow("6 colors") << 6;
+}
+
+void test_WangSet::wildWangIdIsUsed()
+{
+    QFETCH(int, colors);
+
+    SharedTileset tileset = Tileset::create(QLatin1String("tiles"), 1, 1);
+    QScopedPointer<WangSet> wangSet(createRandomWangSet(tileset.data(), 500, colors, colors));
+
+    // A mostly wild wangId that is not used has the most variations to check
+    WangId wangId;
+    wangId.setEdgeColor(0, 1);
+    wangId.setEdgeColor(1, 2);
+    wangId.setEdgeColor(2, 1);
+    wangId.setEdgeColor(3, 2);
+
+    QBENCHMARK {
+        wangSet->wildWangIdIsUsed(wangId);
+        wangSet->findMatchingWangTiles(wangId);
+    }
+}
+
+QTEST_MAIN(test_WangSet)
+#include "test_wangset.moc"